@@ -0,0 +1,191 @@
+#include "avifencprefwidget.h"
+#include "ui_avifencprefwidget.h"
+
+AvifencPrefWidget::AvifencPrefWidget(QWidget *parent)
+    : ImageOptimizerPrefWidget(parent), ui(new Ui::AvifencPrefWidget),
+      m_settings(Settings::instance()) {
+  ui->setupUi(this);
+
+  // Load settings
+  loadSettings();
+
+  // Connect signals for auto-save
+  connect(ui->losslessCheckBox, &QCheckBox::toggled, this,
+          &AvifencPrefWidget::saveSettings);
+  connect(ui->qualitySlider, &QSlider::valueChanged, this,
+          &AvifencPrefWidget::saveSettings);
+  connect(ui->speedSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+          this, &AvifencPrefWidget::saveSettings);
+  connect(ui->yuvFormatComboBox,
+          QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+          &AvifencPrefWidget::saveSettings);
+  connect(ui->codecComboBox,
+          QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+          &AvifencPrefWidget::saveSettings);
+  connect(ui->autoTilingCheckBox, &QCheckBox::toggled, this,
+          &AvifencPrefWidget::saveSettings);
+  connect(ui->tileRowsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+          this, &AvifencPrefWidget::saveSettings);
+  connect(ui->tileColsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+          this, &AvifencPrefWidget::saveSettings);
+  connect(ui->jobsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this,
+          &AvifencPrefWidget::saveSettings);
+
+  // Connect UI update signals
+  connect(ui->losslessCheckBox, &QCheckBox::toggled, this,
+          &AvifencPrefWidget::updateLossyControls);
+  connect(ui->autoTilingCheckBox, &QCheckBox::toggled, this,
+          &AvifencPrefWidget::updateTileControls);
+  connect(ui->qualitySlider, &QSlider::valueChanged, this,
+          &AvifencPrefWidget::updateQualityLabel);
+
+  // Initial UI state
+  updateLossyControls(ui->losslessCheckBox->isChecked());
+  updateTileControls(ui->autoTilingCheckBox->isChecked());
+  updateQualityLabel(ui->qualitySlider->value());
+}
+
+AvifencPrefWidget::~AvifencPrefWidget() { delete ui; }
+
+void AvifencPrefWidget::loadSettings() {
+  const QSettings &settings = m_settings.getSettings();
+
+  // Quality
+  ui->losslessCheckBox->setChecked(
+      settings.value("avifenc/lossless", false).toBool());
+  ui->qualitySlider->setValue(settings.value("avifenc/quality", 60).toInt());
+  ui->speedSpinBox->setValue(settings.value("avifenc/speed", 6).toInt());
+  ui->yuvFormatComboBox->setCurrentIndex(
+      settings.value("avifenc/yuvFormat", 2).toInt());
+
+  // Encoder
+  ui->codecComboBox->setCurrentIndex(
+      settings.value("avifenc/codec", 0).toInt());
+
+  // Tiles and threads
+  ui->autoTilingCheckBox->setChecked(
+      settings.value("avifenc/autoTiling", true).toBool());
+  ui->tileRowsSpinBox->setValue(
+      settings.value("avifenc/tileRowsLog2", 0).toInt());
+  ui->tileColsSpinBox->setValue(
+      settings.value("avifenc/tileColsLog2", 0).toInt());
+  ui->jobsSpinBox->setValue(settings.value("avifenc/jobs", 2).toInt());
+}
+
+void AvifencPrefWidget::saveSettings() {
+  // Don't save to global settings if auto-save is disabled (used in detail panel)
+  if (!m_autoSaveEnabled) {
+    return;
+  }
+
+  QSettings &settings = const_cast<QSettings &>(m_settings.getSettings());
+
+  settings.setValue("avifenc/lossless", ui->losslessCheckBox->isChecked());
+  settings.setValue("avifenc/quality", ui->qualitySlider->value());
+  settings.setValue("avifenc/speed", ui->speedSpinBox->value());
+  settings.setValue("avifenc/yuvFormat", ui->yuvFormatComboBox->currentIndex());
+  settings.setValue("avifenc/codec", ui->codecComboBox->currentIndex());
+  settings.setValue("avifenc/autoTiling", ui->autoTilingCheckBox->isChecked());
+  settings.setValue("avifenc/tileRowsLog2", ui->tileRowsSpinBox->value());
+  settings.setValue("avifenc/tileColsLog2", ui->tileColsSpinBox->value());
+  settings.setValue("avifenc/jobs", ui->jobsSpinBox->value());
+
+  settings.sync();
+}
+
+void AvifencPrefWidget::updateLossyControls(bool lossless) {
+  // Lossless sets quality and 4:4:4 itself
+  ui->qualitySlider->setEnabled(!lossless);
+  ui->yuvFormatComboBox->setEnabled(!lossless);
+}
+
+void AvifencPrefWidget::updateTileControls(bool autoTiling) {
+  ui->tileRowsSpinBox->setEnabled(!autoTiling);
+  ui->tileColsSpinBox->setEnabled(!autoTiling);
+}
+
+void AvifencPrefWidget::updateQualityLabel(int value) {
+  ui->qualityValueLabel->setText(QString::number(value));
+}
+
+void AvifencPrefWidget::setControlSignalsBlocked(bool blocked) {
+  ui->losslessCheckBox->blockSignals(blocked);
+  ui->qualitySlider->blockSignals(blocked);
+  ui->speedSpinBox->blockSignals(blocked);
+  ui->yuvFormatComboBox->blockSignals(blocked);
+  ui->codecComboBox->blockSignals(blocked);
+  ui->autoTilingCheckBox->blockSignals(blocked);
+  ui->tileRowsSpinBox->blockSignals(blocked);
+  ui->tileColsSpinBox->blockSignals(blocked);
+  ui->jobsSpinBox->blockSignals(blocked);
+}
+
+void AvifencPrefWidget::loadCustomSettings(const QVariantMap &settings) {
+  // Block signals to prevent auto-save while loading
+  setControlSignalsBlocked(true);
+
+  ui->losslessCheckBox->setChecked(settings.value("avifenc/lossless", false).toBool());
+  ui->qualitySlider->setValue(settings.value("avifenc/quality", 60).toInt());
+  ui->speedSpinBox->setValue(settings.value("avifenc/speed", 6).toInt());
+  ui->yuvFormatComboBox->setCurrentIndex(settings.value("avifenc/yuvFormat", 2).toInt());
+  ui->codecComboBox->setCurrentIndex(settings.value("avifenc/codec", 0).toInt());
+  ui->autoTilingCheckBox->setChecked(settings.value("avifenc/autoTiling", true).toBool());
+  ui->tileRowsSpinBox->setValue(settings.value("avifenc/tileRowsLog2", 0).toInt());
+  ui->tileColsSpinBox->setValue(settings.value("avifenc/tileColsLog2", 0).toInt());
+  ui->jobsSpinBox->setValue(settings.value("avifenc/jobs", 2).toInt());
+
+  // Update controls state
+  updateLossyControls(ui->losslessCheckBox->isChecked());
+  updateTileControls(ui->autoTilingCheckBox->isChecked());
+  updateQualityLabel(ui->qualitySlider->value());
+
+  // Unblock signals
+  setControlSignalsBlocked(false);
+}
+
+QVariantMap AvifencPrefWidget::getCurrentSettings() const {
+  QVariantMap settings;
+
+  settings["avifenc/lossless"] = ui->losslessCheckBox->isChecked();
+  settings["avifenc/quality"] = ui->qualitySlider->value();
+  settings["avifenc/speed"] = ui->speedSpinBox->value();
+  settings["avifenc/yuvFormat"] = ui->yuvFormatComboBox->currentIndex();
+  settings["avifenc/codec"] = ui->codecComboBox->currentIndex();
+  settings["avifenc/autoTiling"] = ui->autoTilingCheckBox->isChecked();
+  settings["avifenc/tileRowsLog2"] = ui->tileRowsSpinBox->value();
+  settings["avifenc/tileColsLog2"] = ui->tileColsSpinBox->value();
+  settings["avifenc/jobs"] = ui->jobsSpinBox->value();
+
+  return settings;
+}
+
+void AvifencPrefWidget::setAutoSaveEnabled(bool enabled) {
+  m_autoSaveEnabled = enabled;
+}
+
+void AvifencPrefWidget::restoreDefaults() {
+  // Block signals
+  setControlSignalsBlocked(true);
+
+  // Set default values
+  ui->losslessCheckBox->setChecked(false);
+  ui->qualitySlider->setValue(60);  // Close to JPEG 85-90
+  ui->speedSpinBox->setValue(6);  // Balanced
+  ui->yuvFormatComboBox->setCurrentIndex(2);  // 4:2:0
+  ui->codecComboBox->setCurrentIndex(0);  // libavif default
+  ui->autoTilingCheckBox->setChecked(true);
+  ui->tileRowsSpinBox->setValue(0);
+  ui->tileColsSpinBox->setValue(0);
+  ui->jobsSpinBox->setValue(2);
+
+  // Update controls state
+  updateLossyControls(false);
+  updateTileControls(true);
+  updateQualityLabel(60);
+
+  // Unblock signals
+  setControlSignalsBlocked(false);
+
+  // Save defaults to QSettings
+  saveSettings();
+}
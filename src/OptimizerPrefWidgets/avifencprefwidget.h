@@ -0,0 +1,40 @@
+#ifndef AVIFENCPREFWIDGET_H
+#define AVIFENCPREFWIDGET_H
+
+#include "imageoptimizerprefwidget.h"
+#include "settings.h"
+
+#include <QWidget>
+
+namespace Ui {
+class AvifencPrefWidget;
+}
+
+class AvifencPrefWidget : public ImageOptimizerPrefWidget {
+  Q_OBJECT
+
+public:
+  explicit AvifencPrefWidget(QWidget *parent = nullptr);
+  ~AvifencPrefWidget();
+
+  void loadSettings() override;
+  void loadCustomSettings(const QVariantMap &settings) override;
+  QVariantMap getCurrentSettings() const override;
+  void setAutoSaveEnabled(bool enabled) override;
+  void restoreDefaults() override;
+
+private slots:
+  void saveSettings();
+  void updateLossyControls(bool lossless);
+  void updateTileControls(bool autoTiling);
+  void updateQualityLabel(int value);
+
+private:
+  Ui::AvifencPrefWidget *ui;
+  Settings &m_settings;
+  bool m_autoSaveEnabled = true;
+
+  void setControlSignalsBlocked(bool blocked);
+};
+
+#endif // AVIFENCPREFWIDGET_H
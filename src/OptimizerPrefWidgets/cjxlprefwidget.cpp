@@ -0,0 +1,108 @@
+#include "cjxlprefwidget.h"
+#include "ui_cjxlprefwidget.h"
+
+CjxlPrefWidget::CjxlPrefWidget(QWidget *parent)
+    : ImageOptimizerPrefWidget(parent), ui(new Ui::CjxlPrefWidget),
+      m_settings(Settings::instance()) {
+  ui->setupUi(this);
+
+  // Load settings
+  loadSettings();
+
+  // Connect signals for auto-save
+  connect(ui->effortSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+          this, &CjxlPrefWidget::saveSettings);
+  connect(ui->brotliEffortSpinBox,
+          QOverload<int>::of(&QSpinBox::valueChanged), this,
+          &CjxlPrefWidget::saveSettings);
+  connect(ui->threadsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+          this, &CjxlPrefWidget::saveSettings);
+  connect(ui->verifyCheckBox, &QCheckBox::toggled, this,
+          &CjxlPrefWidget::saveSettings);
+}
+
+CjxlPrefWidget::~CjxlPrefWidget() { delete ui; }
+
+void CjxlPrefWidget::loadSettings() {
+  const QSettings &settings = m_settings.getSettings();
+
+  ui->effortSpinBox->setValue(settings.value("cjxl/effort", 7).toInt());
+  ui->brotliEffortSpinBox->setValue(
+      settings.value("cjxl/brotliEffort", 9).toInt());
+  ui->threadsSpinBox->setValue(settings.value("cjxl/threads", 2).toInt());
+  ui->verifyCheckBox->setChecked(
+      settings.value("cjxl/verify", true).toBool());
+}
+
+void CjxlPrefWidget::saveSettings() {
+  // Don't save to global settings if auto-save is disabled (used in detail panel)
+  if (!m_autoSaveEnabled) {
+    return;
+  }
+
+  QSettings &settings = const_cast<QSettings &>(m_settings.getSettings());
+
+  settings.setValue("cjxl/effort", ui->effortSpinBox->value());
+  settings.setValue("cjxl/brotliEffort", ui->brotliEffortSpinBox->value());
+  settings.setValue("cjxl/threads", ui->threadsSpinBox->value());
+  settings.setValue("cjxl/verify", ui->verifyCheckBox->isChecked());
+
+  settings.sync();
+}
+
+void CjxlPrefWidget::loadCustomSettings(const QVariantMap &settings) {
+  // Block signals to prevent auto-save while loading
+  ui->effortSpinBox->blockSignals(true);
+  ui->brotliEffortSpinBox->blockSignals(true);
+  ui->threadsSpinBox->blockSignals(true);
+  ui->verifyCheckBox->blockSignals(true);
+
+  ui->effortSpinBox->setValue(settings.value("cjxl/effort", 7).toInt());
+  ui->brotliEffortSpinBox->setValue(settings.value("cjxl/brotliEffort", 9).toInt());
+  ui->threadsSpinBox->setValue(settings.value("cjxl/threads", 2).toInt());
+  ui->verifyCheckBox->setChecked(settings.value("cjxl/verify", true).toBool());
+
+  // Unblock signals
+  ui->effortSpinBox->blockSignals(false);
+  ui->brotliEffortSpinBox->blockSignals(false);
+  ui->threadsSpinBox->blockSignals(false);
+  ui->verifyCheckBox->blockSignals(false);
+}
+
+QVariantMap CjxlPrefWidget::getCurrentSettings() const {
+  QVariantMap settings;
+
+  settings["cjxl/effort"] = ui->effortSpinBox->value();
+  settings["cjxl/brotliEffort"] = ui->brotliEffortSpinBox->value();
+  settings["cjxl/threads"] = ui->threadsSpinBox->value();
+  settings["cjxl/verify"] = ui->verifyCheckBox->isChecked();
+
+  return settings;
+}
+
+void CjxlPrefWidget::setAutoSaveEnabled(bool enabled) {
+  m_autoSaveEnabled = enabled;
+}
+
+void CjxlPrefWidget::restoreDefaults() {
+  // Block signals
+  ui->effortSpinBox->blockSignals(true);
+  ui->brotliEffortSpinBox->blockSignals(true);
+  ui->threadsSpinBox->blockSignals(true);
+  ui->verifyCheckBox->blockSignals(true);
+
+  // Set default values
+  ui->effortSpinBox->setValue(7);  // cjxl default
+  ui->brotliEffortSpinBox->setValue(9);  // cjxl default
+  ui->threadsSpinBox->setValue(2);
+  ui->verifyCheckBox->setChecked(true);
+
+  // Unblock signals
+  ui->effortSpinBox->blockSignals(false);
+  ui->brotliEffortSpinBox->blockSignals(false);
+  ui->threadsSpinBox->blockSignals(false);
+  ui->verifyCheckBox->blockSignals(false);
+
+  // Save defaults to QSettings
+  saveSettings();
+}
@@ -0,0 +1,35 @@
+#ifndef CJXLPREFWIDGET_H
+#define CJXLPREFWIDGET_H
+
+#include "imageoptimizerprefwidget.h"
+#include "settings.h"
+
+#include <QWidget>
+
+namespace Ui {
+class CjxlPrefWidget;
+}
+
+class CjxlPrefWidget : public ImageOptimizerPrefWidget {
+  Q_OBJECT
+
+public:
+  explicit CjxlPrefWidget(QWidget *parent = nullptr);
+  ~CjxlPrefWidget();
+
+  void loadSettings() override;
+  void loadCustomSettings(const QVariantMap &settings) override;
+  QVariantMap getCurrentSettings() const override;
+  void setAutoSaveEnabled(bool enabled) override;
+  void restoreDefaults() override;
+
+private slots:
+  void saveSettings();
+
+private:
+  Ui::CjxlPrefWidget *ui;
+  Settings &m_settings;
+  bool m_autoSaveEnabled = true;
+};
+
+#endif // CJXLPREFWIDGET_H
@@ -0,0 +1,193 @@
+#include "cwebpprefwidget.h"
+#include "ui_cwebpprefwidget.h"
+
+CwebpPrefWidget::CwebpPrefWidget(QWidget *parent)
+    : ImageOptimizerPrefWidget(parent), ui(new Ui::CwebpPrefWidget),
+      m_settings(Settings::instance()) {
+  ui->setupUi(this);
+
+  // Load settings
+  loadSettings();
+
+  // Connect signals for auto-save
+  connect(ui->losslessRadio, &QRadioButton::toggled, this,
+          &CwebpPrefWidget::saveSettings);
+  connect(ui->qualitySlider, &QSlider::valueChanged, this,
+          &CwebpPrefWidget::saveSettings);
+  connect(ui->methodSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+          this, &CwebpPrefWidget::saveSettings);
+  connect(ui->alphaQualitySpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+          this, &CwebpPrefWidget::saveSettings);
+  connect(ui->exactAlphaCheckBox, &QCheckBox::toggled, this,
+          &CwebpPrefWidget::saveSettings);
+  connect(ui->metadataComboBox,
+          QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+          &CwebpPrefWidget::saveSettings);
+  connect(ui->multiThreadedCheckBox, &QCheckBox::toggled, this,
+          &CwebpPrefWidget::saveSettings);
+
+  // Connect UI update signals
+  connect(ui->losslessRadio, &QRadioButton::toggled, this,
+          &CwebpPrefWidget::updateLossyControls);
+  connect(ui->qualitySlider, &QSlider::valueChanged, this,
+          &CwebpPrefWidget::updateQualityLabel);
+
+  // Initial UI state
+  updateLossyControls(ui->losslessRadio->isChecked());
+  updateQualityLabel(ui->qualitySlider->value());
+}
+
+CwebpPrefWidget::~CwebpPrefWidget() { delete ui; }
+
+void CwebpPrefWidget::loadSettings() {
+  const QSettings &settings = m_settings.getSettings();
+
+  // Compression type
+  if (settings.value("cwebp/lossless", false).toBool()) {
+    ui->losslessRadio->setChecked(true);
+  } else {
+    ui->lossyRadio->setChecked(true);
+  }
+
+  // Quality
+  ui->qualitySlider->setValue(settings.value("cwebp/quality", 80).toInt());
+  ui->methodSpinBox->setValue(settings.value("cwebp/method", 4).toInt());
+
+  // Transparency
+  ui->alphaQualitySpinBox->setValue(
+      settings.value("cwebp/alphaQuality", 100).toInt());
+  ui->exactAlphaCheckBox->setChecked(
+      settings.value("cwebp/exactAlpha", false).toBool());
+
+  // Metadata
+  ui->metadataComboBox->setCurrentIndex(
+      settings.value("cwebp/metadataMode", 1).toInt());
+
+  // Performance
+  ui->multiThreadedCheckBox->setChecked(
+      settings.value("cwebp/multiThreaded", true).toBool());
+}
+
+void CwebpPrefWidget::saveSettings() {
+  // Don't save to global settings if auto-save is disabled (used in detail panel)
+  if (!m_autoSaveEnabled) {
+    return;
+  }
+
+  QSettings &settings = const_cast<QSettings &>(m_settings.getSettings());
+
+  settings.setValue("cwebp/lossless", ui->losslessRadio->isChecked());
+  settings.setValue("cwebp/quality", ui->qualitySlider->value());
+  settings.setValue("cwebp/method", ui->methodSpinBox->value());
+  settings.setValue("cwebp/alphaQuality", ui->alphaQualitySpinBox->value());
+  settings.setValue("cwebp/exactAlpha", ui->exactAlphaCheckBox->isChecked());
+  settings.setValue("cwebp/metadataMode",
+                    ui->metadataComboBox->currentIndex());
+  settings.setValue("cwebp/multiThreaded",
+                    ui->multiThreadedCheckBox->isChecked());
+
+  settings.sync();
+}
+
+void CwebpPrefWidget::updateLossyControls(bool lossless) {
+  // Lossless alpha is lossless already
+  ui->alphaQualitySpinBox->setEnabled(!lossless);
+  ui->qualityLabel->setText(lossless ? tr("Effort:") : tr("Quality:"));
+}
+
+void CwebpPrefWidget::updateQualityLabel(int value) {
+  ui->qualityValueLabel->setText(QString::number(value));
+}
+
+void CwebpPrefWidget::loadCustomSettings(const QVariantMap &settings) {
+  // Block signals to prevent auto-save while loading
+  ui->losslessRadio->blockSignals(true);
+  ui->lossyRadio->blockSignals(true);
+  ui->qualitySlider->blockSignals(true);
+  ui->methodSpinBox->blockSignals(true);
+  ui->alphaQualitySpinBox->blockSignals(true);
+  ui->exactAlphaCheckBox->blockSignals(true);
+  ui->metadataComboBox->blockSignals(true);
+  ui->multiThreadedCheckBox->blockSignals(true);
+
+  bool lossless = settings.value("cwebp/lossless", false).toBool();
+  if (lossless) ui->losslessRadio->setChecked(true);
+  else ui->lossyRadio->setChecked(true);
+
+  ui->qualitySlider->setValue(settings.value("cwebp/quality", 80).toInt());
+  ui->methodSpinBox->setValue(settings.value("cwebp/method", 4).toInt());
+  ui->alphaQualitySpinBox->setValue(settings.value("cwebp/alphaQuality", 100).toInt());
+  ui->exactAlphaCheckBox->setChecked(settings.value("cwebp/exactAlpha", false).toBool());
+  ui->metadataComboBox->setCurrentIndex(settings.value("cwebp/metadataMode", 1).toInt());
+  ui->multiThreadedCheckBox->setChecked(settings.value("cwebp/multiThreaded", true).toBool());
+
+  // Update controls state
+  updateLossyControls(lossless);
+  updateQualityLabel(ui->qualitySlider->value());
+
+  // Unblock signals
+  ui->losslessRadio->blockSignals(false);
+  ui->lossyRadio->blockSignals(false);
+  ui->qualitySlider->blockSignals(false);
+  ui->methodSpinBox->blockSignals(false);
+  ui->alphaQualitySpinBox->blockSignals(false);
+  ui->exactAlphaCheckBox->blockSignals(false);
+  ui->metadataComboBox->blockSignals(false);
+  ui->multiThreadedCheckBox->blockSignals(false);
+}
+
+QVariantMap CwebpPrefWidget::getCurrentSettings() const {
+  QVariantMap settings;
+
+  settings["cwebp/lossless"] = ui->losslessRadio->isChecked();
+  settings["cwebp/quality"] = ui->qualitySlider->value();
+  settings["cwebp/method"] = ui->methodSpinBox->value();
+  settings["cwebp/alphaQuality"] = ui->alphaQualitySpinBox->value();
+  settings["cwebp/exactAlpha"] = ui->exactAlphaCheckBox->isChecked();
+  settings["cwebp/metadataMode"] = ui->metadataComboBox->currentIndex();
+  settings["cwebp/multiThreaded"] = ui->multiThreadedCheckBox->isChecked();
+
+  return settings;
+}
+
+void CwebpPrefWidget::setAutoSaveEnabled(bool enabled) {
+  m_autoSaveEnabled = enabled;
+}
+
+void CwebpPrefWidget::restoreDefaults() {
+  // Block signals
+  ui->losslessRadio->blockSignals(true);
+  ui->lossyRadio->blockSignals(true);
+  ui->qualitySlider->blockSignals(true);
+  ui->methodSpinBox->blockSignals(true);
+  ui->alphaQualitySpinBox->blockSignals(true);
+  ui->exactAlphaCheckBox->blockSignals(true);
+  ui->metadataComboBox->blockSignals(true);
+  ui->multiThreadedCheckBox->blockSignals(true);
+
+  // Set default values
+  ui->lossyRadio->setChecked(true);  // Lossy
+  ui->qualitySlider->setValue(80);  // Good for most photos
+  ui->methodSpinBox->setValue(4);  // Balanced
+  ui->alphaQualitySpinBox->setValue(100);  // Lossless alpha
+  ui->exactAlphaCheckBox->setChecked(false);
+  ui->metadataComboBox->setCurrentIndex(1);  // Keep ICC only
+  ui->multiThreadedCheckBox->setChecked(true);
+
+  // Update controls state
+  updateLossyControls(false);
+  updateQualityLabel(80);
+
+  // Unblock signals
+  ui->losslessRadio->blockSignals(false);
+  ui->lossyRadio->blockSignals(false);
+  ui->qualitySlider->blockSignals(false);
+  ui->methodSpinBox->blockSignals(false);
+  ui->alphaQualitySpinBox->blockSignals(false);
+  ui->exactAlphaCheckBox->blockSignals(false);
+  ui->metadataComboBox->blockSignals(false);
+  ui->multiThreadedCheckBox->blockSignals(false);
+
+  // Save defaults to QSettings
+  saveSettings();
+}
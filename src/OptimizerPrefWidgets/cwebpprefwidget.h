@@ -0,0 +1,37 @@
+#ifndef CWEBPPREFWIDGET_H
+#define CWEBPPREFWIDGET_H
+
+#include "imageoptimizerprefwidget.h"
+#include "settings.h"
+
+#include <QWidget>
+
+namespace Ui {
+class CwebpPrefWidget;
+}
+
+class CwebpPrefWidget : public ImageOptimizerPrefWidget {
+  Q_OBJECT
+
+public:
+  explicit CwebpPrefWidget(QWidget *parent = nullptr);
+  ~CwebpPrefWidget();
+
+  void loadSettings() override;
+  void loadCustomSettings(const QVariantMap &settings) override;
+  QVariantMap getCurrentSettings() const override;
+  void setAutoSaveEnabled(bool enabled) override;
+  void restoreDefaults() override;
+
+private slots:
+  void saveSettings();
+  void updateLossyControls(bool lossless);
+  void updateQualityLabel(int value);
+
+private:
+  Ui::CwebpPrefWidget *ui;
+  Settings &m_settings;
+  bool m_autoSaveEnabled = true;
+};
+
+#endif // CWEBPPREFWIDGET_H
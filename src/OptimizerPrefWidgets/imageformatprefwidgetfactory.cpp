@@ -1,4 +1,7 @@
 #include "imageformatprefwidgetfactory.h"
+#include "cwebpprefwidget.h"
+#include "avifencprefwidget.h"
+#include "cjxlprefwidget.h"
 #include "gifsicleprefwidget.h"
 #include "jpegoptimprefwidget.h"
 #include "pngquantprefwidget.h"
@@ -179,6 +182,21 @@ void ImageFormatPrefWidgetFactory::registerOptimizers() {
           [](QWidget *parent) -> ImageOptimizerPrefWidget * {
         return new SvgoPrefWidget(parent);
       };
+    } else if (optimizerName == "Cwebp") {
+      optimizerWidgetMap[optimizerName] =
+          [](QWidget *parent) -> ImageOptimizerPrefWidget * {
+        return new CwebpPrefWidget(parent);
+      };
+    } else if (optimizerName == "Avifenc") {
+      optimizerWidgetMap[optimizerName] =
+          [](QWidget *parent) -> ImageOptimizerPrefWidget * {
+        return new AvifencPrefWidget(parent);
+      };
+    } else if (optimizerName == "Cjxl") {
+      optimizerWidgetMap[optimizerName] =
+          [](QWidget *parent) -> ImageOptimizerPrefWidget * {
+        return new CjxlPrefWidget(parent);
+      };
     }
   }
 }
@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -45,28 +45,62 @@ SOURCES += \
     OptimizerPrefWidgets/pngquantprefwidget.cpp \
     OptimizerPrefWidgets/gifsicleprefwidget.cpp \
     OptimizerPrefWidgets/svgoprefwidget.cpp \
+    OptimizerPrefWidgets/cwebpprefwidget.cpp \
+    OptimizerPrefWidgets/avifencprefwidget.cpp \
+    OptimizerPrefWidgets/cjxlprefwidget.cpp \
     about.cpp \
     constants.cpp \
+    batchjournal.cpp \
+    commitpolicy.cpp \
     desktoputils.cpp \
+    differenceheatmap.cpp \
     draggablelabel.cpp \
     elideditemdelegate.cpp \
     emptystatewidget.cpp \
     filehandler.cpp \
+    folderwatcher.cpp \
     imagecomparisonwidget.cpp \
     imagedetailpanel.cpp \
     imageformatprefwidget.cpp \
+    imagepyramid.cpp \
     imagestats.cpp \
+    imagetask.cpp \
     main.cpp \
+    outputlinker.cpp \
     pixelbatch.cpp \
     preferenceswidget.cpp \
+    previewloader.cpp \
     settings.cpp \
     taskactionwidget.cpp \
     taskwidget.cpp \
     taskwidgetoverlay.cpp \
+    thumbnailcache.cpp \
+    tiledimageview.cpp \
+    watchfoldersdialog.cpp \
+    workagent.cpp \
+    workcoordinator.cpp \
+    workprotocol.cpp \
     worker/imageoptimizer.cpp \
     worker/imageworkerfactory.cpp \
     worker/jpegoptimworker.cpp \
     worker/pngquantworker.cpp \
+    worker/qualityanalyzer.cpp \
+    worker/qualitymetrics.cpp \
+    worker/qualitysearchworker.cpp \
+    worker/remoteworker.cpp \
+    worker/resourcegovernor.cpp \
+    worker/settingssnapshot.cpp \
+    worker/headeranalyzer.cpp \
+    worker/imageheader.cpp \
+    worker/metadatastripper.cpp \
+    worker/metadatastripworker.cpp \
+    worker/resampler.cpp \
+    worker/resizeworker.cpp \
+    worker/variantworker.cpp \
+    worker/cwebpworker.cpp \
+    worker/avifencworker.cpp \
+    worker/cjxlworker.cpp \
+    worker/jpegreconstructor.cpp \
     worker/gifsicleworker.cpp \
     worker/svgoworker.cpp
 
@@ -77,31 +111,64 @@ HEADERS += \
     OptimizerPrefWidgets/pngquantprefwidget.h \
     OptimizerPrefWidgets/gifsicleprefwidget.h \
     OptimizerPrefWidgets/svgoprefwidget.h \
+    OptimizerPrefWidgets/cwebpprefwidget.h \
+    OptimizerPrefWidgets/avifencprefwidget.h \
+    OptimizerPrefWidgets/cjxlprefwidget.h \
     about.h \
+    batchjournal.h \
+    commitpolicy.h \
     constants.h \
     desktoputils.h \
+    differenceheatmap.h \
     draggablelabel.h \
     emptystatewidget.h \
     elideditemdelegate.h \
     filehandler.h \
+    folderwatcher.h \
     imagecomparisonwidget.h \
     imagedetailpanel.h \
     imageformatprefwidget.h \
+    imagepyramid.h \
     imagestats.h \
     imagetask.h \
     imagetype.h \
+    outputlinker.h \
     pixelbatch.h \
     preferenceswidget.h \
+    previewloader.h \
     settings.h \
     taskactionwidget.h \
     taskwidget.h \
     taskwidgetoverlay.h \
     thememanager.h \
+    thumbnailcache.h \
+    tiledimageview.h \
+    watchfoldersdialog.h \
+    workagent.h \
+    workcoordinator.h \
+    workprotocol.h \
     worker/ImageWorker.h \
     worker/imageoptimizer.h \
     worker/imageworkerfactory.h \
     worker/jpegoptimworker.h \
     worker/pngquantworker.h \
+    worker/qualityanalyzer.h \
+    worker/qualitymetrics.h \
+    worker/qualitysearchworker.h \
+    worker/remoteworker.h \
+    worker/resourcegovernor.h \
+    worker/settingssnapshot.h \
+    worker/headeranalyzer.h \
+    worker/imageheader.h \
+    worker/metadatastripper.h \
+    worker/metadatastripworker.h \
+    worker/resampler.h \
+    worker/resizeworker.h \
+    worker/variantworker.h \
+    worker/cwebpworker.h \
+    worker/avifencworker.h \
+    worker/cjxlworker.h \
+    worker/jpegreconstructor.h \
     worker/gifsicleworker.h \
     worker/svgoworker.h
 
@@ -110,6 +177,9 @@ FORMS += \
     OptimizerPrefWidgets/pngquantprefwidget.ui \
     OptimizerPrefWidgets/gifsicleprefwidget.ui \
     OptimizerPrefWidgets/svgoprefwidget.ui \
+    OptimizerPrefWidgets/cwebpprefwidget.ui \
+    OptimizerPrefWidgets/avifencprefwidget.ui \
+    OptimizerPrefWidgets/cjxlprefwidget.ui \
     about.ui \
     imageformatprefwidget.ui \
     pixelbatch.ui \
@@ -0,0 +1,314 @@
+#include "batchjournal.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QMetaObject>
+#include <QPointer>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+namespace {
+
+const QString EVENT_QUEUED = "queued";
+const QString EVENT_STARTED = "started";
+const QString EVENT_COMMITTED = "committed";
+const QString EVENT_FAILED = "failed";
+const QString EVENT_REMOVED = "removed";
+const QString EVENT_HASHED = "hashed";
+
+QString sha1OfFile(const QString &filePath) {
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return QString();
+  }
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(&file);
+  return QString::fromLatin1(hash.result().toHex());
+}
+
+// Hashes a committed output, the result is posted to the GUI thread
+class HashJob : public QRunnable {
+public:
+  typedef std::function<void(const QString &)> Deliver;
+
+  HashJob(const QString &filePath, Deliver deliver)
+      : m_filePath(filePath), m_deliver(deliver) {}
+
+  void run() override {
+    QString sha1 = sha1OfFile(m_filePath);
+    auto deliver = m_deliver;
+    QMetaObject::invokeMethod(
+        QCoreApplication::instance(), [deliver, sha1]() { deliver(sha1); },
+        Qt::QueuedConnection);
+  }
+
+private:
+  QString m_filePath;
+  Deliver m_deliver;
+};
+
+class ReplayJob : public QRunnable {
+public:
+  typedef std::function<void(const QList<BatchJournal::Entry> &)> Deliver;
+
+  ReplayJob(const QString &filePath, Deliver deliver)
+      : m_filePath(filePath), m_deliver(deliver) {}
+
+  void run() override {
+    QList<BatchJournal::Entry> entries =
+        BatchJournal::unfinishedEntries(m_filePath);
+    auto deliver = m_deliver;
+    QMetaObject::invokeMethod(
+        QCoreApplication::instance(),
+        [deliver, entries]() { deliver(entries); }, Qt::QueuedConnection);
+  }
+
+private:
+  QString m_filePath;
+  Deliver m_deliver;
+};
+
+} // namespace
+
+BatchJournal::BatchJournal(const QString &filePath)
+    : m_filePath(filePath), m_enabled(true) {
+  resetHashState();
+}
+
+BatchJournal::~BatchJournal() {
+  m_hashState->journal = nullptr;
+  m_file.close();
+}
+
+void BatchJournal::resetHashState() {
+  if (m_hashState) {
+    m_hashState->journal = nullptr;
+  }
+  m_hashState = std::make_shared<HashState>();
+  m_hashState->journal = this;
+}
+
+QString BatchJournal::defaultFilePath() {
+  return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+         "/batch.journal";
+}
+
+void BatchJournal::setEnabled(bool enabled) {
+  if (enabled == m_enabled) {
+    return;
+  }
+  if (!enabled) {
+    clear();
+  }
+  m_enabled = enabled;
+}
+
+bool BatchJournal::isEnabled() const { return m_enabled; }
+
+void BatchJournal::recordQueued(const ImageTask *task) {
+  QJsonObject record;
+  if (!task->customOutputDir.isEmpty()) {
+    record["outputDir"] = task->customOutputDir;
+  }
+  if (!task->customOutputPrefix.isEmpty()) {
+    record["outputPrefix"] = task->customOutputPrefix;
+  }
+  if (task->hasCustomOptimizerSettings()) {
+    record["optimizerSettings"] =
+        QJsonObject::fromVariantMap(task->customOptimizerSettings);
+  }
+  append(EVENT_QUEUED, task->imagePath(), record);
+}
+
+void BatchJournal::recordStarted(const ImageTask *task) {
+  append(EVENT_STARTED, task->imagePath());
+}
+
+void BatchJournal::recordCommitted(const ImageTask *task) {
+  if (!m_enabled) {
+    return;
+  }
+  QJsonObject record;
+  if (task->commitOutcome == ImageTask::OutputDiscarded) {
+    // Done, there is just no output to check on replay
+    record["discarded"] = true;
+  } else {
+    record["output"] = task->optimizedPath();
+    record["size"] = QFileInfo(task->optimizedPath()).size();
+  }
+  append(EVENT_COMMITTED, task->imagePath(), record);
+  if (task->commitOutcome == ImageTask::OutputDiscarded) {
+    return;
+  }
+
+  // Until the hash is in, replay checks the size only
+  std::shared_ptr<HashState> state = m_hashState;
+  QString imagePath = task->imagePath();
+  QString outputPath = task->optimizedPath();
+  QThreadPool::globalInstance()->start(new HashJob(
+      outputPath, [state, imagePath, outputPath](const QString &sha1) {
+        if (!state->journal || sha1.isEmpty()) {
+          return;
+        }
+        QJsonObject record;
+        record["output"] = outputPath;
+        record["sha1"] = sha1;
+        state->journal->append(EVENT_HASHED, imagePath, record);
+      }));
+}
+
+void BatchJournal::recordFailed(const ImageTask *task,
+                                const QString &errorString) {
+  QJsonObject record;
+  record["error"] = errorString;
+  append(EVENT_FAILED, task->imagePath(), record);
+}
+
+void BatchJournal::recordRemoved(const ImageTask *task) {
+  append(EVENT_REMOVED, task->imagePath());
+}
+
+void BatchJournal::append(const QString &event, const QString &imagePath,
+                          QJsonObject record) {
+  if (!m_enabled) {
+    return;
+  }
+
+  if (!m_file.isOpen()) {
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+      qWarning() << "Unable to open batch journal" << m_filePath << ":"
+                 << m_file.errorString();
+      return;
+    }
+  }
+
+  record["event"] = event;
+  record["image"] = imagePath;
+  record["time"] = QDateTime::currentMSecsSinceEpoch();
+
+  // One write per record, flushed so a kill loses at most the current line
+  m_file.write(QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n');
+  m_file.flush();
+}
+
+QList<BatchJournal::Entry>
+BatchJournal::unfinishedEntries(const QString &filePath) {
+  struct State {
+    Entry entry;
+    QString event;
+    QString outputPath;
+    qint64 outputSize = -1;
+    QString outputSha1;
+  };
+
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return {};
+  }
+
+  QHash<QString, State> states;
+  QStringList order;
+  while (!file.atEnd()) {
+    QByteArray line = file.readLine().trimmed();
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+    if (parseError.error != QJsonParseError::NoError ||
+        !document.isObject()) {
+      // Torn write of a killed session
+      continue;
+    }
+
+    QJsonObject record = document.object();
+    QString imagePath = record["image"].toString();
+    QString event = record["event"].toString();
+    if (imagePath.isEmpty()) {
+      continue;
+    }
+
+    if (!states.contains(imagePath)) {
+      order.append(imagePath);
+    }
+    State &state = states[imagePath];
+    if (event == EVENT_HASHED) {
+      // Late, the task may have been queued again since
+      if (state.event == EVENT_COMMITTED &&
+          state.outputPath == record["output"].toString()) {
+        state.outputSha1 = record["sha1"].toString();
+      }
+      continue;
+    }
+    state.event = event;
+
+    if (event == EVENT_QUEUED) {
+      state.entry.imagePath = imagePath;
+      state.entry.customOutputDir = record["outputDir"].toString();
+      state.entry.customOutputPrefix = record["outputPrefix"].toString();
+      state.entry.customOptimizerSettings =
+          record["optimizerSettings"].toObject().toVariantMap();
+    } else if (event == EVENT_COMMITTED) {
+      state.outputPath = record["output"].toString();
+      state.outputSize = record["size"].toVariant().toLongLong();
+      state.outputSha1.clear();
+    }
+  }
+
+  QList<Entry> entries;
+  for (const QString &imagePath : qAsConst(order)) {
+    const State &state = states[imagePath];
+    // Only tasks queued in this journal can be resumed
+    if (state.entry.imagePath.isEmpty()) {
+      continue;
+    }
+
+    bool unfinished = state.event == EVENT_QUEUED ||
+                      state.event == EVENT_STARTED;
+    if (state.event == EVENT_COMMITTED && !state.outputPath.isEmpty()) {
+      // Deleted or replaced since, redo it
+      QFileInfo outputInfo(state.outputPath);
+      unfinished = !outputInfo.exists() ||
+                   outputInfo.size() != state.outputSize ||
+                   (!state.outputSha1.isEmpty() &&
+                    sha1OfFile(state.outputPath) != state.outputSha1);
+    }
+    if (unfinished) {
+      entries.append(state.entry);
+    }
+  }
+  return entries;
+}
+
+void BatchJournal::findUnfinishedEntries(
+    QObject *context,
+    std::function<void(const QList<Entry> &)> found) const {
+  QPointer<QObject> receiver(context);
+  QThreadPool::globalInstance()->start(new ReplayJob(
+      m_filePath, [receiver, found](const QList<Entry> &entries) {
+        if (receiver) {
+          found(entries);
+        }
+      }));
+}
+
+void BatchJournal::forget(const QList<Entry> &entries) {
+  for (const Entry &entry : entries) {
+    append(EVENT_REMOVED, entry.imagePath);
+  }
+}
+
+void BatchJournal::clear() {
+  // Hashes of the forgotten batch would start a new journal
+  resetHashState();
+  m_file.close();
+  if (QFile::exists(m_filePath) && !QFile::remove(m_filePath)) {
+    qWarning() << "Unable to remove batch journal" << m_filePath;
+  }
+}
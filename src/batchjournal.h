@@ -0,0 +1,80 @@
+#ifndef BATCHJOURNAL_H
+#define BATCHJOURNAL_H
+
+#include "imagetask.h"
+
+#include <QFile>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QVariantMap>
+
+#include <functional>
+#include <memory>
+
+// Append-only record of the tasks of the running batch, one JSON object per
+// line (queued, started, committed with the size of the output, failed,
+// removed). The SHA-1 of a committed output is computed on a pool thread and
+// appended as its own record once known.
+//
+// Every record is flushed as it is written, so when the application is
+// closed, killed or preempted mid batch the next session can replay the file
+// and queue only the work that never committed. A torn last line from a kill
+// is ignored on replay. The file is truncated once a batch finishes.
+class BatchJournal {
+public:
+  struct Entry {
+    QString imagePath;
+    QString customOutputDir;
+    QString customOutputPrefix;
+    QVariantMap customOptimizerSettings;
+  };
+
+  explicit BatchJournal(const QString &filePath = defaultFilePath());
+  ~BatchJournal();
+
+  static QString defaultFilePath();
+
+  // Disabling stops recording and removes the journal
+  void setEnabled(bool enabled);
+  bool isEnabled() const;
+
+  void recordQueued(const ImageTask *task);
+  void recordStarted(const ImageTask *task);
+  void recordCommitted(const ImageTask *task);
+  void recordFailed(const ImageTask *task, const QString &errorString);
+  void recordRemoved(const ImageTask *task);
+
+  // Tasks of an interrupted batch that were queued or started but never
+  // committed, or whose committed output is gone or changed, in queue
+  // order. Hashes the committed outputs, blocks.
+  static QList<Entry> unfinishedEntries(const QString &filePath);
+  // Same on a pool thread, found runs on the GUI thread unless context is
+  // gone by then
+  void findUnfinishedEntries(
+      QObject *context,
+      std::function<void(const QList<Entry> &)> found) const;
+
+  // Forgets the current batch
+  void clear();
+  // Forgets these entries only, records of a batch started since stay
+  void forget(const QList<Entry> &entries);
+
+  // Cleared by the journal when it goes away or forgets the batch, pending
+  // hashes are dropped then
+  struct HashState {
+    BatchJournal *journal;
+  };
+
+private:
+  void append(const QString &event, const QString &imagePath,
+              QJsonObject record = QJsonObject());
+  void resetHashState();
+
+  QString m_filePath;
+  QFile m_file;
+  bool m_enabled;
+  std::shared_ptr<HashState> m_hashState;
+};
+
+#endif // BATCHJOURNAL_H
@@ -0,0 +1,76 @@
+#include "commitpolicy.h"
+#include "settings.h"
+
+#include <worker/imageworkerfactory.h>
+#include <worker/settingssnapshot.h>
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+
+CommitPolicy::CommitPolicy(Action action, double minimumGainPercent,
+                           OutputLinker::Mode linkMode)
+    : m_action(action), m_minimumGainPercent(minimumGainPercent),
+      m_linkMode(linkMode) {}
+
+CommitPolicy CommitPolicy::fromSettings() {
+  Settings &settings = Settings::instance();
+  return CommitPolicy(actionFromInt(settings.getNotSmallerAction()),
+                      settings.getMinimumGainPercent(),
+                      OutputLinker::modeFromSettings());
+}
+
+CommitPolicy::Action CommitPolicy::actionFromInt(int action) {
+  if (action < KeepOriginal || action > KeepOutput) {
+    action = Constants::DEFAULT_TASK_NOT_SMALLER_ACTION;
+  }
+  return static_cast<Action>(action);
+}
+
+bool CommitPolicy::apply(ImageTask *task, QString *errorString) const {
+  task->commitOutcome = ImageTask::OutputCommitted;
+  if (m_action == KeepOutput) {
+    return true;
+  }
+
+  QFileInfo originalInfo(task->imagePath());
+  QFileInfo outputInfo(task->optimizedPath());
+  if (!outputInfo.exists() || originalInfo.size() <= 0 ||
+      originalInfo.canonicalFilePath() == outputInfo.canonicalFilePath()) {
+    return true;
+  }
+
+  qint64 originalSize = originalInfo.size();
+  qint64 outputSize = outputInfo.size();
+  double gainPercent =
+      100.0 * double(originalSize - outputSize) / double(originalSize);
+  if (outputSize < originalSize && gainPercent >= m_minimumGainPercent) {
+    return true;
+  }
+
+  qDebug() << "Output of" << task->imagePath() << "saves" << gainPercent
+           << "%, not keeping it";
+  // The original can't stand in for a conversion, e.g. to WebP, under its
+  // name
+  ImageType imageType = ImageWorkerFactory::instance().getImageType(task);
+  bool converted =
+      task->settingsSnapshot->optimizer(imageType).convertsFormat();
+  QFile::remove(task->optimizedPath());
+  // Metrics described the output that is gone
+  task->hasQualityMetrics = false;
+
+  if (m_action == DiscardOutput || converted) {
+    task->commitOutcome = ImageTask::OutputDiscarded;
+    return true;
+  }
+
+  QString linkError;
+  if (!OutputLinker::materialize(task->imagePath(), task->optimizedPath(),
+                                 m_linkMode, nullptr, &linkError)) {
+    *errorString =
+        QObject::tr("Unable to keep the original: %1").arg(linkError);
+    return false;
+  }
+  task->commitOutcome = ImageTask::OriginalKept;
+  return true;
+}
@@ -0,0 +1,36 @@
+#ifndef COMMITPOLICY_H
+#define COMMITPOLICY_H
+
+#include "imagetask.h"
+#include "outputlinker.h"
+
+#include <QString>
+
+// Decides whether the output of an optimizer is worth keeping.
+//
+// Applied to every successful task, whatever worker produced it (pngquant's
+// --skip-if-larger is the only tool-side check). An output that is not
+// smaller than the original, or saves less than the minimum gain, is
+// replaced by the original (see OutputLinker) or removed; the outcome is
+// stored on the task for the status and the report. An output in another
+// format than the original is always removed then.
+class CommitPolicy {
+public:
+  // Stored as int in Constants::TASK_NOT_SMALLER_ACTION_KEY
+  enum Action { KeepOriginal, DiscardOutput, KeepOutput };
+
+  CommitPolicy(Action action, double minimumGainPercent,
+               OutputLinker::Mode linkMode);
+  static CommitPolicy fromSettings();
+  static Action actionFromInt(int action);
+
+  // False when the original could not be put in place of the output
+  bool apply(ImageTask *task, QString *errorString) const;
+
+private:
+  Action m_action;
+  double m_minimumGainPercent;
+  OutputLinker::Mode m_linkMode;
+};
+
+#endif // COMMITPOLICY_H
@@ -8,6 +8,14 @@ const QString Constants::DEFAULT_OPTIMIZED_PATH = "/tmp/d/";
 const QString Constants::OUTPUT_FILE_PREFIX_KEY = "file/prefix";
 const QString Constants::DEFAULT_OUTPUT_FILE_PREFIX = "optimized_";
 
+// File name of a responsive variant, after the prefix
+const QString Constants::OUTPUT_VARIANT_NAME_KEY = "file/variant_name";
+const QString Constants::DEFAULT_OUTPUT_VARIANT_NAME = "{name}-{width}w.{ext}";
+
+// Optimizer picked for a format, "format/optimizer_jpg", by name. Unset or
+// unknown means the in-format optimizer
+const QString Constants::FORMAT_OPTIMIZER_KEY_PREFIX = "format/optimizer_";
+
 const QString Constants::INPUT_LAST_IMAGE_DIR_PATH_KEY =
     "file/last_opened_image_dir_path";
 const QString Constants::DEFAULT_INPUT_LAST_IMAGE_DIR_PATH =
@@ -21,6 +29,115 @@ const QString Constants::TASK_MAX_CONCURRENT_TASKS_KEY =
     "task/max_concurrent_tasks";
 const int Constants::DEFAULT_TASK_MAX_CONCURRENT_TASKS = 1;
 
+const QString Constants::CACHE_THUMBNAILS_ON_DISK_KEY =
+    "cache/thumbnails_on_disk";
+const bool Constants::DEFAULT_CACHE_THUMBNAILS_ON_DISK = true;
+
+const QString Constants::TASK_BATCH_JOURNAL_KEY = "task/batch_journal";
+const bool Constants::DEFAULT_TASK_BATCH_JOURNAL = true;
+
+const QString Constants::TASK_PIPE_IO_KEY = "task/pipe_io";
+const bool Constants::DEFAULT_TASK_PIPE_IO = true;
+
+const QString Constants::TASK_PREEMPT_FOR_INTERACTIVE_KEY =
+    "task/preempt_for_interactive";
+const bool Constants::DEFAULT_TASK_PREEMPT_FOR_INTERACTIVE = true;
+
+// CommitPolicy::Action, keep the original by default
+const QString Constants::TASK_NOT_SMALLER_ACTION_KEY =
+    "task/not_smaller_action";
+const int Constants::DEFAULT_TASK_NOT_SMALLER_ACTION = 0;
+
+// Percent of the original size an output has to save to count as smaller
+const QString Constants::TASK_MINIMUM_GAIN_KEY = "task/minimum_gain_percent";
+const double Constants::DEFAULT_TASK_MINIMUM_GAIN = 0.0;
+
+// OutputLinker::Mode, reflink or copy by default, hardlinks are opt-in
+const QString Constants::TASK_LINK_UNCHANGED_KEY = "task/link_unchanged";
+const int Constants::DEFAULT_TASK_LINK_UNCHANGED = 1;
+
+// Seconds an optimizer may run on an empty file, "<tool>/timeoutSeconds"
+// so per image settings can override it too. 0 disables the watchdog
+const QString Constants::TOOL_TIMEOUT_KEY_SUFFIX = "/timeoutSeconds";
+const int Constants::DEFAULT_TOOL_TIMEOUT = 60;
+// Animated GIFs, node startup and AV1 encoding take longer
+const QHash<QString, int> Constants::DEFAULT_TOOL_TIMEOUTS = {
+    {"gifsicle", 180}, {"svgo", 90}, {"avifenc", 300}};
+
+// Seconds added to the tool timeout per MiB of input
+const QString Constants::TASK_TIMEOUT_PER_MB_KEY = "task/timeout_per_mb_s";
+const double Constants::DEFAULT_TASK_TIMEOUT_PER_MB = 10.0;
+
+// Times a timed out task is queued again before it counts as failed
+const QString Constants::TASK_TIMEOUT_RETRIES_KEY = "task/timeout_retries";
+const int Constants::DEFAULT_TASK_TIMEOUT_RETRIES = 1;
+
+// MetadataStripper::Mode, off by default so the optimizers decide
+const QString Constants::TASK_STRIP_METADATA_KEY = "task/strip_metadata";
+const int Constants::DEFAULT_TASK_STRIP_METADATA = 0;
+
+// Largest output size in pixels before the optimizer runs, 0 = no limit
+const QString Constants::RESIZE_MAX_WIDTH_KEY = "resize/max_width";
+const int Constants::DEFAULT_RESIZE_MAX_WIDTH = 0;
+
+const QString Constants::RESIZE_MAX_HEIGHT_KEY = "resize/max_height";
+const int Constants::DEFAULT_RESIZE_MAX_HEIGHT = 0;
+
+// Resampler::Filter
+const QString Constants::RESIZE_FILTER_KEY = "resize/filter";
+const int Constants::DEFAULT_RESIZE_FILTER = 0;
+
+// Comma separated widths of responsive variants, empty = none
+const QString Constants::RESIZE_VARIANT_WIDTHS_KEY = "resize/variant_widths";
+const QString Constants::DEFAULT_RESIZE_VARIANT_WIDTHS = "";
+
+// MiB of data segment per optimizer process, 0 disables the limit
+const QString Constants::RESOURCES_MEMORY_LIMIT_KEY =
+    "resources/memory_limit_mb";
+const int Constants::DEFAULT_RESOURCES_MEMORY_LIMIT = 2048;
+
+// CPU seconds per optimizer process, 0 disables the limit
+const QString Constants::RESOURCES_CPU_TIME_LIMIT_KEY =
+    "resources/cpu_time_limit_s";
+const int Constants::DEFAULT_RESOURCES_CPU_TIME_LIMIT = 0;
+
+// nice(1) level of batch optimizer processes, 0 keeps ours
+const QString Constants::RESOURCES_BATCH_NICENESS_KEY =
+    "resources/batch_niceness";
+const int Constants::DEFAULT_RESOURCES_BATCH_NICENESS = 10;
+
+// Idle I/O class for batch optimizer processes (Linux)
+const QString Constants::RESOURCES_BATCH_IDLE_IO_KEY = "resources/idle_io";
+const bool Constants::DEFAULT_RESOURCES_BATCH_IDLE_IO = false;
+
+// MiB all local tasks together may use, 0 disables the budget
+const QString Constants::RESOURCES_MEMORY_BUDGET_KEY =
+    "resources/memory_budget_mb";
+const int Constants::DEFAULT_RESOURCES_MEMORY_BUDGET = 0;
+
+// Threads all local tools together may run on, 0 = one per core
+const QString Constants::RESOURCES_THREAD_BUDGET_KEY =
+    "resources/thread_budget";
+const int Constants::DEFAULT_RESOURCES_THREAD_BUDGET = 0;
+
+// List of maps, see FolderWatcher::Folder
+const QString Constants::WATCH_FOLDERS_KEY = "watch/folders";
+
+const QString Constants::WATCH_ENABLED_KEY = "watch/enabled";
+const bool Constants::DEFAULT_WATCH_ENABLED = false;
+
+const QString Constants::QUALITY_COMPUTE_METRICS_KEY =
+    "quality/compute_metrics";
+const bool Constants::DEFAULT_QUALITY_COMPUTE_METRICS = false;
+
+// 0 disables the quality floor
+const QString Constants::QUALITY_MINIMUM_SSIM_KEY = "quality/minimum_ssim";
+const double Constants::DEFAULT_QUALITY_MINIMUM_SSIM = 0.0;
+
+// 0 disables the per image quality search
+const QString Constants::QUALITY_TARGET_SSIM_KEY = "quality/target_ssim";
+const double Constants::DEFAULT_QUALITY_TARGET_SSIM = 0.0;
+
 const QString Constants::APPEARANCE_THEME_KEY = "appearance/theme";
 const QString Constants::DEFAULT_APPEARANCE_THEME = "Light";
 
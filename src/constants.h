@@ -1,6 +1,7 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
+#include <QHash>
 #include <QString>
 
 class Constants {
@@ -11,6 +12,11 @@ public:
   static const QString OUTPUT_FILE_PREFIX_KEY;
   static const QString DEFAULT_OUTPUT_FILE_PREFIX;
 
+  static const QString OUTPUT_VARIANT_NAME_KEY;
+  static const QString DEFAULT_OUTPUT_VARIANT_NAME;
+
+  static const QString FORMAT_OPTIMIZER_KEY_PREFIX;
+
   static const QString INPUT_LAST_IMAGE_DIR_PATH_KEY;
   static const QString DEFAULT_INPUT_LAST_IMAGE_DIR_PATH;
 
@@ -20,6 +26,84 @@ public:
   static const QString TASK_MAX_CONCURRENT_TASKS_KEY;
   static const int DEFAULT_TASK_MAX_CONCURRENT_TASKS;
 
+  static const QString CACHE_THUMBNAILS_ON_DISK_KEY;
+  static const bool DEFAULT_CACHE_THUMBNAILS_ON_DISK;
+
+  static const QString TASK_BATCH_JOURNAL_KEY;
+  static const bool DEFAULT_TASK_BATCH_JOURNAL;
+
+  static const QString TASK_PIPE_IO_KEY;
+  static const bool DEFAULT_TASK_PIPE_IO;
+
+  static const QString TASK_PREEMPT_FOR_INTERACTIVE_KEY;
+  static const bool DEFAULT_TASK_PREEMPT_FOR_INTERACTIVE;
+
+  static const QString TASK_NOT_SMALLER_ACTION_KEY;
+  static const int DEFAULT_TASK_NOT_SMALLER_ACTION;
+
+  static const QString TASK_MINIMUM_GAIN_KEY;
+  static const double DEFAULT_TASK_MINIMUM_GAIN;
+
+  static const QString TASK_LINK_UNCHANGED_KEY;
+  static const int DEFAULT_TASK_LINK_UNCHANGED;
+
+  static const QString TOOL_TIMEOUT_KEY_SUFFIX;
+  static const int DEFAULT_TOOL_TIMEOUT;
+  static const QHash<QString, int> DEFAULT_TOOL_TIMEOUTS;
+
+  static const QString TASK_TIMEOUT_PER_MB_KEY;
+  static const double DEFAULT_TASK_TIMEOUT_PER_MB;
+
+  static const QString TASK_TIMEOUT_RETRIES_KEY;
+  static const int DEFAULT_TASK_TIMEOUT_RETRIES;
+
+  static const QString TASK_STRIP_METADATA_KEY;
+  static const int DEFAULT_TASK_STRIP_METADATA;
+
+  static const QString RESIZE_MAX_WIDTH_KEY;
+  static const int DEFAULT_RESIZE_MAX_WIDTH;
+
+  static const QString RESIZE_MAX_HEIGHT_KEY;
+  static const int DEFAULT_RESIZE_MAX_HEIGHT;
+
+  static const QString RESIZE_FILTER_KEY;
+  static const int DEFAULT_RESIZE_FILTER;
+
+  static const QString RESIZE_VARIANT_WIDTHS_KEY;
+  static const QString DEFAULT_RESIZE_VARIANT_WIDTHS;
+
+  static const QString RESOURCES_MEMORY_LIMIT_KEY;
+  static const int DEFAULT_RESOURCES_MEMORY_LIMIT;
+
+  static const QString RESOURCES_CPU_TIME_LIMIT_KEY;
+  static const int DEFAULT_RESOURCES_CPU_TIME_LIMIT;
+
+  static const QString RESOURCES_BATCH_NICENESS_KEY;
+  static const int DEFAULT_RESOURCES_BATCH_NICENESS;
+
+  static const QString RESOURCES_BATCH_IDLE_IO_KEY;
+  static const bool DEFAULT_RESOURCES_BATCH_IDLE_IO;
+
+  static const QString RESOURCES_MEMORY_BUDGET_KEY;
+  static const int DEFAULT_RESOURCES_MEMORY_BUDGET;
+
+  static const QString RESOURCES_THREAD_BUDGET_KEY;
+  static const int DEFAULT_RESOURCES_THREAD_BUDGET;
+
+  static const QString WATCH_FOLDERS_KEY;
+
+  static const QString WATCH_ENABLED_KEY;
+  static const bool DEFAULT_WATCH_ENABLED;
+
+  static const QString QUALITY_COMPUTE_METRICS_KEY;
+  static const bool DEFAULT_QUALITY_COMPUTE_METRICS;
+
+  static const QString QUALITY_MINIMUM_SSIM_KEY;
+  static const double DEFAULT_QUALITY_MINIMUM_SSIM;
+
+  static const QString QUALITY_TARGET_SSIM_KEY;
+  static const double DEFAULT_QUALITY_TARGET_SSIM;
+
   static const QString APPEARANCE_THEME_KEY;
   static const QString DEFAULT_APPEARANCE_THEME;
 
@@ -0,0 +1,207 @@
+#include "differenceheatmap.h"
+
+#include <QColor>
+
+#include <cmath>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DIFFERENCEHEATMAP_X86
+#endif
+
+namespace {
+
+typedef void (*MaxChannelDifference)(const quint32 *a, const quint32 *b,
+                                     quint8 *out, int count);
+
+struct Kernel {
+  const char *name;
+  MaxChannelDifference maxChannelDifference;
+};
+
+inline quint8 maxChannelDifferencePixel(quint32 a, quint32 b) {
+  int red = qAbs(int((a >> 16) & 0xff) - int((b >> 16) & 0xff));
+  int green = qAbs(int((a >> 8) & 0xff) - int((b >> 8) & 0xff));
+  int blue = qAbs(int(a & 0xff) - int(b & 0xff));
+  return quint8(qMax(red, qMax(green, blue)));
+}
+
+void maxChannelDifferenceScalar(const quint32 *a, const quint32 *b,
+                                quint8 *out, int count) {
+  for (int i = 0; i < count; ++i) {
+    out[i] = maxChannelDifferencePixel(a[i], b[i]);
+  }
+}
+
+const Kernel SCALAR_KERNEL = {"scalar", maxChannelDifferenceScalar};
+
+#if defined(DIFFERENCEHEATMAP_X86) && defined(__SSE2__)
+
+// Maximum of the blue, green and red byte differences in the low byte of
+// every 32 bit lane
+inline __m128i laneDifferenceSse2(__m128i a, __m128i b) {
+  const __m128i colorMask = _mm_set1_epi32(0x00ffffff);
+  __m128i difference =
+      _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+  difference = _mm_and_si128(difference, colorMask);
+  difference = _mm_max_epu8(difference, _mm_srli_epi32(difference, 8));
+  difference = _mm_max_epu8(difference, _mm_srli_epi32(difference, 16));
+  return _mm_and_si128(difference, _mm_set1_epi32(0xff));
+}
+
+void maxChannelDifferenceSse2(const quint32 *a, const quint32 *b,
+                              quint8 *out, int count) {
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i d[4];
+    for (int j = 0; j < 4; ++j) {
+      d[j] = laneDifferenceSse2(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i + 4 * j)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i + 4 * j)));
+    }
+    __m128i packed = _mm_packus_epi16(_mm_packs_epi32(d[0], d[1]),
+                                      _mm_packs_epi32(d[2], d[3]));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), packed);
+  }
+  maxChannelDifferenceScalar(a + i, b + i, out + i, count - i);
+}
+
+const Kernel SSE2_KERNEL = {"SSE2", maxChannelDifferenceSse2};
+
+#endif
+
+#if defined(DIFFERENCEHEATMAP_X86) && defined(__GNUC__)
+
+// AVX2, compiled for the target regardless of the build flags and only
+// selected when the CPU reports support for it
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET inline __m256i laneDifferenceAvx2(__m256i a, __m256i b) {
+  const __m256i colorMask = _mm256_set1_epi32(0x00ffffff);
+  __m256i difference =
+      _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+  difference = _mm256_and_si256(difference, colorMask);
+  difference =
+      _mm256_max_epu8(difference, _mm256_srli_epi32(difference, 8));
+  difference =
+      _mm256_max_epu8(difference, _mm256_srli_epi32(difference, 16));
+  return _mm256_and_si256(difference, _mm256_set1_epi32(0xff));
+}
+
+AVX2_TARGET void maxChannelDifferenceAvx2(const quint32 *a, const quint32 *b,
+                                          quint8 *out, int count) {
+  // The packs work per 128 bit lane, this puts the dwords back in order
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  int i = 0;
+  for (; i + 32 <= count; i += 32) {
+    __m256i d[4];
+    for (int j = 0; j < 4; ++j) {
+      d[j] = laneDifferenceAvx2(
+          _mm256_loadu_si256(
+              reinterpret_cast<const __m256i *>(a + i + 8 * j)),
+          _mm256_loadu_si256(
+              reinterpret_cast<const __m256i *>(b + i + 8 * j)));
+    }
+    __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(d[0], d[1]),
+                                         _mm256_packs_epi32(d[2], d[3]));
+    packed = _mm256_permutevar8x32_epi32(packed, order);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), packed);
+  }
+  maxChannelDifferenceScalar(a + i, b + i, out + i, count - i);
+}
+
+const Kernel AVX2_KERNEL = {"AVX2", maxChannelDifferenceAvx2};
+
+#endif
+
+const Kernel &kernel() {
+  static const Kernel selected = []() {
+#if defined(DIFFERENCEHEATMAP_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return AVX2_KERNEL;
+    }
+#endif
+#if defined(DIFFERENCEHEATMAP_X86) && defined(__SSE2__)
+    return SSE2_KERNEL;
+#else
+    return SCALAR_KERNEL;
+#endif
+  }();
+  return selected;
+}
+
+// Dark violet over red and orange to pale yellow, readable on both themes
+QRgb heatColor(int value) {
+  static const int STOP_COUNT = 4;
+  static const int STOPS[STOP_COUNT][3] = {
+      {48, 0, 110}, {210, 20, 60}, {255, 160, 0}, {255, 255, 210}};
+
+  double position = value / 255.0 * (STOP_COUNT - 1);
+  int index = qMin(int(position), STOP_COUNT - 2);
+  double t = position - index;
+  int channels[3];
+  for (int c = 0; c < 3; ++c) {
+    channels[c] = qRound(STOPS[index][c] +
+                         (STOPS[index + 1][c] - STOPS[index][c]) * t);
+  }
+  return qRgb(channels[0], channels[1], channels[2]);
+}
+
+} // namespace
+
+QImage DifferenceHeatmap::render(const QImage &original,
+                                 const QImage &optimized,
+                                 double amplification, int threshold) {
+  if (original.isNull() || optimized.isNull()) {
+    return QImage();
+  }
+
+  QImage reference = original.convertToFormat(QImage::Format_ARGB32);
+  QImage distorted = optimized.size() == original.size()
+                         ? optimized
+                         : optimized.scaled(original.size());
+  distorted = distorted.convertToFormat(QImage::Format_ARGB32);
+
+  threshold = qBound(0, threshold, MAX_THRESHOLD);
+  amplification = qMax(1.0, amplification);
+
+  // Amplification and threshold are folded into one lookup per difference
+  QRgb colors[256];
+  for (int difference = 0; difference < 256; ++difference) {
+    colors[difference] =
+        heatColor(qMin(255, qRound(difference * amplification)));
+  }
+
+  const Kernel &selected = kernel();
+  int width = reference.width();
+  QImage heatmap(reference.size(), QImage::Format_RGB32);
+  std::vector<quint8> differences(width);
+
+  for (int y = 0; y < reference.height(); ++y) {
+    const quint32 *referenceLine =
+        reinterpret_cast<const quint32 *>(reference.constScanLine(y));
+    const quint32 *distortedLine =
+        reinterpret_cast<const quint32 *>(distorted.constScanLine(y));
+    selected.maxChannelDifference(referenceLine, distortedLine,
+                                  differences.data(), width);
+
+    QRgb *out = reinterpret_cast<QRgb *>(heatmap.scanLine(y));
+    for (int x = 0; x < width; ++x) {
+      quint8 difference = differences[x];
+      if (difference >= threshold && difference > 0) {
+        out[x] = colors[difference];
+      } else {
+        int gray = qGray(referenceLine[x]) / 4;
+        out[x] = qRgb(gray, gray, gray);
+      }
+    }
+  }
+  return heatmap;
+}
+
+QString DifferenceHeatmap::instructionSet() {
+  return QString::fromLatin1(kernel().name);
+}
@@ -0,0 +1,29 @@
+#ifndef DIFFERENCEHEATMAP_H
+#define DIFFERENCEHEATMAP_H
+
+#include <QImage>
+#include <QString>
+
+// Per-pixel error heatmap of two renderings of the same image region.
+//
+// The error of a pixel is the largest absolute difference of its red, green
+// and blue channels. It is computed with AVX2 or SSE2, selected at runtime,
+// and mapped through a color ramp after amplification. Pixels below the
+// threshold show the dimmed original so the artifacts stay in context.
+//
+// Reentrant, tiles are rendered on worker threads.
+class DifferenceHeatmap {
+public:
+  static const int MAX_THRESHOLD = 255;
+
+  static QImage render(const QImage &original, const QImage &optimized,
+                       double amplification, int threshold);
+
+  // Instruction set used by the kernel ("AVX2", "SSE2" or "scalar")
+  static QString instructionSet();
+
+private:
+  DifferenceHeatmap() = delete;
+};
+
+#endif // DIFFERENCEHEATMAP_H
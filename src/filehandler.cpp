@@ -7,7 +7,8 @@ FileHandler::FileHandler(QObject *parent)
 void FileHandler::addFiles(const QString &dir) {
   QStringList fileNames =
       QFileDialog::getOpenFileNames(nullptr, tr("Select Images"), dir,
-                                    tr("Images (*.png *.jpg *.jpeg *.gif)"));
+                                    tr("Images (*.png *.jpg *.jpeg *.gif);;"
+                                       "All Files (*)"));
 
   if (fileNames.isEmpty() == false ) {
     saveLasrOpenedImageDirPath(fileNames);
@@ -0,0 +1,408 @@
+#include "folderwatcher.h"
+#include "settings.h"
+
+#include <worker/imageworkerfactory.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSet>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+FolderWatcher::Folder FolderWatcher::Folder::fromVariantMap(
+    const QVariantMap &map) {
+  Folder folder;
+  folder.path = map.value("path").toString();
+  folder.recursive = map.value("recursive", false).toBool();
+  folder.outputDir = map.value("outputDir").toString();
+  folder.outputPrefix = map.value("outputPrefix").toString();
+  folder.optimizerSettings = map.value("optimizerSettings").toMap();
+  return folder;
+}
+
+QVariantMap FolderWatcher::Folder::toVariantMap() const {
+  QVariantMap map;
+  map["path"] = path;
+  map["recursive"] = recursive;
+  map["outputDir"] = outputDir;
+  map["outputPrefix"] = outputPrefix;
+  map["optimizerSettings"] = optimizerSettings;
+  return map;
+}
+
+FolderWatcher::FolderWatcher(QObject *parent)
+    : QObject(parent), m_active(false), m_inotifyFd(-1), m_notifier(nullptr),
+      m_fallbackWatcher(nullptr) {
+  m_debounceTimer.setInterval(DEBOUNCE_MS / 4);
+  connect(&m_debounceTimer, &QTimer::timeout, this,
+          &FolderWatcher::flushSettledFiles);
+}
+
+FolderWatcher::~FolderWatcher() { stop(); }
+
+QList<FolderWatcher::Folder> FolderWatcher::savedFolders() {
+  QList<Folder> folders;
+  const QVariantList list = Settings::instance().getWatchFolders();
+  for (const QVariant &value : list) {
+    Folder folder = Folder::fromVariantMap(value.toMap());
+    if (!folder.path.isEmpty()) {
+      folders.append(folder);
+    }
+  }
+  return folders;
+}
+
+void FolderWatcher::saveFolders(const QList<Folder> &folders) {
+  QVariantList list;
+  for (const Folder &folder : folders) {
+    list.append(folder.toVariantMap());
+  }
+  Settings::instance().setWatchFolders(list);
+}
+
+void FolderWatcher::setFolders(const QList<Folder> &folders) {
+  m_folders = folders;
+  if (m_active) {
+    start();
+  }
+}
+
+QList<FolderWatcher::Folder> FolderWatcher::folders() const {
+  return m_folders;
+}
+
+bool FolderWatcher::start() {
+  stop();
+
+#ifdef Q_OS_LINUX
+  m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_inotifyFd >= 0) {
+    m_notifier =
+        new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this,
+            &FolderWatcher::readInotifyEvents);
+  } else {
+    qWarning() << "inotify unavailable, falling back to QFileSystemWatcher:"
+               << strerror(errno);
+  }
+#endif
+
+  if (m_inotifyFd < 0) {
+    m_fallbackWatcher = new QFileSystemWatcher(this);
+    connect(m_fallbackWatcher, &QFileSystemWatcher::directoryChanged, this,
+            &FolderWatcher::onDirectoryChanged);
+  }
+
+  for (int i = 0; i < m_folders.count(); ++i) {
+    const Folder &folder = m_folders.at(i);
+    if (!QFileInfo(folder.path).isDir()) {
+      emit watchError(tr("Watched folder %1 does not exist").arg(folder.path));
+      continue;
+    }
+
+    QString folderPath = QDir(folder.path).absolutePath();
+    addDirectory(folderPath, i);
+    if (folder.recursive) {
+      QDirIterator it(folderPath, QDir::Dirs | QDir::NoDotAndDotDot,
+                      QDirIterator::Subdirectories);
+      while (it.hasNext()) {
+        addDirectory(it.next(), i);
+      }
+    }
+  }
+
+  m_active = true;
+  return !m_watchDirs.isEmpty() || !m_fallbackFolderIndex.isEmpty();
+}
+
+void FolderWatcher::stop() {
+#ifdef Q_OS_LINUX
+  if (m_inotifyFd >= 0) {
+    delete m_notifier;
+    m_notifier = nullptr;
+    // Closing the descriptor drops all of its watches
+    ::close(m_inotifyFd);
+    m_inotifyFd = -1;
+  }
+#endif
+  m_watchDirs.clear();
+  m_watchFolderIndex.clear();
+
+  delete m_fallbackWatcher;
+  m_fallbackWatcher = nullptr;
+  m_fallbackFolderIndex.clear();
+  m_snapshots.clear();
+
+  m_pendingFiles.clear();
+  m_debounceTimer.stop();
+  m_active = false;
+}
+
+bool FolderWatcher::isActive() const { return m_active; }
+
+void FolderWatcher::addDirectory(const QString &dirPath, int folderIndex) {
+  // Hidden folders hold temporary files, ours included
+  if (QFileInfo(dirPath).fileName().startsWith('.')) {
+    return;
+  }
+
+#ifdef Q_OS_LINUX
+  if (m_inotifyFd >= 0) {
+    int wd = inotify_add_watch(m_inotifyFd,
+                               QFile::encodeName(dirPath).constData(),
+                               IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE |
+                                   IN_ONLYDIR);
+    if (wd < 0) {
+      // ENOSPC means fs.inotify.max_user_watches is exhausted
+      emit watchError(tr("Unable to watch %1: %2")
+                          .arg(dirPath, QString::fromLocal8Bit(
+                                            strerror(errno))));
+      return;
+    }
+    m_watchDirs.insert(wd, dirPath);
+    m_watchFolderIndex.insert(wd, folderIndex);
+    return;
+  }
+#endif
+
+  if (m_fallbackWatcher && m_fallbackWatcher->addPath(dirPath)) {
+    m_fallbackFolderIndex.insert(dirPath, folderIndex);
+    m_snapshots.insert(dirPath, scanDirectory(dirPath));
+  }
+}
+
+void FolderWatcher::readInotifyEvents() {
+#ifdef Q_OS_LINUX
+  alignas(struct inotify_event) char buffer[64 * 1024];
+  bool overflowed = false;
+
+  for (;;) {
+    ssize_t length = ::read(m_inotifyFd, buffer, sizeof(buffer));
+    if (length <= 0) {
+      // EAGAIN, the queue is drained
+      break;
+    }
+
+    for (char *pointer = buffer; pointer < buffer + length;) {
+      const struct inotify_event *event =
+          reinterpret_cast<const struct inotify_event *>(pointer);
+      pointer += sizeof(struct inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        overflowed = true;
+        continue;
+      }
+
+      QString dirPath = m_watchDirs.value(event->wd);
+      if (dirPath.isEmpty()) {
+        continue;
+      }
+      int folderIndex = m_watchFolderIndex.value(event->wd);
+
+      if (event->mask & IN_IGNORED) {
+        // Directory deleted or unmounted
+        m_watchDirs.remove(event->wd);
+        m_watchFolderIndex.remove(event->wd);
+        continue;
+      }
+      if (event->len == 0) {
+        continue;
+      }
+
+      QString path = dirPath + '/' + QFile::decodeName(event->name);
+
+      if (event->mask & IN_ISDIR) {
+        if ((event->mask & (IN_CREATE | IN_MOVED_TO)) &&
+            m_folders.value(folderIndex).recursive) {
+          // Files may land in a new folder before its watch exists
+          addDirectory(path, folderIndex);
+          QDirIterator it(path, QDir::Dirs | QDir::Files |
+                                    QDir::NoDotAndDotDot,
+                          QDirIterator::Subdirectories);
+          while (it.hasNext()) {
+            QString entry = it.next();
+            if (it.fileInfo().isDir()) {
+              addDirectory(entry, folderIndex);
+            } else {
+              fileWritten(entry, folderIndex);
+            }
+          }
+        }
+        continue;
+      }
+
+      if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+        fileWritten(path, folderIndex);
+      }
+    }
+  }
+
+  // Once per drained queue, the dropped events are unknown
+  if (overflowed) {
+    qWarning() << "inotify queue overflowed, rescanning watched folders";
+    rescanFolders();
+  }
+#endif
+}
+
+void FolderWatcher::rescanFolders() {
+  QSet<QString> watchedDirs;
+  for (const QString &dirPath : qAsConst(m_watchDirs)) {
+    watchedDirs.insert(dirPath);
+  }
+
+  for (int i = 0; i < m_folders.count(); ++i) {
+    QString folderPath = QDir(m_folders.at(i).path).absolutePath();
+    if (!QFileInfo(folderPath).isDir()) {
+      continue;
+    }
+
+    QDirIterator it(folderPath,
+                    QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot,
+                    m_folders.at(i).recursive ? QDirIterator::Subdirectories
+                                              : QDirIterator::NoIteratorFlags);
+    while (it.hasNext()) {
+      QString entry = it.next();
+      if (!it.fileInfo().isDir()) {
+        fileWritten(entry, i, true);
+      } else if (m_folders.at(i).recursive && !watchedDirs.contains(entry)) {
+        // Created while events were being dropped
+        addDirectory(entry, i);
+        watchedDirs.insert(entry);
+      }
+    }
+  }
+}
+
+void FolderWatcher::onDirectoryChanged(const QString &dirPath) {
+  int folderIndex = m_fallbackFolderIndex.value(dirPath, -1);
+  if (folderIndex < 0) {
+    return;
+  }
+
+  // Only this folder is rescanned
+  QHash<QString, qint64> snapshot = scanDirectory(dirPath);
+  const QHash<QString, qint64> previous = m_snapshots.value(dirPath);
+  for (auto it = snapshot.constBegin(); it != snapshot.constEnd(); ++it) {
+    if (previous.value(it.key(), -1) != it.value()) {
+      fileWritten(it.key(), folderIndex);
+    }
+  }
+  m_snapshots.insert(dirPath, snapshot);
+
+  if (m_folders.value(folderIndex).recursive) {
+    const QFileInfoList subdirs =
+        QDir(dirPath).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QFileInfo &subdir : subdirs) {
+      if (!m_fallbackFolderIndex.contains(subdir.absoluteFilePath())) {
+        addDirectory(subdir.absoluteFilePath(), folderIndex);
+      }
+    }
+  }
+}
+
+QHash<QString, qint64>
+FolderWatcher::scanDirectory(const QString &dirPath) const {
+  QHash<QString, qint64> snapshot;
+  const QFileInfoList files = QDir(dirPath).entryInfoList(QDir::Files);
+  for (const QFileInfo &file : files) {
+    snapshot.insert(file.absoluteFilePath(),
+                    file.lastModified().toMSecsSinceEpoch());
+  }
+  return snapshot;
+}
+
+bool FolderWatcher::isCandidate(const QString &filePath,
+                                const Folder &folder) const {
+  QFileInfo fileInfo(filePath);
+
+  // Partial uploads and editor temporaries are usually hidden
+  if (fileInfo.fileName().startsWith('.')) {
+    return false;
+  }
+
+  if (ImageWorkerFactory::instance().getImageType(filePath) ==
+      ImageType::Unsupported) {
+    return false;
+  }
+
+  // Our own output, written into a watched folder
+  Settings &settings = Settings::instance();
+  QString outputDir = folder.outputDir.isEmpty() ? settings.getOptimizedPath()
+                                                 : folder.outputDir;
+  QString outputPrefix = folder.outputPrefix.isEmpty()
+                             ? settings.getOutputFilePrefix()
+                             : folder.outputPrefix;
+  if (QDir(outputDir).absolutePath() == fileInfo.absolutePath() &&
+      fileInfo.fileName().startsWith(outputPrefix)) {
+    return false;
+  }
+
+  return true;
+}
+
+void FolderWatcher::fileWritten(const QString &filePath, int folderIndex,
+                                bool rescanned) {
+  if (!isCandidate(filePath, m_folders.value(folderIndex))) {
+    return;
+  }
+
+  // Every new event restarts the quiet period of the file, a real event
+  // outranks a rescan
+  auto existing = m_pendingFiles.constFind(filePath);
+  bool wasRescanned =
+      existing == m_pendingFiles.constEnd() || existing->rescanned;
+  PendingFile &pending = m_pendingFiles[filePath];
+  pending.folderIndex = folderIndex;
+  pending.rescanned = rescanned && wasRescanned;
+  pending.size = QFileInfo(filePath).size();
+  pending.sinceLastEvent.start();
+
+  if (!m_debounceTimer.isActive()) {
+    m_debounceTimer.start();
+  }
+}
+
+void FolderWatcher::flushSettledFiles() {
+  QStringList settled;
+  for (auto it = m_pendingFiles.begin(); it != m_pendingFiles.end(); ++it) {
+    if (it->sinceLastEvent.elapsed() < DEBOUNCE_MS) {
+      continue;
+    }
+
+    // Still growing, e.g. a copy the fallback watcher saw being created
+    qint64 size = QFileInfo(it.key()).size();
+    if (size != it->size) {
+      it->size = size;
+      it->sinceLastEvent.start();
+      continue;
+    }
+    settled.append(it.key());
+  }
+
+  for (const QString &filePath : qAsConst(settled)) {
+    PendingFile pending = m_pendingFiles.take(filePath);
+    if (!QFileInfo(filePath).isFile()) {
+      continue;
+    }
+    if (pending.rescanned) {
+      emit fileFound(filePath, m_folders.value(pending.folderIndex));
+    } else {
+      emit fileReady(filePath, m_folders.value(pending.folderIndex));
+    }
+  }
+
+  if (m_pendingFiles.isEmpty()) {
+    m_debounceTimer.stop();
+  }
+}
@@ -0,0 +1,110 @@
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVariantMap>
+
+class QFileSystemWatcher;
+class QSocketNotifier;
+
+// Watches folders for new or changed images and reports them once they are
+// completely written.
+//
+// On Linux every folder (and with recursion every subfolder) gets an inotify
+// watch for IN_CLOSE_WRITE and IN_MOVED_TO, so files are picked up the moment
+// the writer closes them. Only an overflowed event queue rescans the watched
+// folders, those files are reported as found rather than ready so the receiver
+// can skip what it already knows. Events for the same file are debounced,
+// uploads that close and reopen a file are reported once.
+// Other platforms fall back to QFileSystemWatcher and rescan only the folder
+// that changed.
+//
+// Hidden files (partial uploads, our own temporary files) and the outputs of
+// PixelBatch in a watched folder are ignored.
+class FolderWatcher : public QObject {
+  Q_OBJECT
+
+public:
+  // A watched folder and the settings its images are optimized with, empty
+  // values fall back to the global settings
+  struct Folder {
+    QString path;
+    bool recursive = false;
+    QString outputDir;
+    QString outputPrefix;
+    QVariantMap optimizerSettings;
+
+    static Folder fromVariantMap(const QVariantMap &map);
+    QVariantMap toVariantMap() const;
+  };
+
+  // Quiet period before a file counts as completely written
+  static const int DEBOUNCE_MS = 1000;
+
+  explicit FolderWatcher(QObject *parent = nullptr);
+  ~FolderWatcher();
+
+  // Folders stored in the settings
+  static QList<Folder> savedFolders();
+  static void saveFolders(const QList<Folder> &folders);
+
+  // Restarts watching if active
+  void setFolders(const QList<Folder> &folders);
+  QList<Folder> folders() const;
+
+  bool start();
+  void stop();
+  bool isActive() const;
+
+signals:
+  void fileReady(const QString &filePath, const FolderWatcher::Folder &folder);
+  // Seen by a rescan, possibly unchanged since it was last reported
+  void fileFound(const QString &filePath, const FolderWatcher::Folder &folder);
+  void watchError(const QString &errorString);
+
+private slots:
+  void readInotifyEvents();
+  void onDirectoryChanged(const QString &dirPath);
+  void flushSettledFiles();
+
+private:
+  struct PendingFile {
+    int folderIndex;
+    qint64 size;
+    bool rescanned;
+    QElapsedTimer sinceLastEvent;
+  };
+
+  void addDirectory(const QString &dirPath, int folderIndex);
+  void rescanFolders();
+  void fileWritten(const QString &filePath, int folderIndex,
+                   bool rescanned = false);
+  bool isCandidate(const QString &filePath, const Folder &folder) const;
+  QHash<QString, qint64> scanDirectory(const QString &dirPath) const;
+
+  QList<Folder> m_folders;
+  bool m_active;
+
+  // inotify
+  int m_inotifyFd;
+  QSocketNotifier *m_notifier;
+  QHash<int, QString> m_watchDirs;    // watch descriptor -> directory
+  QHash<int, int> m_watchFolderIndex; // watch descriptor -> folder
+
+  // Fallback, directory -> (file -> modification time)
+  QFileSystemWatcher *m_fallbackWatcher;
+  QHash<QString, int> m_fallbackFolderIndex;
+  QHash<QString, QHash<QString, qint64>> m_snapshots;
+
+  QHash<QString, PendingFile> m_pendingFiles;
+  QTimer m_debounceTimer;
+};
+
+Q_DECLARE_METATYPE(FolderWatcher::Folder)
+
+#endif // FOLDERWATCHER_H
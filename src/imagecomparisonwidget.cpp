@@ -1,4 +1,5 @@
 #include "imagecomparisonwidget.h"
+#include "differenceheatmap.h"
 
 #include <QDebug>
 #include <QFileInfo>
@@ -18,11 +19,14 @@ ImageComparisonWidget::ImageComparisonWidget(const QString &originalPath,
                                              const QString &optimizedPath,
                                              QWidget *parent)
     : QDialog(parent), m_originalPath(originalPath),
-      m_optimizedPath(optimizedPath), m_imageLabel(nullptr),
-      m_leftLabel(nullptr), m_rightLabel(nullptr), m_slider(nullptr),
-      m_toggleButton(nullptr), m_sideBySideWidget(nullptr),
-      m_overlayWidget(nullptr), m_syncScrollCheckbox(nullptr),
-      m_leftScroll(nullptr), m_rightScroll(nullptr), m_isSideBySideView(true),
+      m_optimizedPath(optimizedPath), m_overlayView(nullptr),
+      m_leftView(nullptr), m_rightView(nullptr), m_differenceView(nullptr),
+      m_slider(nullptr), m_viewModeCombo(nullptr),
+      m_sideBySideWidget(nullptr), m_overlayWidget(nullptr),
+      m_differenceWidget(nullptr), m_amplificationSpinBox(nullptr),
+      m_thresholdSpinBox(nullptr), m_syncScrollCheckbox(nullptr),
+      m_leftScroll(nullptr), m_rightScroll(nullptr), m_overlayScroll(nullptr),
+      m_differenceScroll(nullptr), m_viewMode(SideBySideView),
       m_syncScrollBars(true), m_updatingScrollBars(false), m_zoomFactor(1.0) {
 
   setWindowTitle(tr("Compare Images - Before and After"));
@@ -38,12 +42,20 @@ ImageComparisonWidget::~ImageComparisonWidget() {}
 void ImageComparisonWidget::setupUI() {
   QVBoxLayout *mainLayout = new QVBoxLayout(this);
 
-  // Toggle button at top
-  m_toggleButton = new QPushButton(tr("Switch to Slider View"));
-  m_toggleButton->setIcon(QIcon(":/resources/icons/image-edit-line.png"));
-  connect(m_toggleButton, &QPushButton::clicked, this,
-          &ImageComparisonWidget::toggleView);
-  mainLayout->addWidget(m_toggleButton);
+  // View selector at top
+  QHBoxLayout *viewModeLayout = new QHBoxLayout();
+  QLabel *viewModeLabel = new QLabel(tr("View:"));
+  viewModeLayout->addWidget(viewModeLabel);
+
+  m_viewModeCombo = new QComboBox();
+  m_viewModeCombo->addItem(tr("Side by Side"));
+  m_viewModeCombo->addItem(tr("Slider"));
+  m_viewModeCombo->addItem(tr("Difference"));
+  connect(m_viewModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+          this, &ImageComparisonWidget::setViewMode);
+  viewModeLayout->addWidget(m_viewModeCombo);
+  viewModeLayout->addStretch();
+  mainLayout->addLayout(viewModeLayout);
 
   // Side-by-side view
   m_sideBySideWidget = new QWidget();
@@ -59,33 +71,7 @@ void ImageComparisonWidget::setupUI() {
   controlsLayout->addWidget(m_syncScrollCheckbox);
   controlsLayout->addStretch();
 
-  // Zoom controls
-  QLabel *zoomLabel = new QLabel(tr("Zoom:"));
-  controlsLayout->addWidget(zoomLabel);
-
-  QPushButton *zoomOutBtn = new QPushButton(tr("−"));
-  zoomOutBtn->setMaximumWidth(30);
-  zoomOutBtn->setToolTip(tr("Zoom Out (Ctrl+-)"));
-  connect(zoomOutBtn, &QPushButton::clicked, this, &ImageComparisonWidget::zoomOut);
-  controlsLayout->addWidget(zoomOutBtn);
-
-  QPushButton *zoomResetBtn = new QPushButton(tr("100%"));
-  zoomResetBtn->setMaximumWidth(50);
-  zoomResetBtn->setToolTip(tr("Reset Zoom (Ctrl+0)"));
-  connect(zoomResetBtn, &QPushButton::clicked, this, &ImageComparisonWidget::zoomReset);
-  controlsLayout->addWidget(zoomResetBtn);
-
-  QPushButton *zoomInBtn = new QPushButton(tr("+"));
-  zoomInBtn->setMaximumWidth(30);
-  zoomInBtn->setToolTip(tr("Zoom In (Ctrl++)"));
-  connect(zoomInBtn, &QPushButton::clicked, this, &ImageComparisonWidget::zoomIn);
-  controlsLayout->addWidget(zoomInBtn);
-
-  QPushButton *zoomFitBtn = new QPushButton(tr("Fit"));
-  zoomFitBtn->setMaximumWidth(50);
-  zoomFitBtn->setToolTip(tr("Fit to Window"));
-  connect(zoomFitBtn, &QPushButton::clicked, this, &ImageComparisonWidget::zoomFit);
-  controlsLayout->addWidget(zoomFitBtn);
+  addZoomControls(controlsLayout);
 
   sideBySideMainLayout->addLayout(controlsLayout);
 
@@ -99,11 +85,9 @@ void ImageComparisonWidget::setupUI() {
   leftLayout->addWidget(leftTitle);
 
   m_leftScroll = new QScrollArea();
-  m_leftLabel = new DraggableLabel();
-  m_leftLabel->setScaledContents(false);
-  m_leftLabel->setAlignment(Qt::AlignCenter);
-  m_leftLabel->setScrollArea(m_leftScroll);
-  m_leftScroll->setWidget(m_leftLabel);
+  m_leftView = new TiledImageView();
+  m_leftView->setScrollArea(m_leftScroll);
+  m_leftScroll->setWidget(m_leftView);
   m_leftScroll->setWidgetResizable(true);
   // Optimize scroll area for smooth dragging
   m_leftScroll->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
@@ -117,11 +101,9 @@ void ImageComparisonWidget::setupUI() {
   rightLayout->addWidget(rightTitle);
 
   m_rightScroll = new QScrollArea();
-  m_rightLabel = new DraggableLabel();
-  m_rightLabel->setScaledContents(false);
-  m_rightLabel->setAlignment(Qt::AlignCenter);
-  m_rightLabel->setScrollArea(m_rightScroll);
-  m_rightScroll->setWidget(m_rightLabel);
+  m_rightView = new TiledImageView();
+  m_rightView->setScrollArea(m_rightScroll);
+  m_rightScroll->setWidget(m_rightView);
   m_rightScroll->setWidgetResizable(true);
   // Optimize scroll area for smooth dragging
   m_rightScroll->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
@@ -160,43 +142,16 @@ void ImageComparisonWidget::setupUI() {
 
   overlayTopLayout->addStretch();
 
-  // Zoom controls for slider view
-  QLabel *zoomLabel2 = new QLabel(tr("Zoom:"));
-  overlayTopLayout->addWidget(zoomLabel2);
-
-  QPushButton *zoomOutBtn2 = new QPushButton(tr("−"));
-  zoomOutBtn2->setMaximumWidth(30);
-  zoomOutBtn2->setToolTip(tr("Zoom Out (Ctrl+-)"));
-  connect(zoomOutBtn2, &QPushButton::clicked, this, &ImageComparisonWidget::zoomOut);
-  overlayTopLayout->addWidget(zoomOutBtn2);
-
-  QPushButton *zoomResetBtn2 = new QPushButton(tr("100%"));
-  zoomResetBtn2->setMaximumWidth(50);
-  zoomResetBtn2->setToolTip(tr("Reset Zoom (Ctrl+0)"));
-  connect(zoomResetBtn2, &QPushButton::clicked, this, &ImageComparisonWidget::zoomReset);
-  overlayTopLayout->addWidget(zoomResetBtn2);
-
-  QPushButton *zoomInBtn2 = new QPushButton(tr("+"));
-  zoomInBtn2->setMaximumWidth(30);
-  zoomInBtn2->setToolTip(tr("Zoom In (Ctrl++)"));
-  connect(zoomInBtn2, &QPushButton::clicked, this, &ImageComparisonWidget::zoomIn);
-  overlayTopLayout->addWidget(zoomInBtn2);
-
-  QPushButton *zoomFitBtn2 = new QPushButton(tr("Fit"));
-  zoomFitBtn2->setMaximumWidth(50);
-  zoomFitBtn2->setToolTip(tr("Fit to Window"));
-  connect(zoomFitBtn2, &QPushButton::clicked, this, &ImageComparisonWidget::zoomFit);
-  overlayTopLayout->addWidget(zoomFitBtn2);
+  addZoomControls(overlayTopLayout);
 
   overlayLayout->addLayout(overlayTopLayout);
 
-  QScrollArea *overlayScroll = new QScrollArea();
-  m_imageLabel = new QLabel();
-  m_imageLabel->setScaledContents(false);
-  m_imageLabel->setAlignment(Qt::AlignCenter);
-  overlayScroll->setWidget(m_imageLabel);
-  overlayScroll->setWidgetResizable(true);
-  overlayLayout->addWidget(overlayScroll, 1);
+  m_overlayScroll = new QScrollArea();
+  m_overlayView = new TiledImageView();
+  m_overlayView->setScrollArea(m_overlayScroll);
+  m_overlayScroll->setWidget(m_overlayView);
+  m_overlayScroll->setWidgetResizable(true);
+  overlayLayout->addWidget(m_overlayScroll, 1);
 
   m_slider = new QSlider(Qt::Horizontal);
   m_slider->setRange(0, 100);
@@ -208,6 +163,62 @@ void ImageComparisonWidget::setupUI() {
   mainLayout->addWidget(m_overlayWidget, 1);
   m_overlayWidget->hide();
 
+  // Difference view
+  m_differenceWidget = new QWidget();
+  QVBoxLayout *differenceLayout = new QVBoxLayout(m_differenceWidget);
+  differenceLayout->setContentsMargins(0, 0, 0, 0);
+
+  QHBoxLayout *differenceTopLayout = new QHBoxLayout();
+
+  QLabel *differenceTitle = new QLabel(
+      tr("<b>Difference View</b> - Brighter colors mean larger errors"));
+  differenceTitle->setAlignment(Qt::AlignLeft | Qt::AlignVCenter);
+  differenceTopLayout->addWidget(differenceTitle, 1);
+
+  QSettings settings;
+
+  QLabel *amplificationLabel = new QLabel(tr("Amplification:"));
+  differenceTopLayout->addWidget(amplificationLabel);
+  m_amplificationSpinBox = new QSpinBox();
+  m_amplificationSpinBox->setRange(1, 64);
+  m_amplificationSpinBox->setSuffix(tr("x"));
+  m_amplificationSpinBox->setToolTip(
+      tr("Multiply the differences to make subtle artifacts visible"));
+  m_amplificationSpinBox->setValue(
+      settings.value("ImageComparison/differenceAmplification", 8).toInt());
+  differenceTopLayout->addWidget(m_amplificationSpinBox);
+
+  QLabel *thresholdLabel = new QLabel(tr("Threshold:"));
+  differenceTopLayout->addWidget(thresholdLabel);
+  m_thresholdSpinBox = new QSpinBox();
+  m_thresholdSpinBox->setRange(0, DifferenceHeatmap::MAX_THRESHOLD);
+  m_thresholdSpinBox->setToolTip(
+      tr("Ignore channel differences below this value (0-255)"));
+  m_thresholdSpinBox->setValue(
+      settings.value("ImageComparison/differenceThreshold", 1).toInt());
+  differenceTopLayout->addWidget(m_thresholdSpinBox);
+
+  connect(m_amplificationSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+          this, &ImageComparisonWidget::updateDifferenceParameters);
+  connect(m_thresholdSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+          this, &ImageComparisonWidget::updateDifferenceParameters);
+
+  differenceTopLayout->addSpacing(12);
+  addZoomControls(differenceTopLayout);
+
+  differenceLayout->addLayout(differenceTopLayout);
+
+  m_differenceScroll = new QScrollArea();
+  m_differenceView = new TiledImageView();
+  m_differenceView->setRenderMode(TiledImageView::DifferenceMode);
+  m_differenceView->setScrollArea(m_differenceScroll);
+  m_differenceScroll->setWidget(m_differenceView);
+  m_differenceScroll->setWidgetResizable(true);
+  differenceLayout->addWidget(m_differenceScroll, 1);
+
+  mainLayout->addWidget(m_differenceWidget, 1);
+  m_differenceWidget->hide();
+
   // Info section at bottom with minimal space
   QGroupBox *infoGroup = new QGroupBox(tr("Image Information"));
   infoGroup->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Maximum);
@@ -261,33 +272,61 @@ void ImageComparisonWidget::setupUI() {
           &ImageComparisonWidget::onRightScrollChanged);
 }
 
+void ImageComparisonWidget::addZoomControls(QHBoxLayout *layout) {
+  QLabel *zoomLabel = new QLabel(tr("Zoom:"));
+  layout->addWidget(zoomLabel);
+
+  QPushButton *zoomOutBtn = new QPushButton(tr("−"));
+  zoomOutBtn->setMaximumWidth(30);
+  zoomOutBtn->setToolTip(tr("Zoom Out (Ctrl+-)"));
+  connect(zoomOutBtn, &QPushButton::clicked, this, &ImageComparisonWidget::zoomOut);
+  layout->addWidget(zoomOutBtn);
+
+  QPushButton *zoomResetBtn = new QPushButton(tr("100%"));
+  zoomResetBtn->setMaximumWidth(50);
+  zoomResetBtn->setToolTip(tr("Reset Zoom (Ctrl+0)"));
+  connect(zoomResetBtn, &QPushButton::clicked, this, &ImageComparisonWidget::zoomReset);
+  layout->addWidget(zoomResetBtn);
+
+  QPushButton *zoomInBtn = new QPushButton(tr("+"));
+  zoomInBtn->setMaximumWidth(30);
+  zoomInBtn->setToolTip(tr("Zoom In (Ctrl++)"));
+  connect(zoomInBtn, &QPushButton::clicked, this, &ImageComparisonWidget::zoomIn);
+  layout->addWidget(zoomInBtn);
+
+  QPushButton *zoomFitBtn = new QPushButton(tr("Fit"));
+  zoomFitBtn->setMaximumWidth(50);
+  zoomFitBtn->setToolTip(tr("Fit to Window"));
+  connect(zoomFitBtn, &QPushButton::clicked, this, &ImageComparisonWidget::zoomFit);
+  layout->addWidget(zoomFitBtn);
+}
+
 void ImageComparisonWidget::loadImages() {
-  m_originalPixmap.load(m_originalPath);
-  m_optimizedPixmap.load(m_optimizedPath);
+  // Full resolution, the views only render the tiles that are on screen
+  QSharedPointer<ImagePyramid> originalImage(new ImagePyramid());
+  QSharedPointer<ImagePyramid> optimizedImage(new ImagePyramid());
 
-  if (m_originalPixmap.isNull() || m_optimizedPixmap.isNull()) {
+  if (!originalImage->load(m_originalPath) ||
+      !optimizedImage->load(m_optimizedPath)) {
     qWarning() << "Failed to load one or both images";
     return;
   }
 
-  // Scale images if they're too large (max 2000px in either dimension)
-  int maxDim = 2000;
-  if (m_originalPixmap.width() > maxDim || m_originalPixmap.height() > maxDim) {
-    m_originalPixmap = m_originalPixmap.scaled(
-        maxDim, maxDim, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-  }
-  if (m_optimizedPixmap.width() > maxDim ||
-      m_optimizedPixmap.height() > maxDim) {
-    m_optimizedPixmap = m_optimizedPixmap.scaled(
-        maxDim, maxDim, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-  }
+  m_originalImage = originalImage;
+  m_optimizedImage = optimizedImage;
+
+  m_leftView->setImages(m_originalImage);
+  m_rightView->setImages(m_optimizedImage);
+  m_overlayView->setImages(m_originalImage, m_optimizedImage);
+  m_differenceView->setImages(m_originalImage, m_optimizedImage);
+  updateDifferenceParameters();
 }
 
 void ImageComparisonWidget::showSideBySide() {
   m_sideBySideWidget->show();
   m_overlayWidget->hide();
-  m_isSideBySideView = true;
-  m_toggleButton->setText(tr("Switch to Slider View"));
+  m_differenceWidget->hide();
+  m_viewMode = SideBySideView;
 
   updateZoom();
 
@@ -297,8 +336,8 @@ void ImageComparisonWidget::showSideBySide() {
 void ImageComparisonWidget::showOverlay() {
   m_sideBySideWidget->hide();
   m_overlayWidget->show();
-  m_isSideBySideView = false;
-  m_toggleButton->setText(tr("Switch to Side-by-Side View"));
+  m_differenceWidget->hide();
+  m_viewMode = SliderView;
 
   updateZoom();
   updateComparison(m_slider->value());
@@ -306,55 +345,52 @@ void ImageComparisonWidget::showOverlay() {
   saveViewMode();
 }
 
-void ImageComparisonWidget::updateComparison(int value) {
-  if (m_originalPixmap.isNull() || m_optimizedPixmap.isNull()) {
-    return;
-  }
+void ImageComparisonWidget::showDifference() {
+  m_sideBySideWidget->hide();
+  m_overlayWidget->hide();
+  m_differenceWidget->show();
+  m_viewMode = DifferenceView;
 
-  // Use scaled pixmaps if zoom is active, otherwise use original
-  QPixmap &originalToUse = (m_zoomFactor != 1.0 && !m_originalPixmapScaled.isNull())
-                            ? m_originalPixmapScaled
-                            : m_originalPixmap;
-  QPixmap &optimizedToUse = (m_zoomFactor != 1.0 && !m_optimizedPixmapScaled.isNull())
-                             ? m_optimizedPixmapScaled
-                             : m_optimizedPixmap;
-
-  // Create a composite image
-  QPixmap composite(originalToUse.size());
-  QPainter painter(&composite);
-
-  // Calculate split position
-  int splitX = (originalToUse.width() * value) / 100;
-
-  // Draw original image (left part)
-  painter.drawPixmap(0, 0, originalToUse);
-
-  // Draw optimized image (right part)
-  if (splitX < originalToUse.width()) {
-    QRect sourceRect(splitX, 0, optimizedToUse.width() - splitX,
-                     optimizedToUse.height());
-    QRect targetRect(splitX, 0, originalToUse.width() - splitX,
-                     originalToUse.height());
-    painter.drawPixmap(targetRect, optimizedToUse, sourceRect);
-  }
+  updateZoom();
 
-  // Draw a vertical line at the split position
-  painter.setPen(QPen(Qt::yellow, 3));
-  painter.drawLine(splitX, 0, splitX, originalToUse.height());
+  saveViewMode();
+}
 
-  painter.end();
+void ImageComparisonWidget::updateComparison(int value) {
+  if (m_originalImage.isNull() || m_optimizedImage.isNull()) {
+    return;
+  }
 
-  m_imageLabel->setPixmap(composite);
+  // Only the split moves, the view repaints from its cached tiles
+  m_overlayView->setSplitPosition(value);
 }
 
-void ImageComparisonWidget::toggleView() {
-  if (m_isSideBySideView) {
+void ImageComparisonWidget::setViewMode(int index) {
+  switch (index) {
+  case SliderView:
     showOverlay();
-  } else {
+    break;
+  case DifferenceView:
+    showDifference();
+    break;
+  default:
     showSideBySide();
+    break;
   }
 }
 
+void ImageComparisonWidget::updateDifferenceParameters() {
+  // Re-renders the visible heatmap tiles in the background
+  m_differenceView->setDifferenceParameters(m_amplificationSpinBox->value(),
+                                            m_thresholdSpinBox->value());
+
+  QSettings settings;
+  settings.setValue("ImageComparison/differenceAmplification",
+                    m_amplificationSpinBox->value());
+  settings.setValue("ImageComparison/differenceThreshold",
+                    m_thresholdSpinBox->value());
+}
+
 void ImageComparisonWidget::syncScrollBars() {
   if (!m_syncScrollBars || m_updatingScrollBars) {
     return;
@@ -449,8 +485,13 @@ void ImageComparisonWidget::onSyncCheckboxToggled(bool checked) {
 
 void ImageComparisonWidget::saveViewMode() {
   QSettings settings;
-  settings.setValue("ImageComparison/viewMode",
-                    m_isSideBySideView ? "sidebyside" : "slider");
+  QString viewMode = "sidebyside";
+  if (m_viewMode == SliderView) {
+    viewMode = "slider";
+  } else if (m_viewMode == DifferenceView) {
+    viewMode = "difference";
+  }
+  settings.setValue("ImageComparison/viewMode", viewMode);
 }
 
 void ImageComparisonWidget::loadViewMode() {
@@ -458,10 +499,18 @@ void ImageComparisonWidget::loadViewMode() {
   QString viewMode =
       settings.value("ImageComparison/viewMode", "sidebyside").toString();
 
+  int index = SideBySideView;
   if (viewMode == "slider") {
-    showOverlay();
+    index = SliderView;
+  } else if (viewMode == "difference") {
+    index = DifferenceView;
+  }
+
+  // Index changes show the view through setViewMode()
+  if (m_viewModeCombo->currentIndex() == index) {
+    setViewMode(index);
   } else {
-    showSideBySide();
+    m_viewModeCombo->setCurrentIndex(index);
   }
 }
 
@@ -478,29 +527,25 @@ void ImageComparisonWidget::zoomReset() {
 }
 
 void ImageComparisonWidget::zoomFit() {
-  if (m_originalPixmap.isNull()) {
+  if (m_originalImage.isNull()) {
     return;
   }
 
   QSize scrollSize;
 
   // Get viewport size based on current view
-  if (m_isSideBySideView && m_leftScroll) {
+  if (m_viewMode == SideBySideView && m_leftScroll) {
     scrollSize = m_leftScroll->viewport()->size();
-  } else if (!m_isSideBySideView && m_imageLabel && m_imageLabel->parentWidget()) {
-    // For slider view, get the scroll area size
-    QScrollArea *scrollArea = qobject_cast<QScrollArea*>(m_imageLabel->parentWidget()->parentWidget());
-    if (scrollArea) {
-      scrollSize = scrollArea->viewport()->size();
-    } else {
-      return;
-    }
+  } else if (m_viewMode == SliderView && m_overlayScroll) {
+    scrollSize = m_overlayScroll->viewport()->size();
+  } else if (m_viewMode == DifferenceView && m_differenceScroll) {
+    scrollSize = m_differenceScroll->viewport()->size();
   } else {
     return;
   }
 
   // Calculate zoom to fit the image in the scroll area
-  QSize imageSize = m_originalPixmap.size();
+  QSize imageSize = m_originalImage->size();
 
   double widthRatio = (double)scrollSize.width() / imageSize.width();
   double heightRatio = (double)scrollSize.height() / imageSize.height();
@@ -515,9 +560,10 @@ void ImageComparisonWidget::zoomFit() {
 }
 
 void ImageComparisonWidget::applyZoom(double factor) {
-  // Clamp zoom factor between 10% and 500%
-  if (factor < 0.1) {
-    factor = 0.1;
+  // Clamp zoom factor between 1% and 500%, images are shown at full
+  // resolution so very large ones need to go well below 10% to fit
+  if (factor < 0.01) {
+    factor = 0.01;
   } else if (factor > 5.0) {
     factor = 5.0;
   }
@@ -527,22 +573,11 @@ void ImageComparisonWidget::applyZoom(double factor) {
 }
 
 void ImageComparisonWidget::updateZoom() {
-  if (m_originalPixmap.isNull() || m_optimizedPixmap.isNull()) {
+  if (m_originalImage.isNull() || m_optimizedImage.isNull()) {
     return;
   }
 
-  // Calculate scaled size
-  QSize originalSize = m_originalPixmap.size();
-  QSize scaledSize(originalSize.width() * m_zoomFactor,
-                   originalSize.height() * m_zoomFactor);
-
-  // Scale the pixmaps
-  m_originalPixmapScaled = m_originalPixmap.scaled(
-      scaledSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-  m_optimizedPixmapScaled = m_optimizedPixmap.scaled(
-      scaledSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-  if (m_isSideBySideView) {
+  if (m_viewMode == SideBySideView) {
     // Store current scroll positions (as ratios)
     double hRatioLeft = 0.0;
     double vRatioLeft = 0.0;
@@ -555,9 +590,9 @@ void ImageComparisonWidget::updateZoom() {
                    m_leftScroll->verticalScrollBar()->maximum();
     }
 
-    // Update the labels
-    m_leftLabel->setPixmap(m_originalPixmapScaled);
-    m_rightLabel->setPixmap(m_optimizedPixmapScaled);
+    // Update the views, tiles are rendered lazily on the next paint
+    m_leftView->setZoomFactor(m_zoomFactor);
+    m_rightView->setZoomFactor(m_zoomFactor);
 
     // Restore scroll positions after a short delay to allow layout update
     QTimer::singleShot(10, this, [this, hRatioLeft, vRatioLeft]() {
@@ -570,9 +605,12 @@ void ImageComparisonWidget::updateZoom() {
             vRatioLeft * m_leftScroll->verticalScrollBar()->maximum());
       }
     });
-  } else {
-    // In slider view, update the composite image
+  } else if (m_viewMode == SliderView) {
+    // In slider view, update the split view
+    m_overlayView->setZoomFactor(m_zoomFactor);
     updateComparison(m_slider->value());
+  } else {
+    m_differenceView->setZoomFactor(m_zoomFactor);
   }
 }
 
@@ -1,15 +1,19 @@
 #ifndef IMAGECOMPARISONWIDGET_H
 #define IMAGECOMPARISONWIDGET_H
 
-#include "draggablelabel.h"
+#include "imagepyramid.h"
+#include "tiledimageview.h"
 
 #include <QCheckBox>
+#include <QComboBox>
 #include <QDialog>
+#include <QHBoxLayout>
 #include <QLabel>
-#include <QPixmap>
 #include <QScrollArea>
 #include <QScrollBar>
+#include <QSharedPointer>
 #include <QSlider>
+#include <QSpinBox>
 #include <QVBoxLayout>
 
 class ImageComparisonWidget : public QDialog {
@@ -23,7 +27,8 @@ public:
 
 private slots:
   void updateComparison(int value);
-  void toggleView();
+  void setViewMode(int index);
+  void updateDifferenceParameters();
   void syncScrollBars();
   void onLeftScrollChanged();
   void onRightScrollChanged();
@@ -34,37 +39,45 @@ private slots:
   void zoomFit();
 
 private:
+  enum ViewMode { SideBySideView, SliderView, DifferenceView };
+
   void setupUI();
+  void addZoomControls(QHBoxLayout *layout);
   void loadImages();
   void showSideBySide();
   void showOverlay();
+  void showDifference();
   void saveViewMode();
   void loadViewMode();
 
   QString m_originalPath;
   QString m_optimizedPath;
 
-  QPixmap m_originalPixmap;
-  QPixmap m_optimizedPixmap;
+  QSharedPointer<ImagePyramid> m_originalImage;
+  QSharedPointer<ImagePyramid> m_optimizedImage;
 
-  QLabel *m_imageLabel;
-  DraggableLabel *m_leftLabel;
-  DraggableLabel *m_rightLabel;
+  TiledImageView *m_overlayView;
+  TiledImageView *m_leftView;
+  TiledImageView *m_rightView;
+  TiledImageView *m_differenceView;
   QSlider *m_slider;
-  QPushButton *m_toggleButton;
+  QComboBox *m_viewModeCombo;
   QWidget *m_sideBySideWidget;
   QWidget *m_overlayWidget;
+  QWidget *m_differenceWidget;
+  QSpinBox *m_amplificationSpinBox;
+  QSpinBox *m_thresholdSpinBox;
   QCheckBox *m_syncScrollCheckbox;
   QScrollArea *m_leftScroll;
   QScrollArea *m_rightScroll;
+  QScrollArea *m_overlayScroll;
+  QScrollArea *m_differenceScroll;
 
-  bool m_isSideBySideView;
+  ViewMode m_viewMode;
   bool m_syncScrollBars;
   bool m_updatingScrollBars;
 
   double m_zoomFactor;
-  QPixmap m_originalPixmapScaled;
-  QPixmap m_optimizedPixmapScaled;
 
   void updateZoom();
   void applyZoom(double factor);
@@ -7,13 +7,19 @@
 #include <QFileInfo>
 #include <QGridLayout>
 #include <QHBoxLayout>
-#include <QImageReader>
+#include <QLocale>
 #include <QMessageBox>
 
 ImageDetailPanel::ImageDetailPanel(QWidget *parent)
     : QWidget(parent), m_currentTask(nullptr), m_settings(Settings::instance()),
-      m_currentOptimizerWidget(nullptr) {
+      m_currentOptimizerWidget(nullptr),
+      m_previewLoader(new PreviewLoader(this)), m_previewRequestId(0) {
   setupUI();
+
+  connect(m_previewLoader, &PreviewLoader::previewReady, this,
+          &ImageDetailPanel::onPreviewReady);
+  connect(m_previewLoader, &PreviewLoader::previewFailed, this,
+          &ImageDetailPanel::onPreviewFailed);
 }
 
 ImageDetailPanel::~ImageDetailPanel() {}
@@ -48,6 +54,8 @@ void ImageDetailPanel::setupUI() {
   m_sizeLabel = new QLabel(tr("-"));
   m_dimensionsLabel = new QLabel(tr("-"));
   m_formatLabel = new QLabel(tr("-"));
+  m_headerLabel = new QLabel(tr("-"));
+  m_headerLabel->setWordWrap(true);
 
   m_filenameLabel->setWordWrap(true);
   m_filenameLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
@@ -64,6 +72,9 @@ void ImageDetailPanel::setupUI() {
   infoLayout->addWidget(new QLabel(tr("<b>Format:</b>")), 3, 0);
   infoLayout->addWidget(m_formatLabel, 3, 1);
 
+  infoLayout->addWidget(new QLabel(tr("<b>Details:</b>")), 4, 0);
+  infoLayout->addWidget(m_headerLabel, 4, 1);
+
   contentLayout->addWidget(infoGroup);
 
   // Output Settings Section
@@ -192,6 +203,7 @@ void ImageDetailPanel::setImageTask(ImageTask *task) {
 
 void ImageDetailPanel::clear() {
   m_currentTask = nullptr;
+  m_previewLoader->cancel();
 
   m_previewLabel->clear();
   m_previewLabel->setText(tr("No image selected"));
@@ -200,6 +212,7 @@ void ImageDetailPanel::clear() {
   m_sizeLabel->setText(tr("-"));
   m_dimensionsLabel->setText(tr("-"));
   m_formatLabel->setText(tr("-"));
+  m_headerLabel->setText(tr("-"));
 
   // Clear output settings
   m_useCustomOutputCheckBox->setChecked(false);
@@ -231,52 +244,14 @@ void ImageDetailPanel::updateImagePreview() {
     return;
   }
 
-  QFileInfo fileInfo(m_currentTask->imagePath);
-  if (!fileInfo.exists()) {
-    m_previewLabel->setText(tr("Image file not found"));
-    return;
-  }
-
-  // Load image
-  QImageReader reader(m_currentTask->imagePath);
-  if (!reader.canRead()) {
-    m_previewLabel->setText(tr("Cannot read image"));
-    return;
-  }
-
-  QImage image = reader.read();
-  if (image.isNull()) {
-    m_previewLabel->setText(tr("Failed to load image"));
-    return;
-  }
-
-  // Convert to pixmap and scale only if larger than max preview size
-  m_originalPixmap = QPixmap::fromImage(image);
+  // Decoding happens on the preview loader's thread, see onPreviewReady()
+  m_previewLabel->clear();
+  m_previewLabel->setText(tr("Loading preview..."));
+  m_previewLabel->setToolTip("");
 
   const int maxPreviewSize = 250;
-  QPixmap displayPixmap;
-
-  if (m_originalPixmap.width() > maxPreviewSize ||
-      m_originalPixmap.height() > maxPreviewSize) {
-    // Scale down large images
-    displayPixmap =
-        m_originalPixmap.scaled(maxPreviewSize, maxPreviewSize,
-                                Qt::KeepAspectRatio, Qt::SmoothTransformation);
-  } else {
-    // Use original size for small images
-    displayPixmap = m_originalPixmap;
-  }
-
-  m_previewLabel->setPixmap(displayPixmap);
-
-  // Add note for GIF images (only shows first frame)
-  QString extension = fileInfo.suffix().toLower();
-  if (extension == "gif") {
-    m_previewLabel->setToolTip(
-        tr("Note: GIF preview shows only the first frame, not the animation"));
-  } else {
-    m_previewLabel->setToolTip("");
-  }
+  m_previewRequestId =
+      m_previewLoader->requestPreview(m_currentTask->imagePath(), maxPreviewSize);
 }
 
 void ImageDetailPanel::updateImageInfo() {
@@ -284,7 +259,7 @@ void ImageDetailPanel::updateImageInfo() {
     return;
   }
 
-  QFileInfo fileInfo(m_currentTask->imagePath);
+  QFileInfo fileInfo(m_currentTask->imagePath());
 
   // Filename
   m_filenameLabel->setText(fileInfo.fileName());
@@ -301,25 +276,93 @@ void ImageDetailPanel::updateImageInfo() {
   }
   m_sizeLabel->setText(sizeText);
 
-  // Dimensions
-  QImageReader reader(m_currentTask->imagePath);
-  QSize imageSize = reader.size();
-  if (imageSize.isValid()) {
+  // Dimensions and format come from the same reader that decodes the preview
+  m_dimensionsLabel->setText(tr("..."));
+  m_formatLabel->setText(tr("..."));
+
+  updateHeaderInfo();
+}
+
+void ImageDetailPanel::updateImageHeader(ImageTask *task) {
+  if (task && task == m_currentTask) {
+    updateHeaderInfo();
+  }
+}
+
+void ImageDetailPanel::updateHeaderInfo() {
+  const ImageHeader::Info &header = m_currentTask->header;
+  if (!header.valid) {
+    m_headerLabel->setText(tr("..."));
+    return;
+  }
+
+  // Known before the preview is decoded
+  m_dimensionsLabel->setText(
+      QString("%1 × %2").arg(header.width).arg(header.height));
+
+  QStringList details;
+  QString colorType = ImageHeader::colorTypeToString(header.colorType);
+  if (header.colorType == ImageHeader::Vector || header.bitDepth == 0) {
+    details << colorType;
+  } else {
+    details << tr("%1-bit %2").arg(header.bitDepth).arg(colorType);
+  }
+  if (header.progressive) {
+    details << (m_currentTask->imageType == ImageType::JPG
+                    ? tr("progressive")
+                    : tr("interlaced"));
+  }
+  if (header.frameCount > 1) {
+    details << tr("%1 frames").arg(header.frameCount);
+  }
+  details << tr("%1 of metadata")
+                 .arg(QLocale().formattedDataSize(header.metadataBytes));
+  m_headerLabel->setText(details.join(", "));
+}
+
+void ImageDetailPanel::onPreviewReady(quint64 requestId,
+                                      const QString &imagePath,
+                                      const QImage &image,
+                                      const QSize &originalSize,
+                                      const QByteArray &format) {
+  // Ignore results for a selection that is no longer current
+  if (!m_currentTask || requestId != m_previewRequestId ||
+      imagePath != m_currentTask->imagePath()) {
+    return;
+  }
+
+  m_previewLabel->setPixmap(QPixmap::fromImage(image));
+
+  if (originalSize.isValid()) {
     m_dimensionsLabel->setText(
-        QString("%1 × %2").arg(imageSize.width()).arg(imageSize.height()));
+        QString("%1 × %2").arg(originalSize.width()).arg(originalSize.height()));
   } else {
     m_dimensionsLabel->setText(tr("Unknown"));
   }
 
-  // Format
-  QString format = QString::fromLatin1(reader.format()).toUpper();
-  QString extension = fileInfo.suffix().toLower();
-
-  if (extension == "gif") {
-    m_formatLabel->setText(format + tr(" (preview shows first frame only)"));
+  // Add note for GIF images (only shows first frame)
+  QString formatText = QString::fromLatin1(format).toUpper();
+  if (m_currentTask->imageType == ImageType::GIF) {
+    m_previewLabel->setToolTip(
+        tr("Note: GIF preview shows only the first frame, not the animation"));
+    m_formatLabel->setText(formatText + tr(" (preview shows first frame only)"));
   } else {
-    m_formatLabel->setText(format);
+    m_previewLabel->setToolTip("");
+    m_formatLabel->setText(formatText);
+  }
+}
+
+void ImageDetailPanel::onPreviewFailed(quint64 requestId,
+                                       const QString &imagePath,
+                                       const QString &errorString) {
+  if (!m_currentTask || requestId != m_previewRequestId ||
+      imagePath != m_currentTask->imagePath()) {
+    return;
   }
+
+  m_previewLabel->setText(errorString);
+  m_dimensionsLabel->setText(tr("Unknown"));
+  m_formatLabel->setText(tr("Unknown"));
 }
 
 void ImageDetailPanel::updateOptimizerSettings() {
@@ -345,11 +388,9 @@ void ImageDetailPanel::loadOptimizerWidget() {
     return;
   }
 
-  // Determine image type from file extension
-  QFileInfo fileInfo(m_currentTask->imagePath);
-  QString extension = fileInfo.suffix().toLower();
+  // Determine image type from the file content
   ImageType imageType =
-      ImageWorkerFactory::instance().getImageTypeByExtension(extension);
+      ImageWorkerFactory::instance().getImageType(m_currentTask);
 
   if (imageType == ImageType::Unsupported) {
     QLabel *noOptimizerLabel =
@@ -361,9 +402,10 @@ void ImageDetailPanel::loadOptimizerWidget() {
     return;
   }
 
-  // Get the optimizer for this image type
-  ImageOptimizer optimizer =
-      ImageWorkerFactory::instance().getOptimizerByImageType(imageType);
+  // Get the optimizer picked for this image type
+  ImageOptimizer optimizer = ImageWorkerFactory::instance().getOptimizer(
+      imageType, m_settings.getFormatOptimizer(
+                     ImageTypeUtils::imageTypeToString(imageType)));
 
   // Create the preference widget without scroll area wrapping (we have outer scroll area)
   QWidget *prefWidget =
@@ -385,7 +427,7 @@ void ImageDetailPanel::loadOptimizerWidget() {
       // Load custom settings if task has them, otherwise load global settings
       if (m_currentTask->hasCustomOptimizerSettings()) {
         optimizerWidget->loadCustomSettings(m_currentTask->customOptimizerSettings);
-        qDebug() << "Loaded custom settings into widget for task:" << m_currentTask->imagePath;
+        qDebug() << "Loaded custom settings into widget for task:" << m_currentTask->imagePath();
       }
     }
   } else {
@@ -532,10 +574,10 @@ void ImageDetailPanel::onSaveOptimizerSettings() {
   }
 
   // Determine file type for logging
-  QFileInfo fileInfo(m_currentTask->imagePath);
+  QFileInfo fileInfo(m_currentTask->imagePath());
   QString extension = fileInfo.suffix().toLower();
 
-  qDebug() << "Saving custom settings for task:" << m_currentTask->imagePath;
+  qDebug() << "Saving custom settings for task:" << m_currentTask->imagePath();
   qDebug() << "Settings:" << customSettings;
 
   // Emit signal with the custom settings
@@ -545,10 +587,22 @@ void ImageDetailPanel::onSaveOptimizerSettings() {
   m_customSettingsIndicator->setVisible(true);
   m_resetOptimizerButton->setVisible(true);
 
-  // Show confirmation
-  QMessageBox::information(this, tr("Settings Saved"),
-                          tr("Custom optimization settings saved for this image.\n\n"
-                             "These settings will be used instead of global settings when processing this image."));
+  // Show confirmation, offer to try the settings right away
+  if (m_currentTask->taskStatus == ImageTask::Processing) {
+    QMessageBox::information(this, tr("Settings Saved"),
+                            tr("Custom optimization settings saved for this image.\n\n"
+                               "These settings will be used instead of global settings when processing this image."));
+    return;
+  }
+
+  QMessageBox::StandardButton reply = QMessageBox::question(
+      this, tr("Settings Saved"),
+      tr("Custom optimization settings saved for this image.\n\n"
+         "Optimize it now with these settings, ahead of the queued images?"),
+      QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
+  if (reply == QMessageBox::Yes) {
+    emit optimizeNowRequested(m_currentTask);
+  }
 }
 
 void ImageDetailPanel::onResetOptimizerSettings() {
@@ -2,6 +2,7 @@
 #define IMAGEDETAILPANEL_H
 
 #include "imagetask.h"
+#include "previewloader.h"
 #include "settings.h"
 
 #include <QCheckBox>
@@ -22,6 +23,8 @@ public:
 
   void setImageTask(ImageTask *task);
   void clear();
+  // The header pre-flight of the task finished
+  void updateImageHeader(ImageTask *task);
 
 signals:
   void customOutputDirChanged(ImageTask *task, const QString &dir);
@@ -30,6 +33,8 @@ signals:
   void customOutputPrefixCleared(ImageTask *task);
   void customOptimizerSettingsChanged(ImageTask *task, const QVariantMap &settings);
   void customOptimizerSettingsCleared(ImageTask *task);
+  // Optimize the task ahead of the queued batch
+  void optimizeNowRequested(ImageTask *task);
 
 private slots:
   void onChangeOutputDir();
@@ -37,11 +42,17 @@ private slots:
   void onOutputPrefixChanged(const QString &text);
   void onSaveOptimizerSettings();
   void onResetOptimizerSettings();
+  void onPreviewReady(quint64 requestId, const QString &imagePath,
+                      const QImage &image, const QSize &originalSize,
+                      const QByteArray &format);
+  void onPreviewFailed(quint64 requestId, const QString &imagePath,
+                       const QString &errorString);
 
 private:
   void setupUI();
   void updateImagePreview();
   void updateImageInfo();
+  void updateHeaderInfo();
   void updateOptimizerSettings();
   void updateOutputSettings();
   void loadOptimizerWidget();
@@ -55,6 +66,7 @@ private:
   QLabel *m_sizeLabel;
   QLabel *m_dimensionsLabel;
   QLabel *m_formatLabel;
+  QLabel *m_headerLabel;
   QVBoxLayout *m_optimizerSettingsLayout;
   QWidget *m_currentOptimizerWidget;
   QPushButton *m_saveOptimizerButton;
@@ -67,7 +79,9 @@ private:
   QLineEdit *m_outputPrefixLineEdit;
   QPushButton *m_changeOutputDirButton;
 
-  QPixmap m_originalPixmap;
+  // Background preview decoding
+  PreviewLoader *m_previewLoader;
+  quint64 m_previewRequestId;
 };
 
 #endif // IMAGEDETAILPANEL_H
@@ -1,6 +1,7 @@
 #include "imageformatprefwidget.h"
 #include "OptimizerPrefWidgets/imageformatprefwidgetfactory.h"
 #include "OptimizerPrefWidgets/imageoptimizerprefwidget.h"
+#include "settings.h"
 #include "ui_imageformatprefwidget.h"
 
 #include <QDebug>
@@ -10,7 +11,7 @@ ImageFormatPrefWidget::ImageFormatPrefWidget(QWidget *parent,
                                              QString formatName,
                                              QList<ImageOptimizer> optimizers)
     : QWidget(parent), ui(new Ui::ImageFormatPrefWidget),
-      m_formatName(formatName),
+      m_formatName(formatName), m_optimizers(optimizers),
       m_optimizer(optimizers.isEmpty() ? ImageOptimizer() : optimizers.at(0)) {
   ui->setupUi(this);
 
@@ -30,6 +31,31 @@ ImageFormatPrefWidget::ImageFormatPrefWidget(QWidget *parent,
   ui->formatName->setText(formatName);
   ui->optimizerLabel->setText(m_optimizer.isValid() ? m_optimizer.getName() : tr("None"));
 
+  // Formats with conversions pick their optimizer, the first is in-format
+  QString selected = Settings::instance().getFormatOptimizer(formatName);
+  int selectedIndex = 0;
+  for (int i = 0; i < m_optimizers.count(); ++i) {
+    const ImageOptimizer &optimizer = m_optimizers.at(i);
+    ui->optimizerComboBox->addItem(
+        optimizer.convertsFormat()
+            ? tr("%1 (to %2)").arg(optimizer.getName(),
+                                   optimizer.getOutputFormat().toUpper())
+            : optimizer.getName());
+    if (optimizer.getName() == selected) {
+      selectedIndex = i;
+    }
+  }
+  ui->optimizerComboBox->setCurrentIndex(selectedIndex);
+  ui->optimizerComboBox->setVisible(m_optimizers.count() > 1);
+  ui->optimizerLabel->setVisible(m_optimizers.count() <= 1);
+  connect(ui->optimizerComboBox,
+          QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+          [=](int index) {
+            selectOptimizer(index);
+            Settings::instance().setFormatOptimizer(m_formatName,
+                                                    m_optimizer.getName());
+          });
+
   connect(ui->formatSettingsPushButton, &QPushButton::clicked, this, [=]() {
     if (m_optimizer.isValid()) {
       ImageFormatPrefWidgetFactory::instance().openPrefWidgetFor(m_optimizer);
@@ -69,6 +95,12 @@ ImageFormatPrefWidget::ImageFormatPrefWidget(QWidget *parent,
     }
   });
 
+  selectOptimizer(selectedIndex);
+}
+
+void ImageFormatPrefWidget::selectOptimizer(int index) {
+  m_optimizer = m_optimizers.value(index);
+
   bool hasWidget = m_optimizer.isValid() &&
                    ImageFormatPrefWidgetFactory::instance().hasPrefWidgetFor(m_optimizer);
 
@@ -24,7 +24,9 @@ public:
 private:
   Ui::ImageFormatPrefWidget *ui;
   QString m_formatName;
-  ImageOptimizer m_optimizer;
+  QList<ImageOptimizer> m_optimizers;
+  ImageOptimizer m_optimizer; // the one picked for the format
+  void selectOptimizer(int index);
   void updateTooltips();
 };
 
@@ -0,0 +1,220 @@
+#include "imagepyramid.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QPainter>
+
+#include <cmath>
+
+namespace {
+
+// Levels smaller than this are not worth building
+const int MIN_LEVEL_SIZE = 64;
+
+} // namespace
+
+ImagePyramid::ImagePyramid()
+    : m_baseScale(1.0), m_canDecodeRegions(false), m_levelCount(0) {}
+
+bool ImagePyramid::load(const QString &imagePath, qint64 maxPixelsInMemory) {
+  QMutexLocker locker(&m_mutex);
+
+  m_imagePath = imagePath;
+  m_levels.clear();
+  m_levelCount = 0;
+  m_baseScale = 1.0;
+  m_canDecodeRegions = false;
+
+  if (!QFileInfo::exists(imagePath)) {
+    m_errorString = QObject::tr("Image file not found");
+    return false;
+  }
+
+  QImageReader reader(imagePath);
+  if (!reader.canRead()) {
+    m_errorString = QObject::tr("Cannot read image");
+    return false;
+  }
+
+  m_size = reader.size();
+
+  // Too large to keep at full resolution, decode a reduced base level and
+  // fetch the detail from the file when zoomed in
+  if (m_size.isValid() &&
+      qint64(m_size.width()) * m_size.height() > maxPixelsInMemory) {
+    double scale = std::sqrt(double(maxPixelsInMemory) /
+                             (double(m_size.width()) * m_size.height()));
+    reader.setScaledSize(QSize(qMax(1, int(m_size.width() * scale)),
+                               qMax(1, int(m_size.height() * scale))));
+    m_canDecodeRegions = reader.supportsOption(QImageIOHandler::ClipRect);
+  }
+
+  QImage base = reader.read();
+  if (base.isNull()) {
+    m_errorString = reader.errorString();
+    return false;
+  }
+
+  if (!m_size.isValid()) {
+    m_size = base.size();
+  }
+  m_baseScale = double(base.width()) / m_size.width();
+
+  if (m_baseScale < 1.0) {
+    qDebug() << "Image" << imagePath << "exceeds the preview budget, base level"
+             << base.size() << (m_canDecodeRegions ? "with" : "without")
+             << "region decoding";
+  }
+
+  // Premultiplied ARGB is the fast path for QPainter
+  m_levels.append(base.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+
+  m_levelCount = 1;
+  QSize levelSize = base.size();
+  while (levelSize.width() / 2 >= MIN_LEVEL_SIZE &&
+         levelSize.height() / 2 >= MIN_LEVEL_SIZE) {
+    levelSize /= 2;
+    ++m_levelCount;
+  }
+
+  m_errorString.clear();
+  return true;
+}
+
+bool ImagePyramid::isNull() const {
+  QMutexLocker locker(&m_mutex);
+  return m_levels.isEmpty();
+}
+
+QString ImagePyramid::errorString() const {
+  QMutexLocker locker(&m_mutex);
+  return m_errorString;
+}
+
+QSize ImagePyramid::size() const {
+  QMutexLocker locker(&m_mutex);
+  return m_size;
+}
+
+int ImagePyramid::levelCount() const {
+  QMutexLocker locker(&m_mutex);
+  return m_levelCount;
+}
+
+double ImagePyramid::levelScale(int level) const {
+  QMutexLocker locker(&m_mutex);
+  return m_baseScale / double(1 << level);
+}
+
+int ImagePyramid::levelForScale(double scale) const {
+  QMutexLocker locker(&m_mutex);
+  int level = 0;
+  while (level + 1 < m_levelCount &&
+         m_baseScale / double(1 << (level + 1)) >= scale) {
+    ++level;
+  }
+  return level;
+}
+
+QImage ImagePyramid::level(int level) {
+  QMutexLocker locker(&m_mutex);
+  if (m_levels.isEmpty() || level < 0) {
+    return QImage();
+  }
+  level = qMin(level, m_levelCount - 1);
+
+  // Each level is a box filtered half of the previous one
+  while (m_levels.size() <= level) {
+    const QImage &previous = m_levels.last();
+    m_levels.append(previous.scaled(previous.width() / 2, previous.height() / 2,
+                                    Qt::IgnoreAspectRatio,
+                                    Qt::SmoothTransformation));
+  }
+  return m_levels.at(level);
+}
+
+bool ImagePyramid::needsRegionDecode(const QRectF &sourceRect,
+                                     const QSize &targetSize) const {
+  QMutexLocker locker(&m_mutex);
+  if (!m_canDecodeRegions || sourceRect.isEmpty()) {
+    return false;
+  }
+  double scale = targetSize.width() / sourceRect.width();
+  return scale > m_baseScale;
+}
+
+QImage ImagePyramid::render(const QRectF &sourceRect, const QSize &targetSize) {
+  QImage target(targetSize, QImage::Format_ARGB32_Premultiplied);
+  target.fill(Qt::transparent);
+  if (sourceRect.isEmpty() || targetSize.isEmpty()) {
+    return target;
+  }
+
+  double scale = targetSize.width() / sourceRect.width();
+  int index = levelForScale(scale);
+  QImage source = level(index);
+  if (source.isNull()) {
+    return target;
+  }
+  double sourceScale = levelScale(index);
+
+  QRectF levelRect(sourceRect.x() * sourceScale, sourceRect.y() * sourceScale,
+                   sourceRect.width() * sourceScale,
+                   sourceRect.height() * sourceScale);
+
+  QPainter painter(&target);
+  // Keep pixels sharp when zoomed in, that is where artifacts are inspected
+  painter.setRenderHint(QPainter::SmoothPixmapTransform,
+                        scale < sourceScale);
+  painter.drawImage(QRectF(QPointF(0, 0), QSizeF(targetSize)), source,
+                    levelRect);
+  return target;
+}
+
+QImage ImagePyramid::renderFromFile(const QRectF &sourceRect,
+                                    const QSize &targetSize) const {
+  QString imagePath;
+  QSize imageSize;
+  {
+    QMutexLocker locker(&m_mutex);
+    imagePath = m_imagePath;
+    imageSize = m_size;
+  }
+
+  QRect clipRect = sourceRect.toAlignedRect() & QRect(QPoint(0, 0), imageSize);
+  if (clipRect.isEmpty()) {
+    return QImage();
+  }
+
+  QImageReader reader(imagePath);
+  reader.setClipRect(clipRect);
+  // Only scale down in the decoder, zooming in stays nearest neighbour
+  bool zoomedIn = targetSize.width() > clipRect.width();
+  if (!zoomedIn) {
+    reader.setScaledSize(targetSize);
+  }
+
+  QImage region = reader.read();
+  if (region.isNull()) {
+    qDebug() << "Region decode failed for" << imagePath << reader.errorString();
+    return QImage();
+  }
+
+  region = region.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  if (!zoomedIn) {
+    return region;
+  }
+
+  // The aligned clip rect may start before the requested region
+  QRectF regionRect(sourceRect.x() - clipRect.x(),
+                    sourceRect.y() - clipRect.y(), sourceRect.width(),
+                    sourceRect.height());
+  QImage target(targetSize, QImage::Format_ARGB32_Premultiplied);
+  target.fill(Qt::transparent);
+  QPainter painter(&target);
+  painter.drawImage(QRectF(QPointF(0, 0), QSizeF(targetSize)), region,
+                    regionRect);
+  return target;
+}
@@ -0,0 +1,68 @@
+#ifndef IMAGEPYRAMID_H
+#define IMAGEPYRAMID_H
+
+#include <QImage>
+#include <QMutex>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+// Mip pyramid of a single image, used for tiled rendering.
+//
+// The base level is the decoded image, unless the image has more pixels than
+// the memory budget allows; in that case the base level is decoded at a
+// reduced size and, when the image plugin can decode sub-regions (JPEG),
+// regions needed above the base resolution are decoded straight from the
+// file. Smaller levels are built lazily by halving the previous one.
+//
+// All methods are thread safe so tiles can be rendered on a thread pool.
+class ImagePyramid {
+public:
+  // 32 megapixels, ~128 MB for a 32-bit base level
+  static const qint64 DEFAULT_MAX_PIXELS = 32 * 1024 * 1024;
+
+  ImagePyramid();
+
+  bool load(const QString &imagePath,
+            qint64 maxPixelsInMemory = DEFAULT_MAX_PIXELS);
+
+  bool isNull() const;
+  QString errorString() const;
+
+  // Full resolution size of the image
+  QSize size() const;
+
+  int levelCount() const;
+  // Pixels of the level per pixel of the full resolution image
+  double levelScale(int level) const;
+  // Smallest level that still has at least the requested scale
+  int levelForScale(double scale) const;
+  QImage level(int level);
+
+  // True if rendering this region at this size needs more detail than the
+  // base level holds and the region can be decoded from the file
+  bool needsRegionDecode(const QRectF &sourceRect,
+                         const QSize &targetSize) const;
+
+  // Renders a region given in full resolution coordinates into an image of
+  // targetSize using the in-memory levels
+  QImage render(const QRectF &sourceRect, const QSize &targetSize);
+
+  // Renders a region decoding it from the file at the requested size
+  QImage renderFromFile(const QRectF &sourceRect,
+                        const QSize &targetSize) const;
+
+private:
+  QString m_imagePath;
+  QString m_errorString;
+  QSize m_size;
+  double m_baseScale;
+  bool m_canDecodeRegions;
+  int m_levelCount;
+
+  mutable QMutex m_mutex;
+  QVector<QImage> m_levels;
+};
+
+#endif // IMAGEPYRAMID_H
@@ -1,5 +1,7 @@
 #include "imagestats.h"
 
+#include <worker/jpegreconstructor.h>
+
 ImageStats::ImageStats(const QString &originalFilePath, const QString &optimizedFilePath)
     : originalFileInfo(originalFilePath), optimizedFileInfo(optimizedFilePath) {}
 
@@ -21,3 +23,8 @@ double ImageStats::getCompressionPercentage() const {
     }
     return 100.0 * (1.0 - static_cast<double>(getOptimizedSize()) / static_cast<double>(getOriginalSize()));
 }
+
+bool ImageStats::isJpegReconstructible() const {
+    return JpegReconstructor::hasReconstructionData(
+        optimizedFileInfo.absoluteFilePath());
+}
@@ -12,6 +12,9 @@ public:
     qint64 getOptimizedSize() const;
     qint64 getSavings() const;
     double getCompressionPercentage() const;
+    // The optimized file carries JPEG reconstruction data, only a round trip
+    // proves it restores the original (see JpegReconstructor::verify)
+    bool isJpegReconstructible() const;
 
 private:
     QFileInfo originalFileInfo;
@@ -0,0 +1,176 @@
+#include "imagetask.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QReadLocker>
+#include <QReadWriteLock>
+#include <QVector>
+#include <QWriteLocker>
+
+#include <cstddef>
+#include <new>
+
+namespace {
+
+// Directories of all paths of the session, tasks keep an index. Never
+// shrinks, a session has few directories compared to files.
+class DirectoryTable {
+public:
+  quint32 intern(const QString &directory) {
+    {
+      QReadLocker locker(&m_lock);
+      auto it = m_ids.constFind(directory);
+      if (it != m_ids.cend()) {
+        return it.value();
+      }
+    }
+    QWriteLocker locker(&m_lock);
+    auto it = m_ids.constFind(directory);
+    if (it != m_ids.cend()) {
+      return it.value();
+    }
+    quint32 id = quint32(m_directories.size());
+    m_directories.append(directory);
+    m_ids.insert(directory, id);
+    return id;
+  }
+
+  QString directory(quint32 id) const {
+    QReadLocker locker(&m_lock);
+    return m_directories.at(int(id));
+  }
+
+private:
+  mutable QReadWriteLock m_lock;
+  QVector<QString> m_directories;
+  QHash<QString, quint32> m_ids;
+};
+
+DirectoryTable &directoryTable() {
+  static DirectoryTable table;
+  return table;
+}
+
+// Fixed size slots carved out of large blocks, freed slots are reused
+// before a new block is allocated. Saves the per allocation overhead of the
+// heap for every task and keeps tasks of a session close together.
+class TaskPool {
+public:
+  void *allocate() {
+    QMutexLocker locker(&m_mutex);
+    if (!m_freeSlots) {
+      char *block =
+          static_cast<char *>(::operator new(SLOT_SIZE * BLOCK_SLOTS));
+      m_blocks.append(block);
+      for (int i = BLOCK_SLOTS - 1; i >= 0; --i) {
+        Slot *slot = reinterpret_cast<Slot *>(block + i * SLOT_SIZE);
+        slot->next = m_freeSlots;
+        m_freeSlots = slot;
+      }
+    }
+    Slot *slot = m_freeSlots;
+    m_freeSlots = slot->next;
+    return slot;
+  }
+
+  void release(void *pointer) {
+    QMutexLocker locker(&m_mutex);
+    Slot *slot = static_cast<Slot *>(pointer);
+    slot->next = m_freeSlots;
+    m_freeSlots = slot;
+  }
+
+private:
+  struct Slot {
+    Slot *next;
+  };
+
+  static constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+  static constexpr size_t SLOT_SIZE =
+      (qMax(sizeof(ImageTask), sizeof(Slot)) + ALIGNMENT - 1) &
+      ~(ALIGNMENT - 1);
+  static constexpr int BLOCK_SLOTS = 4096;
+
+  QMutex m_mutex;
+  QVector<char *> m_blocks; // kept for the lifetime of the process
+  Slot *m_freeSlots = nullptr;
+};
+
+TaskPool &taskPool() {
+  static TaskPool pool;
+  return pool;
+}
+
+void splitPath(const QString &path, quint32 *directory, QString *name) {
+  int separator = path.lastIndexOf('/');
+  *directory = directoryTable().intern(path.left(separator + 1));
+  *name = path.mid(separator + 1);
+}
+
+} // namespace
+
+ImageTask::ImageTask(const QString &src, const QString &dst)
+    : taskStatus(Pending) {
+  splitPath(src, &m_imageDirectory, &m_imageName);
+  setOptimizedPath(dst);
+}
+
+void *ImageTask::operator new(size_t size) {
+  // Subclasses don't fit in a slot
+  if (size != sizeof(ImageTask)) {
+    return ::operator new(size);
+  }
+  return taskPool().allocate();
+}
+
+void ImageTask::operator delete(void *pointer, size_t size) {
+  if (!pointer) {
+    return;
+  }
+  if (size != sizeof(ImageTask)) {
+    ::operator delete(pointer);
+    return;
+  }
+  taskPool().release(pointer);
+}
+
+QString ImageTask::imagePath() const {
+  return directoryTable().directory(m_imageDirectory) + m_imageName;
+}
+
+QString ImageTask::optimizedPath() const {
+  return directoryTable().directory(m_optimizedDirectory) + m_optimizedName;
+}
+
+void ImageTask::setOptimizedPath(const QString &path) {
+  splitPath(path, &m_optimizedDirectory, &m_optimizedName);
+}
+
+QPair<quint32, QString> ImageTask::pathKey(const QString &path) {
+  QPair<quint32, QString> key;
+  splitPath(path, &key.first, &key.second);
+  return key;
+}
+
+QVariantMap ImageTask::internSettings(const QVariantMap &settings) {
+  static QMutex mutex;
+  static QHash<QByteArray, QVariantMap> maps;
+
+  if (settings.isEmpty()) {
+    return QVariantMap();
+  }
+  QByteArray key;
+  QDataStream stream(&key, QIODevice::WriteOnly);
+  stream << settings;
+
+  QMutexLocker locker(&mutex);
+  auto it = maps.constFind(key);
+  if (it != maps.cend()) {
+    return it.value();
+  }
+  maps.insert(key, settings);
+  return settings;
+}
@@ -1,18 +1,29 @@
 #ifndef IMAGETASK_H
 #define IMAGETASK_H
 
+#include "imagetype.h"
+#include "worker/imageheader.h"
+
 #include <QMetaType>
+#include <QPair>
+#include <QSharedPointer>
+#include <QSize>
 #include <QString>
 #include <QVariantMap>
 
+class SettingsSnapshot;
+
+// Sessions can hold a million tasks, so a task stays small: its paths are
+// an interned directory id plus a file name, rebuilt on access, and tasks
+// are allocated from a pool (see imagetask.cpp).
 struct ImageTask {
-  QString imagePath;     // Source image path
-  QString optimizedPath; // Destination (optimized) image path
   QString customOutputDir; // Custom output directory for this task (empty = use global default)
   QString customOutputPrefix; // Custom output prefix for this task (empty = use global default)
   QVariantMap customOptimizerSettings; // Custom optimization settings for this task (empty = use global defaults)
+  // Global and custom settings as of queueing, see SettingsSnapshot
+  QSharedPointer<const SettingsSnapshot> settingsSnapshot;
 
-  enum Status { Pending, Queued, Processing, Completed, Error };
+  enum Status : quint8 { Pending, Queued, Processing, Completed, Error };
 
   struct TaskStatusCounts {
     int completedCount = 0;
@@ -20,34 +31,99 @@ struct ImageTask {
     int errorCount = 0;
     int queuedCount = 0;
     int totalTasks = 0;
+    int unchangedCount = 0; // completed, output was not smaller
+  };
+
+  // What the CommitPolicy did with the output of a successful optimization
+  enum CommitOutcome : quint8 {
+    OutputCommitted,
+    OriginalKept,
+    OutputDiscarded
   };
 
   Status taskStatus;
+  // Sniffed from the file content, see ImageWorkerFactory::getImageType.
+  // Unsupported is a result too, imageTypeSniffed tells it from not yet
+  // sniffed.
+  ImageType imageType = ImageType::Unsupported;
+  bool imageTypeSniffed = false;
+  CommitOutcome commitOutcome = OutputCommitted;
+  // Removed from the output by the native metadata stage
+  qint64 metadataBytesRemoved = 0;
+  // Shrunk to by the resize stage, invalid when not resized
+  QSize resizedTo;
+  // The JPEG XL output was restored to the original JPEG and compared, see
+  // CjxlWorker
+  bool jpegRoundTripVerified = false;
+
+  // Read from the headers when the task is added, see HeaderAnalyzer
+  ImageHeader::Info header;
+
+  // Perceptual quality of the output, filled in by the quality post-stage
+  bool hasQualityMetrics = false;
+  double psnr = 0.0;
+  double ssim = 0.0;
+  double msSsim = 0.0;
+  int searchedQuality = -1; // picked by the SSIM targeted quality search
+
+  QString processedOn; // Host of the agent that optimized it, empty = here
+  // Error or result details, shown in the status tooltip
+  QString statusDetail;
+
+  // Set when the watchdog stopped its optimizer, see ImageWorker
+  bool timedOut = false;
+  int timeoutRetries = 0; // retries after a timeout so far
 
   QString statusToString() const {
     switch (taskStatus) {
     case Pending:
-      return "Pending";
+      return QStringLiteral("Pending");
     case Queued:
-      return "Queued";
+      return QStringLiteral("Queued");
     case Processing:
-      return "Processing";
+      return QStringLiteral("Processing");
     case Completed:
-      return "Completed";
+      return QStringLiteral("Completed");
     case Error:
-      return "Error";
+      return QStringLiteral("Error");
     default:
-      return "Unknown";
+      return QStringLiteral("Unknown");
     }
   }
 
-  ImageTask(const QString &src, const QString &dst)
-      : imagePath(src), optimizedPath(dst), taskStatus(Pending) {}
+  ImageTask(const QString &src, const QString &dst);
+
+  static void *operator new(size_t size);
+  static void operator delete(void *pointer, size_t size);
+
+  QString imagePath() const; // Source image path
+  QString fileName() const { return m_imageName; }
+  // Destination (optimized) image path
+  QString optimizedPath() const;
+  void setOptimizedPath(const QString &path);
+
+  // Identifies the source path without building it
+  QPair<quint32, QString> pathKey() const {
+    return qMakePair(m_imageDirectory, m_imageName);
+  }
+  QPair<quint32, QString> optimizedPathKey() const {
+    return qMakePair(m_optimizedDirectory, m_optimizedName);
+  }
+  static QPair<quint32, QString> pathKey(const QString &path);
+
+  // Identical custom settings share one map, e.g. across a resumed batch
+  static QVariantMap internSettings(const QVariantMap &settings);
 
   // Helper to check if task uses custom output settings
   bool hasCustomOutputDir() const { return !customOutputDir.isEmpty(); }
   bool hasCustomOutputPrefix() const { return !customOutputPrefix.isEmpty(); }
   bool hasCustomOptimizerSettings() const { return !customOptimizerSettings.isEmpty(); }
+
+private:
+  quint32 m_imageDirectory;
+  quint32 m_optimizedDirectory;
+  QString m_imageName;
+  QString m_optimizedName;
 };
 
 Q_DECLARE_METATYPE(ImageTask *)
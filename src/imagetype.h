@@ -3,7 +3,7 @@
 
 #include <QList>
 
-enum class ImageType { JPG, PNG, GIF, SVG, Unsupported };
+enum class ImageType : quint8 { JPG, PNG, GIF, SVG, Unsupported };
 
 class ImageTypeUtils {
 public:
@@ -1,20 +1,60 @@
 #include "pixelbatch.h"
 #include "constants.h"
+#include "workagent.h"
+
+#include <worker/imageworkerfactory.h>
+#include <worker/jpegreconstructor.h>
 
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QDir>
 #include <QFileInfo>
+#include <QThread>
 #include <QTimer>
 
+namespace {
+
+// Agents and JPEG restores run headless, decided before any application
+// object exists
+bool isHeadlessMode(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    if (qstrcmp(argv[i], "--agent") == 0 ||
+        qstrncmp(argv[i], "--agent=", 8) == 0 ||
+        qstrcmp(argv[i], "--restore-jpeg") == 0 ||
+        qstrncmp(argv[i], "--restore-jpeg=", 15) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Restores each JPEG next to its JPEG XL file, see JpegReconstructor
+int restoreJpegs(const QStringList &jxlPaths) {
+  int failed = 0;
+  for (const QString &jxlPath : jxlPaths) {
+    QString jpegPath = JpegReconstructor::defaultJpegPath(jxlPath);
+    QString errorString;
+    if (JpegReconstructor::restore(jxlPath, jpegPath, &errorString)) {
+      qInfo().noquote() << jpegPath;
+    } else {
+      qCritical().noquote() << errorString;
+      failed++;
+    }
+  }
+  return failed > 0 ? 1 : 0;
+}
+
+} // namespace
+
 int main(int argc, char *argv[]) {
-  QApplication a(argc, argv);
+  QScopedPointer<QCoreApplication> a(isHeadlessMode(argc, argv)
+                                         ? new QCoreApplication(argc, argv)
+                                         : new QApplication(argc, argv));
 
-  QApplication::setApplicationName(APPLICATION_FULLNAME);
-  QApplication::setDesktopFileName("com.ktechpit.pixelbatch");
-  QApplication::setOrganizationDomain("com.ktechpit");
-  QApplication::setOrganizationName("org.keshavnrj.ubuntu");
-  QApplication::setApplicationVersion(VERSIONSTR);
+  QCoreApplication::setApplicationName(APPLICATION_FULLNAME);
+  QCoreApplication::setOrganizationDomain("com.ktechpit");
+  QCoreApplication::setOrganizationName("org.keshavnrj.ubuntu");
+  QCoreApplication::setApplicationVersion(VERSIONSTR);
 
   qRegisterMetaType<ImageTask *>("ImageTask*");
 
@@ -24,11 +64,74 @@ int main(int argc, char *argv[]) {
   parser.addHelpOption();
   parser.addVersionOption();
   parser.addPositionalArgument("files", "Image files or folders to optimize", "[files...]");
-  parser.process(a);
+  QCommandLineOption resumeOption(
+      "resume", "Resume an interrupted batch without asking");
+  parser.addOption(resumeOption);
+  QCommandLineOption watchOption(
+      "watch", "Optimize images as they are written to <folder>", "folder");
+  parser.addOption(watchOption);
+  QCommandLineOption coordinatorOption(
+      "coordinator",
+      "Share the queue with agents connecting to <address> "
+      "(host:port or a socket path)",
+      "address");
+  parser.addOption(coordinatorOption);
+  QCommandLineOption agentOption(
+      "agent", "Run headless, optimizing images for the coordinator at "
+               "<address>. Both need the same secret in "
+               "PIXELBATCH_AGENT_SECRET, required over TCP",
+      "address");
+  parser.addOption(agentOption);
+  QCommandLineOption agentSlotsOption(
+      "agent-slots", "Images the agent optimizes at once", "count",
+      QString::number(QThread::idealThreadCount()));
+  parser.addOption(agentSlotsOption);
+  QCommandLineOption agentSharedPathsOption(
+      "agent-shared-paths",
+      "The agent sees the coordinator's files under the same paths");
+  parser.addOption(agentSharedPathsOption);
+  QCommandLineOption restoreJpegOption(
+      "restore-jpeg",
+      "Restore the original JPEG of a losslessly transcoded JPEG XL <file> "
+      "next to it, then exit",
+      "file");
+  parser.addOption(restoreJpegOption);
+  parser.process(*a);
+
+  if (parser.isSet(restoreJpegOption)) {
+    return restoreJpegs(parser.values(restoreJpegOption));
+  }
+
+  if (parser.isSet(agentOption)) {
+    WorkAgent agent(parser.value(agentOption),
+                    parser.value(agentSlotsOption).toInt(),
+                    parser.isSet(agentSharedPathsOption));
+    QString errorString;
+    if (!agent.start(&errorString)) {
+      qCritical().noquote() << errorString;
+      return 1;
+    }
+    return a->exec();
+  }
+
+  QGuiApplication::setDesktopFileName("com.ktechpit.pixelbatch");
 
   PixelBatch w;
   w.show();
 
+  // Offer to finish the batch of a session that was closed or killed
+  bool resume = parser.isSet(resumeOption);
+  QTimer::singleShot(0, &w, [&w, resume]() { w.checkInterruptedBatch(resume); });
+
+  if (parser.isSet(coordinatorOption)) {
+    w.listenForAgents(parser.value(coordinatorOption));
+  }
+
+  QStringList watchedFolders = parser.values(watchOption);
+  if (!watchedFolders.isEmpty()) {
+    w.watchFolders(watchedFolders);
+  }
+
   // Process command-line arguments (files/folders)
   QStringList args = parser.positionalArguments();
   if (!args.isEmpty()) {
@@ -43,17 +146,15 @@ int main(int argc, char *argv[]) {
           // Single file
           filesToAdd.append(fileInfo.absoluteFilePath());
         } else if (fileInfo.isDir()) {
-          // Directory - find all image files
+          // Directory - find all image files, by content so extensionless
+          // and misnamed files are found too
           QDir dir(fileInfo.absoluteFilePath());
-          QStringList nameFilters;
-          nameFilters << "*.jpg" << "*.jpeg" << "*.JPG" << "*.JPEG"
-                      << "*.png" << "*.PNG"
-                      << "*.gif" << "*.GIF"
-                      << "*.svg" << "*.SVG";
-
-          QFileInfoList files = dir.entryInfoList(nameFilters, QDir::Files);
+          QFileInfoList files = dir.entryInfoList(QDir::Files);
           for (const QFileInfo &file : files) {
-            filesToAdd.append(file.absoluteFilePath());
+            if (ImageWorkerFactory::instance().getImageType(
+                    file.absoluteFilePath()) != ImageType::Unsupported) {
+              filesToAdd.append(file.absoluteFilePath());
+            }
           }
         }
       }
@@ -65,5 +166,5 @@ int main(int argc, char *argv[]) {
     });
   }
 
-  return a.exec();
+  return a->exec();
 }
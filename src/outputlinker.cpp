@@ -0,0 +1,125 @@
+#include "outputlinker.h"
+#include "settings.h"
+
+#include <QDebug>
+#include <QFile>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(Q_OS_LINUX)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#elif defined(Q_OS_MACOS)
+#include <sys/clonefile.h>
+#endif
+
+OutputLinker::Mode OutputLinker::modeFromSettings() {
+  return modeFromInt(Settings::instance().getLinkUnchangedMode());
+}
+
+OutputLinker::Mode OutputLinker::modeFromInt(int mode) {
+  if (mode < CopyOnly || mode > ReflinkHardlinkOrCopy) {
+    mode = Constants::DEFAULT_TASK_LINK_UNCHANGED;
+  }
+  return static_cast<Mode>(mode);
+}
+
+bool OutputLinker::materialize(const QString &source,
+                               const QString &destination, Mode mode,
+                               Method *method, QString *errorString) {
+  if (QFile::exists(destination) && !QFile::remove(destination)) {
+    if (errorString) {
+      *errorString = QObject::tr("Unable to replace %1").arg(destination);
+    }
+    return false;
+  }
+
+  Method used = Copy;
+  if (mode != CopyOnly && reflink(source, destination)) {
+    used = Reflink;
+  } else if (mode == ReflinkHardlinkOrCopy && hardlink(source, destination)) {
+    used = Hardlink;
+  } else {
+    QFile original(source);
+    if (!original.copy(destination)) {
+      if (errorString) {
+        *errorString = original.errorString();
+      }
+      return false;
+    }
+  }
+
+  qDebug() << "Materialized" << destination << "by" << methodName(used);
+  if (method) {
+    *method = used;
+  }
+  return true;
+}
+
+QString OutputLinker::methodName(Method method) {
+  switch (method) {
+  case Reflink:
+    return "reflink";
+  case Hardlink:
+    return "hardlink";
+  case Copy:
+  default:
+    return "copy";
+  }
+}
+
+bool OutputLinker::reflink(const QString &source, const QString &destination) {
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+  QByteArray sourcePath = QFile::encodeName(source);
+  QByteArray destinationPath = QFile::encodeName(destination);
+
+  int sourceFd = ::open(sourcePath.constData(), O_RDONLY | O_CLOEXEC);
+  if (sourceFd < 0) {
+    return false;
+  }
+  struct stat sourceStat;
+  if (::fstat(sourceFd, &sourceStat) != 0) {
+    ::close(sourceFd);
+    return false;
+  }
+  int destinationFd = ::open(destinationPath.constData(),
+                             O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                             sourceStat.st_mode & 0777);
+  if (destinationFd < 0) {
+    ::close(sourceFd);
+    return false;
+  }
+
+  // Fails with EXDEV across filesystems, EOPNOTSUPP on ext4 and friends
+  bool cloned = ::ioctl(destinationFd, FICLONE, sourceFd) == 0;
+  ::close(destinationFd);
+  ::close(sourceFd);
+  if (!cloned) {
+    ::unlink(destinationPath.constData());
+  }
+  return cloned;
+#elif defined(Q_OS_MACOS)
+  return ::clonefile(QFile::encodeName(source).constData(),
+                     QFile::encodeName(destination).constData(), 0) == 0;
+#else
+  Q_UNUSED(source)
+  Q_UNUSED(destination)
+  return false;
+#endif
+}
+
+bool OutputLinker::hardlink(const QString &source,
+                            const QString &destination) {
+#if defined(Q_OS_UNIX)
+  return ::link(QFile::encodeName(source).constData(),
+                QFile::encodeName(destination).constData()) == 0;
+#else
+  Q_UNUSED(source)
+  Q_UNUSED(destination)
+  return false;
+#endif
+}
@@ -0,0 +1,39 @@
+#ifndef OUTPUTLINKER_H
+#define OUTPUTLINKER_H
+
+#include <QString>
+
+// Puts a file with the content of an original at an output path without
+// writing the bytes again when the filesystem allows it.
+//
+// A reflink (FICLONE on Linux, clonefile on macOS) shares the extents
+// copy-on-write, so both files stay independent. A hardlink shares the
+// inode: the workers and the coordinator replace outputs rather than edit
+// them, but anything else editing the output in place edits the original
+// too, so hardlinks are opt-in. Anything the filesystem refuses, e.g. a
+// link across filesystems, falls back to the next method and finally to a
+// plain copy.
+class OutputLinker {
+public:
+  // Stored as int in Constants::TASK_LINK_UNCHANGED_KEY
+  enum Mode { CopyOnly, ReflinkOrCopy, ReflinkHardlinkOrCopy };
+  enum Method { Reflink, Hardlink, Copy };
+
+  static Mode modeFromSettings();
+  static Mode modeFromInt(int mode);
+
+  // Replaces destination, false with errorString when even copying failed
+  static bool materialize(const QString &source, const QString &destination,
+                          Mode mode, Method *method = nullptr,
+                          QString *errorString = nullptr);
+
+  static QString methodName(Method method);
+
+private:
+  OutputLinker() = delete;
+
+  static bool reflink(const QString &source, const QString &destination);
+  static bool hardlink(const QString &source, const QString &destination);
+};
+
+#endif // OUTPUTLINKER_H
@@ -5,6 +5,7 @@
 #include "elideditemdelegate.h"
 #include "thememanager.h"
 #include "ui_pixelbatch.h"
+#include "watchfoldersdialog.h"
 
 #include <QCloseEvent>
 #include <QDesktopWidget>
@@ -29,7 +30,8 @@ PixelBatch::PixelBatch(QWidget *parent)
           new QPushButton(QIcon(":/resources/icons/bubble-chart-line.png"),
                           tr("Process Images"), this)),
       m_StatusbarPermanentMessageLabel(new QLabel(this)),
-      m_fileHandler(new FileHandler(this)) {
+      m_fileHandler(new FileHandler(this)),
+      m_folderWatcher(new FolderWatcher(this)) {
 
   ui->setupUi(this);
 
@@ -55,6 +57,8 @@ PixelBatch::PixelBatch(QWidget *parent)
 
   initPreferencesWidget();
 
+  initFolderWatcher();
+
   restoreWindowState(); // Restore saved window size and splitter state
 
   updateStatusBarButtons(); // keep it last
@@ -177,6 +181,11 @@ void PixelBatch::initMenuBar() {
   connect(addImagesAction, &QAction::triggered, this, &PixelBatch::addImages);
   fileMenu->addAction(addImagesAction);
 
+  QAction *watchFoldersAction = new QAction(tr("Watch Folders..."), fileMenu);
+  connect(watchFoldersAction, &QAction::triggered, this,
+          &PixelBatch::editWatchFolders);
+  fileMenu->addAction(watchFoldersAction);
+
   QAction *settingsAction = new QAction(tr("Preferences"), fileMenu);
   settingsAction->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_P));
   connect(settingsAction, &QAction::triggered, this, &PixelBatch::openSettings);
@@ -284,6 +293,69 @@ void PixelBatch::initPreferencesWidget() {
                                       tr("Preferences"));
 }
 
+void PixelBatch::initFolderWatcher() {
+  connect(m_folderWatcher, &FolderWatcher::fileReady, m_taskWidget,
+          &TaskWidget::addWatchedFile);
+  connect(m_folderWatcher, &FolderWatcher::fileFound, m_taskWidget,
+          &TaskWidget::addRescannedFile);
+  connect(m_folderWatcher, &FolderWatcher::watchError, this,
+          [this](const QString &errorString) {
+            qWarning() << errorString;
+            setStatus(errorString);
+          });
+
+  m_folderWatcher->setFolders(FolderWatcher::savedFolders());
+  applyWatchState(m_settings.getWatchEnabled());
+}
+
+void PixelBatch::applyWatchState(bool watch) {
+  if (!watch || m_folderWatcher->folders().isEmpty()) {
+    m_folderWatcher->stop();
+    return;
+  }
+
+  if (m_folderWatcher->start()) {
+    setStatus(tr("Watching %1 folder(s) for new images")
+                  .arg(m_folderWatcher->folders().count()));
+  }
+}
+
+void PixelBatch::editWatchFolders() {
+  WatchFoldersDialog dialog(FolderWatcher::savedFolders(),
+                            m_settings.getWatchEnabled(), this);
+  if (dialog.exec() != QDialog::Accepted) {
+    return;
+  }
+
+  FolderWatcher::saveFolders(dialog.folders());
+  m_settings.setWatchEnabled(dialog.isWatchEnabled());
+
+  m_folderWatcher->setFolders(dialog.folders());
+  applyWatchState(dialog.isWatchEnabled());
+}
+
+void PixelBatch::watchFolders(const QStringList &folderPaths) {
+  QList<FolderWatcher::Folder> folders = m_folderWatcher->folders();
+  for (const QString &folderPath : folderPaths) {
+    FolderWatcher::Folder folder;
+    folder.path = QFileInfo(folderPath).absoluteFilePath();
+    folders.append(folder);
+  }
+  m_folderWatcher->setFolders(folders);
+  applyWatchState(true);
+}
+
+void PixelBatch::listenForAgents(const QString &address) {
+  QString errorString;
+  if (m_taskWidget->listenForAgents(address, &errorString)) {
+    setStatus(tr("Waiting for agents on %1").arg(address));
+  } else {
+    QMessageBox::warning(this, tr("Work Distribution"),
+                         tr("Unable to listen for agents on %1: %2")
+                             .arg(address, errorString));
+  }
+}
+
 void PixelBatch::initTaskActionWidget() {
 
   QObject::connect(m_taskWidget, &TaskWidget::selectionChangedCustom,
@@ -301,6 +373,8 @@ void PixelBatch::initImageDetailPanel() {
 
   connect(m_taskWidget, &TaskWidget::selectedImageTaskChanged,
           m_imageDetailPanel, &ImageDetailPanel::setImageTask);
+  connect(m_taskWidget, &TaskWidget::imageHeaderAnalyzed, m_imageDetailPanel,
+          &ImageDetailPanel::updateImageHeader);
 
   connect(m_taskWidget, &TaskWidget::selectionChangedCustom, this, [this]() {
     bool hasSelection = m_taskWidget->hasSelection();
@@ -338,6 +412,8 @@ void PixelBatch::initImageDetailPanel() {
           m_taskWidget, &TaskWidget::setTaskCustomOptimizerSettings);
   connect(m_imageDetailPanel, &ImageDetailPanel::customOptimizerSettingsCleared,
           m_taskWidget, &TaskWidget::clearTaskCustomOptimizerSettings);
+  connect(m_imageDetailPanel, &ImageDetailPanel::optimizeNowRequested,
+          m_taskWidget, &TaskWidget::optimizeTaskNow);
 
   m_imageDetailPanel->setMinimumWidth(300);
 
@@ -498,8 +574,45 @@ void PixelBatch::addFileFromCommandLine(const QString &filePath) {
   }
 }
 
+void PixelBatch::checkInterruptedBatch(bool resumeWithoutAsking) {
+  m_taskWidget->findInterruptedBatch(
+      [this, resumeWithoutAsking](const QList<BatchJournal::Entry> &entries) {
+        offerInterruptedBatch(entries, resumeWithoutAsking);
+      });
+}
+
+void PixelBatch::offerInterruptedBatch(
+    const QList<BatchJournal::Entry> &entries, bool resumeWithoutAsking) {
+  if (entries.isEmpty()) {
+    return;
+  }
+
+  if (!resumeWithoutAsking) {
+    QMessageBox::StandardButton answer = QMessageBox::question(
+        this, tr("Resume Interrupted Batch"),
+        tr("The previous session ended while %1 image(s) were still "
+           "waiting to be optimized.\n\nDo you want to resume them now?")
+            .arg(entries.count()),
+        QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
+    if (answer != QMessageBox::Yes) {
+      m_taskWidget->discardInterruptedBatch(entries);
+      return;
+    }
+  }
+
+  m_taskWidget->resumeInterruptedBatch(entries);
+}
+
 void PixelBatch::showProcessingCompletedDialog(
     const ImageTask::TaskStatusCounts &counts) {
+  // Batches keep coming in while watching, don't interrupt with a dialog
+  if (m_folderWatcher->isActive()) {
+    setStatus(tr("Watching for new images. %1 optimized, %2 failed")
+                  .arg(counts.completedCount)
+                  .arg(counts.errorCount));
+    return;
+  }
+
   // Build the message
   QString title = tr("Processing Complete");
   QString message;
@@ -508,10 +621,19 @@ void PixelBatch::showProcessingCompletedDialog(
     // All succeeded
     message = tr("All %1 image(s) have been successfully optimized!")
                   .arg(counts.totalTasks);
+    if (counts.unchangedCount > 0) {
+      message += tr("\n\n%1 of them could not be made smaller and were "
+                    "left unchanged.")
+                     .arg(counts.unchangedCount);
+    }
   } else {
     // Some succeeded, some failed
     message = tr("Processing finished:\n\n");
     message += tr("✓ Successfully optimized: %1\n").arg(counts.completedCount);
+    if (counts.unchangedCount > 0) {
+      message += tr("= Not smaller, left unchanged: %1\n")
+                     .arg(counts.unchangedCount);
+    }
     if (counts.errorCount > 0) {
       message += tr("✗ Failed: %1\n").arg(counts.errorCount);
     }
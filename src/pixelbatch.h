@@ -3,6 +3,7 @@
 
 #include "emptystatewidget.h"
 #include "filehandler.h"
+#include "folderwatcher.h"
 #include "imagedetailpanel.h"
 #include "imagetask.h"
 #include "preferenceswidget.h"
@@ -28,6 +29,10 @@ public:
   ~PixelBatch();
 
   void addFileFromCommandLine(const QString &filePath);
+  void checkInterruptedBatch(bool resumeWithoutAsking = false);
+  // Watch these folders for this session, next to the saved ones
+  void watchFolders(const QStringList &folderPaths);
+  void listenForAgents(const QString &address);
 
 private slots:
   void setStatus(const QString &message);
@@ -42,6 +47,7 @@ private slots:
   void reportIssue();
   void donate();
   void showAbout();
+  void editWatchFolders();
 
 protected:
   void closeEvent(QCloseEvent *event) override;
@@ -61,6 +67,7 @@ private:
   QPushButton *m_statusBarProcessButton;
   QLabel *m_StatusbarPermanentMessageLabel;
   FileHandler *m_fileHandler;
+  FolderWatcher *m_folderWatcher;
 
   void initTaskWidget();
   void initTaskActionWidget();
@@ -69,6 +76,10 @@ private:
   void setupStatusBar();
   void initMenuBar();
   void initPreferencesWidget();
+  void initFolderWatcher();
+  void applyWatchState(bool watch);
+  void offerInterruptedBatch(const QList<BatchJournal::Entry> &entries,
+                             bool resumeWithoutAsking);
   void applySavedThemeAndStyle();
   void saveWindowState();
   void restoreWindowState();
@@ -1,6 +1,8 @@
 #include "preferenceswidget.h"
+#include "commitpolicy.h"
 #include "imageformatprefwidget.h"
 #include "thememanager.h"
+#include "thumbnailcache.h"
 #include "ui_preferenceswidget.h"
 
 #include <QAction>
@@ -82,6 +84,158 @@ PreferencesWidget::PreferencesWidget(QWidget *parent)
   connect(ui->filepickerRememberLastPathCheckBox, &QCheckBox::toggled, this,
           [=](bool arg1) { m_settings.setRememberOpenLastOpenedPath(arg1); });
 
+  ui->cacheThumbnailsOnDiskCheckBox->setChecked(
+      m_settings.getThumbnailDiskCacheEnabled());
+  connect(ui->cacheThumbnailsOnDiskCheckBox, &QCheckBox::toggled, this,
+          [=](bool arg1) {
+            m_settings.setThumbnailDiskCacheEnabled(arg1);
+            ThumbnailCache::instance().setDiskCacheEnabled(arg1);
+          });
+
+  ui->batchJournalCheckBox->setChecked(m_settings.getBatchJournalEnabled());
+  connect(ui->batchJournalCheckBox, &QCheckBox::toggled, this,
+          [=](bool arg1) { m_settings.setBatchJournalEnabled(arg1); });
+
+  ui->pipeIoCheckBox->setChecked(m_settings.getPipeIoEnabled());
+  connect(ui->pipeIoCheckBox, &QCheckBox::toggled, this,
+          [=](bool arg1) { m_settings.setPipeIoEnabled(arg1); });
+
+  ui->preemptForInteractiveCheckBox->setChecked(
+      m_settings.getPreemptForInteractive());
+  connect(ui->preemptForInteractiveCheckBox, &QCheckBox::toggled, this,
+          [=](bool arg1) { m_settings.setPreemptForInteractive(arg1); });
+
+  ui->computeQualityMetricsCheckBox->setChecked(
+      m_settings.getComputeQualityMetrics());
+  connect(ui->computeQualityMetricsCheckBox, &QCheckBox::toggled, this,
+          [=](bool arg1) {
+            m_settings.setComputeQualityMetrics(arg1);
+            ui->minimumSsimSpinBox->setEnabled(arg1);
+          });
+
+  ui->minimumSsimSpinBox->setValue(m_settings.getMinimumSsim());
+  ui->minimumSsimSpinBox->setEnabled(m_settings.getComputeQualityMetrics());
+  connect(ui->minimumSsimSpinBox,
+          QOverload<double>::of(&QDoubleSpinBox::valueChanged), this,
+          [=](double arg1) { m_settings.setMinimumSsim(arg1); });
+
+  ui->targetSsimSpinBox->setValue(m_settings.getTargetSsim());
+  connect(ui->targetSsimSpinBox,
+          QOverload<double>::of(&QDoubleSpinBox::valueChanged), this,
+          [=](double arg1) { m_settings.setTargetSsim(arg1); });
+
+  ui->minimumGainSpinBox->setValue(m_settings.getMinimumGainPercent());
+  connect(ui->minimumGainSpinBox,
+          QOverload<double>::of(&QDoubleSpinBox::valueChanged), this,
+          [=](double arg1) { m_settings.setMinimumGainPercent(arg1); });
+
+  ui->notSmallerActionComboBox->setCurrentIndex(
+      m_settings.getNotSmallerAction());
+  connect(ui->notSmallerActionComboBox,
+          QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+          [=](int index) {
+            m_settings.setNotSmallerAction(index);
+            ui->minimumGainSpinBox->setEnabled(index !=
+                                               CommitPolicy::KeepOutput);
+            ui->linkUnchangedComboBox->setEnabled(
+                index == CommitPolicy::KeepOriginal);
+          });
+  ui->minimumGainSpinBox->setEnabled(m_settings.getNotSmallerAction() !=
+                                     CommitPolicy::KeepOutput);
+
+  ui->linkUnchangedComboBox->setCurrentIndex(
+      m_settings.getLinkUnchangedMode());
+  ui->linkUnchangedComboBox->setEnabled(m_settings.getNotSmallerAction() ==
+                                        CommitPolicy::KeepOriginal);
+  connect(ui->linkUnchangedComboBox,
+          QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+          [=](int index) { m_settings.setLinkUnchangedMode(index); });
+
+  ui->toolMemoryLimitSpinBox->setValue(m_settings.getToolMemoryLimitMb());
+  connect(ui->toolMemoryLimitSpinBox,
+          QOverload<int>::of(&QSpinBox::valueChanged), this,
+          [=](int arg1) { m_settings.setToolMemoryLimitMb(arg1); });
+
+  ui->toolCpuTimeLimitSpinBox->setValue(m_settings.getToolCpuTimeLimit());
+  connect(ui->toolCpuTimeLimitSpinBox,
+          QOverload<int>::of(&QSpinBox::valueChanged), this,
+          [=](int arg1) { m_settings.setToolCpuTimeLimit(arg1); });
+
+  ui->batchNicenessSpinBox->setValue(m_settings.getBatchNiceness());
+  connect(ui->batchNicenessSpinBox,
+          QOverload<int>::of(&QSpinBox::valueChanged), this,
+          [=](int arg1) { m_settings.setBatchNiceness(arg1); });
+
+  ui->batchIdleIoCheckBox->setChecked(m_settings.getBatchIdleIo());
+  connect(ui->batchIdleIoCheckBox, &QCheckBox::toggled, this,
+          [=](bool arg1) { m_settings.setBatchIdleIo(arg1); });
+
+  ui->memoryBudgetSpinBox->setValue(m_settings.getMemoryBudgetMb());
+  connect(ui->memoryBudgetSpinBox,
+          QOverload<int>::of(&QSpinBox::valueChanged), this,
+          [=](int arg1) { m_settings.setMemoryBudgetMb(arg1); });
+
+  ui->threadBudgetSpinBox->setValue(m_settings.getThreadBudget());
+  connect(ui->threadBudgetSpinBox,
+          QOverload<int>::of(&QSpinBox::valueChanged), this,
+          [=](int arg1) { m_settings.setThreadBudget(arg1); });
+
+  const QList<QPair<QString, QSpinBox *>> toolTimeoutSpinBoxes = {
+      {"jpegoptim", ui->jpegoptimTimeoutSpinBox},
+      {"pngquant", ui->pngquantTimeoutSpinBox},
+      {"gifsicle", ui->gifsicleTimeoutSpinBox},
+      {"svgo", ui->svgoTimeoutSpinBox},
+      {"cwebp", ui->cwebpTimeoutSpinBox},
+      {"avifenc", ui->avifencTimeoutSpinBox},
+      {"cjxl", ui->cjxlTimeoutSpinBox}};
+  for (const auto &toolSpinBox : toolTimeoutSpinBoxes) {
+    const QString tool = toolSpinBox.first;
+    toolSpinBox.second->setValue(m_settings.getToolTimeout(tool));
+    connect(toolSpinBox.second, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, [=](int arg1) { m_settings.setToolTimeout(tool, arg1); });
+  }
+
+  ui->timeoutPerMbSpinBox->setValue(m_settings.getTimeoutPerMb());
+  connect(ui->timeoutPerMbSpinBox,
+          QOverload<double>::of(&QDoubleSpinBox::valueChanged), this,
+          [=](double arg1) { m_settings.setTimeoutPerMb(arg1); });
+
+  ui->timeoutRetriesSpinBox->setValue(m_settings.getTimeoutRetries());
+  connect(ui->timeoutRetriesSpinBox,
+          QOverload<int>::of(&QSpinBox::valueChanged), this,
+          [=](int arg1) { m_settings.setTimeoutRetries(arg1); });
+
+  ui->stripMetadataComboBox->setCurrentIndex(
+      m_settings.getStripMetadataMode());
+  connect(ui->stripMetadataComboBox,
+          QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+          [=](int index) { m_settings.setStripMetadataMode(index); });
+
+  ui->resizeMaxWidthSpinBox->setValue(m_settings.getResizeMaxWidth());
+  connect(ui->resizeMaxWidthSpinBox,
+          QOverload<int>::of(&QSpinBox::valueChanged), this,
+          [=](int arg1) { m_settings.setResizeMaxWidth(arg1); });
+
+  ui->resizeMaxHeightSpinBox->setValue(m_settings.getResizeMaxHeight());
+  connect(ui->resizeMaxHeightSpinBox,
+          QOverload<int>::of(&QSpinBox::valueChanged), this,
+          [=](int arg1) { m_settings.setResizeMaxHeight(arg1); });
+
+  ui->resizeFilterComboBox->setCurrentIndex(m_settings.getResizeFilter());
+  connect(ui->resizeFilterComboBox,
+          QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+          [=](int index) { m_settings.setResizeFilter(index); });
+
+  ui->variantWidthsLineEdit->setText(m_settings.getVariantWidths());
+  connect(ui->variantWidthsLineEdit, &QLineEdit::textChanged, this,
+          [=](const QString &arg1) { m_settings.setVariantWidths(arg1); });
+
+  ui->variantNameLineEdit->setText(m_settings.getVariantNameTemplate());
+  connect(ui->variantNameLineEdit, &QLineEdit::textChanged, this,
+          [=](const QString &arg1) {
+            m_settings.setVariantNameTemplate(arg1);
+          });
+
   // Theme and Style
   // Load use system theme setting
   bool useSystemTheme = m_settings.getUseSystemTheme();
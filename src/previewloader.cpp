@@ -0,0 +1,126 @@
+#include "previewloader.h"
+
+#include "thumbnailcache.h"
+
+#include <QDebug>
+#include <QMetaObject>
+#include <QRunnable>
+
+namespace {
+
+class PreviewDecodeJob : public QRunnable {
+public:
+  PreviewDecodeJob(PreviewLoader *loader,
+                   std::shared_ptr<QAtomicInteger<quint64>> currentRequestId,
+                   quint64 requestId, const QString &imagePath,
+                   int maxPreviewSize)
+      : m_loader(loader), m_currentRequestId(currentRequestId),
+        m_requestId(requestId), m_imagePath(imagePath),
+        m_maxPreviewSize(maxPreviewSize) {}
+
+  void run() override {
+    // Selection moved on while we were waiting in the queue
+    if (isStale()) {
+      return;
+    }
+
+    QString errorString;
+    ThumbnailCache::Entry entry =
+        ThumbnailCache::instance().thumbnail(m_imagePath, &errorString);
+    if (!entry.isValid()) {
+      fail(errorString);
+      return;
+    }
+
+    if (isStale()) {
+      return;
+    }
+
+    deliver(m_loader, m_requestId, m_imagePath, entry, m_maxPreviewSize);
+  }
+
+  static void deliver(PreviewLoader *loader, quint64 requestId,
+                      const QString &imagePath,
+                      const ThumbnailCache::Entry &entry, int maxPreviewSize) {
+    QImage image = entry.image;
+    if (image.width() > maxPreviewSize || image.height() > maxPreviewSize) {
+      image = image.scaled(maxPreviewSize, maxPreviewSize, Qt::KeepAspectRatio,
+                           Qt::SmoothTransformation);
+    }
+
+    QSize originalSize = entry.originalSize;
+    QByteArray format = entry.format;
+    QMetaObject::invokeMethod(
+        loader,
+        [loader, requestId, imagePath, image, originalSize, format]() {
+          emit loader->previewReady(requestId, imagePath, image, originalSize,
+                                    format);
+        },
+        Qt::QueuedConnection);
+  }
+
+private:
+  bool isStale() const { return m_currentRequestId->loadAcquire() != m_requestId; }
+
+  void fail(const QString &errorString) {
+    if (isStale()) {
+      return;
+    }
+    PreviewLoader *loader = m_loader;
+    quint64 requestId = m_requestId;
+    QString imagePath = m_imagePath;
+    QMetaObject::invokeMethod(
+        loader,
+        [loader, requestId, imagePath, errorString]() {
+          emit loader->previewFailed(requestId, imagePath, errorString);
+        },
+        Qt::QueuedConnection);
+  }
+
+  PreviewLoader *m_loader;
+  std::shared_ptr<QAtomicInteger<quint64>> m_currentRequestId;
+  quint64 m_requestId;
+  QString m_imagePath;
+  int m_maxPreviewSize;
+};
+
+} // namespace
+
+PreviewLoader::PreviewLoader(QObject *parent)
+    : QObject(parent),
+      m_currentRequestId(std::make_shared<QAtomicInteger<quint64>>(0)) {
+  // Two threads: one can still be finishing a stale decode while the latest
+  // request already starts
+  m_threadPool.setMaxThreadCount(2);
+}
+
+PreviewLoader::~PreviewLoader() {
+  cancel();
+  // Jobs hold a raw pointer to us, make sure none outlives the loader
+  m_threadPool.waitForDone();
+}
+
+quint64 PreviewLoader::requestPreview(const QString &imagePath,
+                                      int maxPreviewSize) {
+  // Drop requests that did not start yet, running ones become stale
+  m_threadPool.clear();
+  quint64 requestId = m_currentRequestId->fetchAndAddOrdered(1) + 1;
+
+  // Already decoded (or prefetched), no need to go through the pool
+  ThumbnailCache::Entry entry =
+      ThumbnailCache::instance().cachedThumbnail(imagePath);
+  if (entry.isValid()) {
+    PreviewDecodeJob::deliver(this, requestId, imagePath, entry,
+                              maxPreviewSize);
+    return requestId;
+  }
+
+  m_threadPool.start(new PreviewDecodeJob(this, m_currentRequestId, requestId,
+                                          imagePath, maxPreviewSize));
+  return requestId;
+}
+
+void PreviewLoader::cancel() {
+  m_threadPool.clear();
+  m_currentRequestId->fetchAndAddOrdered(1);
+}
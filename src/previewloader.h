@@ -0,0 +1,44 @@
+#ifndef PREVIEWLOADER_H
+#define PREVIEWLOADER_H
+
+#include <QAtomicInteger>
+#include <QImage>
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+
+#include <memory>
+
+// Decodes image previews off the GUI thread.
+//
+// Every request reads the image header and the pixels through a single
+// QImageReader, asking the image plugin for a scaled decode (JPEG uses libjpeg
+// DCT scaling) so that large photos never get decoded at full resolution just
+// to show a thumbnail. Starting a new request cancels the previous ones:
+// queued requests are dropped from the pool and results of requests that were
+// already running are discarded.
+class PreviewLoader : public QObject {
+  Q_OBJECT
+
+public:
+  explicit PreviewLoader(QObject *parent = nullptr);
+  ~PreviewLoader();
+
+  // Returns the id of the request, which is passed back in the signals
+  quint64 requestPreview(const QString &imagePath, int maxPreviewSize);
+  void cancel();
+
+signals:
+  void previewReady(quint64 requestId, const QString &imagePath,
+                    const QImage &image, const QSize &originalSize,
+                    const QByteArray &format);
+  void previewFailed(quint64 requestId, const QString &imagePath,
+                     const QString &errorString);
+
+private:
+  QThreadPool m_threadPool;
+  std::shared_ptr<QAtomicInteger<quint64>> m_currentRequestId;
+};
+
+#endif // PREVIEWLOADER_H
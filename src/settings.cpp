@@ -30,6 +30,29 @@ void Settings::setOutputFilePrefix(const QString &prefix) {
   settings.setValue(Constants::OUTPUT_FILE_PREFIX_KEY, prefix);
 }
 
+QString Settings::getVariantNameTemplate() const {
+  return settings
+      .value(Constants::OUTPUT_VARIANT_NAME_KEY,
+             Constants::DEFAULT_OUTPUT_VARIANT_NAME)
+      .toString();
+}
+
+void Settings::setVariantNameTemplate(const QString &nameTemplate) {
+  settings.setValue(Constants::OUTPUT_VARIANT_NAME_KEY, nameTemplate);
+}
+
+QString Settings::getFormatOptimizer(const QString &format) const {
+  return settings
+      .value(Constants::FORMAT_OPTIMIZER_KEY_PREFIX + format.toLower())
+      .toString();
+}
+
+void Settings::setFormatOptimizer(const QString &format,
+                                  const QString &name) {
+  settings.setValue(Constants::FORMAT_OPTIMIZER_KEY_PREFIX + format.toLower(),
+                    name);
+}
+
 QString Settings::getLastOpenedImageDirPath() const {
   return settings
       .value(Constants::INPUT_LAST_IMAGE_DIR_PATH_KEY,
@@ -65,6 +88,287 @@ void Settings::setRememberOpenLastOpenedPath(const bool &remember) {
                     remember);
 }
 
+bool Settings::getThumbnailDiskCacheEnabled() const {
+  return settings
+      .value(Constants::CACHE_THUMBNAILS_ON_DISK_KEY,
+             Constants::DEFAULT_CACHE_THUMBNAILS_ON_DISK)
+      .toBool();
+}
+
+void Settings::setThumbnailDiskCacheEnabled(const bool &enabled) {
+  settings.setValue(Constants::CACHE_THUMBNAILS_ON_DISK_KEY, enabled);
+}
+
+bool Settings::getBatchJournalEnabled() const {
+  return settings
+      .value(Constants::TASK_BATCH_JOURNAL_KEY,
+             Constants::DEFAULT_TASK_BATCH_JOURNAL)
+      .toBool();
+}
+
+void Settings::setBatchJournalEnabled(const bool &enabled) {
+  settings.setValue(Constants::TASK_BATCH_JOURNAL_KEY, enabled);
+}
+
+bool Settings::getPipeIoEnabled() const {
+  return settings
+      .value(Constants::TASK_PIPE_IO_KEY, Constants::DEFAULT_TASK_PIPE_IO)
+      .toBool();
+}
+
+void Settings::setPipeIoEnabled(const bool &enabled) {
+  settings.setValue(Constants::TASK_PIPE_IO_KEY, enabled);
+}
+
+bool Settings::getPreemptForInteractive() const {
+  return settings
+      .value(Constants::TASK_PREEMPT_FOR_INTERACTIVE_KEY,
+             Constants::DEFAULT_TASK_PREEMPT_FOR_INTERACTIVE)
+      .toBool();
+}
+
+void Settings::setPreemptForInteractive(const bool &enabled) {
+  settings.setValue(Constants::TASK_PREEMPT_FOR_INTERACTIVE_KEY, enabled);
+}
+
+int Settings::getNotSmallerAction() const {
+  return settings
+      .value(Constants::TASK_NOT_SMALLER_ACTION_KEY,
+             Constants::DEFAULT_TASK_NOT_SMALLER_ACTION)
+      .toInt();
+}
+
+void Settings::setNotSmallerAction(const int &action) {
+  settings.setValue(Constants::TASK_NOT_SMALLER_ACTION_KEY, action);
+}
+
+double Settings::getMinimumGainPercent() const {
+  return settings
+      .value(Constants::TASK_MINIMUM_GAIN_KEY,
+             Constants::DEFAULT_TASK_MINIMUM_GAIN)
+      .toDouble();
+}
+
+void Settings::setMinimumGainPercent(const double &percent) {
+  settings.setValue(Constants::TASK_MINIMUM_GAIN_KEY, percent);
+}
+
+int Settings::getLinkUnchangedMode() const {
+  return settings
+      .value(Constants::TASK_LINK_UNCHANGED_KEY,
+             Constants::DEFAULT_TASK_LINK_UNCHANGED)
+      .toInt();
+}
+
+void Settings::setLinkUnchangedMode(const int &mode) {
+  settings.setValue(Constants::TASK_LINK_UNCHANGED_KEY, mode);
+}
+
+int Settings::getToolTimeout(const QString &tool) const {
+  return settings
+      .value(tool + Constants::TOOL_TIMEOUT_KEY_SUFFIX,
+             Constants::DEFAULT_TOOL_TIMEOUTS.value(
+                 tool, Constants::DEFAULT_TOOL_TIMEOUT))
+      .toInt();
+}
+
+void Settings::setToolTimeout(const QString &tool, const int &seconds) {
+  settings.setValue(tool + Constants::TOOL_TIMEOUT_KEY_SUFFIX, seconds);
+}
+
+double Settings::getTimeoutPerMb() const {
+  return settings
+      .value(Constants::TASK_TIMEOUT_PER_MB_KEY,
+             Constants::DEFAULT_TASK_TIMEOUT_PER_MB)
+      .toDouble();
+}
+
+void Settings::setTimeoutPerMb(const double &seconds) {
+  settings.setValue(Constants::TASK_TIMEOUT_PER_MB_KEY, seconds);
+}
+
+int Settings::getTimeoutRetries() const {
+  return settings
+      .value(Constants::TASK_TIMEOUT_RETRIES_KEY,
+             Constants::DEFAULT_TASK_TIMEOUT_RETRIES)
+      .toInt();
+}
+
+void Settings::setTimeoutRetries(const int &retries) {
+  settings.setValue(Constants::TASK_TIMEOUT_RETRIES_KEY, retries);
+}
+
+int Settings::getStripMetadataMode() const {
+  return settings
+      .value(Constants::TASK_STRIP_METADATA_KEY,
+             Constants::DEFAULT_TASK_STRIP_METADATA)
+      .toInt();
+}
+
+void Settings::setStripMetadataMode(const int &mode) {
+  settings.setValue(Constants::TASK_STRIP_METADATA_KEY, mode);
+}
+
+int Settings::getResizeMaxWidth() const {
+  return settings
+      .value(Constants::RESIZE_MAX_WIDTH_KEY,
+             Constants::DEFAULT_RESIZE_MAX_WIDTH)
+      .toInt();
+}
+
+void Settings::setResizeMaxWidth(const int &pixels) {
+  settings.setValue(Constants::RESIZE_MAX_WIDTH_KEY, pixels);
+}
+
+int Settings::getResizeMaxHeight() const {
+  return settings
+      .value(Constants::RESIZE_MAX_HEIGHT_KEY,
+             Constants::DEFAULT_RESIZE_MAX_HEIGHT)
+      .toInt();
+}
+
+void Settings::setResizeMaxHeight(const int &pixels) {
+  settings.setValue(Constants::RESIZE_MAX_HEIGHT_KEY, pixels);
+}
+
+int Settings::getResizeFilter() const {
+  return settings
+      .value(Constants::RESIZE_FILTER_KEY, Constants::DEFAULT_RESIZE_FILTER)
+      .toInt();
+}
+
+void Settings::setResizeFilter(const int &filter) {
+  settings.setValue(Constants::RESIZE_FILTER_KEY, filter);
+}
+
+QString Settings::getVariantWidths() const {
+  return settings
+      .value(Constants::RESIZE_VARIANT_WIDTHS_KEY,
+             Constants::DEFAULT_RESIZE_VARIANT_WIDTHS)
+      .toString();
+}
+
+void Settings::setVariantWidths(const QString &widths) {
+  settings.setValue(Constants::RESIZE_VARIANT_WIDTHS_KEY, widths);
+}
+
+int Settings::getToolMemoryLimitMb() const {
+  return settings
+      .value(Constants::RESOURCES_MEMORY_LIMIT_KEY,
+             Constants::DEFAULT_RESOURCES_MEMORY_LIMIT)
+      .toInt();
+}
+
+void Settings::setToolMemoryLimitMb(const int &megabytes) {
+  settings.setValue(Constants::RESOURCES_MEMORY_LIMIT_KEY, megabytes);
+}
+
+int Settings::getToolCpuTimeLimit() const {
+  return settings
+      .value(Constants::RESOURCES_CPU_TIME_LIMIT_KEY,
+             Constants::DEFAULT_RESOURCES_CPU_TIME_LIMIT)
+      .toInt();
+}
+
+void Settings::setToolCpuTimeLimit(const int &seconds) {
+  settings.setValue(Constants::RESOURCES_CPU_TIME_LIMIT_KEY, seconds);
+}
+
+int Settings::getBatchNiceness() const {
+  return settings
+      .value(Constants::RESOURCES_BATCH_NICENESS_KEY,
+             Constants::DEFAULT_RESOURCES_BATCH_NICENESS)
+      .toInt();
+}
+
+void Settings::setBatchNiceness(const int &niceness) {
+  settings.setValue(Constants::RESOURCES_BATCH_NICENESS_KEY, niceness);
+}
+
+bool Settings::getBatchIdleIo() const {
+  return settings
+      .value(Constants::RESOURCES_BATCH_IDLE_IO_KEY,
+             Constants::DEFAULT_RESOURCES_BATCH_IDLE_IO)
+      .toBool();
+}
+
+void Settings::setBatchIdleIo(const bool &enabled) {
+  settings.setValue(Constants::RESOURCES_BATCH_IDLE_IO_KEY, enabled);
+}
+
+int Settings::getMemoryBudgetMb() const {
+  return settings
+      .value(Constants::RESOURCES_MEMORY_BUDGET_KEY,
+             Constants::DEFAULT_RESOURCES_MEMORY_BUDGET)
+      .toInt();
+}
+
+void Settings::setMemoryBudgetMb(const int &megabytes) {
+  settings.setValue(Constants::RESOURCES_MEMORY_BUDGET_KEY, megabytes);
+}
+
+int Settings::getThreadBudget() const {
+  return settings
+      .value(Constants::RESOURCES_THREAD_BUDGET_KEY,
+             Constants::DEFAULT_RESOURCES_THREAD_BUDGET)
+      .toInt();
+}
+
+void Settings::setThreadBudget(const int &threads) {
+  settings.setValue(Constants::RESOURCES_THREAD_BUDGET_KEY, threads);
+}
+
+QVariantList Settings::getWatchFolders() const {
+  return settings.value(Constants::WATCH_FOLDERS_KEY).toList();
+}
+
+void Settings::setWatchFolders(const QVariantList &folders) {
+  settings.setValue(Constants::WATCH_FOLDERS_KEY, folders);
+}
+
+bool Settings::getWatchEnabled() const {
+  return settings
+      .value(Constants::WATCH_ENABLED_KEY, Constants::DEFAULT_WATCH_ENABLED)
+      .toBool();
+}
+
+void Settings::setWatchEnabled(const bool &enabled) {
+  settings.setValue(Constants::WATCH_ENABLED_KEY, enabled);
+}
+
+bool Settings::getComputeQualityMetrics() const {
+  return settings
+      .value(Constants::QUALITY_COMPUTE_METRICS_KEY,
+             Constants::DEFAULT_QUALITY_COMPUTE_METRICS)
+      .toBool();
+}
+
+void Settings::setComputeQualityMetrics(const bool &enabled) {
+  settings.setValue(Constants::QUALITY_COMPUTE_METRICS_KEY, enabled);
+}
+
+double Settings::getMinimumSsim() const {
+  return settings
+      .value(Constants::QUALITY_MINIMUM_SSIM_KEY,
+             Constants::DEFAULT_QUALITY_MINIMUM_SSIM)
+      .toDouble();
+}
+
+void Settings::setMinimumSsim(const double &minimumSsim) {
+  settings.setValue(Constants::QUALITY_MINIMUM_SSIM_KEY, minimumSsim);
+}
+
+double Settings::getTargetSsim() const {
+  return settings
+      .value(Constants::QUALITY_TARGET_SSIM_KEY,
+             Constants::DEFAULT_QUALITY_TARGET_SSIM)
+      .toDouble();
+}
+
+void Settings::setTargetSsim(const double &targetSsim) {
+  settings.setValue(Constants::QUALITY_TARGET_SSIM_KEY, targetSsim);
+}
+
 QString Settings::getTheme() const {
   return settings.value(Constants::APPEARANCE_THEME_KEY,
                         Constants::DEFAULT_APPEARANCE_THEME).toString();
@@ -19,6 +19,13 @@ public:
   QString getOutputFilePrefix() const;
   void setOutputFilePrefix(const QString &prefix);
 
+  QString getVariantNameTemplate() const;
+  void setVariantNameTemplate(const QString &nameTemplate);
+
+  // format as in ImageTypeUtils::imageTypeToString
+  QString getFormatOptimizer(const QString &format) const;
+  void setFormatOptimizer(const QString &format, const QString &name);
+
   QString getLastOpenedImageDirPath() const;
   void setLastOpenedImageDirPath(const QString &prefix);
 
@@ -28,6 +35,84 @@ public:
   bool getRememberOpenLastOpenedPath() const;
   void setRememberOpenLastOpenedPath(const bool &remember);
 
+  bool getThumbnailDiskCacheEnabled() const;
+  void setThumbnailDiskCacheEnabled(const bool &enabled);
+
+  bool getBatchJournalEnabled() const;
+  void setBatchJournalEnabled(const bool &enabled);
+
+  bool getPipeIoEnabled() const;
+  void setPipeIoEnabled(const bool &enabled);
+
+  bool getPreemptForInteractive() const;
+  void setPreemptForInteractive(const bool &enabled);
+
+  int getNotSmallerAction() const;
+  void setNotSmallerAction(const int &action);
+
+  double getMinimumGainPercent() const;
+  void setMinimumGainPercent(const double &percent);
+
+  int getLinkUnchangedMode() const;
+  void setLinkUnchangedMode(const int &mode);
+
+  int getToolTimeout(const QString &tool) const;
+  void setToolTimeout(const QString &tool, const int &seconds);
+
+  double getTimeoutPerMb() const;
+  void setTimeoutPerMb(const double &seconds);
+
+  int getTimeoutRetries() const;
+  void setTimeoutRetries(const int &retries);
+
+  int getStripMetadataMode() const;
+  void setStripMetadataMode(const int &mode);
+
+  int getResizeMaxWidth() const;
+  void setResizeMaxWidth(const int &pixels);
+
+  int getResizeMaxHeight() const;
+  void setResizeMaxHeight(const int &pixels);
+
+  int getResizeFilter() const;
+  void setResizeFilter(const int &filter);
+
+  QString getVariantWidths() const;
+  void setVariantWidths(const QString &widths);
+
+  int getToolMemoryLimitMb() const;
+  void setToolMemoryLimitMb(const int &megabytes);
+
+  int getToolCpuTimeLimit() const;
+  void setToolCpuTimeLimit(const int &seconds);
+
+  int getBatchNiceness() const;
+  void setBatchNiceness(const int &niceness);
+
+  bool getBatchIdleIo() const;
+  void setBatchIdleIo(const bool &enabled);
+
+  int getMemoryBudgetMb() const;
+  void setMemoryBudgetMb(const int &megabytes);
+
+  int getThreadBudget() const;
+  void setThreadBudget(const int &threads);
+
+  QVariantList getWatchFolders() const;
+  void setWatchFolders(const QVariantList &folders);
+
+  bool getWatchEnabled() const;
+  void setWatchEnabled(const bool &enabled);
+
+  bool getComputeQualityMetrics() const;
+  void setComputeQualityMetrics(const bool &enabled);
+
+  double getMinimumSsim() const;
+  void setMinimumSsim(const double &minimumSsim);
+
+  double getTargetSsim() const;
+  void setTargetSsim(const double &targetSsim);
+
   QString getTheme() const;
   void setTheme(const QString &theme);
 
@@ -6,25 +6,67 @@
 #include "imagestats.h"
 #include "imagetask.h"
 #include "settings.h"
+#include "thumbnailcache.h"
+#include "workcoordinator.h"
 
 #include <worker/ImageWorker.h>
+#include <worker/headeranalyzer.h>
 #include <worker/imageworkerfactory.h>
-
-#include <QCheckBox>
+#include <worker/metadatastripworker.h>
+#include <worker/qualityanalyzer.h>
+#include <worker/qualitysearchworker.h>
+#include <worker/remoteworker.h>
+#include <worker/resizeworker.h>
+#include <worker/variantworker.h>
+#include <worker/resourcegovernor.h>
+
+#include <QDataStream>
 #include <QDir>
 #include <QFileInfo>
-#include <QHBoxLayout>
+#include <QHelpEvent>
 #include <QKeyEvent>
 #include <QMainWindow>
 #include <QMessageBox>
 #include <QMouseEvent>
 #include <QQueue>
 #include <QRegularExpression>
+#include <QScrollBar>
+#include <QToolTip>
 #include <QThreadPool>
 
+namespace {
+
+// Builds the source path of its task when shown instead of keeping a copy,
+// at a million rows every string per row counts
+class TaskFileItem : public QTableWidgetItem {
+public:
+  explicit TaskFileItem(ImageTask *task) : m_task(task) {}
+
+  QVariant data(int role) const override {
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::ToolTipRole: // full path on hover
+      return m_task->imagePath();
+    case Qt::UserRole: // maps the row to its ImageTask
+      return QVariant::fromValue<ImageTask *>(m_task);
+    default:
+      return QTableWidgetItem::data(role);
+    }
+  }
+
+private:
+  ImageTask *m_task;
+};
+
+} // namespace
+
 TaskWidget::TaskWidget(QWidget *parent)
     : QTableWidget(parent), m_overlayWidget(new TaskWidgetOverlay(this)),
-      m_settings(Settings::instance()) {
+      m_settings(Settings::instance()), m_isProcessing(false),
+      m_thumbnailPrefetchTimer(new QTimer(this)),
+      m_headerAnalyzer(new HeaderAnalyzer(this)),
+      m_qualityAnalyzer(new QualityAnalyzer(this)),
+      m_coordinator(new WorkCoordinator(this)) {
 
   m_overlayWidget->setGeometry(this->rect());
   updateTaskOverlayWidget();
@@ -53,6 +95,33 @@ TaskWidget::TaskWidget(QWidget *parent)
     updateTaskOverlayWidget();
     emit isProcessingChanged(false); // force update buttons
   });
+
+  // Prefetch thumbnails once scrolling/adding settles down, so selecting a
+  // row shows its preview without decoding
+  m_thumbnailPrefetchTimer->setSingleShot(true);
+  m_thumbnailPrefetchTimer->setInterval(150);
+  connect(m_thumbnailPrefetchTimer, &QTimer::timeout, this,
+          &TaskWidget::prefetchVisibleThumbnails);
+  connect(verticalScrollBar(), &QScrollBar::valueChanged,
+          m_thumbnailPrefetchTimer, QOverload<>::of(&QTimer::start));
+  connect(this->model(), &QAbstractItemModel::rowsInserted,
+          m_thumbnailPrefetchTimer, QOverload<>::of(&QTimer::start));
+
+  connect(this, &QTableWidget::itemChanged, this, &TaskWidget::onItemChanged);
+
+  connect(m_headerAnalyzer, &HeaderAnalyzer::analysisFinished, this,
+          &TaskWidget::onHeaderAnalysisFinished);
+  connect(m_qualityAnalyzer, &QualityAnalyzer::analysisFinished, this,
+          &TaskWidget::onQualityAnalysisFinished);
+
+  m_journal.setEnabled(m_settings.getBatchJournalEnabled());
+
+  // Slots of agents that joined mid batch are used right away
+  connect(m_coordinator, &WorkCoordinator::agentsChanged, this, [this]() {
+    if (m_isProcessing) {
+      processNextBatch();
+    }
+  });
 }
 
 TaskWidget::~TaskWidget() {
@@ -62,6 +131,12 @@ TaskWidget::~TaskWidget() {
   // Clean up image tasks
   qDeleteAll(m_imageTasks);
   m_imageTasks.clear();
+  m_taskRows.clear();
+  m_tasksByPath.clear();
+  m_taskOutputPaths.clear();
+  m_taskStems.clear();
+  m_watchTasks.clear();
+  m_completedWatchTasks.clear();
 }
 
 void TaskWidget::cancelAllProcessing() {
@@ -75,11 +150,22 @@ void TaskWidget::cancelAllProcessing() {
     }
   }
   m_activeWorkers.clear();
-
-  // Clear the queue
+  m_runningBatchTasks.clear();
+  m_taskMemory.clear();
+  m_reservedMemory = 0;
+  m_taskThreads.clear();
+  m_reservedThreads = 0;
+  m_retryingTasks.clear();
+
+  // Clear the queue, the journal keeps it for the next session
   m_imageTaskQueue.clear();
+  m_interactiveTaskQueue.clear();
   m_activeTasks = 0;
 
+  // Results of running measurements are discarded
+  m_qualityAnalyzer->cancel();
+  m_activeMeasurements = 0;
+
   qDebug() << "All processing cancelled and workers cleaned up";
 }
 
@@ -91,9 +177,8 @@ void TaskWidget::dragEnterEvent(QDragEnterEvent *event) {
   if (event->mimeData()->hasUrls()) {
     bool hasValidImage = false;
     foreach (const QUrl &url, event->mimeData()->urls()) {
-      QFileInfo fileInfo(url.toLocalFile());
-      if (QImageReader::supportedImageFormats().contains(
-              fileInfo.suffix().toLower().toUtf8())) {
+      if (ImageWorkerFactory::instance().getImageType(url.toLocalFile()) !=
+          ImageType::Unsupported) {
         hasValidImage = true;
         break;
       }
@@ -124,9 +209,9 @@ void TaskWidget::dropEvent(QDropEvent *event) {
     foreach (const QUrl &url, event->mimeData()->urls()) {
       QFileInfo fileInfo(url.toLocalFile());
 
-      // Check if file is a supported image format
-      if (!QImageReader::supportedImageFormats().contains(
-              fileInfo.suffix().toLower().toUtf8())) {
+      // Check if file is a supported image format, by content
+      if (ImageWorkerFactory::instance().getImageType(fileInfo.filePath()) ==
+          ImageType::Unsupported) {
         skippedFiles << fileInfo.fileName();
         continue;
       }
@@ -256,69 +341,56 @@ bool TaskWidget::addFileToTable(const QString &filePath) {
   QFileInfo fileInfo(filePath);
 
   // Check for duplicates
-  for (const ImageTask *existingTask : qAsConst(m_imageTasks)) {
-    if (existingTask->imagePath == filePath) {
-      // Silently skip duplicates when adding multiple files
-      return false;
-    }
+  if (m_tasksByPath.contains(ImageTask::pathKey(filePath))) {
+    // Silently skip duplicates when adding multiple files
+    return false;
   }
 
   // Create a new task with temporary destination (will be updated via generateOutputPath)
   ImageTask *imageTask = new ImageTask(filePath, "");
   imageTask->taskStatus = ImageTask::Pending;
-  imageTask->optimizedPath = generateOutputPath(imageTask);
+  imageTask->imageType = ImageWorkerFactory::instance().getImageType(filePath);
+  imageTask->imageTypeSniffed = true;
+  m_taskStems[stemKey(imageTask)]++;
+  setTaskOutputPath(imageTask, generateOutputPath(imageTask));
   m_imageTasks.append(imageTask);
+  m_tasksByPath.insert(imageTask->pathKey(), imageTask);
 
   // Create a new row
   int newRow = rowCount();
   insertRow(newRow);
 
-  // Insert checkbox in first column
-  QWidget *checkBoxWidget = new QWidget();
-  QCheckBox *checkBox = new QCheckBox();
-  checkBox->setChecked(false);
-  QHBoxLayout *layoutCheckBox = new QHBoxLayout(checkBoxWidget);
-  layoutCheckBox->addWidget(checkBox);
-  layoutCheckBox->setAlignment(Qt::AlignCenter);
-  layoutCheckBox->setContentsMargins(0, 0, 0, 0);
-  setCellWidget(newRow, 0, checkBoxWidget);
-
-  // Connect checkbox state change
-  connect(checkBox, &QCheckBox::stateChanged, this, &TaskWidget::onCheckboxStateChanged);
+  // Checkable item in the first column, a widget per row doesn't scale to
+  // large sessions
+  QTableWidgetItem *checkItem = new QTableWidgetItem();
+  checkItem->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsEnabled);
+  checkItem->setCheckState(Qt::Unchecked);
+  setItem(newRow, 0, checkItem);
 
   // Insert file path
-  QTableWidgetItem *fileItem = new QTableWidgetItem(filePath);
-  // we use this data to map ImageTask to table row
-  fileItem->setData(Qt::UserRole, QVariant::fromValue<ImageTask *>(imageTask));
-  fileItem->setToolTip(filePath); // Show full path on hover
-  setItem(newRow, 1, fileItem);
+  setItem(newRow, 1, new TaskFileItem(imageTask));
+  m_taskRows.insert(imageTask,
+                    QPersistentModelIndex(model()->index(newRow, 1)));
 
-  // Insert initial status
+  // Insert initial status, the literal is shared by every row
   QTableWidgetItem *statusItem =
       new QTableWidgetItem(imageTask->statusToString());
   statusItem->setTextAlignment(Qt::AlignCenter);
-  statusItem->setToolTip(tr("Waiting to be processed"));
   setItem(newRow, 2, statusItem);
 
   // Insert file size before
-  qint64 fileSize = fileInfo.size();
-  QString formattedSize = m_locale.formattedDataSize(fileSize);
-  QTableWidgetItem *sizeBeforeItem = new QTableWidgetItem(formattedSize);
+  QTableWidgetItem *sizeBeforeItem =
+      new QTableWidgetItem(m_locale.formattedDataSize(fileInfo.size()));
   sizeBeforeItem->setTextAlignment(Qt::AlignCenter);
-  sizeBeforeItem->setToolTip(tr("Original file size: %1 bytes").arg(fileSize));
   setItem(newRow, 3, sizeBeforeItem);
 
-  // Insert file size after
-  QTableWidgetItem *sizeAfterItem = new QTableWidgetItem("—");
-  sizeAfterItem->setTextAlignment(Qt::AlignCenter);
-  sizeAfterItem->setToolTip(tr("Not yet optimized"));
-  setItem(newRow, 4, sizeAfterItem);
+  // Size after and savings get their items once optimized, see resultItem
 
-  // savings
-  QTableWidgetItem *savingsItem = new QTableWidgetItem("—");
-  savingsItem->setTextAlignment(Qt::AlignCenter);
-  savingsItem->setToolTip(tr("Not yet optimized"));
-  setItem(newRow, 5, savingsItem);
+  // Dimensions, frames and metadata without decoding, in the background
+  if (imageTask->imageType != ImageType::Unsupported) {
+    m_headerPendingTasks.insert(imageTask);
+    m_headerAnalyzer->analyze(imageTask);
+  }
 
   emit isProcessingChanged(false); // force update buttons
 
@@ -341,23 +413,20 @@ void TaskWidget::updateTableHeader(const bool &contentLoaded) {
 }
 
 void TaskWidget::processImages() {
+  beginBatch();
   int queuedCount = 0;
 
   for (ImageTask *imageTask : qAsConst(m_imageTasks)) {
     // Process pending tasks
     if (imageTask->taskStatus == ImageTask::Pending) {
-      imageTask->taskStatus = ImageTask::Queued;
-      m_imageTaskQueue.enqueue(imageTask);
-      updateTaskStatus(imageTask);
+      queueTask(imageTask);
       queuedCount++;
     }
     // Re-process completed or error tasks
     else if (imageTask->taskStatus == ImageTask::Completed ||
              imageTask->taskStatus == ImageTask::Error) {
       // Reset status to Queued for re-processing
-      imageTask->taskStatus = ImageTask::Queued;
-      m_imageTaskQueue.enqueue(imageTask);
-      updateTaskStatus(imageTask);
+      queueTask(imageTask);
 
       // Clear previous results
       updateTaskSizeAfter(imageTask, "—");
@@ -384,6 +453,9 @@ ImageTask::TaskStatusCounts TaskWidget::getTaskStatusCounts() const {
   for (const ImageTask *task : qAsConst(m_imageTasks)) {
     if (task->taskStatus == ImageTask::Completed) {
       counts.completedCount++;
+      if (task->commitOutcome != ImageTask::OutputCommitted) {
+        counts.unchangedCount++;
+      }
     } else if (task->taskStatus == ImageTask::Error) {
       counts.errorCount++;
     } else if (task->taskStatus == ImageTask::Pending) {
@@ -417,67 +489,203 @@ QString TaskWidget::getSummaryAndUpdateView() {
 }
 
 void TaskWidget::processNextBatch() {
-  int maxConcurrentTasks = m_settings.getMaxConcurrentTasks();
-  while (m_activeTasks < maxConcurrentTasks && !m_imageTaskQueue.isEmpty()) {
-    ImageTask *imageTask = m_imageTaskQueue.dequeue();
+  // Connected agents add their slots to the local ones
+  int maxConcurrentTasks =
+      m_settings.getMaxConcurrentTasks() + m_coordinator->totalSlots();
+
+  // Interactive tasks don't wait for batch tasks to finish
+  if (m_settings.getPreemptForInteractive()) {
+    int missingSlots = m_interactiveTaskQueue.count() -
+                       (maxConcurrentTasks - m_activeTasks);
+    while (missingSlots-- > 0 && preemptBatchTask()) {
+    }
+  }
+
+  while (m_activeTasks < maxConcurrentTasks && queuedTaskCount() > 0) {
+    bool interactive = !m_interactiveTaskQueue.isEmpty();
+    QQueue<ImageTask *> &queue =
+        interactive ? m_interactiveTaskQueue : m_imageTaskQueue;
+
+    // Agents have their own memory and cores, local tasks wait for a
+    // running one to finish when they don't fit in the budgets. The memory
+    // estimate needs the pre-flight header, its analysis calls us again.
+    bool remote = m_coordinator->hasFreeSlot();
+    if (!remote && (m_headerPendingTasks.contains(queue.head()) ||
+                    !reserveTaskResources(queue.head()))) {
+      break;
+    }
+    ImageTask *imageTask = queue.dequeue();
     m_activeTasks++;
     imageTask->taskStatus = ImageTask::Processing;
+    imageTask->hasQualityMetrics = false;
+    imageTask->searchedQuality = -1;
+    imageTask->processedOn.clear();
+    imageTask->commitOutcome = ImageTask::OutputCommitted;
+    imageTask->timedOut = false;
+    imageTask->resizedTo = QSize();
+    imageTask->jpegRoundTripVerified = false;
 
     // Regenerate output path in case settings or custom path changed
-    imageTask->optimizedPath = generateOutputPath(imageTask);
+    setTaskOutputPath(imageTask, generateOutputPath(imageTask));
+    m_journal.recordStarted(imageTask);
 
     updateTaskStatus(imageTask);
     try {
       // Ensure destination dir exists
-      QFileInfo destinationInfo(imageTask->optimizedPath);
+      QFileInfo destinationInfo(imageTask->optimizedPath());
       QDir().mkpath(destinationInfo.absoluteDir().absolutePath());
 
-      // Process
-      ImageWorker *worker =
-          ImageWorkerFactory::instance().getWorker(imageTask->imagePath);
-
-      // Apply task-specific settings if available
-      if (imageTask->hasCustomOptimizerSettings()) {
-        worker->setCustomSettings(imageTask->customOptimizerSettings);
-        qDebug() << "Applied custom settings to worker for" << imageTask->imagePath;
+      // Process, searching the quality per image when a target is set,
+      // conversions are encoded at the quality of their settings
+      ImageType imageType =
+          ImageWorkerFactory::instance().getImageType(imageTask);
+      ImageOptimizer optimizer =
+          imageTask->settingsSnapshot->optimizer(imageType);
+      double targetSsim = imageTask->settingsSnapshot->targetSsim();
+      // The JPEG XL output of a resized JPEG restores the resized one, never
+      // the original, variants are resized too
+      if (optimizer.keepsOriginalRestorable() &&
+          (imageTask->settingsSnapshot->resizes() ||
+           !imageTask->settingsSnapshot->variantWidths().isEmpty())) {
+        releaseTaskResources(imageTask);
+        m_activeTasks--;
+        imageTask->taskStatus = ImageTask::Error;
+        onOptimizationError(
+            imageTask, tr("%1 keeps the original JPEG restorable and can't "
+                          "be combined with resizing or variants")
+                           .arg(optimizer.getName()));
+        continue;
+      }
+      ImageWorker *worker = nullptr;
+      if (remote) {
+        RemoteWorker *remoteWorker =
+            new RemoteWorker(m_coordinator, targetSsim);
+        // Already running, so over the budgets or not
+        connect(remoteWorker, &RemoteWorker::runningLocally, this,
+                [this](ImageTask *task) { reserveTaskResources(task, true); });
+        worker = remoteWorker;
+      } else if (targetSsim > 0.0 && !optimizer.convertsFormat() &&
+                 !optimizer.stripsMetadataOnly() &&
+                 QualitySearchWorker::canSearch(imageType)) {
+        worker = new QualitySearchWorker(targetSsim);
+      } else {
+        worker = ImageWorkerFactory::instance().getWorker(optimizer);
       }
+      MetadataStripWorker *stripWorker =
+          qobject_cast<MetadataStripWorker *>(worker);
+      // Shrunk to the maximum size first, whoever optimizes it
+      if (imageTask->settingsSnapshot->resizes() &&
+          ResizeWorker::canResize(imageType)) {
+        worker = new ResizeWorker(worker);
+      }
+      // Stripped before the commit policy, so the output of an image the
+      // optimizer could not improve still counts as smaller without it
+      MetadataStripper::Mode stripMode =
+          imageTask->settingsSnapshot->stripMetadataMode();
+      if (!stripWorker && stripMode != MetadataStripper::Off) {
+        stripWorker = new MetadataStripWorker(worker);
+        worker = stripWorker;
+      }
+      if (stripWorker) {
+        connect(stripWorker, &MetadataStripWorker::metadataStripped, this,
+                [this](ImageTask *, const MetadataStripper::Result &result) {
+                  m_strippedMetadata += result;
+                });
+      }
+      // Responsive variants next to it, from a single decode
+      const QList<int> &variantWidths =
+          imageTask->settingsSnapshot->variantWidths();
+      if (!variantWidths.isEmpty() && ResizeWorker::canResize(imageType)) {
+        worker = new VariantWorker(
+            worker, variantWidths,
+            [this, imageTask](int width) {
+              return generateOutputPath(imageTask, width);
+            },
+            imageTask->optimizedPath() + ".srcset.json");
+      }
+
+      // Global and task-specific settings as of queueing
+      worker->setSnapshot(imageTask->settingsSnapshot);
+
+      worker->setBackground(!interactive);
 
       // Track worker for cleanup
       m_activeWorkers.append(worker);
+      if (!interactive) {
+        m_runningBatchTasks.append(qMakePair(worker, imageTask));
+      }
 
       connect(worker, &ImageWorker::optimizationFinished, this,
               [this, worker](ImageTask *task, bool success) {
-                task->taskStatus =
-                    success ? ImageTask::Completed : ImageTask::Error;
-                onOptimizationFinished(task, success);
+                task->timeoutRetries = 0;
+                // Outputs that are not smaller never count as optimized
+                QString policyError;
+                if (success && !task->settingsSnapshot->commitPolicy().apply(
+                                   task, &policyError)) {
+                  task->taskStatus = ImageTask::Error;
+                  onOptimizationError(task, policyError);
+                } else if (success && task->hasQualityMetrics) {
+                  // Already measured by the quality search
+                  applyQualityMetrics(task);
+                } else if (success &&
+                           task->commitOutcome ==
+                               ImageTask::OutputCommitted &&
+                           shouldMeasureQuality(task)) {
+                  // Stays Processing until the metrics are in, the
+                  // optimizer slot is free for the next task meanwhile.
+                  // The analyzer decodes the original and the output, the
+                  // reservation is held until it is done, tasks that ran
+                  // on an agent take one now.
+                  if (!m_taskMemory.contains(task)) {
+                    reserveTaskResources(task, true);
+                  }
+                  updateTaskStatus(task, tr("Measuring quality..."));
+                  m_activeMeasurements++;
+                  m_qualityAnalyzer->analyze(task);
+                } else {
+                  task->taskStatus =
+                      success ? ImageTask::Completed : ImageTask::Error;
+                  onOptimizationFinished(task, success);
+                }
+                if (task->taskStatus != ImageTask::Processing) {
+                  releaseTaskResources(task);
+                }
                 m_activeWorkers.removeOne(worker);
+                forgetRunningBatchTask(worker);
                 worker->deleteLater();
                 m_activeTasks--;
                 processNextBatch();
               });
       connect(worker, &ImageWorker::optimizationError, this,
               [this, worker](ImageTask *task, const QString &errorString) {
-                task->taskStatus = ImageTask::Error;
-                onOptimizationError(task, errorString);
+                releaseTaskResources(task);
+                if (!retryTimedOutTask(task)) {
+                  task->taskStatus = ImageTask::Error;
+                  task->timeoutRetries = 0;
+                  onOptimizationError(task, errorString);
+                }
                 m_activeWorkers.removeOne(worker);
+                forgetRunningBatchTask(worker);
                 worker->deleteLater();
                 m_activeTasks--;
                 processNextBatch();
               });
       worker->optimize(imageTask);
     } catch (const std::exception &e) {
+      m_journal.recordFailed(imageTask, e.what());
       updateTaskStatus(imageTask, e.what());
-      qWarning() << "Error processing " << imageTask->imagePath << ": "
+      qWarning() << "Error processing " << imageTask->imagePath() << ": "
                  << e.what();
+      releaseTaskResources(imageTask);
       m_activeTasks--;
       processNextBatch();
     }
 
     // Update progress message
     int processedTasks =
-        m_imageTasks.count() - m_imageTaskQueue.count() - m_activeTasks;
+        m_imageTasks.count() - queuedTaskCount() - m_activeTasks;
     int totalTasks = m_imageTasks.count();
-    int remainingTasks = m_imageTaskQueue.count();
+    int remainingTasks = queuedTaskCount();
 
     updateStatusBarMessage(
         tr("Processing: %1 of %2 complete (%3 in progress, %4 remaining)")
@@ -487,11 +695,22 @@ void TaskWidget::processNextBatch() {
             .arg(remainingTasks));
   }
 
-  if (m_imageTaskQueue.isEmpty() && m_activeTasks == 0) {
+  if (queuedTaskCount() == 0 && m_activeTasks == 0 &&
+      m_activeMeasurements == 0 && m_retryingTasks.isEmpty()) {
     auto taskStatusCounts = getTaskStatusCounts();
-    updateStatusBarMessage(getSummaryAndUpdateView());
+    QString summary = getSummaryAndUpdateView();
+    if (m_strippedMetadata.total() > 0) {
+      summary += ", " + tr("Metadata removed: %1")
+                            .arg(m_strippedMetadata.toString());
+      qDebug() << "Metadata removed:" << m_strippedMetadata.toString();
+      m_strippedMetadata = MetadataStripper::Result();
+    }
+    updateStatusBarMessage(summary);
     setIsProcessing(false);
 
+    // Nothing left to resume
+    m_journal.clear();
+
     // Emit signal for completion notification (only if there are tasks)
     if (taskStatusCounts.totalTasks > 0) {
       emit allTasksCompleted(taskStatusCounts);
@@ -532,8 +751,25 @@ void TaskWidget::clearAllOperations() {
 void TaskWidget::removeTask(ImageTask *task) {
   int row = findRowByImageTask(task);
   if (row >= 0) {
+    if (task->taskStatus == ImageTask::Queued ||
+        task->taskStatus == ImageTask::Processing) {
+      m_journal.recordRemoved(task);
+    }
     m_imageTaskQueue.removeAll(task);
+    m_interactiveTaskQueue.removeAll(task);
+    m_retryingTasks.remove(task);
+    m_headerPendingTasks.remove(task);
+    m_watchTasks.remove(task);
+    m_completedWatchTasks.removeAll(task);
     m_imageTasks.removeAll(task);
+    m_taskRows.remove(task);
+    releaseTaskResources(task);
+    m_tasksByPath.remove(task->pathKey());
+    setTaskOutputPath(task, QString());
+    QPair<quint32, QString> stem = stemKey(task);
+    if (--m_taskStems[stem] <= 0) {
+      m_taskStems.remove(stem);
+    }
 
     this->removeRow(row);
 
@@ -561,7 +797,7 @@ void TaskWidget::openOptimizedImageInFileManagerForSelectedTask() {
   }
 
   // Check if the optimized file exists
-  QFileInfo fileInfo(task->optimizedPath);
+  QFileInfo fileInfo(task->optimizedPath());
   if (!fileInfo.exists()) {
     QMessageBox::warning(this, tr("File Not Found"),
                          tr("The optimized image does not exist yet.\n"
@@ -582,7 +818,7 @@ void TaskWidget::openOptimizedImageInImageViewerForSelectedTask() {
   }
 
   // Check if the optimized file exists
-  QFileInfo fileInfo(task->optimizedPath);
+  QFileInfo fileInfo(task->optimizedPath());
   if (!fileInfo.exists()) {
     QMessageBox::warning(this, tr("File Not Found"),
                          tr("The optimized image does not exist yet.\n"
@@ -608,7 +844,7 @@ void TaskWidget::openOriginalImageInImageViewerForSelectedTask() {
   }
 
   // Check if the original file exists
-  QFileInfo fileInfo(task->imagePath);
+  QFileInfo fileInfo(task->imagePath());
   if (!fileInfo.exists()) {
     QMessageBox::warning(this, tr("File Not Found"),
                          tr("The original image file does not exist.\n"
@@ -643,8 +879,8 @@ void TaskWidget::compareImagesForSelectedTask() {
   }
 
   // Check if both files exist
-  QFileInfo originalInfo(task->imagePath);
-  QFileInfo optimizedInfo(task->optimizedPath);
+  QFileInfo originalInfo(task->imagePath());
+  QFileInfo optimizedInfo(task->optimizedPath());
 
   if (!originalInfo.exists()) {
     QMessageBox::warning(this, tr("File Not Found"),
@@ -662,23 +898,112 @@ void TaskWidget::compareImagesForSelectedTask() {
 
   // Create and show the comparison dialog
   ImageComparisonWidget *comparisonDialog =
-      new ImageComparisonWidget(task->imagePath, task->optimizedPath, this);
+      new ImageComparisonWidget(task->imagePath(), task->optimizedPath(), this);
   comparisonDialog->setAttribute(Qt::WA_DeleteOnClose);
   comparisonDialog->exec();
 }
 
 int TaskWidget::findRowByImageTask(ImageTask *task) {
-  for (int row = 0; row < rowCount(); ++row) {
-    // ImageTask(task) pointer is mapped with data of QTableWidgetItem in File column (column 1)
-    QTableWidgetItem *item = this->item(row, 1);
-    if (item) {
-      ImageTask *storedTask = item->data(Qt::UserRole).value<ImageTask *>();
-      if (storedTask == task) {
-        return row;
-      }
+  auto it = m_taskRows.constFind(task);
+  if (it == m_taskRows.cend() || !it->isValid()) {
+    return -1;
+  }
+  return it->row();
+}
+
+QTableWidgetItem *TaskWidget::resultItem(int row, int column) {
+  QTableWidgetItem *resultItem = item(row, column);
+  if (!resultItem) {
+    resultItem = new QTableWidgetItem();
+    resultItem->setTextAlignment(Qt::AlignCenter);
+    setItem(row, column, resultItem);
+  }
+  return resultItem;
+}
+
+bool TaskWidget::viewportEvent(QEvent *event) {
+  if (event->type() != QEvent::ToolTip) {
+    return QTableWidget::viewportEvent(event);
+  }
+
+  QHelpEvent *helpEvent = static_cast<QHelpEvent *>(event);
+  QModelIndex index = indexAt(helpEvent->pos());
+  QString toolTip =
+      index.isValid() ? taskToolTip(index.row(), index.column()) : QString();
+  if (toolTip.isEmpty()) {
+    return QTableWidget::viewportEvent(event);
+  }
+  QToolTip::showText(helpEvent->globalPos(), toolTip, viewport(),
+                     visualRect(index));
+  return true;
+}
+
+QString TaskWidget::taskToolTip(int row, int column) const {
+  const ImageTask *task = getImageTaskFromRow(row);
+  if (!task) {
+    return QString();
+  }
+
+  switch (column) {
+  case 2: { // Status
+    QString toolTip;
+    switch (task->taskStatus) {
+    case ImageTask::Pending:
+      toolTip = tr("Waiting to be processed");
+      break;
+    case ImageTask::Queued:
+      toolTip = tr("Queued for processing");
+      break;
+    case ImageTask::Processing:
+      toolTip = tr("Currently being optimized...");
+      break;
+    case ImageTask::Completed:
+      toolTip = tr("Successfully optimized");
+      break;
+    case ImageTask::Error:
+      return task->statusDetail.isEmpty()
+                 ? tr("Optimization failed")
+                 : tr("Error: %1").arg(task->statusDetail);
+    }
+    if (!task->statusDetail.isEmpty()) {
+      toolTip += "\n" + task->statusDetail;
     }
+    return toolTip;
+  }
+  case 3: // Size before
+    return tr("Original file size: %1 bytes")
+        .arg(QFileInfo(task->imagePath()).size());
+  case 4: { // Size after
+    QFileInfo fileInfo(task->optimizedPath());
+    if (task->taskStatus != ImageTask::Completed || !fileInfo.exists()) {
+      return tr("Not yet optimized");
+    }
+    return tr("Optimized file size: %1 bytes").arg(fileInfo.size());
+  }
+  case 5: { // Savings, from the text "XXX KB (YY.YY%)"
+    QTableWidgetItem *savingItem = item(row, 5);
+    QRegularExpression re("\\(([\\d.]+)%\\)");
+    QRegularExpressionMatch match =
+        re.match(savingItem ? savingItem->text() : QString());
+    if (!match.hasMatch()) {
+      return tr("Not yet optimized");
+    }
+    double percentage = match.captured(1).toDouble();
+    QString saved = QString::number(percentage, 'f', 2);
+    if (percentage >= 30.0) {
+      return tr("Excellent compression! Saved %1%").arg(saved);
+    } else if (percentage >= 15.0) {
+      return tr("Good compression. Saved %1%").arg(saved);
+    } else if (percentage >= 5.0) {
+      return tr("Moderate compression. Saved %1%").arg(saved);
+    } else if (percentage > 0.0) {
+      return tr("Minimal compression. Saved %1%").arg(saved);
+    }
+    return tr("No compression achieved");
+  }
+  default:
+    return QString();
   }
-  return -1;
 }
 
 ImageTask *TaskWidget::getImageTaskFromRow(int row) const {
@@ -706,6 +1031,16 @@ ImageTask *TaskWidget::getSelectedImageTask() const {
 
 void TaskWidget::updateTaskStatus(ImageTask *task,
                                   const QString optionalDetail) {
+  // Shared by every row, a brush per item doesn't scale to large sessions
+  static const QBrush pendingBrush(QColor("#999999"));    // Gray
+  static const QBrush queuedBrush(QColor("#0066CC"));     // Blue
+  static const QBrush processingBrush(QColor("#FF8800")); // Orange
+  static const QBrush completedBrush(QColor("#00AA00"));  // Green
+  static const QBrush errorBrush(QColor("#CC0000"));      // Red
+
+  // The tooltip is built from it when shown, see taskToolTip
+  task->statusDetail = optionalDetail;
+
   int row = findRowByImageTask(task);
   if (row >= 0) {
     QTableWidgetItem *statusItem = item(row, 2); // Status column
@@ -713,61 +1048,45 @@ void TaskWidget::updateTaskStatus(ImageTask *task,
     // Set status text
     statusItem->setText(task->statusToString());
 
-    // Set tooltip with details
-    QString tooltip;
     switch (task->taskStatus) {
     case ImageTask::Pending:
-      tooltip = tr("Waiting to be processed");
-      statusItem->setForeground(QBrush(QColor("#999999"))); // Gray
+      statusItem->setForeground(pendingBrush);
       break;
     case ImageTask::Queued:
-      tooltip = tr("Queued for processing");
-      statusItem->setForeground(QBrush(QColor("#0066CC"))); // Blue
+      statusItem->setForeground(queuedBrush);
       break;
     case ImageTask::Processing:
-      tooltip = tr("Currently being optimized...");
-      statusItem->setForeground(QBrush(QColor("#FF8800"))); // Orange
+      statusItem->setForeground(processingBrush);
       // Auto-scroll to the currently processing item so user can see progress
       scrollToItem(statusItem, QAbstractItemView::PositionAtCenter);
       break;
     case ImageTask::Completed:
-      tooltip = tr("Successfully optimized");
-      statusItem->setForeground(QBrush(QColor("#00AA00"))); // Green
+      statusItem->setForeground(completedBrush);
       break;
     case ImageTask::Error:
-      tooltip = optionalDetail.isEmpty() ? tr("Optimization failed")
-                                         : tr("Error: %1").arg(optionalDetail);
-      statusItem->setForeground(QBrush(QColor("#CC0000"))); // Red
+      statusItem->setForeground(errorBrush);
       break;
     }
-
-    if (!optionalDetail.isEmpty() && task->taskStatus != ImageTask::Error) {
-      tooltip += "\n" + optionalDetail;
-    }
-
-    statusItem->setToolTip(tooltip);
   }
 }
 
 void TaskWidget::updateTaskSizeAfter(ImageTask *task, const QString text) {
   int row = findRowByImageTask(task);
   if (row >= 0) {
-    QTableWidgetItem *sizeAfterItem = item(row, 4); // Size After column
-    sizeAfterItem->setText(text);
-
-    // Add tooltip with formatted size
-    QFileInfo fileInfo(task->optimizedPath);
-    if (fileInfo.exists()) {
-      qint64 bytes = fileInfo.size();
-      sizeAfterItem->setToolTip(tr("Optimized file size: %1 bytes").arg(bytes));
-    }
+    resultItem(row, 4)->setText(text); // Size After column
   }
 }
 
 void TaskWidget::updateTaskSaving(ImageTask *task, const QString text) {
+  static const QBrush excellentBrush(QColor("#00AA00")); // Dark Green
+  static const QBrush goodBrush(QColor("#44AA44"));      // Green
+  static const QBrush moderateBrush(QColor("#FF8800"));  // Orange
+  static const QBrush minimalBrush(QColor("#999999"));   // Gray
+  static const QBrush noSavingsBrush(QColor("#666666")); // Dark Gray
+
   int row = findRowByImageTask(task);
   if (row >= 0) {
-    QTableWidgetItem *savingItem = item(row, 5); // Savings column
+    QTableWidgetItem *savingItem = resultItem(row, 5); // Savings column
     savingItem->setText(text);
 
     // Extract percentage from text (format: "XXX KB (YY.YY%)")
@@ -779,38 +1098,34 @@ void TaskWidget::updateTaskSaving(ImageTask *task, const QString text) {
 
       // Color code based on savings
       if (percentage >= 30.0) {
-        savingItem->setForeground(
-            QBrush(QColor("#00AA00"))); // Excellent - Dark Green
-        savingItem->setToolTip(tr("Excellent compression! Saved %1%")
-                                   .arg(QString::number(percentage, 'f', 2)));
+        savingItem->setForeground(excellentBrush);
       } else if (percentage >= 15.0) {
-        savingItem->setForeground(QBrush(QColor("#44AA44"))); // Good - Green
-        savingItem->setToolTip(tr("Good compression. Saved %1%")
-                                   .arg(QString::number(percentage, 'f', 2)));
+        savingItem->setForeground(goodBrush);
       } else if (percentage >= 5.0) {
-        savingItem->setForeground(
-            QBrush(QColor("#FF8800"))); // Moderate - Orange
-        savingItem->setToolTip(tr("Moderate compression. Saved %1%")
-                                   .arg(QString::number(percentage, 'f', 2)));
+        savingItem->setForeground(moderateBrush);
       } else if (percentage > 0.0) {
-        savingItem->setForeground(QBrush(QColor("#999999"))); // Minimal - Gray
-        savingItem->setToolTip(tr("Minimal compression. Saved %1%")
-                                   .arg(QString::number(percentage, 'f', 2)));
+        savingItem->setForeground(minimalBrush);
       } else {
-        savingItem->setForeground(
-            QBrush(QColor("#666666"))); // No savings - Dark Gray
-        savingItem->setToolTip(tr("No compression achieved"));
+        savingItem->setForeground(noSavingsBrush);
       }
     }
   }
 }
 
 void TaskWidget::onOptimizationFinished(ImageTask *task, bool success) {
-  // qDebug() << "Optimization finished for" << task->imagePath
+  // qDebug() << "Optimization finished for" << task->imagePath()
   //          << "with success:" << success;
 
-  if (success) {
-    ImageStats stats(task->imagePath, task->optimizedPath);
+  if (success && task->commitOutcome == ImageTask::OutputDiscarded) {
+    m_journal.recordCommitted(task);
+    updateTaskSaving(task, "—");
+    updateTaskSizeAfter(task, tr("Not written"));
+    updateTaskStatus(task, tr("Output was not smaller than the original "
+                              "and was discarded"));
+  } else if (success) {
+    m_journal.recordCommitted(task);
+
+    ImageStats stats(task->imagePath(), task->optimizedPath());
 
     // update saving
     qint64 savings = stats.getSavings();
@@ -827,19 +1142,501 @@ void TaskWidget::onOptimizationFinished(ImageTask *task, bool success) {
     updateTaskSizeAfter(task, formattedSizeAfter);
 
     // update status
-    updateTaskStatus(task);
+    QString detail = qualityMetricsText(task);
+    if (task->commitOutcome == ImageTask::OriginalKept) {
+      detail = tr("Output was not smaller, the original was kept");
+    } else if (task->metadataBytesRemoved > 0) {
+      detail += (detail.isEmpty() ? "" : "\n") +
+                tr("Removed %1 of metadata")
+                    .arg(m_locale.formattedDataSize(
+                        task->metadataBytesRemoved));
+    } else if (task->jpegRoundTripVerified) {
+      detail += (detail.isEmpty() ? "" : "\n") +
+                tr("Lossless, pixelbatch --restore-jpeg gives back the "
+                   "original JPEG");
+    } else if (stats.isJpegReconstructible()) {
+      detail += (detail.isEmpty() ? "" : "\n") +
+                tr("Holds JPEG reconstruction data, the round trip was not "
+                   "verified");
+    }
+    if (task->resizedTo.isValid() &&
+        task->commitOutcome != ImageTask::OriginalKept) {
+      detail += (detail.isEmpty() ? "" : "\n") +
+                tr("Resized to %1 x %2")
+                    .arg(task->resizedTo.width())
+                    .arg(task->resizedTo.height());
+    }
+    if (!task->processedOn.isEmpty()) {
+      detail += (detail.isEmpty() ? "" : "\n") +
+                tr("Optimized on %1").arg(task->processedOn);
+    }
+    updateTaskStatus(task, detail);
   } else {
+    m_journal.recordFailed(task, QString());
     updateTaskStatus(task);
   }
+
+  if (success && m_watchTasks.contains(task)) {
+    pruneWatchTasks(task);
+  }
+}
+
+void TaskWidget::pruneWatchTasks(ImageTask *completedTask) {
+  m_completedWatchTasks.removeAll(completedTask);
+  m_completedWatchTasks.enqueue(completedTask);
+
+  // The task just completed is the newest and always stays
+  while (m_completedWatchTasks.count() > WATCH_TASKS_KEPT) {
+    ImageTask *oldest = m_completedWatchTasks.dequeue();
+    // Queued again since, it comes back once completed
+    if (oldest->taskStatus == ImageTask::Completed) {
+      removeTask(oldest);
+    }
+  }
 }
 
 void TaskWidget::onOptimizationError(ImageTask *task,
                                      const QString &errorString) {
-  qWarning() << "Optimization error for" << task->imagePath << ":"
+  qWarning() << "Optimization error for" << task->imagePath() << ":"
              << errorString;
+  m_journal.recordFailed(task, errorString);
   updateTaskStatus(task, errorString);
 }
 
+bool TaskWidget::shouldMeasureQuality(ImageTask *task) {
+  if (!task->settingsSnapshot->computeQualityMetrics()) {
+    return false;
+  }
+
+  // A resized output has no pixels to compare with the original one to one
+  if (task->resizedTo.isValid()) {
+    return false;
+  }
+
+  // Vector images have no pixels to compare
+  return ImageWorkerFactory::instance().getImageType(task) != ImageType::SVG;
+}
+
+QString TaskWidget::qualityMetricsText(const ImageTask *task) const {
+  if (!task->hasQualityMetrics) {
+    return QString();
+  }
+
+  QString psnr = qIsInf(task->psnr)
+                     ? tr("lossless")
+                     : QString("%1 dB").arg(task->psnr, 0, 'f', 2);
+  QString text = tr("PSNR: %1, SSIM: %2, MS-SSIM: %3")
+                     .arg(psnr)
+                     .arg(task->ssim, 0, 'f', 4)
+                     .arg(task->msSsim, 0, 'f', 4);
+  if (task->searchedQuality >= 0) {
+    text += "\n" + tr("Searched quality: %1").arg(task->searchedQuality);
+  }
+  return text;
+}
+
+void TaskWidget::onHeaderAnalysisFinished(ImageTask *task,
+                                          const QString &imagePath,
+                                          const ImageHeader::Info &info,
+                                          const QString &errorString) {
+  // Removed meanwhile, or a new task took its place
+  if (!m_headerPendingTasks.remove(task) || task->imagePath() != imagePath) {
+    return;
+  }
+
+  if (info.valid) {
+    task->header = info;
+    emit imageHeaderAnalyzed(task);
+  } else {
+    qWarning() << "Unable to read the header of" << imagePath << ":"
+               << errorString;
+  }
+
+  if (m_isProcessing) {
+    processNextBatch();
+  } else if (m_headerPendingTasks.isEmpty()) {
+    updateStatusBarMessage(headerSummary());
+  }
+}
+
+QString TaskWidget::headerSummary() const {
+  int imageCount = 0;
+  int progressiveCount = 0;
+  qint64 frameCount = 0;
+  double megapixels = 0.0;
+  qint64 metadataBytes = 0;
+  for (const ImageTask *task : qAsConst(m_imageTasks)) {
+    if (!task->header.valid) {
+      continue;
+    }
+    imageCount++;
+    progressiveCount += task->header.progressive ? 1 : 0;
+    frameCount += task->header.frameCount;
+    megapixels += double(task->header.width) * task->header.height / 1e6;
+    metadataBytes += task->header.metadataBytes;
+  }
+
+  return tr("Analyzed %1 image(s): %2 megapixels, %3 frame(s), %4 "
+            "progressive, %5 of metadata")
+      .arg(imageCount)
+      .arg(megapixels, 0, 'f', 1)
+      .arg(frameCount)
+      .arg(progressiveCount)
+      .arg(m_locale.formattedDataSize(metadataBytes));
+}
+
+void TaskWidget::onQualityAnalysisFinished(ImageTask *task,
+                                           const QualityMetrics::Result &result,
+                                           const QString &errorString) {
+  m_activeMeasurements--;
+  releaseTaskResources(task);
+
+  // The task may have been removed or cancelled while it was measured
+  if (!m_imageTasks.contains(task) ||
+      task->taskStatus != ImageTask::Processing) {
+    processNextBatch();
+    return;
+  }
+
+  if (!result.valid) {
+    // Not being able to measure is no reason to throw the output away
+    qWarning() << "Unable to measure quality of" << task->optimizedPath() << ":"
+               << errorString;
+    task->taskStatus = ImageTask::Completed;
+    onOptimizationFinished(task, true);
+    updateTaskStatus(task, tr("Quality not measured: %1").arg(errorString));
+    processNextBatch();
+    return;
+  }
+
+  task->hasQualityMetrics = true;
+  task->psnr = result.psnr;
+  task->ssim = result.ssim;
+  task->msSsim = result.msSsim;
+  applyQualityMetrics(task);
+
+  processNextBatch();
+}
+
+void TaskWidget::applyQualityMetrics(ImageTask *task) {
+  double minimumSsim = task->settingsSnapshot->minimumSsim();
+  if (minimumSsim > 0.0 && task->ssim < minimumSsim) {
+    QFile::remove(task->optimizedPath());
+    task->taskStatus = ImageTask::Error;
+    onOptimizationError(task,
+                        tr("SSIM %1 is below the minimum of %2, output "
+                           "discarded")
+                            .arg(task->ssim, 0, 'f', 4)
+                            .arg(minimumSsim, 0, 'f', 3));
+  } else {
+    task->taskStatus = ImageTask::Completed;
+    onOptimizationFinished(task, true);
+  }
+}
+
+void TaskWidget::beginBatch() {
+  // Preferences apply from the next batch on, the snapshots compiled for it
+  // are shared by all its tasks
+  if (!m_isProcessing) {
+    m_journal.setEnabled(m_settings.getBatchJournalEnabled());
+    m_settingsSnapshots.clear();
+  }
+}
+
+void TaskWidget::queueTask(ImageTask *task, bool interactive) {
+  task->settingsSnapshot = settingsSnapshotFor(task);
+  task->taskStatus = ImageTask::Queued;
+  if (interactive) {
+    m_interactiveTaskQueue.enqueue(task);
+  } else {
+    m_imageTaskQueue.enqueue(task);
+  }
+  m_journal.recordQueued(task);
+  updateTaskStatus(task);
+}
+
+int TaskWidget::queuedTaskCount() const {
+  return m_interactiveTaskQueue.count() + m_imageTaskQueue.count();
+}
+
+void TaskWidget::optimizeTaskNow(ImageTask *task) {
+  if (!task || task->taskStatus == ImageTask::Processing ||
+      findRowByImageTask(task) < 0) {
+    return;
+  }
+
+  // Already waiting in the batch, move it to the front lane
+  m_imageTaskQueue.removeAll(task);
+  m_interactiveTaskQueue.removeAll(task);
+  m_retryingTasks.remove(task);
+  beginBatch();
+  queueTask(task, true);
+  updateTaskSizeAfter(task, "—");
+  updateTaskSaving(task, "—");
+
+  setIsProcessing(true);
+  updateStatusBarMessage(tr("%1 queued ahead of the batch")
+                             .arg(QFileInfo(task->imagePath()).fileName()));
+  processNextBatch();
+}
+
+bool TaskWidget::preemptBatchTask() {
+  if (m_runningBatchTasks.isEmpty()) {
+    return false;
+  }
+
+  // The newest one has the least work to lose
+  QPair<ImageWorker *, ImageTask *> victim = m_runningBatchTasks.takeLast();
+  ImageWorker *worker = victim.first;
+  ImageTask *task = victim.second;
+  qDebug() << "Preempting" << task->imagePath() << "for an interactive task";
+
+  // Kills its processes, without calling us back
+  disconnect(worker, nullptr, this, nullptr);
+  m_activeWorkers.removeOne(worker);
+  delete worker;
+  QFile::remove(task->optimizedPath());
+  releaseTaskResources(task);
+  m_activeTasks--;
+
+  // First in line once the interactive tasks are done
+  task->taskStatus = ImageTask::Queued;
+  m_imageTaskQueue.prepend(task);
+  updateTaskStatus(task, tr("Paused for an image optimized on demand"));
+  return true;
+}
+
+void TaskWidget::forgetRunningBatchTask(ImageWorker *worker) {
+  for (int i = 0; i < m_runningBatchTasks.count(); ++i) {
+    if (m_runningBatchTasks.at(i).first == worker) {
+      m_runningBatchTasks.removeAt(i);
+      return;
+    }
+  }
+}
+
+bool TaskWidget::reserveTaskResources(ImageTask *task, bool force) {
+  // Multithreaded encoders would oversubscribe the cores next to each other,
+  // quality search and variants run several of them per task
+  ImageType imageType = ImageWorkerFactory::instance().getImageType(task);
+  int encodes = task->settingsSnapshot->concurrentEncodes(imageType);
+  int threads = task->settingsSnapshot->threads(imageType) * encodes;
+  int threadBudget = ResourceGovernor::threadBudget();
+  // A single task over a budget still runs, alone
+  if (!force && m_reservedThreads > 0 &&
+      m_reservedThreads + threads > threadBudget) {
+    qDebug() << "Holding" << task->imagePath() << "back," << threads
+             << "threads would exceed the thread budget";
+    return false;
+  }
+
+  qint64 estimate = 0;
+  qint64 budget = ResourceGovernor::memoryBudget();
+  if (budget > 0) {
+    // Every concurrent encoder holds its own copy of the pixels
+    estimate =
+        ResourceGovernor::estimateTaskMemory(task->imagePath(), task->header) *
+        encodes;
+    if (!force && m_reservedMemory > 0 &&
+        m_reservedMemory + estimate > budget) {
+      qDebug() << "Holding" << task->imagePath() << "back," << estimate
+               << "bytes would exceed the memory budget";
+      return false;
+    }
+  }
+
+  // Reserved once per run
+  releaseTaskResources(task);
+  m_taskMemory.insert(task, estimate);
+  m_reservedMemory += estimate;
+  m_taskThreads.insert(task, threads);
+  m_reservedThreads += threads;
+  return true;
+}
+
+void TaskWidget::releaseTaskResources(ImageTask *task) {
+  m_reservedMemory -= m_taskMemory.take(task);
+  m_reservedThreads -= m_taskThreads.take(task);
+}
+
+SettingsSnapshot::Ptr TaskWidget::settingsSnapshotFor(const ImageTask *task) {
+  QByteArray key;
+  QDataStream stream(&key, QIODevice::WriteOnly);
+  stream << task->customOptimizerSettings;
+
+  auto it = m_settingsSnapshots.constFind(key);
+  if (it != m_settingsSnapshots.cend()) {
+    return it.value();
+  }
+  SettingsSnapshot::Ptr snapshot =
+      SettingsSnapshot::compile(task->customOptimizerSettings);
+  m_settingsSnapshots.insert(key, snapshot);
+  return snapshot;
+}
+
+bool TaskWidget::retryTimedOutTask(ImageTask *task) {
+  static const int RETRY_BACKOFF_MS = 5000;
+
+  if (!task->timedOut ||
+      task->timeoutRetries >= m_settings.getTimeoutRetries()) {
+    return false;
+  }
+
+  // 5 s, 10 s, 20 s... a box busy enough to stall a tool gets some air
+  int delayMs = RETRY_BACKOFF_MS << qMin(task->timeoutRetries, 6);
+  task->timeoutRetries++;
+  task->taskStatus = ImageTask::Queued;
+  m_retryingTasks.insert(task);
+  updateTaskStatus(task, tr("Timed out, retrying in %1 s (attempt %2 of %3)")
+                             .arg(delayMs / 1000)
+                             .arg(task->timeoutRetries + 1)
+                             .arg(m_settings.getTimeoutRetries() + 1));
+
+  QTimer::singleShot(delayMs, this, [this, task]() {
+    // Removed or cancelled meanwhile
+    if (!m_retryingTasks.remove(task)) {
+      return;
+    }
+    queueTask(task);
+    processNextBatch();
+  });
+  return true;
+}
+
+void TaskWidget::findInterruptedBatch(
+    std::function<void(const QList<BatchJournal::Entry> &)> found) {
+  m_journal.findUnfinishedEntries(this, found);
+}
+
+void TaskWidget::resumeInterruptedBatch(
+    const QList<BatchJournal::Entry> &entries) {
+  // The resumed tasks are journaled again as they are queued, a batch
+  // started while the journal was being read keeps its records
+  if (m_isProcessing) {
+    m_journal.forget(entries);
+  } else {
+    m_journal.clear();
+  }
+  beginBatch();
+
+  int queuedCount = 0;
+  for (const BatchJournal::Entry &entry : entries) {
+    if (!QFileInfo::exists(entry.imagePath)) {
+      qWarning() << "Not resuming" << entry.imagePath
+                 << ", the file no longer exists";
+      continue;
+    }
+
+    addFileToTable(entry.imagePath);
+    ImageTask *imageTask =
+        m_tasksByPath.value(ImageTask::pathKey(entry.imagePath));
+    if (!imageTask || imageTask->taskStatus == ImageTask::Queued ||
+        imageTask->taskStatus == ImageTask::Processing) {
+      continue;
+    }
+
+    imageTask->customOutputDir = entry.customOutputDir;
+    imageTask->customOutputPrefix = entry.customOutputPrefix;
+    imageTask->customOptimizerSettings =
+        ImageTask::internSettings(entry.customOptimizerSettings);
+    setTaskOutputPath(imageTask, generateOutputPath(imageTask));
+    queueTask(imageTask);
+    queuedCount++;
+  }
+
+  if (queuedCount > 0) {
+    setIsProcessing(true);
+    updateStatusBarMessage(
+        tr("%1 %2 of the interrupted batch queued for processing")
+            .arg(QString::number(queuedCount),
+                 QString(queuedCount > 1 ? "items" : "item")));
+  }
+
+  processNextBatch();
+}
+
+void TaskWidget::discardInterruptedBatch(
+    const QList<BatchJournal::Entry> &entries) {
+  if (m_isProcessing) {
+    m_journal.forget(entries);
+  } else {
+    m_journal.clear();
+  }
+}
+
+void TaskWidget::addWatchedFile(const QString &filePath,
+                                const FolderWatcher::Folder &folder) {
+  const QPair<quint32, QString> pathKey = ImageTask::pathKey(filePath);
+  // Never feed our own output back in
+  if (m_taskOutputPaths.contains(pathKey)) {
+    return;
+  }
+  ImageTask *imageTask = m_tasksByPath.value(pathKey);
+
+  if (imageTask) {
+    // Changed while being optimized, the current run wins
+    if (imageTask->taskStatus == ImageTask::Queued ||
+        imageTask->taskStatus == ImageTask::Processing) {
+      return;
+    }
+    updateTaskSizeAfter(imageTask, "—");
+    updateTaskSaving(imageTask, "—");
+  } else {
+    if (!addFileToTable(filePath)) {
+      return;
+    }
+    imageTask = m_imageTasks.last();
+  }
+  m_watchTasks.insert(imageTask);
+
+  imageTask->customOutputDir = folder.outputDir;
+  imageTask->customOutputPrefix = folder.outputPrefix;
+  imageTask->customOptimizerSettings =
+      ImageTask::internSettings(folder.optimizerSettings);
+  setTaskOutputPath(imageTask, generateOutputPath(imageTask));
+
+  beginBatch();
+  queueTask(imageTask);
+  setIsProcessing(true);
+  processNextBatch();
+}
+
+void TaskWidget::addRescannedFile(const QString &filePath,
+                                  const FolderWatcher::Folder &folder) {
+  ImageTask *imageTask = m_tasksByPath.value(ImageTask::pathKey(filePath));
+  if (imageTask && (imageTask->taskStatus == ImageTask::Queued ||
+                    imageTask->taskStatus == ImageTask::Processing)) {
+    return;
+  }
+
+  // Tasks pruned or from an earlier session leave only their output behind
+  QString outputPath;
+  if (imageTask) {
+    outputPath = imageTask->optimizedPath();
+  } else {
+    ImageTask probe(filePath, QString());
+    probe.customOutputDir = folder.outputDir;
+    probe.customOutputPrefix = folder.outputPrefix;
+    probe.customOptimizerSettings =
+        ImageTask::internSettings(folder.optimizerSettings);
+    probe.settingsSnapshot = settingsSnapshotFor(&probe);
+    outputPath = generateOutputPath(&probe);
+  }
+
+  QFileInfo output(outputPath);
+  if (output.isFile() &&
+      output.lastModified() >= QFileInfo(filePath).lastModified()) {
+    return;
+  }
+
+  addWatchedFile(filePath, folder);
+}
+
+bool TaskWidget::listenForAgents(const QString &address,
+                                 QString *errorString) {
+  return m_coordinator->listen(address, errorString);
+}
+
 void TaskWidget::setIsProcessing(bool value) {
   if (m_isProcessing != value) {
     m_isProcessing = value;
@@ -851,17 +1648,62 @@ void TaskWidget::updateTaskOverlayWidget() {
   rowCount() == 0 ? m_overlayWidget->show() : m_overlayWidget->hide();
 }
 
+void TaskWidget::prefetchVisibleThumbnails() {
+  if (rowCount() == 0) {
+    return;
+  }
+
+  int firstVisibleRow = rowAt(0);
+  int lastVisibleRow = rowAt(viewport()->height() - 1);
+  if (firstVisibleRow < 0) {
+    return;
+  }
+  if (lastVisibleRow < 0) {
+    lastVisibleRow = rowCount() - 1;
+  }
+
+  // One page above and below the viewport
+  int margin = lastVisibleRow - firstVisibleRow + 1;
+  int firstRow = qMax(0, firstVisibleRow - margin);
+  int lastRow = qMin(rowCount() - 1, lastVisibleRow + margin);
+
+  // Visible rows first, then the surrounding ones
+  QStringList imagePaths;
+  for (int row = firstVisibleRow; row <= lastVisibleRow; ++row) {
+    if (ImageTask *task = getImageTaskFromRow(row)) {
+      imagePaths.append(task->imagePath());
+    }
+  }
+  for (int offset = 1; offset <= margin; ++offset) {
+    int below = lastVisibleRow + offset;
+    int above = firstVisibleRow - offset;
+    if (below <= lastRow) {
+      if (ImageTask *task = getImageTaskFromRow(below)) {
+        imagePaths.append(task->imagePath());
+      }
+    }
+    if (above >= firstRow) {
+      if (ImageTask *task = getImageTaskFromRow(above)) {
+        imagePaths.append(task->imagePath());
+      }
+    }
+  }
+
+  ThumbnailCache::instance().prefetch(imagePaths);
+}
+
 bool TaskWidget::hasSelection() {
   QList<QTableWidgetItem *> selectedItems = this->selectedItems();
   return !selectedItems.isEmpty();
 }
 
-QString TaskWidget::generateOutputPath(ImageTask *task) const {
+QString TaskWidget::generateOutputPath(ImageTask *task,
+                                      int variantWidth) const {
   if (!task) {
     return QString();
   }
 
-  QFileInfo fileInfo(task->imagePath);
+  QFileInfo fileInfo(task->imagePath());
 
   // Use custom settings if set, otherwise use global settings
   QString outputDir = task->hasCustomOutputDir()
@@ -871,7 +1713,65 @@ QString TaskWidget::generateOutputPath(ImageTask *task) const {
                          ? task->customOutputPrefix
                          : m_settings.getOutputFilePrefix();
 
-  return outputDir + outputPrefix + fileInfo.fileName();
+  // Conversions write another format, photo.jpg becomes photo.webp
+  ImageWorkerFactory &factory = ImageWorkerFactory::instance();
+  ImageType imageType = factory.getImageType(task);
+  ImageOptimizer optimizer =
+      task->settingsSnapshot
+          ? task->settingsSnapshot->optimizer(imageType)
+          : factory.getOptimizer(imageType,
+                                 m_settings.getFormatOptimizer(
+                                     ImageTypeUtils::imageTypeToString(
+                                         imageType)));
+  QString suffix = optimizer.convertsFormat() ? optimizer.getOutputFormat()
+                                              : fileInfo.suffix();
+
+  // photo.jpg and photo.png next to each other convert to photo.jpg.webp
+  // and photo.png.webp
+  QString baseName = fileInfo.completeBaseName();
+  if (optimizer.convertsFormat() && m_taskStems.value(stemKey(task)) > 1) {
+    baseName = fileInfo.fileName();
+  }
+
+  QString fileName = fileInfo.fileName();
+  if (variantWidth > 0) {
+    // Extensionless sources get the one of their content
+    if (suffix.isEmpty()) {
+      suffix = factory.getOptimizerByImageType(imageType)
+                   .getSupportedFormats()
+                   .value(0);
+    }
+    fileName = m_settings.getVariantNameTemplate()
+                   .replace("{name}", baseName)
+                   .replace("{width}", QString::number(variantWidth))
+                   .replace("{ext}", suffix);
+  } else if (optimizer.convertsFormat()) {
+    fileName = baseName + "." + suffix;
+  }
+
+  return outputDir + outputPrefix + fileName;
+}
+
+void TaskWidget::setTaskOutputPath(ImageTask *task, const QString &path) {
+  // Tasks without an output yet have an empty name
+  QPair<quint32, QString> oldKey = task->optimizedPathKey();
+  if (!oldKey.second.isEmpty() && --m_taskOutputPaths[oldKey] <= 0) {
+    m_taskOutputPaths.remove(oldKey);
+  }
+  task->setOptimizedPath(path);
+  QPair<quint32, QString> newKey = task->optimizedPathKey();
+  if (!newKey.second.isEmpty()) {
+    m_taskOutputPaths[newKey]++;
+  }
+}
+
+QPair<quint32, QString> TaskWidget::stemKey(const ImageTask *task) {
+  QPair<quint32, QString> key = task->pathKey();
+  int dot = key.second.lastIndexOf('.');
+  if (dot > 0) {
+    key.second.truncate(dot);
+  }
+  return key;
 }
 
 void TaskWidget::setTaskCustomOutputDir(ImageTask *task, const QString &dir) {
@@ -883,7 +1783,7 @@ void TaskWidget::setTaskCustomOutputDir(ImageTask *task, const QString &dir) {
   if (task->taskStatus == ImageTask::Pending ||
       task->taskStatus == ImageTask::Queued ||
       task->taskStatus == ImageTask::Error) {
-    task->optimizedPath = generateOutputPath(task);
+    setTaskOutputPath(task, generateOutputPath(task));
   }
 }
 
@@ -896,7 +1796,7 @@ void TaskWidget::setTaskCustomOutputPrefix(ImageTask *task, const QString &prefi
   if (task->taskStatus == ImageTask::Pending ||
       task->taskStatus == ImageTask::Queued ||
       task->taskStatus == ImageTask::Error) {
-    task->optimizedPath = generateOutputPath(task);
+    setTaskOutputPath(task, generateOutputPath(task));
   }
 }
 
@@ -909,7 +1809,7 @@ void TaskWidget::clearTaskCustomOutputDir(ImageTask *task) {
   if (task->taskStatus == ImageTask::Pending ||
       task->taskStatus == ImageTask::Queued ||
       task->taskStatus == ImageTask::Error) {
-    task->optimizedPath = generateOutputPath(task);
+    setTaskOutputPath(task, generateOutputPath(task));
   }
 }
 
@@ -922,25 +1822,31 @@ void TaskWidget::clearTaskCustomOutputPrefix(ImageTask *task) {
   if (task->taskStatus == ImageTask::Pending ||
       task->taskStatus == ImageTask::Queued ||
       task->taskStatus == ImageTask::Error) {
-    task->optimizedPath = generateOutputPath(task);
+    setTaskOutputPath(task, generateOutputPath(task));
   }
 }
 
 void TaskWidget::setTaskCustomOptimizerSettings(ImageTask *task, const QVariantMap &settings) {
   if (!task) return;
 
-  task->customOptimizerSettings = settings;
+  task->customOptimizerSettings = ImageTask::internSettings(settings);
+  // Queued tasks run with the snapshot compiled when they were queued
+  if (task->taskStatus == ImageTask::Queued) {
+    task->settingsSnapshot = settingsSnapshotFor(task);
+  }
 
-  qDebug() << "Set custom optimizer settings for task:" << task->imagePath;
-  qDebug() << "Custom settings:" << settings;
+  qDebug() << "Set custom optimizer settings for task:" << task->imagePath();
 }
 
 void TaskWidget::clearTaskCustomOptimizerSettings(ImageTask *task) {
   if (!task) return;
 
   task->customOptimizerSettings.clear();
+  if (task->taskStatus == ImageTask::Queued) {
+    task->settingsSnapshot = settingsSnapshotFor(task);
+  }
 
-  qDebug() << "Cleared custom optimizer settings for task:" << task->imagePath;
+  qDebug() << "Cleared custom optimizer settings for task:" << task->imagePath();
 }
 
 void TaskWidget::onBatchAdditionStarting() {
@@ -970,8 +1876,10 @@ void TaskWidget::onFilesAddedBatch(int requestedCount) {
   }
 }
 
-void TaskWidget::onCheckboxStateChanged(int state) {
-  Q_UNUSED(state);
+void TaskWidget::onItemChanged(QTableWidgetItem *item) {
+  if (item->column() != 0) {
+    return;
+  }
 
   // Emit signal with count of checked items
   emit checkedItemsChanged(getCheckedTasks().count());
@@ -979,12 +1887,9 @@ void TaskWidget::onCheckboxStateChanged(int state) {
 
 bool TaskWidget::hasCheckedItems() const {
   for (int row = 0; row < rowCount(); ++row) {
-    QWidget *widget = cellWidget(row, 0);
-    if (widget) {
-      QCheckBox *checkBox = widget->findChild<QCheckBox *>();
-      if (checkBox && checkBox->isChecked()) {
-        return true;
-      }
+    QTableWidgetItem *checkItem = item(row, 0);
+    if (checkItem && checkItem->checkState() == Qt::Checked) {
+      return true;
     }
   }
   return false;
@@ -994,14 +1899,11 @@ QList<ImageTask *> TaskWidget::getCheckedTasks() const {
   QList<ImageTask *> checkedTasks;
 
   for (int row = 0; row < rowCount(); ++row) {
-    QWidget *widget = cellWidget(row, 0);
-    if (widget) {
-      QCheckBox *checkBox = widget->findChild<QCheckBox *>();
-      if (checkBox && checkBox->isChecked()) {
-        ImageTask *task = getImageTaskFromRow(row);
-        if (task) {
-          checkedTasks.append(task);
-        }
+    QTableWidgetItem *checkItem = item(row, 0);
+    if (checkItem && checkItem->checkState() == Qt::Checked) {
+      ImageTask *task = getImageTaskFromRow(row);
+      if (task) {
+        checkedTasks.append(task);
       }
     }
   }
@@ -1009,29 +1911,23 @@ QList<ImageTask *> TaskWidget::getCheckedTasks() const {
   return checkedTasks;
 }
 
-void TaskWidget::checkAll() {
-  for (int row = 0; row < rowCount(); ++row) {
-    QWidget *widget = cellWidget(row, 0);
-    if (widget) {
-      QCheckBox *checkBox = widget->findChild<QCheckBox *>();
-      if (checkBox) {
-        checkBox->setChecked(true);
+void TaskWidget::setAllCheckStates(Qt::CheckState state) {
+  // One checkedItemsChanged for the whole table, not one per row
+  {
+    QSignalBlocker blocker(this);
+    for (int row = 0; row < rowCount(); ++row) {
+      QTableWidgetItem *checkItem = item(row, 0);
+      if (checkItem) {
+        checkItem->setCheckState(state);
       }
     }
   }
+  emit checkedItemsChanged(getCheckedTasks().count());
 }
 
-void TaskWidget::uncheckAll() {
-  for (int row = 0; row < rowCount(); ++row) {
-    QWidget *widget = cellWidget(row, 0);
-    if (widget) {
-      QCheckBox *checkBox = widget->findChild<QCheckBox *>();
-      if (checkBox) {
-        checkBox->setChecked(false);
-      }
-    }
-  }
-}
+void TaskWidget::checkAll() { setAllCheckStates(Qt::Checked); }
+
+void TaskWidget::uncheckAll() { setAllCheckStates(Qt::Unchecked); }
 
 void TaskWidget::processCheckedImages() {
   QList<ImageTask *> checkedTasks = getCheckedTasks();
@@ -1041,14 +1937,13 @@ void TaskWidget::processCheckedImages() {
     return;
   }
 
+  beginBatch();
   int queuedCount = 0;
 
   for (ImageTask *imageTask : checkedTasks) {
     // Only process pending tasks
     if (imageTask->taskStatus == ImageTask::Pending) {
-      imageTask->taskStatus = ImageTask::Queued;
-      m_imageTaskQueue.enqueue(imageTask);
-      updateTaskStatus(imageTask);
+      queueTask(imageTask);
       queuedCount++;
     }
   }
@@ -1073,15 +1968,14 @@ void TaskWidget::reprocessCheckedImages() {
     return;
   }
 
+  beginBatch();
   int queuedCount = 0;
 
   for (ImageTask *imageTask : checkedTasks) {
     // Re-process completed or error tasks
     if (imageTask->taskStatus == ImageTask::Completed ||
         imageTask->taskStatus == ImageTask::Error) {
-      imageTask->taskStatus = ImageTask::Queued;
-      m_imageTaskQueue.enqueue(imageTask);
-      updateTaskStatus(imageTask);
+      queueTask(imageTask);
 
       // Clear previous results
       updateTaskSizeAfter(imageTask, "—");
@@ -1,18 +1,32 @@
 #ifndef TASKWIDGET_H
 #define TASKWIDGET_H
 
+#include "batchjournal.h"
+#include "folderwatcher.h"
 #include "imagetask.h"
 #include "settings.h"
 #include "taskactionwidget.h"
 #include "taskwidgetoverlay.h"
 
+#include <worker/qualitymetrics.h>
+#include <worker/settingssnapshot.h>
+
 #include <QDragEnterEvent>
 #include <QFileInfo>
+#include <QHash>
 #include <QHeaderView>
 #include <QImageReader>
 #include <QMimeData>
+#include <QPersistentModelIndex>
 #include <QQueue>
+#include <QSet>
 #include <QTableWidget>
+#include <QTimer>
+
+class HeaderAnalyzer;
+class ImageWorker;
+class QualityAnalyzer;
+class WorkCoordinator;
 
 class TaskWidget : public QTableWidget {
 
@@ -40,8 +54,30 @@ public:
   void setTaskCustomOptimizerSettings(ImageTask *task, const QVariantMap &settings);
   void clearTaskCustomOptimizerSettings(ImageTask *task);
 
+  // Interactive lane, the task runs before anything of the queued batch and
+  // may preempt a running batch task for its slot
+  void optimizeTaskNow(ImageTask *task);
+
   void cancelAllProcessing();
 
+  // Batch interrupted in a previous session, see BatchJournal. Read and
+  // checked on a pool thread, found is called with it on this thread.
+  void findInterruptedBatch(
+      std::function<void(const QList<BatchJournal::Entry> &)> found);
+  void resumeInterruptedBatch(const QList<BatchJournal::Entry> &entries);
+  void discardInterruptedBatch(const QList<BatchJournal::Entry> &entries);
+
+  // Queue a file reported by the FolderWatcher, again if it changed
+  void addWatchedFile(const QString &filePath,
+                      const FolderWatcher::Folder &folder);
+  // Same for a file found by a rescan, skipped if queued already or its
+  // output is not older than it
+  void addRescannedFile(const QString &filePath,
+                        const FolderWatcher::Folder &folder);
+
+  // Share the queue with agents (pixelbatch --agent) connecting to address
+  bool listenForAgents(const QString &address, QString *errorString);
+
 public slots:
 
   // taskactionwidget slots
@@ -76,6 +112,7 @@ signals:
   void selectedImageTaskChanged(ImageTask *task);
   void allTasksCompleted(const ImageTask::TaskStatusCounts &counts);
   void checkedItemsChanged(int count);
+  void imageHeaderAnalyzed(ImageTask *task);
 
 protected:
   void dragEnterEvent(QDragEnterEvent *event) override;
@@ -86,14 +123,33 @@ protected:
                         const QItemSelection &deselected) override;
   void keyPressEvent(QKeyEvent *event) override;
   void mousePressEvent(QMouseEvent *event) override;
+  // Tooltips are built from the task when shown, not stored per row
+  bool viewportEvent(QEvent *event) override;
 
 private slots:
   void onOptimizationFinished(ImageTask *task, bool success);
   void onOptimizationError(ImageTask *task, const QString &errorString);
-  void onCheckboxStateChanged(int state);
+  void onHeaderAnalysisFinished(ImageTask *task, const QString &imagePath,
+                                const ImageHeader::Info &info,
+                                const QString &errorString);
+  void onQualityAnalysisFinished(ImageTask *task,
+                                 const QualityMetrics::Result &result,
+                                 const QString &errorString);
+  void onItemChanged(QTableWidgetItem *item);
 
 private:
   QList<ImageTask *> m_imageTasks;
+  // File column of the row of each task, kept current by the model on
+  // inserts and removals
+  QHash<ImageTask *, QPersistentModelIndex> m_taskRows;
+  // Tasks by ImageTask::pathKey(), duplicate check when adding
+  QHash<QPair<quint32, QString>, ImageTask *> m_tasksByPath;
+  // Tasks writing to each ImageTask::optimizedPathKey(), keep it current
+  // with setTaskOutputPath
+  QHash<QPair<quint32, QString>, int> m_taskOutputPaths;
+  // Tasks by source directory and name without extension, conversions of
+  // photo.jpg and photo.png must not both write photo.webp
+  QHash<QPair<quint32, QString>, int> m_taskStems;
 
   TaskWidgetOverlay *m_overlayWidget;
 
@@ -108,23 +164,84 @@ private:
   void updateTaskSaving(ImageTask *task, const QString text);
   void updateTaskStatus(ImageTask *task, const QString optionalDetail = "");
   void processNextBatch();
+  void beginBatch();
+  void queueTask(ImageTask *task, bool interactive = false);
+  int queuedTaskCount() const;
+  bool preemptBatchTask();
+  void forgetRunningBatchTask(ImageWorker *worker);
+  bool reserveTaskResources(ImageTask *task, bool force = false);
+  void releaseTaskResources(ImageTask *task);
+  bool retryTimedOutTask(ImageTask *task);
+  SettingsSnapshot::Ptr settingsSnapshotFor(const ImageTask *task);
 
   QQueue<ImageTask *> m_imageTaskQueue;
+  QQueue<ImageTask *> m_interactiveTaskQueue; // served first
+  // Batch tasks started by this widget, oldest first, preemption candidates
+  QList<QPair<ImageWorker *, ImageTask *>> m_runningBatchTasks;
   int m_activeTasks = 0;
+  // Estimated memory of the running local tasks, see ResourceGovernor
+  QHash<ImageTask *, qint64> m_taskMemory;
+  qint64 m_reservedMemory = 0;
+  // Threads of their tools, see ImageWorker::threadCount
+  QHash<ImageTask *, int> m_taskThreads;
+  int m_reservedThreads = 0;
+  // Timed out tasks waiting out their backoff before being queued again
+  QSet<ImageTask *> m_retryingTasks;
+  // Metadata removed from the outputs of the batch, per category
+  MetadataStripper::Result m_strippedMetadata;
+  // One per distinct custom settings of the batch
+  QHash<QByteArray, SettingsSnapshot::Ptr> m_settingsSnapshots;
   QList<QObject*> m_activeWorkers;  // Track active workers for cleanup
   int m_pendingCountBeforeBatch = 0; // Track count before batch addition
   bool m_checkboxesVisible = false; // Track if checkboxes are visible
 
   void removeTask(ImageTask *task);
+  void setAllCheckStates(Qt::CheckState state);
   int findRowByImageTask(ImageTask *task);
+  // Created when first filled, unprocessed rows go without
+  QTableWidgetItem *resultItem(int row, int column);
+  QString taskToolTip(int row, int column) const;
   void removeTasksByStatus(const ImageTask::Status &status);
   void updateStatusBarMessage(const QString &message);
   QString getSummaryAndUpdateView();
   ImageTask *getImageTaskFromRow(int row) const;
 
   void updateTaskOverlayWidget();
+
+  // Warm the thumbnail cache for rows around the viewport
+  QTimer *m_thumbnailPrefetchTimer;
+  void prefetchVisibleThumbnails();
+  // Header pre-flight of added images, feeds the memory estimate and the
+  // detail panel
+  HeaderAnalyzer *m_headerAnalyzer;
+  QSet<ImageTask *> m_headerPendingTasks;
+  QString headerSummary() const;
+  // Optional quality post-stage, runs after a successful optimization
+  QualityAnalyzer *m_qualityAnalyzer;
+  int m_activeMeasurements = 0;
+  bool shouldMeasureQuality(ImageTask *task);
+  QString qualityMetricsText(const ImageTask *task) const;
+  void applyQualityMetrics(ImageTask *task);
+
+  // Completed watch tasks beyond this many are removed, oldest first, a
+  // watched folder would grow the table forever
+  static const int WATCH_TASKS_KEPT = 100;
+  QSet<ImageTask *> m_watchTasks;
+  QQueue<ImageTask *> m_completedWatchTasks;
+  void pruneWatchTasks(ImageTask *completedTask);
+
+  // Crash and kill recovery of the running batch
+  BatchJournal m_journal;
+
+  // Remote agents, their slots come on top of the local ones
+  WorkCoordinator *m_coordinator;
+
   QString generateSummary(const ImageTask::TaskStatusCounts &counts) const;
-  QString generateOutputPath(ImageTask *task) const;
+  // Output of the responsive variant of that width when variantWidth > 0
+  QString generateOutputPath(ImageTask *task, int variantWidth = 0) const;
+  void setTaskOutputPath(ImageTask *task, const QString &path);
+  // Key of m_taskStems
+  static QPair<quint32, QString> stemKey(const ImageTask *task);
 };
 
 #endif // TASKWIDGET_H
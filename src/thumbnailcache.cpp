@@ -0,0 +1,277 @@
+#include "thumbnailcache.h"
+#include "settings.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QUrl>
+
+namespace {
+
+// Upper bound of decoded thumbnails kept in memory (in KB)
+const int MEMORY_CACHE_LIMIT_KB = 64 * 1024;
+
+class ThumbnailPrefetchJob : public QRunnable {
+public:
+  explicit ThumbnailPrefetchJob(const QString &imagePath)
+      : m_imagePath(imagePath) {}
+
+  void run() override { ThumbnailCache::instance().thumbnail(m_imagePath); }
+
+private:
+  QString m_imagePath;
+};
+
+} // namespace
+
+ThumbnailCache &ThumbnailCache::instance() {
+  static ThumbnailCache instance;
+  return instance;
+}
+
+ThumbnailCache::ThumbnailCache(QObject *parent)
+    : QObject(parent), m_memoryCache(MEMORY_CACHE_LIMIT_KB),
+      m_diskCacheEnabled(Settings::instance().getThumbnailDiskCacheEnabled()) {
+  // XDG_CACHE_HOME/thumbnails/large as defined by the freedesktop.org spec
+  m_diskCacheDir =
+      QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+      "/thumbnails/large";
+
+  // Prefetching must never compete with the actual optimization work
+  m_prefetchPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+ThumbnailCache::~ThumbnailCache() {
+  m_prefetchPool.clear();
+  m_prefetchPool.waitForDone();
+}
+
+void ThumbnailCache::setDiskCacheEnabled(bool enabled) {
+  m_diskCacheEnabled.storeRelease(enabled ? 1 : 0);
+}
+
+bool ThumbnailCache::isDiskCacheEnabled() const {
+  return m_diskCacheEnabled.loadAcquire() != 0;
+}
+
+QString ThumbnailCache::cacheKey(const QString &imagePath) const {
+  QFileInfo fileInfo(imagePath);
+  return QString("%1|%2|%3")
+      .arg(fileInfo.absoluteFilePath())
+      .arg(fileInfo.lastModified().toMSecsSinceEpoch())
+      .arg(fileInfo.size());
+}
+
+ThumbnailCache::Entry
+ThumbnailCache::cachedThumbnail(const QString &imagePath) {
+  QString key = cacheKey(imagePath);
+
+  QMutexLocker locker(&m_mutex);
+  Entry *entry = m_memoryCache.object(key); // also marks it as recently used
+  return entry ? *entry : Entry();
+}
+
+ThumbnailCache::Entry ThumbnailCache::thumbnail(const QString &imagePath,
+                                                QString *errorString) {
+  QString key = cacheKey(imagePath);
+
+  {
+    QMutexLocker locker(&m_mutex);
+    if (Entry *entry = m_memoryCache.object(key)) {
+      return *entry;
+    }
+  }
+
+  Entry entry;
+  if (isDiskCacheEnabled()) {
+    entry = loadFromDisk(imagePath);
+  }
+
+  if (!entry.isValid()) {
+    entry = decode(imagePath, errorString);
+    if (!entry.isValid()) {
+      return entry;
+    }
+    if (isDiskCacheEnabled()) {
+      saveToDisk(imagePath, entry);
+    }
+  }
+
+  insertIntoMemory(key, entry);
+  return entry;
+}
+
+void ThumbnailCache::prefetch(const QStringList &imagePaths) {
+  // Viewport moved, what was queued for the old position is not needed now
+  m_prefetchPool.clear();
+
+  for (const QString &imagePath : imagePaths) {
+    if (cachedThumbnail(imagePath).isValid()) {
+      continue;
+    }
+    m_prefetchPool.start(new ThumbnailPrefetchJob(imagePath));
+  }
+}
+
+void ThumbnailCache::insertIntoMemory(const QString &key, const Entry &entry) {
+  int costKb = qMax(1, int(entry.image.sizeInBytes() / 1024));
+
+  QMutexLocker locker(&m_mutex);
+  m_memoryCache.insert(key, new Entry(entry), costKb);
+}
+
+ThumbnailCache::Entry ThumbnailCache::decode(const QString &imagePath,
+                                             QString *errorString) {
+  Entry entry;
+
+  if (!QFileInfo::exists(imagePath)) {
+    if (errorString) {
+      *errorString = tr("Image file not found");
+    }
+    return entry;
+  }
+
+  // Single reader for header (size/format) and pixel data
+  QImageReader reader(imagePath);
+  if (!reader.canRead()) {
+    if (errorString) {
+      *errorString = tr("Cannot read image");
+    }
+    return entry;
+  }
+
+  entry.format = reader.format();
+  entry.originalSize = reader.size();
+
+  // Let the plugin decode directly at thumbnail size (JPEG: DCT scaling)
+  if (entry.originalSize.isValid() &&
+      (entry.originalSize.width() > THUMBNAIL_SIZE ||
+       entry.originalSize.height() > THUMBNAIL_SIZE)) {
+    reader.setScaledSize(entry.originalSize.scaled(
+        THUMBNAIL_SIZE, THUMBNAIL_SIZE, Qt::KeepAspectRatio));
+  }
+
+  QImage image = reader.read();
+  if (image.isNull()) {
+    if (errorString) {
+      *errorString = tr("Failed to load image");
+    }
+    return entry;
+  }
+
+  // Plugins without ScaledSize support and unknown header sizes
+  if (image.width() > THUMBNAIL_SIZE || image.height() > THUMBNAIL_SIZE) {
+    image = image.scaled(THUMBNAIL_SIZE, THUMBNAIL_SIZE, Qt::KeepAspectRatio,
+                         Qt::SmoothTransformation);
+  }
+
+  if (!entry.originalSize.isValid()) {
+    entry.originalSize = image.size();
+  }
+
+  entry.image = image;
+  return entry;
+}
+
+QString ThumbnailCache::diskCachePath(const QString &imagePath) const {
+  // Thumbnail name is the MD5 of the canonical file URI
+  QByteArray uri =
+      QUrl::fromLocalFile(QFileInfo(imagePath).absoluteFilePath()).toEncoded();
+  QByteArray hash =
+      QCryptographicHash::hash(uri, QCryptographicHash::Md5).toHex();
+  return m_diskCacheDir + "/" + QString::fromLatin1(hash) + ".png";
+}
+
+ThumbnailCache::Entry ThumbnailCache::loadFromDisk(const QString &imagePath) {
+  Entry entry;
+
+  QString thumbnailPath = diskCachePath(imagePath);
+  if (!QFile::exists(thumbnailPath)) {
+    return entry;
+  }
+
+  QFileInfo fileInfo(imagePath);
+  QImageReader reader(thumbnailPath, "png");
+
+  // A thumbnail is only valid while the source keeps its mtime (and size)
+  QString mtime = reader.text("Thumb::MTime");
+  if (mtime.isEmpty() ||
+      mtime.toLongLong() != fileInfo.lastModified().toSecsSinceEpoch()) {
+    return entry;
+  }
+  QString size = reader.text("Thumb::Size");
+  if (!size.isEmpty() && size.toLongLong() != fileInfo.size()) {
+    return entry;
+  }
+
+  QSize originalSize(reader.text("Thumb::Image::Width").toInt(),
+                     reader.text("Thumb::Image::Height").toInt());
+
+  QImage image = reader.read();
+  if (image.isNull()) {
+    return entry;
+  }
+
+  // Thumbnails written by other applications may lack the optional keys
+  QImageReader sourceReader(imagePath);
+  entry.format = sourceReader.format();
+  entry.originalSize =
+      originalSize.isValid() ? originalSize : sourceReader.size();
+  entry.image = image;
+  return entry;
+}
+
+void ThumbnailCache::saveToDisk(const QString &imagePath, const Entry &entry) {
+  // Never thumbnail the thumbnail cache itself
+  QFileInfo fileInfo(imagePath);
+  if (fileInfo.absoluteFilePath().startsWith(m_diskCacheDir)) {
+    return;
+  }
+
+  // Only images larger than the thumbnail are worth caching
+  if (entry.originalSize.width() <= THUMBNAIL_SIZE &&
+      entry.originalSize.height() <= THUMBNAIL_SIZE) {
+    return;
+  }
+
+  if (!QDir().mkpath(m_diskCacheDir)) {
+    return;
+  }
+  QFile::setPermissions(m_diskCacheDir, QFileDevice::ReadOwner |
+                                            QFileDevice::WriteOwner |
+                                            QFileDevice::ExeOwner);
+
+  QImage image = entry.image;
+  image.setText("Thumb::URI", QString::fromLatin1(QUrl::fromLocalFile(
+                                  fileInfo.absoluteFilePath())
+                                                      .toEncoded()));
+  image.setText("Thumb::MTime",
+                QString::number(fileInfo.lastModified().toSecsSinceEpoch()));
+  image.setText("Thumb::Size", QString::number(fileInfo.size()));
+  image.setText("Thumb::Image::Width",
+                QString::number(entry.originalSize.width()));
+  image.setText("Thumb::Image::Height",
+                QString::number(entry.originalSize.height()));
+  image.setText("Software", QStringLiteral("PixelBatch"));
+
+  // Write to a temporary file and rename, as required by the spec
+  QSaveFile file(diskCachePath(imagePath));
+  if (!file.open(QIODevice::WriteOnly)) {
+    return;
+  }
+  if (!image.save(&file, "png") || !file.commit()) {
+    qDebug() << "Unable to write thumbnail for" << imagePath;
+    return;
+  }
+  QFile::setPermissions(file.fileName(),
+                        QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+}
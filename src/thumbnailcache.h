@@ -0,0 +1,77 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+// Two level cache for image previews.
+//
+// Entries are keyed by path + modification time + file size, so an image that
+// changes on disk is decoded again. The first level is a bounded in-memory LRU,
+// the second (optional) level is the shared freedesktop.org thumbnail cache
+// (~/.cache/thumbnails/large), which means thumbnails written by file managers
+// are reused and ours are reused by them.
+//
+// All lookups are thread safe, thumbnails are decoded on the caller's thread
+// (preview loader or prefetch pool) and never on the GUI thread.
+class ThumbnailCache : public QObject {
+  Q_OBJECT
+
+public:
+  // freedesktop.org "large" thumbnail size
+  static const int THUMBNAIL_SIZE = 256;
+
+  struct Entry {
+    QImage image;
+    QSize originalSize;
+    QByteArray format;
+
+    bool isValid() const { return !image.isNull(); }
+  };
+
+  static ThumbnailCache &instance();
+
+  // Memory cache only, cheap enough for the GUI thread
+  Entry cachedThumbnail(const QString &imagePath);
+
+  // Memory cache, then disk cache, then decode (and store in both)
+  Entry thumbnail(const QString &imagePath, QString *errorString = nullptr);
+
+  // Decode thumbnails for these images in the background. Pending prefetches
+  // from a previous call are dropped.
+  void prefetch(const QStringList &imagePaths);
+
+  void setDiskCacheEnabled(bool enabled);
+  bool isDiskCacheEnabled() const;
+
+private:
+  ThumbnailCache(QObject *parent = nullptr);
+  ~ThumbnailCache();
+  ThumbnailCache(const ThumbnailCache &) = delete;
+  ThumbnailCache &operator=(const ThumbnailCache &) = delete;
+
+  QString cacheKey(const QString &imagePath) const;
+  void insertIntoMemory(const QString &key, const Entry &entry);
+
+  Entry loadFromDisk(const QString &imagePath);
+  void saveToDisk(const QString &imagePath, const Entry &entry);
+  QString diskCachePath(const QString &imagePath) const;
+
+  Entry decode(const QString &imagePath, QString *errorString);
+
+  QMutex m_mutex;
+  QCache<QString, Entry> m_memoryCache; // cost in KB
+  QAtomicInt m_diskCacheEnabled;
+  QString m_diskCacheDir;
+  QThreadPool m_prefetchPool;
+};
+
+#endif // THUMBNAILCACHE_H
@@ -0,0 +1,331 @@
+#include "tiledimageview.h"
+#include "differenceheatmap.h"
+
+#include <QMetaObject>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QRunnable>
+
+namespace {
+
+// Upper bound of rendered tiles kept per view (in KB)
+const int TILE_CACHE_LIMIT_KB = 96 * 1024;
+
+QImage renderRegion(const QSharedPointer<ImagePyramid> &image,
+                    const QRectF &sourceRect, const QSize &tileSize) {
+  return image->needsRegionDecode(sourceRect, tileSize)
+             ? image->renderFromFile(sourceRect, tileSize)
+             : image->render(sourceRect, tileSize);
+}
+
+// Renders one tile off the GUI thread (region decodes, difference heatmaps)
+class TileRenderJob : public QRunnable {
+public:
+  TileRenderJob(TiledImageView *view,
+                std::shared_ptr<QAtomicInteger<quint64>> generation,
+                quint64 requestGeneration, const QString &key,
+                const QRect &updateRect, std::function<QImage()> render,
+                std::function<void(const QString &, const QImage &,
+                                   const QRect &)>
+                    deliver)
+      : m_view(view), m_generation(generation),
+        m_requestGeneration(requestGeneration), m_key(key),
+        m_updateRect(updateRect), m_render(render), m_deliver(deliver) {}
+
+  void run() override {
+    // Zoom changed while we were waiting in the queue
+    if (m_generation->loadAcquire() != m_requestGeneration) {
+      return;
+    }
+
+    QImage tile = m_render();
+    if (tile.isNull() || m_generation->loadAcquire() != m_requestGeneration) {
+      return;
+    }
+
+    auto deliver = m_deliver;
+    QString key = m_key;
+    QRect updateRect = m_updateRect;
+    QMetaObject::invokeMethod(
+        m_view,
+        [deliver, key, tile, updateRect]() { deliver(key, tile, updateRect); },
+        Qt::QueuedConnection);
+  }
+
+private:
+  TiledImageView *m_view;
+  std::shared_ptr<QAtomicInteger<quint64>> m_generation;
+  quint64 m_requestGeneration;
+  QString m_key;
+  QRect m_updateRect;
+  std::function<QImage()> m_render;
+  std::function<void(const QString &, const QImage &, const QRect &)>
+      m_deliver;
+};
+
+int pixmapCostKb(const QPixmap &pixmap) {
+  return qMax(1, pixmap.width() * pixmap.height() * 4 / 1024);
+}
+
+} // namespace
+
+TiledImageView::TiledImageView(QWidget *parent)
+    : DraggableLabel(parent), m_zoomFactor(1.0), m_splitPercent(-1),
+      m_renderMode(ImageMode), m_amplification(1.0), m_threshold(0),
+      m_tileCache(TILE_CACHE_LIMIT_KB),
+      m_generation(std::make_shared<QAtomicInteger<quint64>>(0)) {
+  // Region decodes and heatmaps are heavy, keep them from starving the
+  // optimizers
+  m_threadPool.setMaxThreadCount(2);
+}
+
+TiledImageView::~TiledImageView() {
+  m_threadPool.clear();
+  m_generation->fetchAndAddOrdered(1);
+  // Jobs hold a raw pointer to us, make sure none outlives the view
+  m_threadPool.waitForDone();
+}
+
+void TiledImageView::setImages(QSharedPointer<ImagePyramid> primary,
+                               QSharedPointer<ImagePyramid> secondary) {
+  m_images[0] = primary;
+  m_images[1] = secondary;
+  resetTiles();
+  setMinimumSize(scaledImageSize());
+  updateGeometry();
+  update();
+}
+
+void TiledImageView::setZoomFactor(double zoomFactor) {
+  if (qFuzzyCompare(zoomFactor, m_zoomFactor)) {
+    return;
+  }
+  m_zoomFactor = zoomFactor;
+  resetTiles();
+  setMinimumSize(scaledImageSize());
+  updateGeometry();
+  update();
+}
+
+double TiledImageView::zoomFactor() const { return m_zoomFactor; }
+
+void TiledImageView::setSplitPosition(int percent) {
+  if (percent == m_splitPercent) {
+    return;
+  }
+  m_splitPercent = percent;
+  // Tiles stay valid, only the clipping changes
+  update();
+}
+
+void TiledImageView::setRenderMode(RenderMode mode) {
+  if (mode == m_renderMode) {
+    return;
+  }
+  m_renderMode = mode;
+  resetTiles();
+  update();
+}
+
+TiledImageView::RenderMode TiledImageView::renderMode() const {
+  return m_renderMode;
+}
+
+void TiledImageView::setDifferenceParameters(double amplification,
+                                             int threshold) {
+  if (qFuzzyCompare(amplification, m_amplification) &&
+      threshold == m_threshold) {
+    return;
+  }
+  m_amplification = amplification;
+  m_threshold = threshold;
+  if (m_renderMode == DifferenceMode) {
+    resetTiles();
+    update();
+  }
+}
+
+QSize TiledImageView::scaledImageSize() const {
+  if (!m_images[0] || m_images[0]->isNull()) {
+    return QSize(0, 0);
+  }
+  QSize size = m_images[0]->size();
+  return QSize(qMax(1, qRound(size.width() * m_zoomFactor)),
+               qMax(1, qRound(size.height() * m_zoomFactor)));
+}
+
+QSize TiledImageView::sizeHint() const { return scaledImageSize(); }
+
+void TiledImageView::resetTiles() {
+  m_threadPool.clear();
+  m_generation->fetchAndAddOrdered(1);
+  m_tileCache.clear();
+  m_pendingTiles.clear();
+}
+
+QPoint TiledImageView::imageOrigin() const {
+  // Center the image when it is smaller than the viewport
+  QSize imageSize = scaledImageSize();
+  return QPoint(qMax(0, (width() - imageSize.width()) / 2),
+                qMax(0, (height() - imageSize.height()) / 2));
+}
+
+QRect TiledImageView::tileRect(int column, int row) const {
+  return QRect(column * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE) &
+         QRect(QPoint(0, 0), scaledImageSize());
+}
+
+QRectF TiledImageView::sourceRect(int imageIndex,
+                                  const QRect &displayRect) const {
+  // The second image is stretched over the first one, as the optimizers keep
+  // the dimensions this normally is 1:1
+  QSize primarySize = m_images[0]->size();
+  QSize imageSize = m_images[imageIndex]->size();
+  double scaleX =
+      double(imageSize.width()) / primarySize.width() / m_zoomFactor;
+  double scaleY =
+      double(imageSize.height()) / primarySize.height() / m_zoomFactor;
+  return QRectF(displayRect.x() * scaleX, displayRect.y() * scaleY,
+                displayRect.width() * scaleX, displayRect.height() * scaleY);
+}
+
+QPixmap TiledImageView::tile(int imageIndex, int column, int row) {
+  QString key = QString("%1:%2:%3").arg(imageIndex).arg(column).arg(row);
+  if (QPixmap *cached = m_tileCache.object(key)) {
+    return *cached;
+  }
+
+  QSharedPointer<ImagePyramid> image = m_images[imageIndex];
+  QRect displayRect = tileRect(column, row);
+  QRectF source = sourceRect(imageIndex, displayRect);
+
+  // Rendering from memory is cheap, use it right away and as placeholder
+  QPixmap pixmap =
+      QPixmap::fromImage(image->render(source, displayRect.size()));
+  m_tileCache.insert(key, new QPixmap(pixmap), pixmapCostKb(pixmap));
+
+  if (image->needsRegionDecode(source, displayRect.size())) {
+    QSize tileSize = displayRect.size();
+    requestTile(key, column, row, [image, source, tileSize]() {
+      return image->renderFromFile(source, tileSize);
+    });
+  }
+  return pixmap;
+}
+
+QPixmap TiledImageView::differenceTile(int column, int row) {
+  QString key = QString("d:%1:%2").arg(column).arg(row);
+  if (QPixmap *cached = m_tileCache.object(key)) {
+    return *cached;
+  }
+
+  QRect displayRect = tileRect(column, row);
+  QSharedPointer<ImagePyramid> original = m_images[0];
+  QSharedPointer<ImagePyramid> optimized = m_images[1];
+  QRectF originalSource = sourceRect(0, displayRect);
+  QRectF optimizedSource = sourceRect(1, displayRect);
+  QSize tileSize = displayRect.size();
+  double amplification = m_amplification;
+  int threshold = m_threshold;
+
+  requestTile(key, column, row, [=]() {
+    return DifferenceHeatmap::render(
+        renderRegion(original, originalSource, tileSize),
+        renderRegion(optimized, optimizedSource, tileSize), amplification,
+        threshold);
+  });
+
+  // Placeholder until the heatmap of the tile arrives
+  QPixmap placeholder(tileSize);
+  placeholder.fill(Qt::black);
+  return placeholder;
+}
+
+void TiledImageView::requestTile(const QString &key, int column, int row,
+                                 std::function<QImage()> render) {
+  if (m_pendingTiles.contains(key)) {
+    return;
+  }
+  m_pendingTiles.insert(key);
+
+  QRect updateRect = tileRect(column, row);
+  quint64 generation = m_generation->loadAcquire();
+  auto deliver = [this, generation](const QString &key, const QImage &image,
+                                    const QRect &updateRect) {
+    // Tiles were reset (zoom or images changed) in the meantime
+    if (m_generation->loadAcquire() != generation ||
+        !m_pendingTiles.remove(key)) {
+      return;
+    }
+    QPixmap pixmap = QPixmap::fromImage(image);
+    m_tileCache.insert(key, new QPixmap(pixmap), pixmapCostKb(pixmap));
+    update(updateRect.translated(imageOrigin()));
+  };
+
+  m_threadPool.start(new TileRenderJob(this, m_generation, generation, key,
+                                       updateRect, render, deliver));
+}
+
+void TiledImageView::paintEvent(QPaintEvent *event) {
+  if (!m_images[0] || m_images[0]->isNull()) {
+    DraggableLabel::paintEvent(event);
+    return;
+  }
+
+  QPainter painter(this);
+  QPoint origin = imageOrigin();
+  QSize imageSize = scaledImageSize();
+
+  // Exposed area in image display coordinates
+  QRect exposed =
+      event->rect().translated(-origin) & QRect(QPoint(0, 0), imageSize);
+  if (exposed.isEmpty()) {
+    return;
+  }
+
+  bool hasSecondImage = m_images[1] && !m_images[1]->isNull();
+  bool difference = m_renderMode == DifferenceMode && hasSecondImage;
+  bool split = !difference && m_splitPercent >= 0 && hasSecondImage;
+  int splitX = split ? imageSize.width() * m_splitPercent / 100
+                     : imageSize.width();
+
+  int firstColumn = exposed.left() / TILE_SIZE;
+  int lastColumn = exposed.right() / TILE_SIZE;
+  int firstRow = exposed.top() / TILE_SIZE;
+  int lastRow = exposed.bottom() / TILE_SIZE;
+
+  for (int row = firstRow; row <= lastRow; ++row) {
+    for (int column = firstColumn; column <= lastColumn; ++column) {
+      QRect rect = tileRect(column, row);
+
+      if (difference) {
+        painter.drawPixmap(rect.translated(origin), differenceTile(column, row),
+                           QRect(QPoint(0, 0), rect.size()));
+        continue;
+      }
+
+      // Left of the split: first image
+      QRect left = rect & QRect(0, 0, splitX, imageSize.height());
+      if (!left.isEmpty()) {
+        painter.drawPixmap(left.translated(origin), tile(0, column, row),
+                           left.translated(-rect.topLeft()));
+      }
+
+      // Right of the split: second image
+      if (split) {
+        QRect right = rect & QRect(splitX, 0, imageSize.width() - splitX,
+                                   imageSize.height());
+        if (!right.isEmpty()) {
+          painter.drawPixmap(right.translated(origin), tile(1, column, row),
+                             right.translated(-rect.topLeft()));
+        }
+      }
+    }
+  }
+
+  if (split) {
+    painter.setPen(QPen(Qt::yellow, 3));
+    painter.drawLine(origin.x() + splitX, origin.y(), origin.x() + splitX,
+                     origin.y() + imageSize.height());
+  }
+}
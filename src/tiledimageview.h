@@ -0,0 +1,86 @@
+#ifndef TILEDIMAGEVIEW_H
+#define TILEDIMAGEVIEW_H
+
+#include "draggablelabel.h"
+#include "imagepyramid.h"
+
+#include <QAtomicInteger>
+#include <QCache>
+#include <QPixmap>
+#include <QSet>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include <functional>
+#include <memory>
+
+// Image view that renders only the tiles intersecting the exposed area.
+//
+// Tiles are rendered from an ImagePyramid at the current zoom and kept in a
+// bounded LRU cache, so panning over a large image never rescales the whole
+// image. Tiles that need detail beyond the in-memory base level are decoded
+// from the file on a thread pool, showing the base level until they arrive.
+//
+// With a second image and a split position set, the view draws the first image
+// left of the split and the second one right of it (slider comparison). In
+// difference mode it shows an error heatmap of the second image against the
+// first one instead, rendered per tile in the background.
+class TiledImageView : public DraggableLabel {
+  Q_OBJECT
+
+public:
+  static const int TILE_SIZE = 256;
+
+  enum RenderMode { ImageMode, DifferenceMode };
+
+  explicit TiledImageView(QWidget *parent = nullptr);
+  ~TiledImageView();
+
+  void setImages(QSharedPointer<ImagePyramid> primary,
+                 QSharedPointer<ImagePyramid> secondary = {});
+
+  void setZoomFactor(double zoomFactor);
+  double zoomFactor() const;
+
+  // Split position in percent of the image width, -1 disables the split
+  void setSplitPosition(int percent);
+
+  void setRenderMode(RenderMode mode);
+  RenderMode renderMode() const;
+
+  // Heatmap parameters, see DifferenceHeatmap
+  void setDifferenceParameters(double amplification, int threshold);
+
+  // Size of the image at the current zoom
+  QSize scaledImageSize() const;
+
+  QSize sizeHint() const override;
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+
+private:
+  QPixmap tile(int imageIndex, int column, int row);
+  QPixmap differenceTile(int column, int row);
+  void requestTile(const QString &key, int column, int row,
+                   std::function<QImage()> render);
+  QRect tileRect(int column, int row) const;
+  QRectF sourceRect(int imageIndex, const QRect &displayRect) const;
+  QPoint imageOrigin() const;
+  void resetTiles();
+
+  QSharedPointer<ImagePyramid> m_images[2];
+  double m_zoomFactor;
+  int m_splitPercent;
+  RenderMode m_renderMode;
+  double m_amplification;
+  int m_threshold;
+
+  QCache<QString, QPixmap> m_tileCache; // cost in KB
+  QSet<QString> m_pendingTiles;
+
+  QThreadPool m_threadPool;
+  std::shared_ptr<QAtomicInteger<quint64>> m_generation;
+};
+
+#endif // TILEDIMAGEVIEW_H
@@ -0,0 +1,144 @@
+#include "watchfoldersdialog.h"
+
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+namespace {
+
+enum Column { FolderColumn, SubfoldersColumn, OutputDirColumn, PrefixColumn };
+
+} // namespace
+
+WatchFoldersDialog::WatchFoldersDialog(
+    const QList<FolderWatcher::Folder> &folders, bool watchEnabled,
+    QWidget *parent)
+    : QDialog(parent), m_table(new QTableWidget(this)),
+      m_enabledCheckBox(new QCheckBox(this)) {
+
+  setWindowTitle(tr("Watch Folders"));
+  resize(760, 360);
+
+  QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+  QLabel *infoLabel = new QLabel(
+      tr("Images written to these folders are optimized as soon as they are "
+         "complete. Leave the output folder or prefix empty to use the "
+         "preferences."));
+  infoLabel->setWordWrap(true);
+  mainLayout->addWidget(infoLabel);
+
+  m_table->setColumnCount(4);
+  m_table->setHorizontalHeaderLabels({tr("Folder"), tr("Subfolders"),
+                                      tr("Output Folder"), tr("Prefix")});
+  m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+  m_table->setSelectionMode(QAbstractItemView::SingleSelection);
+  m_table->horizontalHeader()->setSectionResizeMode(FolderColumn,
+                                                    QHeaderView::Stretch);
+  m_table->horizontalHeader()->setSectionResizeMode(
+      SubfoldersColumn, QHeaderView::ResizeToContents);
+  m_table->horizontalHeader()->setSectionResizeMode(OutputDirColumn,
+                                                    QHeaderView::Stretch);
+  m_table->verticalHeader()->setVisible(false);
+  mainLayout->addWidget(m_table, 1);
+
+  QHBoxLayout *buttonsLayout = new QHBoxLayout();
+  QPushButton *addButton = new QPushButton(
+      QIcon(":/resources/icons/folder-add-line.png"), tr("Add Folder..."));
+  connect(addButton, &QPushButton::clicked, this,
+          &WatchFoldersDialog::addFolder);
+  buttonsLayout->addWidget(addButton);
+
+  QPushButton *removeButton = new QPushButton(tr("Remove"));
+  connect(removeButton, &QPushButton::clicked, this,
+          &WatchFoldersDialog::removeSelectedFolder);
+  buttonsLayout->addWidget(removeButton);
+  buttonsLayout->addStretch();
+  mainLayout->addLayout(buttonsLayout);
+
+  m_enabledCheckBox->setText(tr("Watch these folders for new images"));
+  m_enabledCheckBox->setChecked(watchEnabled);
+  mainLayout->addWidget(m_enabledCheckBox);
+
+  QDialogButtonBox *buttonBox =
+      new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+  connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+  connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+  mainLayout->addWidget(buttonBox);
+
+  for (const FolderWatcher::Folder &folder : folders) {
+    appendFolder(folder);
+  }
+}
+
+void WatchFoldersDialog::appendFolder(const FolderWatcher::Folder &folder) {
+  int row = m_table->rowCount();
+  m_table->insertRow(row);
+
+  QTableWidgetItem *folderItem = new QTableWidgetItem(folder.path);
+  folderItem->setFlags(folderItem->flags() & ~Qt::ItemIsEditable);
+  folderItem->setToolTip(folder.path);
+  // Not editable here, carried over as is
+  folderItem->setData(Qt::UserRole, folder.optimizerSettings);
+  m_table->setItem(row, FolderColumn, folderItem);
+
+  QTableWidgetItem *subfoldersItem = new QTableWidgetItem();
+  subfoldersItem->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsEnabled |
+                           Qt::ItemIsSelectable);
+  subfoldersItem->setCheckState(folder.recursive ? Qt::Checked
+                                                 : Qt::Unchecked);
+  m_table->setItem(row, SubfoldersColumn, subfoldersItem);
+
+  m_table->setItem(row, OutputDirColumn,
+                   new QTableWidgetItem(folder.outputDir));
+  m_table->setItem(row, PrefixColumn,
+                   new QTableWidgetItem(folder.outputPrefix));
+}
+
+void WatchFoldersDialog::addFolder() {
+  QString dir = QFileDialog::getExistingDirectory(this, tr("Watch Folder"),
+                                                  QDir::homePath());
+  if (dir.isEmpty()) {
+    return;
+  }
+
+  FolderWatcher::Folder folder;
+  folder.path = dir;
+  appendFolder(folder);
+}
+
+void WatchFoldersDialog::removeSelectedFolder() {
+  int row = m_table->currentRow();
+  if (row >= 0) {
+    m_table->removeRow(row);
+  }
+}
+
+QList<FolderWatcher::Folder> WatchFoldersDialog::folders() const {
+  QList<FolderWatcher::Folder> folders;
+  for (int row = 0; row < m_table->rowCount(); ++row) {
+    FolderWatcher::Folder folder;
+    folder.path = m_table->item(row, FolderColumn)->text();
+    folder.optimizerSettings =
+        m_table->item(row, FolderColumn)->data(Qt::UserRole).toMap();
+    folder.recursive =
+        m_table->item(row, SubfoldersColumn)->checkState() == Qt::Checked;
+    folder.outputDir = m_table->item(row, OutputDirColumn)->text().trimmed();
+    if (!folder.outputDir.isEmpty() &&
+        !folder.outputDir.endsWith(QDir::separator())) {
+      folder.outputDir += QDir::separator();
+    }
+    folder.outputPrefix = m_table->item(row, PrefixColumn)->text().trimmed();
+    folders.append(folder);
+  }
+  return folders;
+}
+
+bool WatchFoldersDialog::isWatchEnabled() const {
+  return m_enabledCheckBox->isChecked();
+}
@@ -0,0 +1,32 @@
+#ifndef WATCHFOLDERSDIALOG_H
+#define WATCHFOLDERSDIALOG_H
+
+#include "folderwatcher.h"
+
+#include <QCheckBox>
+#include <QDialog>
+#include <QTableWidget>
+
+// Edits the watched folders and their output settings
+class WatchFoldersDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  explicit WatchFoldersDialog(const QList<FolderWatcher::Folder> &folders,
+                              bool watchEnabled, QWidget *parent = nullptr);
+
+  QList<FolderWatcher::Folder> folders() const;
+  bool isWatchEnabled() const;
+
+private slots:
+  void addFolder();
+  void removeSelectedFolder();
+
+private:
+  void appendFolder(const FolderWatcher::Folder &folder);
+
+  QTableWidget *m_table;
+  QCheckBox *m_enabledCheckBox;
+};
+
+#endif // WATCHFOLDERSDIALOG_H
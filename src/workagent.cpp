@@ -0,0 +1,270 @@
+#include "workagent.h"
+
+#include <worker/imageworkerfactory.h>
+#include <worker/qualitysearchworker.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocalSocket>
+#include <QSysInfo>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+
+#include <cmath>
+
+WorkAgent::WorkAgent(const QString &address, int slots, bool sharedPaths,
+                     QObject *parent)
+    : QObject(parent), m_port(0), m_slots(qMax(1, slots)),
+      m_sharedPaths(sharedPaths), m_socket(nullptr) {
+  WorkProtocol::parseAddress(address, &m_host, &m_port, &m_socketPath);
+
+  m_reconnectTimer.setSingleShot(true);
+  m_reconnectTimer.setInterval(RECONNECT_INTERVAL_MS);
+  connect(&m_reconnectTimer, &QTimer::timeout, this,
+          &WorkAgent::connectToCoordinator);
+}
+
+WorkAgent::~WorkAgent() { abortJobs(); }
+
+bool WorkAgent::start(QString *errorString) {
+  if (m_socketPath.isEmpty() && m_host.isEmpty()) {
+    if (errorString) {
+      *errorString = tr("Invalid coordinator address");
+    }
+    return false;
+  }
+
+  if (!m_socketPath.isEmpty()) {
+    QLocalSocket *socket = new QLocalSocket(this);
+    connect(socket, &QLocalSocket::connected, this, &WorkAgent::onConnected);
+    connect(socket, &QLocalSocket::disconnected, this,
+            &WorkAgent::onConnectionLost);
+    connect(socket, &QLocalSocket::errorOccurred, this,
+            &WorkAgent::onConnectionLost);
+    m_socket = socket;
+  } else {
+    QTcpSocket *socket = new QTcpSocket(this);
+    connect(socket, &QTcpSocket::connected, this, &WorkAgent::onConnected);
+    connect(socket, &QTcpSocket::disconnected, this,
+            &WorkAgent::onConnectionLost);
+    connect(socket, &QTcpSocket::errorOccurred, this,
+            &WorkAgent::onConnectionLost);
+    m_socket = socket;
+  }
+  connect(m_socket, &QIODevice::readyRead, this, &WorkAgent::readMessages);
+
+  connectToCoordinator();
+  return true;
+}
+
+void WorkAgent::connectToCoordinator() {
+  m_reader = WorkProtocol::FrameReader();
+  m_authenticated = false;
+  if (QLocalSocket *local = qobject_cast<QLocalSocket *>(m_socket)) {
+    local->abort();
+    local->connectToServer(m_socketPath);
+  } else if (QTcpSocket *tcp = qobject_cast<QTcpSocket *>(m_socket)) {
+    tcp->abort();
+    tcp->connectToHost(m_host, m_port);
+  }
+}
+
+void WorkAgent::onConnected() {
+  if (QTcpSocket *tcp = qobject_cast<QTcpSocket *>(m_socket)) {
+    tcp->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+  }
+  // The hello answers the challenge of the coordinator
+}
+
+void WorkAgent::sendHello(const WorkProtocol::Message &challenge) {
+  m_nonce = WorkProtocol::newNonce();
+
+  QJsonObject hello;
+  hello["type"] = "hello";
+  hello["version"] = WorkProtocol::VERSION;
+  hello["slots"] = m_slots;
+  hello["host"] = QSysInfo::machineHostName();
+  hello["sharedPaths"] = m_sharedPaths;
+  hello["auth"] = WorkProtocol::authCode(
+      "agent", challenge.header.value("nonce").toString());
+  hello["nonce"] = m_nonce;
+  m_socket->write(WorkProtocol::encode(hello));
+}
+
+void WorkAgent::onConnectionLost() {
+  // Both disconnected and errorOccurred end up here
+  if (m_reconnectTimer.isActive()) {
+    return;
+  }
+  if (!m_jobs.isEmpty()) {
+    qWarning() << "Coordinator lost, dropping" << m_jobs.count() << "tasks";
+    abortJobs();
+  }
+  m_reconnectTimer.start();
+}
+
+void WorkAgent::readMessages() {
+  m_reader.read(m_socket);
+
+  WorkProtocol::Message message;
+  QString errorString;
+  while (m_reader.takeMessage(&message, &errorString)) {
+    if (message.type() == "challenge" && !m_authenticated) {
+      sendHello(message);
+    } else if (message.type() == "welcome" && !m_authenticated) {
+      // Only the holder of the secret may hand us work
+      if (!WorkProtocol::verifyAuthCode(
+              "coordinator", m_nonce,
+              message.header.value("auth").toString())) {
+        errorString = tr("The coordinator does not know the secret");
+        break;
+      }
+      m_authenticated = true;
+      m_reader.setPayloadAllowed(true);
+      qDebug() << "Connected to coordinator, offering" << m_slots << "slots";
+    } else if (!m_authenticated) {
+      errorString = tr("%1 before welcome").arg(message.type());
+      break;
+    } else if (message.type() == "task") {
+      runTask(message);
+    } else if (message.type() == "cancel") {
+      quint64 id = message.header.value("id").toVariant().toULongLong();
+      if (m_jobs.contains(id)) {
+        // Takes the task and work directory with it, see runTask
+        delete m_jobs.take(id).worker;
+      }
+    }
+  }
+
+  if (!errorString.isEmpty()) {
+    qWarning() << "Protocol error:" << errorString;
+    onConnectionLost();
+  }
+}
+
+void WorkAgent::runTask(const WorkProtocol::Message &message) {
+  quint64 id = message.header.value("id").toVariant().toULongLong();
+  QString fileName = QFileInfo(message.header.value("fileName").toString())
+                         .fileName();
+  double targetSsim = message.header.value("targetSsim").toDouble();
+
+  QTemporaryDir *workDir = nullptr;
+  ImageTask *task = nullptr;
+  if (message.header.contains("imagePath")) {
+    task = new ImageTask(message.header.value("imagePath").toString(),
+                         message.header.value("outputPath").toString());
+    QDir().mkpath(QFileInfo(task->optimizedPath()).absolutePath());
+  } else {
+    // Source and output keep the original file name, the tools care
+    workDir = new QTemporaryDir();
+    QDir(workDir->path()).mkdir("source");
+    task = new ImageTask(workDir->path() + "/source/" + fileName,
+                         workDir->path() + "/" + fileName);
+    QFile source(task->imagePath());
+    if (!workDir->isValid() || !source.open(QIODevice::WriteOnly) ||
+        source.write(message.payload) != message.payload.size()) {
+      sendResult(id, false, tr("Unable to store %1 on the agent: %2")
+                                .arg(fileName, source.errorString()));
+      delete task;
+      delete workDir;
+      return;
+    }
+  }
+
+  // The coordinator's settings only, with the optimizer it picked
+  SettingsSnapshot::Ptr snapshot = SettingsSnapshot::fromTransferMap(
+      message.header.value("settings").toObject().toVariantMap());
+  ImageType imageType = ImageWorkerFactory::instance().getImageType(task);
+  ImageOptimizer optimizer = snapshot->optimizer(imageType);
+  ImageWorker *worker = nullptr;
+  try {
+    worker = targetSsim > 0.0 && !optimizer.convertsFormat() &&
+                     !optimizer.stripsMetadataOnly() &&
+                     QualitySearchWorker::canSearch(imageType)
+                 ? new QualitySearchWorker(targetSsim)
+                 : ImageWorkerFactory::instance().getWorker(optimizer);
+  } catch (const std::exception &e) {
+    sendResult(id, false, e.what());
+    delete task;
+    delete workDir;
+    return;
+  }
+  worker->setSnapshot(snapshot);
+
+  // Workers still touch the task after their signals, release it with them
+  connect(worker, &QObject::destroyed, [task, workDir]() {
+    delete task;
+    delete workDir;
+  });
+  connect(worker, &ImageWorker::optimizationFinished, this,
+          [this, id](ImageTask *, bool success) {
+            finishJob(id, success, QString());
+          });
+  connect(worker, &ImageWorker::optimizationError, this,
+          [this, id](ImageTask *, const QString &errorString) {
+            finishJob(id, false, errorString);
+          });
+
+  m_jobs.insert(id, Job{worker, task, workDir});
+  qDebug() << "Optimizing" << fileName << "for the coordinator";
+  worker->optimize(task);
+}
+
+void WorkAgent::finishJob(quint64 id, bool success,
+                          const QString &errorString) {
+  if (!m_jobs.contains(id)) {
+    return;
+  }
+  Job job = m_jobs.take(id);
+  job.worker->deleteLater();
+
+  QByteArray output;
+  QString error = errorString;
+  if (success && job.workDir) {
+    QFile file(job.task->optimizedPath());
+    if (file.size() > WorkProtocol::MAX_PAYLOAD_SIZE) {
+      success = false;
+      error = tr("The output is too big to send back");
+    } else if (file.open(QIODevice::ReadOnly)) {
+      output = file.readAll();
+    } else {
+      success = false;
+      error = tr("Unable to read the output: %1").arg(file.errorString());
+    }
+  }
+  sendResult(id, success, error, job.task, output);
+}
+
+void WorkAgent::sendResult(quint64 id, bool success,
+                           const QString &errorString, const ImageTask *task,
+                           const QByteArray &output) {
+  QJsonObject header;
+  header["type"] = "result";
+  header["id"] = double(id);
+  header["ok"] = success;
+  if (!success) {
+    header["error"] = errorString.isEmpty() ? tr("Optimization failed")
+                                            : errorString;
+  }
+  if (success && task && task->hasQualityMetrics) {
+    QJsonObject quality;
+    if (std::isfinite(task->psnr)) {
+      quality["psnr"] = task->psnr;
+    }
+    quality["ssim"] = task->ssim;
+    quality["msSsim"] = task->msSsim;
+    quality["searchedQuality"] = task->searchedQuality;
+    header["quality"] = quality;
+  }
+  m_socket->write(WorkProtocol::encode(header, output));
+}
+
+void WorkAgent::abortJobs() {
+  const QList<Job> jobs = m_jobs.values();
+  m_jobs.clear();
+  for (const Job &job : jobs) {
+    delete job.worker;
+  }
+}
@@ -0,0 +1,66 @@
+#ifndef WORKAGENT_H
+#define WORKAGENT_H
+
+#include "imagetask.h"
+#include "workprotocol.h"
+
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+class ImageWorker;
+class QIODevice;
+class QTemporaryDir;
+
+// Headless side of the work distribution (pixelbatch --agent <address>).
+//
+// Connects to a WorkCoordinator, both prove they share the secret, then runs
+// up to `slots` tasks at once with the regular workers and the settings sent
+// along, and reports the results.
+// Reconnects when the coordinator goes away, running tasks are dropped then.
+class WorkAgent : public QObject {
+  Q_OBJECT
+
+public:
+  static const int RECONNECT_INTERVAL_MS = 2000;
+
+  WorkAgent(const QString &address, int slots, bool sharedPaths,
+            QObject *parent = nullptr);
+  ~WorkAgent();
+
+  bool start(QString *errorString = nullptr);
+
+private:
+  struct Job {
+    ImageWorker *worker;
+    ImageTask *task;
+    QTemporaryDir *workDir; // null when the coordinator's paths are used
+  };
+
+  void connectToCoordinator();
+  void onConnected();
+  void sendHello(const WorkProtocol::Message &challenge);
+  void onConnectionLost();
+  void readMessages();
+  void runTask(const WorkProtocol::Message &message);
+  void finishJob(quint64 id, bool success, const QString &errorString);
+  void sendResult(quint64 id, bool success, const QString &errorString,
+                  const ImageTask *task = nullptr,
+                  const QByteArray &output = QByteArray());
+  void abortJobs();
+
+  QString m_host;
+  quint16 m_port;
+  QString m_socketPath;
+  int m_slots;
+  bool m_sharedPaths;
+
+  QIODevice *m_socket;
+  QTimer m_reconnectTimer;
+  WorkProtocol::FrameReader m_reader;
+  QString m_nonce; // of the hello
+  bool m_authenticated = false;
+  QHash<quint64, Job> m_jobs;
+};
+
+#endif // WORKAGENT_H
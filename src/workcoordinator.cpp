@@ -0,0 +1,365 @@
+#include "workcoordinator.h"
+
+#include <worker/remoteworker.h>
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <limits>
+
+WorkCoordinator::WorkCoordinator(QObject *parent)
+    : QObject(parent), m_tcpServer(nullptr), m_localServer(nullptr),
+      m_nextJobId(1) {}
+
+WorkCoordinator::~WorkCoordinator() {
+  for (Agent *agent : qAsConst(m_agents)) {
+    agent->socket->disconnect(this);
+    delete agent;
+  }
+  m_agents.clear();
+}
+
+bool WorkCoordinator::listen(const QString &address, QString *errorString) {
+  QString host;
+  quint16 port = 0;
+  QString socketPath;
+  if (!WorkProtocol::parseAddress(address, &host, &port, &socketPath)) {
+    if (errorString) {
+      *errorString = tr("Invalid address %1").arg(address);
+    }
+    return false;
+  }
+
+  if (!socketPath.isEmpty()) {
+    // Left behind by a coordinator that was killed
+    QLocalServer::removeServer(socketPath);
+    m_localServer = new QLocalServer(this);
+    if (!m_localServer->listen(socketPath)) {
+      if (errorString) {
+        *errorString = m_localServer->errorString();
+      }
+      return false;
+    }
+    connect(m_localServer, &QLocalServer::newConnection, this, [this]() {
+      while (m_localServer->hasPendingConnections()) {
+        addConnection(m_localServer->nextPendingConnection(), true);
+      }
+    });
+  } else {
+    m_tcpServer = new QTcpServer(this);
+    QHostAddress hostAddress = host == "*" ? QHostAddress(QHostAddress::Any)
+                                           : QHostAddress(host);
+    if (hostAddress.isNull() && host == "localhost") {
+      hostAddress = QHostAddress::LocalHost;
+    }
+    // Any peer could take slots, read sources and return arbitrary outputs
+    if (WorkProtocol::secret().isEmpty()) {
+      if (errorString) {
+        *errorString = tr("Set %1 to share the queue over TCP")
+                           .arg(WorkProtocol::SECRET_ENVIRONMENT_VARIABLE);
+      }
+      return false;
+    }
+    if (!m_tcpServer->listen(hostAddress, port)) {
+      if (errorString) {
+        *errorString = m_tcpServer->errorString();
+      }
+      return false;
+    }
+    connect(m_tcpServer, &QTcpServer::newConnection, this, [this]() {
+      while (m_tcpServer->hasPendingConnections()) {
+        addConnection(m_tcpServer->nextPendingConnection(), false);
+      }
+    });
+  }
+
+  qDebug() << "Coordinator listening on" << address;
+  return true;
+}
+
+bool WorkCoordinator::isListening() const {
+  return (m_tcpServer && m_tcpServer->isListening()) ||
+         (m_localServer && m_localServer->isListening());
+}
+
+int WorkCoordinator::totalSlots() const {
+  int slots = 0;
+  for (const Agent *agent : m_agents) {
+    slots += agent->slots;
+  }
+  return slots;
+}
+
+bool WorkCoordinator::hasFreeSlot() const {
+  int freeSlots = 0;
+  for (const Agent *agent : m_agents) {
+    freeSlots += qMax(0, agent->slots - agent->jobs.count());
+  }
+  return freeSlots > m_reservations.count();
+}
+
+void WorkCoordinator::reserveSlot(RemoteWorker *worker) {
+  m_reservations.insert(worker);
+}
+
+void WorkCoordinator::addConnection(QIODevice *socket, bool localSocket) {
+  Agent *agent = new Agent();
+  agent->socket = socket;
+  agent->localSocket = localSocket;
+  m_agents.append(agent);
+
+  connect(socket, &QIODevice::readyRead, this,
+          [this, agent]() { readMessages(agent); });
+  if (QTcpSocket *tcpSocket = qobject_cast<QTcpSocket *>(socket)) {
+    // Results are small frames, don't let Nagle hold them back
+    tcpSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(tcpSocket, &QTcpSocket::disconnected, this,
+            [this, agent]() { removeAgent(agent, tr("disconnected")); });
+  } else if (QLocalSocket *local = qobject_cast<QLocalSocket *>(socket)) {
+    connect(local, &QLocalSocket::disconnected, this,
+            [this, agent]() { removeAgent(agent, tr("disconnected")); });
+  }
+
+  agent->nonce = WorkProtocol::newNonce();
+  QJsonObject challenge;
+  challenge["type"] = "challenge";
+  challenge["nonce"] = agent->nonce;
+  socket->write(WorkProtocol::encode(challenge));
+
+  // Peers that never answer don't keep their connection
+  QTimer::singleShot(AUTHENTICATION_TIMEOUT_MS, this, [this, agent]() {
+    if (m_agents.contains(agent) && !agent->authenticated) {
+      removeAgent(agent, tr("no hello"));
+    }
+  });
+}
+
+void WorkCoordinator::readMessages(Agent *agent) {
+  agent->reader.read(agent->socket);
+
+  WorkProtocol::Message message;
+  QString errorString;
+  while (agent->reader.takeMessage(&message, &errorString)) {
+    if (message.type() == "hello" && !agent->authenticated) {
+      handleHello(agent, message);
+      if (!m_agents.contains(agent)) {
+        return;
+      }
+      agent->reader.setPayloadAllowed(true);
+    } else if (!agent->authenticated) {
+      removeAgent(agent, tr("%1 before hello").arg(message.type()));
+      return;
+    } else if (message.type() == "result") {
+      handleResult(agent, message);
+    }
+  }
+
+  if (!errorString.isEmpty()) {
+    removeAgent(agent, errorString);
+  }
+}
+
+void WorkCoordinator::handleHello(Agent *agent,
+                                  const WorkProtocol::Message &message) {
+  int version = message.header.value("version").toInt();
+  if (version != WorkProtocol::VERSION) {
+    removeAgent(agent,
+                tr("protocol version %1 is not supported").arg(version));
+    return;
+  }
+  if (!WorkProtocol::verifyAuthCode("agent", agent->nonce,
+                                    message.header.value("auth").toString())) {
+    removeAgent(agent, tr("wrong secret"));
+    return;
+  }
+  agent->authenticated = true;
+
+  // Lets the agent check us in turn
+  QJsonObject welcome;
+  welcome["type"] = "welcome";
+  welcome["auth"] = WorkProtocol::authCode(
+      "coordinator", message.header.value("nonce").toString());
+  agent->socket->write(WorkProtocol::encode(welcome));
+
+  agent->host = message.header.value("host").toString();
+  agent->slots = qMax(1, message.header.value("slots").toInt());
+  agent->sharedPaths = agent->localSocket ||
+                       message.header.value("sharedPaths").toBool() ||
+                       agent->host == QSysInfo::machineHostName();
+  qDebug() << "Agent" << agent->host << "joined with" << agent->slots
+           << "slots, shared paths:" << agent->sharedPaths;
+  emit agentsChanged(totalSlots());
+}
+
+bool WorkCoordinator::submit(RemoteWorker *worker, ImageTask *task,
+                             const QVariantMap &settings, double targetSsim) {
+  m_reservations.remove(worker);
+
+  // Least busy agent first
+  Agent *target = nullptr;
+  int mostFreeSlots = 0;
+  for (Agent *agent : qAsConst(m_agents)) {
+    int freeSlots = agent->slots - agent->jobs.count();
+    if (freeSlots > mostFreeSlots) {
+      target = agent;
+      mostFreeSlots = freeSlots;
+    }
+  }
+  if (!target) {
+    return false;
+  }
+  // Too big to send, the agent would drop the connection
+  if (!target->sharedPaths &&
+      QFileInfo(task->imagePath()).size() > WorkProtocol::MAX_PAYLOAD_SIZE) {
+    return false;
+  }
+
+  quint64 id = m_nextJobId++;
+  QJsonObject header;
+  header["type"] = "task";
+  header["id"] = double(id);
+  header["fileName"] = QFileInfo(task->imagePath()).fileName();
+  header["settings"] = QJsonObject::fromVariantMap(settings);
+  header["targetSsim"] = targetSsim;
+
+  target->jobs.append(id);
+  if (target->sharedPaths) {
+    header["imagePath"] = QFileInfo(task->imagePath()).absoluteFilePath();
+    header["outputPath"] = QFileInfo(task->optimizedPath()).absoluteFilePath();
+    target->socket->write(WorkProtocol::encode(header));
+    m_jobs.insert(id, Job{worker, task, target, true, QJsonObject()});
+    return true;
+  }
+
+  // The slot is taken now, the task goes out once its source is read
+  m_jobs.insert(id, Job{worker, task, target, false, header});
+  QString imagePath = task->imagePath();
+  m_readPool.start([this, id, imagePath]() {
+    QFile file(imagePath);
+    QByteArray source;
+    QString errorString;
+    if (file.open(QIODevice::ReadOnly)) {
+      source = file.readAll();
+    }
+    if (file.error() != QFileDevice::NoError) {
+      errorString =
+          tr("Unable to read %1: %2").arg(imagePath, file.errorString());
+    }
+    QMetaObject::invokeMethod(
+        this,
+        [this, id, source, errorString]() {
+          sendSource(id, source, errorString);
+        },
+        Qt::QueuedConnection);
+  });
+  return true;
+}
+
+void WorkCoordinator::sendSource(quint64 id, const QByteArray &source,
+                                 const QString &errorString) {
+  // Cancelled or the agent left meanwhile
+  if (!m_jobs.contains(id)) {
+    return;
+  }
+  Job &job = m_jobs[id];
+  if (!errorString.isEmpty()) {
+    Job failed = m_jobs.take(id);
+    failed.agent->jobs.removeOne(id);
+    failed.worker->remoteFinished(false, errorString);
+    return;
+  }
+  job.agent->socket->write(WorkProtocol::encode(job.pendingHeader, source));
+  job.pendingHeader = QJsonObject();
+}
+
+void WorkCoordinator::cancel(RemoteWorker *worker) {
+  m_reservations.remove(worker);
+  for (auto it = m_jobs.begin(); it != m_jobs.end(); ++it) {
+    if (it->worker != worker) {
+      continue;
+    }
+    // Nothing to cancel on the agent while the source is being read
+    if (it->pendingHeader.isEmpty()) {
+      QJsonObject header;
+      header["type"] = "cancel";
+      header["id"] = double(it.key());
+      it->agent->socket->write(WorkProtocol::encode(header));
+    }
+    it->agent->jobs.removeOne(it.key());
+    m_jobs.erase(it);
+    return;
+  }
+}
+
+void WorkCoordinator::handleResult(Agent *agent,
+                                   const WorkProtocol::Message &message) {
+  quint64 id = message.header.value("id").toVariant().toULongLong();
+  agent->jobs.removeOne(id);
+  if (!m_jobs.contains(id)) {
+    // Cancelled in the meantime
+    return;
+  }
+  Job job = m_jobs.take(id);
+
+  bool ok = message.header.value("ok").toBool();
+  QString errorString = message.header.value("error").toString();
+
+  if (ok && !job.sharedPaths) {
+    // Replaces the file rather than writing into it, an output hardlinked
+    // to its original (see OutputLinker) must not change the original
+    QSaveFile output(job.task->optimizedPath());
+    if (!output.open(QIODevice::WriteOnly) ||
+        output.write(message.payload) != message.payload.size() ||
+        !output.commit()) {
+      ok = false;
+      errorString = tr("Unable to write %1: %2")
+                        .arg(job.task->optimizedPath(), output.errorString());
+    }
+  }
+
+  QJsonObject quality = message.header.value("quality").toObject();
+  if (ok && !quality.isEmpty()) {
+    job.task->hasQualityMetrics = true;
+    // JSON has no infinity, lossless results come without PSNR
+    job.task->psnr = quality.contains("psnr")
+                         ? quality.value("psnr").toDouble()
+                         : std::numeric_limits<double>::infinity();
+    job.task->ssim = quality.value("ssim").toDouble();
+    job.task->msSsim = quality.value("msSsim").toDouble();
+    job.task->searchedQuality = quality.value("searchedQuality").toInt(-1);
+  }
+  job.task->processedOn = agent->host;
+
+  job.worker->remoteFinished(ok, errorString);
+}
+
+void WorkCoordinator::removeAgent(Agent *agent, const QString &reason) {
+  if (!m_agents.removeOne(agent)) {
+    return;
+  }
+  qWarning() << "Agent" << agent->host << "removed:" << reason;
+
+  agent->socket->disconnect(this);
+  agent->socket->deleteLater();
+
+  // Unfinished work goes back to the workers, they run it locally
+  const QList<quint64> jobs = agent->jobs;
+  delete agent;
+  for (quint64 id : jobs) {
+    if (m_jobs.contains(id)) {
+      Job job = m_jobs.take(id);
+      job.worker->agentLost(reason);
+    }
+  }
+
+  emit agentsChanged(totalSlots());
+}
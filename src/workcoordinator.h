@@ -0,0 +1,96 @@
+#ifndef WORKCOORDINATOR_H
+#define WORKCOORDINATOR_H
+
+#include "imagetask.h"
+#include "workprotocol.h"
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+#include <QVariantMap>
+
+class QIODevice;
+class QLocalServer;
+class QTcpServer;
+class RemoteWorker;
+
+// Hands tasks to agents (pixelbatch --agent) connected over TCP or a local
+// socket, see WorkProtocol.
+//
+// Agents must know the shared secret (see WorkProtocol), TCP is refused
+// without one. They announce how many tasks they run at once, the
+// coordinator keeps each of them at most that busy. Agents that mount the
+// same paths (same host, local socket or --agent-shared-paths) read and
+// write the files directly, the others get the source bytes and send the
+// output back.
+class WorkCoordinator : public QObject {
+  Q_OBJECT
+
+public:
+  static const int AUTHENTICATION_TIMEOUT_MS = 10000;
+
+  explicit WorkCoordinator(QObject *parent = nullptr);
+  ~WorkCoordinator();
+
+  bool listen(const QString &address, QString *errorString = nullptr);
+  bool isListening() const;
+
+  int totalSlots() const;
+  // Slots reserved by workers that did not submit yet count as taken
+  bool hasFreeSlot() const;
+
+  // Called by RemoteWorker. A slot is reserved from its creation, local
+  // stages like a resize may run before it submits, until it submits or is
+  // cancelled.
+  void reserveSlot(RemoteWorker *worker);
+  bool submit(RemoteWorker *worker, ImageTask *task,
+              const QVariantMap &settings, double targetSsim);
+  void cancel(RemoteWorker *worker);
+
+signals:
+  // Agents connected or left, free slots may have changed
+  void agentsChanged(int totalSlots);
+
+private:
+  struct Agent {
+    QIODevice *socket = nullptr;
+    WorkProtocol::FrameReader reader;
+    QString nonce; // of the challenge
+    bool authenticated = false;
+    QString host;
+    int slots = 0;
+    bool sharedPaths = false;
+    bool localSocket = false;
+    QList<quint64> jobs;
+  };
+
+  struct Job {
+    RemoteWorker *worker;
+    ImageTask *task;
+    Agent *agent;
+    bool sharedPaths;
+    // Sent once the source is read, empty after
+    QJsonObject pendingHeader;
+  };
+
+  void addConnection(QIODevice *socket, bool localSocket);
+  void readMessages(Agent *agent);
+  void handleHello(Agent *agent, const WorkProtocol::Message &message);
+  void handleResult(Agent *agent, const WorkProtocol::Message &message);
+  void sendSource(quint64 id, const QByteArray &source,
+                  const QString &errorString);
+  void removeAgent(Agent *agent, const QString &reason);
+
+  QTcpServer *m_tcpServer;
+  QLocalServer *m_localServer;
+  QList<Agent *> m_agents;
+  QHash<quint64, Job> m_jobs;
+  QSet<RemoteWorker *> m_reservations;
+  quint64 m_nextJobId;
+  // Reads the sources sent to agents off the GUI thread
+  QThreadPool m_readPool;
+};
+
+#endif // WORKCOORDINATOR_H
@@ -9,12 +9,18 @@
 #include <QJsonObject>
 #include <QObject>
 #include <QProcess>
+#include <QSaveFile>
 #include <QString>
 #include <QStringList>
 #include <QThread>
+#include <QTimer>
 #include <QVariantMap>
 #include <imagetask.h>
 #include <settings.h>
+#include <worker/resourcegovernor.h>
+#include <worker/settingssnapshot.h>
+
+#include <memory>
 
 struct ImageTask;
 class ImageWorker : public QObject {
@@ -29,6 +35,25 @@ public:
     m_customSettings = settings;
   }
 
+  // Settings compiled when the task was queued, custom settings included.
+  // Takes precedence over setCustomSettings and the global settings.
+  void setSnapshot(const SettingsSnapshot::Ptr &snapshot) {
+    m_snapshot = snapshot;
+  }
+
+  // Settings group and program of the tool, empty for composite workers
+  virtual QString toolName() const { return QString(); }
+
+  // Tool options derived from the settings alone, without input and output
+  virtual QStringList optionArguments() const { return QStringList(); }
+
+  // Threads the tool runs on, counted against the thread budget by the
+  // scheduler, see ResourceGovernor::threadBudget
+  virtual int threadCount() const { return 1; }
+
+  // Background workers run their tools at the batch CPU and I/O priority
+  void setBackground(bool background) { m_background = background; }
+
   virtual ~ImageWorker() {
     // Kill any running processes when worker is destroyed
     qDebug() << "ImageWorker destructor - terminating" << m_runningProcesses.count() << "processes";
@@ -69,9 +94,14 @@ signals:
 protected:
   QList<QProcess*> m_runningProcesses;  // Track all processes
   QVariantMap m_customSettings;  // Custom settings for this worker instance
+  bool m_background = true;
+  SettingsSnapshot::Ptr m_snapshot;
 
-  // Helper to get setting value - checks custom settings first, then falls back to global QSettings
+  // Helper to get setting value - the snapshot when set, else custom settings first, then global QSettings
   QVariant getSetting(const QString &key, const QVariant &defaultValue = QVariant()) const {
+    if (m_snapshot) {
+      return m_snapshot->value(key, defaultValue);
+    }
     if (m_customSettings.contains(key)) {
       return m_customSettings.value(key);
     }
@@ -80,9 +110,36 @@ protected:
     return settings.value(key, defaultValue);
   }
 
+  // Optimizer picked for the type by name, see Settings::getFormatOptimizer
+  QString formatOptimizerName(ImageType imageType) const {
+    return getSetting(
+               Constants::FORMAT_OPTIMIZER_KEY_PREFIX +
+               ImageTypeUtils::imageTypeToString(imageType).toLower())
+        .toString();
+  }
+
+  // optionArguments, prebuilt by the snapshot when there is one
+  QStringList compiledArguments() const {
+    if (m_snapshot && m_snapshot->hasArguments(toolName())) {
+      return m_snapshot->arguments(toolName());
+    }
+    return optionArguments();
+  }
+
+  ResourceGovernor::Limits processLimits() const {
+    return m_snapshot ? m_snapshot->limits(m_background)
+                      : ResourceGovernor::limits(m_background);
+  }
+
+  // The tool of executeProcess exited cleanly, workers that check what it
+  // wrote report the task themselves
+  virtual void processSucceeded(ImageTask *task) {
+    emit optimizationFinished(task, true);
+  }
+
   void executeProcess(const QString &program, const QStringList &arguments,
                       ImageTask *task) {
-    QProcess *process = new QProcess(this);
+    QProcess *process = new GovernedProcess(processLimits(), this);
 
     // Track this process
     m_runningProcesses.append(process);
@@ -91,19 +148,22 @@ protected:
         process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
         this,
         [task, this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-          // Remove from tracking list
-          m_runningProcesses.removeOne(process);
+          // Remove from tracking list, a crash was reported by errorOccurred
+          if (!m_runningProcesses.removeOne(process)) {
+            return;
+          }
 
           if (exitStatus == QProcess::NormalExit && exitCode == 0) {
-            qDebug() << "Process finished successfully for" << task->imagePath;
-            emit optimizationFinished(task, true);
+            qDebug() << "Process finished successfully for" << task->imagePath();
+            processSucceeded(task);
           } else {
             qWarning().noquote() << "Process finished with error:";
             qWarning().noquote()
                 << serializeProcessError(process, exitCode, exitStatus);
-            emit optimizationError(task, "Process failed with exit code: " +
-                                             QString::number(exitCode));
-            QFile::remove(task->optimizedPath);
+            emit optimizationError(
+                task, failureReason(task, "Process failed with exit code: " +
+                                              QString::number(exitCode)));
+            QFile::remove(task->optimizedPath());
           }
           process->deleteLater();
         });
@@ -111,30 +171,232 @@ protected:
     connect(process, &QProcess::errorOccurred, this,
             [task, this, process](QProcess::ProcessError error) {
               // Remove from tracking list
-              m_runningProcesses.removeOne(process);
+              if (!m_runningProcesses.removeOne(process)) {
+                return;
+              }
 
               qWarning().noquote() << "Error occurred with the process:";
               qWarning().noquote()
                   << serializeProcessError(process, 500, QProcess::CrashExit);
               emit optimizationError(
-                  task, "ErrorString: " + process->errorString() +
-                            " ErrorCode: " + QString::number(error));
-              QFile::remove(task->optimizedPath);
+                  task, failureReason(task, "ErrorString: " +
+                                                process->errorString() +
+                                                " ErrorCode: " +
+                                                QString::number(error)));
+              QFile::remove(task->optimizedPath());
               process->deleteLater();
             });
 
-    qDebug() << "Starting process for" << task->imagePath << "with program"
+    qDebug() << "Starting process for" << task->imagePath() << "with program"
              << program << "and arguments" << arguments;
+    startWatchdog(process, program, task);
     process->start(program, arguments);
 
     if (!process->waitForStarted()) {
-      qDebug() << "Process failed to start for" << task->imagePath;
+      qDebug() << "Process failed to start for" << task->imagePath();
       m_runningProcesses.removeOne(process);
       emit optimizationError(task, "Process failed to start");
       process->deleteLater();
     }
   }
 
+  // Stops the process when it runs longer than the timeout of the tool,
+  // scaled by the input size. TaskWidget retries timed out tasks.
+  void startWatchdog(QProcess *process, const QString &program,
+                     ImageTask *task) {
+    static const int KILL_GRACE_MS = 2000;
+
+    task->timedOut = false;
+    int baseSeconds =
+        getSetting(program + Constants::TOOL_TIMEOUT_KEY_SUFFIX,
+                   Constants::DEFAULT_TOOL_TIMEOUTS.value(
+                       program, Constants::DEFAULT_TOOL_TIMEOUT))
+            .toInt();
+    if (baseSeconds <= 0) {
+      return;
+    }
+    double inputMb = QFileInfo(task->imagePath()).size() / (1024.0 * 1024.0);
+    double perMb = getSetting(Constants::TASK_TIMEOUT_PER_MB_KEY,
+                              Constants::DEFAULT_TASK_TIMEOUT_PER_MB)
+                       .toDouble();
+    int timeoutMs = int((baseSeconds + perMb * inputMb) * 1000);
+
+    // Owned by the process, gone with it
+    QTimer *watchdog = new QTimer(process);
+    watchdog->setSingleShot(true);
+    connect(watchdog, &QTimer::timeout, process, [process, task, timeoutMs]() {
+      if (process->state() == QProcess::NotRunning) {
+        return;
+      }
+      qWarning() << process->program() << "ran longer than" << timeoutMs
+                 << "ms on" << task->imagePath() << ", stopping it";
+      task->timedOut = true;
+      process->terminate();
+      QTimer::singleShot(KILL_GRACE_MS, process, [process]() {
+        if (process->state() != QProcess::NotRunning) {
+          process->kill();
+        }
+      });
+    });
+    connect(process, &QProcess::started, watchdog,
+            [watchdog, timeoutMs]() { watchdog->start(timeoutMs); });
+  }
+
+  QString failureReason(ImageTask *task, const QString &reason) const {
+    return task->timedOut ? QString("Timed out, the optimizer was stopped")
+                          : reason;
+  }
+
+  // Whether tools get the image through stdin/stdout, see executePipedProcess
+  bool usePipes() const {
+    return getSetting(Constants::TASK_PIPE_IO_KEY,
+                      Constants::DEFAULT_TASK_PIPE_IO)
+        .toBool();
+  }
+
+  // Like executeProcess, but the tool reads the image from stdin and writes
+  // the result to stdout. The source is mapped and fed in chunks as the tool
+  // consumes them, the output is collected in memory and written to
+  // optimizedPath in one go, whether to keep it is up to CommitPolicy like
+  // for every other output. No copies, no temp files.
+  void executePipedProcess(const QString &program,
+                           const QStringList &arguments, ImageTask *task) {
+    static const qint64 PIPE_CHUNK_SIZE = 256 * 1024;
+
+    QProcess *process = new GovernedProcess(processLimits(), this);
+    m_runningProcesses.append(process);
+
+    // Lives as long as the process, so does the mapping
+    QFile *source = new QFile(task->imagePath(), process);
+    const uchar *sourceData = nullptr;
+    qint64 sourceSize = 0;
+    if (source->open(QIODevice::ReadOnly)) {
+      sourceSize = source->size();
+      sourceData = sourceSize > 0 ? source->map(0, sourceSize) : nullptr;
+    }
+    if (!sourceData) {
+      qWarning() << "Unable to map" << task->imagePath() << source->errorString();
+      m_runningProcesses.removeOne(process);
+      emit optimizationError(task, "Unable to read source file");
+      process->deleteLater();
+      return;
+    }
+
+    auto written = std::make_shared<qint64>(0);
+    auto output = std::make_shared<QByteArray>();
+
+    // Keep at most one chunk queued, the rest stays in the page cache
+    auto feed = [process, sourceData, sourceSize, written]() {
+      if (*written == sourceSize) {
+        return;
+      }
+      while (*written < sourceSize &&
+             process->bytesToWrite() < PIPE_CHUNK_SIZE) {
+        qint64 chunk = qMin(PIPE_CHUNK_SIZE, sourceSize - *written);
+        process->write(reinterpret_cast<const char *>(sourceData) + *written,
+                       chunk);
+        *written += chunk;
+      }
+      if (*written == sourceSize) {
+        process->closeWriteChannel();
+      }
+    };
+    connect(process, &QProcess::started, process, feed);
+    connect(process, &QProcess::bytesWritten, process, feed);
+    connect(process, &QProcess::readyReadStandardOutput, process,
+            [process, output]() {
+              output->append(process->readAllStandardOutput());
+            });
+
+    connect(
+        process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+        this,
+        [task, this, process,
+         output](int exitCode, QProcess::ExitStatus exitStatus) {
+          // Already reported by errorOccurred
+          if (!m_runningProcesses.removeOne(process)) {
+            return;
+          }
+
+          if (exitStatus == QProcess::NormalExit && exitCode == 0) {
+            output->append(process->readAllStandardOutput());
+            QString errorString;
+            if (commitPipedOutput(task, *output, &errorString)) {
+              qDebug() << "Process finished successfully for"
+                       << task->imagePath();
+              emit optimizationFinished(task, true);
+            } else {
+              emit optimizationError(task, errorString);
+              QFile::remove(task->optimizedPath());
+            }
+          } else {
+            qWarning().noquote() << "Process finished with error:";
+            qWarning().noquote()
+                << serializeProcessError(process, exitCode, exitStatus);
+            emit optimizationError(
+                task, failureReason(task, "Process failed with exit code: " +
+                                              QString::number(exitCode)));
+            QFile::remove(task->optimizedPath());
+          }
+          process->deleteLater();
+        });
+
+    connect(process, &QProcess::errorOccurred, this,
+            [task, this, process](QProcess::ProcessError error) {
+              // The tool closing stdin early also ends up here, its exit
+              // code is what counts then
+              if (error == QProcess::WriteError ||
+                  !m_runningProcesses.contains(process)) {
+                return;
+              }
+              m_runningProcesses.removeOne(process);
+
+              qWarning().noquote() << "Error occurred with the process:";
+              qWarning().noquote()
+                  << serializeProcessError(process, 500, QProcess::CrashExit);
+              emit optimizationError(
+                  task, failureReason(task, "ErrorString: " +
+                                                process->errorString() +
+                                                " ErrorCode: " +
+                                                QString::number(error)));
+              QFile::remove(task->optimizedPath());
+              process->deleteLater();
+            });
+
+    qDebug() << "Starting piped process for" << task->imagePath()
+             << "with program" << program << "and arguments" << arguments;
+    startWatchdog(process, program, task);
+    process->start(program, arguments);
+
+    if (!process->waitForStarted()) {
+      qDebug() << "Process failed to start for" << task->imagePath();
+      if (m_runningProcesses.removeOne(process)) {
+        emit optimizationError(task, "Process failed to start");
+        process->deleteLater();
+      }
+    }
+  }
+
+  bool commitPipedOutput(ImageTask *task, const QByteArray &output,
+                         QString *errorString) {
+    if (output.isEmpty()) {
+      *errorString = "Process produced no output";
+      return false;
+    }
+
+    QSaveFile file(task->optimizedPath());
+    if (!file.open(QIODevice::WriteOnly)) {
+      *errorString = "Unable to write output: " + file.errorString();
+      return false;
+    }
+    file.write(output);
+    if (!file.commit()) {
+      *errorString = "Unable to write output: " + file.errorString();
+      return false;
+    }
+    return true;
+  }
+
   QByteArray serializeProcessError(QProcess *process, int exitCode,
                                    QProcess::ExitStatus exitStatus) {
     QJsonObject errorObject;
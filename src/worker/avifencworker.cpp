@@ -0,0 +1,153 @@
+#include "avifencworker.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+/**
+ * https://github.com/AOMediaCodec/libavif
+ * Based on avifenc 1.1.1 (libavif)
+ *
+ * AVIF Conversion Worker
+ *
+ * This worker encodes JPEG and PNG images to AVIF with libavif and a CPU
+ * AV1 encoder (aom, rav1e or SVT-AV1, whichever libavif was built with).
+ * It is picked per input format in the preferences, like the WebP
+ * conversion, the output then gets the .avif suffix.
+ *
+ * AV1 encoding is slow, so its threads matter: avifenc runs on
+ * avifenc/jobs threads and TaskWidget counts them against the thread
+ * budget (see ResourceGovernor::threadBudget), so several AVIF tasks never
+ * run on more threads than there are cores. Tiles let the encoder spread a
+ * single image over those threads.
+ *
+ * Settings Mapping:
+ *
+ * Quality (avifenc/quality, 0-100, default: 60):
+ *   - Higher = better quality, larger file
+ *   → -q N
+ *
+ * Lossless (avifenc/lossless, default: false):
+ *   → --lossless (overrides quality and chroma subsampling)
+ *
+ * Speed (avifenc/speed, 0-10, default: 6):
+ *   - 0 = Slowest, smallest output
+ *   - 10 = Fastest
+ *   → -s N
+ *
+ * Chroma Subsampling (avifenc/yuvFormat, default: 2):
+ *   Mode 0: 4:4:4 → -y 444 (full color resolution)
+ *   Mode 1: 4:2:2 → -y 422
+ *   Mode 2: 4:2:0 → -y 420 (smallest, fine for photos)
+ *   Mode 3: 4:0:0 → -y 400 (grayscale)
+ *
+ * Encoder (avifenc/codec, default: 0):
+ *   Mode 0: Default of libavif
+ *   Mode 1: aom     → -c aom
+ *   Mode 2: rav1e   → -c rav1e
+ *   Mode 3: SVT-AV1 → -c svt
+ *
+ * Tiles:
+ *   - avifenc/autoTiling (default: true)
+ *     → --autotiling (tiles from the image size and the threads)
+ *   - avifenc/tileRowsLog2, avifenc/tileColsLog2 (0-6, default: 0)
+ *     → --tilerowslog2 N --tilecolslog2 N (when auto tiling is off)
+ *
+ * Performance:
+ *   - avifenc/jobs (0-64, default: 2, 0 = all cores)
+ *     → -j N, -j all
+ *
+ * Example Commands:
+ *
+ * Quality 60, speed 6, 4:2:0:
+ *   avifenc -q 60 -s 6 -y 420 --autotiling -j 2 in.jpg out.avif
+ *
+ * Note: the output is never piped. An output that is not smaller is
+ * discarded by the commit policy, like any conversion (see CommitPolicy).
+ *
+ * @brief AvifencWorker::AvifencWorker
+ * @param parent
+ */
+AvifencWorker::AvifencWorker(QObject *parent) : ImageWorker(parent) {}
+
+void AvifencWorker::optimize(ImageTask *task) {
+  QString src = task->imagePath();
+  QString dst = task->optimizedPath();
+
+  // Ensure destination directory exists
+  QFileInfo dstInfo(dst);
+  QDir dstDir = dstInfo.absoluteDir();
+  if (!dstDir.exists()) {
+    dstDir.mkpath(".");
+  }
+
+  // Remove existing destination file
+  if (QFile::exists(dst)) {
+    QFile::remove(dst);
+  }
+
+  // avifenc takes no end of options marker, keep paths from looking like
+  // options
+  QStringList args = compiledArguments();
+  args << QFileInfo(src).absoluteFilePath() << dstInfo.absoluteFilePath();
+
+  // Debug output
+  qDebug() << "avifenc command:" << "avifenc" << args.join(" ");
+
+  // Execute the conversion
+  executeProcess("avifenc", args, task);
+}
+
+QStringList AvifencWorker::optionArguments() const {
+  // Load settings (using getSetting which checks custom settings first, then falls back to global)
+  int quality = getSetting("avifenc/quality", 60).toInt();
+  bool lossless = getSetting("avifenc/lossless", false).toBool();
+  int speed = getSetting("avifenc/speed", 6).toInt();
+  int yuvFormat = getSetting("avifenc/yuvFormat", 2).toInt();
+  int codec = getSetting("avifenc/codec", 0).toInt();
+  bool autoTiling = getSetting("avifenc/autoTiling", true).toBool();
+  int tileRowsLog2 = getSetting("avifenc/tileRowsLog2", 0).toInt();
+  int tileColsLog2 = getSetting("avifenc/tileColsLog2", 0).toInt();
+  int jobs = getSetting("avifenc/jobs", 2).toInt();
+
+  // Build arguments
+  QStringList args;
+
+  // Quality and chroma subsampling, lossless sets both
+  if (lossless) {
+    args << "--lossless";
+  } else {
+    args << "-q" << QString::number(qBound(0, quality, 100));
+
+    static const QStringList yuvFormats = {"444", "422", "420", "400"};
+    args << "-y" << yuvFormats.value(yuvFormat, "420");
+  }
+
+  // Speed
+  args << "-s" << QString::number(qBound(0, speed, 10));
+
+  // Encoder
+  static const QStringList codecs = {QString(), "aom", "rav1e", "svt"};
+  QString codecName = codecs.value(codec);
+  if (!codecName.isEmpty()) {
+    args << "-c" << codecName;
+  }
+
+  // Tiles
+  if (autoTiling) {
+    args << "--autotiling";
+  } else {
+    args << "--tilerowslog2" << QString::number(qBound(0, tileRowsLog2, 6))
+         << "--tilecolslog2" << QString::number(qBound(0, tileColsLog2, 6));
+  }
+
+  // Threads
+  args << "-j" << (jobs > 0 ? QString::number(jobs) : QString("all"));
+
+  return args;
+}
+
+int AvifencWorker::threadCount() const {
+  int jobs = getSetting("avifenc/jobs", 2).toInt();
+  return jobs > 0 ? jobs : qMax(1, QThread::idealThreadCount());
+}
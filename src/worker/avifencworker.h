@@ -0,0 +1,19 @@
+#ifndef AVIFENCWORKER_H
+#define AVIFENCWORKER_H
+
+#include "ImageWorker.h"
+#include <imagetask.h>
+
+// Converts JPEG and PNG images to AVIF, see ImageOptimizer::getOutputFormat
+class AvifencWorker : public ImageWorker {
+  Q_OBJECT
+public:
+  explicit AvifencWorker(QObject *parent = nullptr);
+
+  void optimize(ImageTask *task) override;
+  QString toolName() const override { return "avifenc"; }
+  QStringList optionArguments() const override;
+  int threadCount() const override;
+};
+
+#endif // AVIFENCWORKER_H
@@ -0,0 +1,236 @@
+#include "cjxlworker.h"
+#include "jpegreconstructor.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <functional>
+
+// Cleared by the worker when it goes away, the job delivers while holding
+// the mutex so it never posts to a deleted worker
+struct CjxlWorker::JobState {
+  QMutex mutex;
+  CjxlWorker *receiver;
+};
+
+namespace {
+
+class VerifyJob : public QRunnable {
+public:
+  typedef std::function<void(bool, const QString &)> Deliver;
+
+  VerifyJob(std::shared_ptr<CjxlWorker::JobState> state,
+            const QString &restoredPath, const QString &jpegPath,
+            Deliver deliver)
+      : m_state(state), m_restoredPath(restoredPath), m_jpegPath(jpegPath),
+        m_deliver(deliver) {}
+
+  void run() override {
+    QString errorString;
+    bool success = JpegReconstructor::sameContent(m_restoredPath, m_jpegPath,
+                                                  &errorString);
+
+    QMutexLocker locker(&m_state->mutex);
+    if (!m_state->receiver) {
+      return;
+    }
+    auto deliver = m_deliver;
+    QMetaObject::invokeMethod(
+        m_state->receiver,
+        [deliver, success, errorString]() { deliver(success, errorString); },
+        Qt::QueuedConnection);
+  }
+
+private:
+  std::shared_ptr<CjxlWorker::JobState> m_state;
+  QString m_restoredPath;
+  QString m_jpegPath;
+  Deliver m_deliver;
+};
+
+} // namespace
+
+/**
+ * https://github.com/libjxl/libjxl
+ * Based on cjxl 0.10 (libjxl)
+ *
+ * Lossless JPEG XL Transcoding Worker
+ *
+ * This worker recompresses JPEG images to JPEG XL without decoding them:
+ * the DCT coefficients are kept as they are and coded more efficiently,
+ * about 20% smaller, with no quality loss at all. The JPEG bitstream
+ * reconstruction data (the jbrd box) is stored along, so the original JPEG
+ * can be restored byte for byte with pixelbatch --restore-jpeg (see
+ * JpegReconstructor). It is picked for JPEG in the preferences, the output
+ * then gets the .jxl suffix.
+ *
+ * Settings Mapping:
+ *
+ * Effort (cjxl/effort, 1-10, default: 7):
+ *   - 1 = Fastest, 10 = Slowest, smallest output
+ *   → -e N
+ *
+ * Brotli Effort (cjxl/brotliEffort, 0-11, default: 9):
+ *   - Compression of the reconstruction data and the metadata boxes
+ *   → --brotli_effort N
+ *
+ * Performance:
+ *   - cjxl/threads (1-64, default: 2)
+ *     → --num_threads N
+ *
+ * Verify (cjxl/verify, default: true):
+ *   - Restores the output with djxl through executeProcess, so the djxl
+ *     timeout, the resource limits and cancellation apply, then compares
+ *     its SHA-256 with the original on a pool thread. A failure or mismatch
+ *     fails the task and removes the output. Off, the output is only known
+ *     to carry the jbrd box.
+ *   → djxl --num_threads N --quiet out.jxl restored.jpg
+ *
+ * Always set:
+ *   --lossless_jpeg=1 --allow_jpeg_reconstruction=1
+ *   (metadata can't be stripped, the original would not be restorable)
+ *
+ * Example Commands:
+ *
+ * Default effort:
+ *   cjxl --quiet --lossless_jpeg=1 --allow_jpeg_reconstruction=1 -e 7
+ *        --brotli_effort 9 --num_threads 2 in.jpg out.jxl
+ *
+ * Note: the output is never piped. JPEGs cjxl can't transcode (arithmetic
+ * coding, some CMYK files) fail instead of being re-encoded lossily.
+ *
+ * @brief CjxlWorker::CjxlWorker
+ * @param parent
+ */
+CjxlWorker::CjxlWorker(QObject *parent) : ImageWorker(parent) {}
+
+CjxlWorker::~CjxlWorker() {
+  if (m_state) {
+    QMutexLocker locker(&m_state->mutex);
+    m_state->receiver = nullptr;
+  }
+}
+
+void CjxlWorker::optimize(ImageTask *task) {
+  task->jpegRoundTripVerified = false;
+  m_verifying = false;
+  QString src = task->imagePath();
+  QString dst = task->optimizedPath();
+
+  // Ensure destination directory exists
+  QFileInfo dstInfo(dst);
+  QDir dstDir = dstInfo.absoluteDir();
+  if (!dstDir.exists()) {
+    dstDir.mkpath(".");
+  }
+
+  // Remove existing destination file
+  if (QFile::exists(dst)) {
+    QFile::remove(dst);
+  }
+
+  // cjxl takes no end of options marker, keep paths from looking like
+  // options
+  QStringList args = compiledArguments();
+  args << QFileInfo(src).absoluteFilePath() << dstInfo.absoluteFilePath();
+
+  // Debug output
+  qDebug() << "cjxl command:" << "cjxl" << args.join(" ");
+
+  // Execute the transcoding
+  executeProcess("cjxl", args, task);
+}
+
+QStringList CjxlWorker::optionArguments() const {
+  // Load settings (using getSetting which checks custom settings first, then falls back to global)
+  int effort = getSetting("cjxl/effort", 7).toInt();
+  int brotliEffort = getSetting("cjxl/brotliEffort", 9).toInt();
+  int threads = getSetting("cjxl/threads", 2).toInt();
+
+  // Build arguments
+  QStringList args;
+
+  // Always quiet mode for cleaner output
+  args << "--quiet";
+
+  // Transcode the coefficients and keep what restores the JPEG
+  args << "--lossless_jpeg=1" << "--allow_jpeg_reconstruction=1";
+
+  // Effort
+  args << "-e" << QString::number(qBound(1, effort, 10));
+  args << "--brotli_effort" << QString::number(qBound(0, brotliEffort, 11));
+
+  // Threads
+  args << "--num_threads" << QString::number(qBound(1, threads, 64));
+
+  return args;
+}
+
+int CjxlWorker::threadCount() const {
+  return qBound(1, getSetting("cjxl/threads", 2).toInt(), 64);
+}
+
+void CjxlWorker::processSucceeded(ImageTask *task) {
+  if (m_verifying) {
+    m_verifying = false;
+    QString restoredPath = m_restoreDir->filePath("restored.jpg");
+    if (m_state) {
+      QMutexLocker locker(&m_state->mutex);
+      m_state->receiver = nullptr;
+    }
+    m_state = std::make_shared<JobState>();
+    m_state->receiver = this;
+    QThreadPool::globalInstance()->start(new VerifyJob(
+        m_state, restoredPath, task->imagePath(),
+        [this, task](bool success, const QString &errorString) {
+          onVerified(task, success, errorString);
+        }));
+    return;
+  }
+
+  if (!getSetting("cjxl/verify", true).toBool()) {
+    emit optimizationFinished(task, true);
+    return;
+  }
+  restoreOutput(task);
+}
+
+void CjxlWorker::restoreOutput(ImageTask *task) {
+  if (!JpegReconstructor::hasReconstructionData(task->optimizedPath())) {
+    onVerified(task, false, tr("the output has no reconstruction data"));
+    return;
+  }
+  m_restoreDir.reset(new QTemporaryDir());
+  if (!m_restoreDir->isValid()) {
+    onVerified(task, false, tr("could not create a temporary directory"));
+    return;
+  }
+
+  // Same thread budget as the transcode, a failed run removes the output
+  QStringList args;
+  args << "--num_threads" << QString::number(threadCount());
+  args << JpegReconstructor::restoreArguments(
+      task->optimizedPath(), m_restoreDir->filePath("restored.jpg"));
+  m_verifying = true;
+  executeProcess("djxl", args, task);
+}
+
+void CjxlWorker::onVerified(ImageTask *task, bool success,
+                            const QString &errorString) {
+  m_restoreDir.reset();
+  if (!success) {
+    // Never left behind as if the original could be restored from it
+    QFile::remove(task->optimizedPath());
+    emit optimizationError(
+        task, tr("JPEG round trip failed: %1").arg(errorString));
+    return;
+  }
+  task->jpegRoundTripVerified = true;
+  emit optimizationFinished(task, true);
+}
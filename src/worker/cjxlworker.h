@@ -0,0 +1,39 @@
+#ifndef CJXLWORKER_H
+#define CJXLWORKER_H
+
+#include "ImageWorker.h"
+#include <imagetask.h>
+
+#include <QTemporaryDir>
+
+#include <memory>
+
+// Transcodes JPEG images to JPEG XL losslessly, see JpegReconstructor
+class CjxlWorker : public ImageWorker {
+  Q_OBJECT
+public:
+  explicit CjxlWorker(QObject *parent = nullptr);
+  ~CjxlWorker();
+
+  void optimize(ImageTask *task) override;
+  QString toolName() const override { return "cjxl"; }
+  QStringList optionArguments() const override;
+  int threadCount() const override;
+
+  // Shared with the round trip job, which may outlive us
+  struct JobState;
+
+protected:
+  void processSucceeded(ImageTask *task) override;
+
+private:
+  void restoreOutput(ImageTask *task);
+  void onVerified(ImageTask *task, bool success, const QString &errorString);
+
+  std::shared_ptr<JobState> m_state;
+  // djxl writes the restored JPEG here while verifying
+  std::unique_ptr<QTemporaryDir> m_restoreDir;
+  bool m_verifying = false;
+};
+
+#endif // CJXLWORKER_H
@@ -0,0 +1,160 @@
+#include "cwebpworker.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+/**
+ * https://developers.google.com/speed/webp/docs/cwebp
+ * Based on cwebp 1.4.0 (libwebp)
+ *
+ * WebP Conversion Worker
+ *
+ * This worker encodes JPEG and PNG images to WebP, which is usually far
+ * smaller than the best in-format recompression. It is picked per input
+ * format in the preferences (format/optimizer_jpg, format/optimizer_png),
+ * the output then gets the .webp suffix.
+ *
+ * Key Features:
+ * - Lossy encoding with quality control
+ * - Lossless encoding for graphics and screenshots
+ * - Separate alpha channel quality
+ * - Multithreaded encoding
+ *
+ * Settings Mapping:
+ *
+ * Encoding (cwebp/lossless, default: false):
+ *   - false = Lossy (VP8)
+ *   - true = Lossless (VP8L) → -lossless
+ *
+ * Quality (cwebp/quality, 0-100, default: 80):
+ *   - Lossy: visual quality, higher = better quality, larger file
+ *   - Lossless: compression effort, higher = smaller file, slower
+ *   → -q N
+ *
+ * Method (cwebp/method, 0-6, default: 4):
+ *   - 0 = Fastest, 6 = Slowest, smallest output
+ *   → -m N
+ *
+ * Alpha:
+ *   - cwebp/alphaQuality (0-100, default: 100)
+ *     → -alpha_q N (lossy only, 100 keeps the alpha channel lossless)
+ *   - cwebp/exactAlpha (default: false)
+ *     → -exact (keep the RGB values under transparent pixels)
+ *
+ * Metadata (cwebp/metadataMode, default: 1):
+ *   Mode 0: Strip all  → -metadata none
+ *   Mode 1: ICC only   → -metadata icc
+ *   Mode 2: EXIF + ICC → -metadata exif,icc
+ *   Mode 3: Keep all   → -metadata all
+ *
+ * Performance:
+ *   - cwebp/multiThreaded (default: true)
+ *     → -mt (encode with several threads where the format allows)
+ *
+ * Example Commands:
+ *
+ * Lossy, quality 80:
+ *   cwebp -quiet -q 80 -m 4 -alpha_q 100 -metadata icc -mt -o out.webp -- in.jpg
+ *
+ * Lossless, maximum effort:
+ *   cwebp -quiet -lossless -q 100 -m 6 -metadata icc -mt -o out.webp -- in.png
+ *
+ * Note: the output is never piped. An output that is not smaller can't be
+ * replaced by the source under a .webp name, the commit policy discards it
+ * instead (see CommitPolicy).
+ *
+ * @brief CwebpWorker::CwebpWorker
+ * @param parent
+ */
+CwebpWorker::CwebpWorker(QObject *parent) : ImageWorker(parent) {}
+
+void CwebpWorker::optimize(ImageTask *task) {
+  QString src = task->imagePath();
+  QString dst = task->optimizedPath();
+
+  // Ensure destination directory exists
+  QFileInfo dstInfo(dst);
+  QDir dstDir = dstInfo.absoluteDir();
+  if (!dstDir.exists()) {
+    dstDir.mkpath(".");
+  }
+
+  // Remove existing destination file
+  if (QFile::exists(dst)) {
+    QFile::remove(dst);
+  }
+
+  QStringList args = compiledArguments();
+  args << "-o" << dst << "--" << src;
+
+  // Debug output
+  qDebug() << "cwebp command:" << "cwebp" << args.join(" ");
+
+  // Execute the conversion
+  executeProcess("cwebp", args, task);
+}
+
+QStringList CwebpWorker::optionArguments() const {
+  // Load settings (using getSetting which checks custom settings first, then falls back to global)
+  bool lossless = getSetting("cwebp/lossless", false).toBool();
+  int quality = getSetting("cwebp/quality", 80).toInt();
+  int method = getSetting("cwebp/method", 4).toInt();
+  int alphaQuality = getSetting("cwebp/alphaQuality", 100).toInt();
+  bool exactAlpha = getSetting("cwebp/exactAlpha", false).toBool();
+  int metadataMode = getSetting("cwebp/metadataMode", 1).toInt();
+  bool multiThreaded = getSetting("cwebp/multiThreaded", true).toBool();
+
+  // Build arguments
+  QStringList args;
+
+  // Always quiet mode for cleaner output
+  args << "-quiet";
+
+  if (lossless) {
+    args << "-lossless";
+  }
+
+  // Quality, or effort when lossless
+  args << "-q" << QString::number(qBound(0, quality, 100));
+
+  // Compression method
+  args << "-m" << QString::number(qBound(0, method, 6));
+
+  // Alpha quality, lossless alpha is already lossless
+  if (!lossless) {
+    args << "-alpha_q" << QString::number(qBound(0, alphaQuality, 100));
+  }
+
+  if (exactAlpha) {
+    args << "-exact";
+  }
+
+  // Metadata handling
+  switch (metadataMode) {
+    case 0: // Strip all
+      args << "-metadata" << "none";
+      break;
+    case 2: // Keep EXIF + ICC
+      args << "-metadata" << "exif,icc";
+      break;
+    case 3: // Keep all
+      args << "-metadata" << "all";
+      break;
+    case 1: // Keep ICC only
+    default:
+      args << "-metadata" << "icc";
+      break;
+  }
+
+  // Multithreaded encoding
+  if (multiThreaded) {
+    args << "-mt";
+  }
+
+  return args;
+}
+
+int CwebpWorker::threadCount() const {
+  // -mt splits analysis and encoding, about two threads busy
+  return getSetting("cwebp/multiThreaded", true).toBool() ? 2 : 1;
+}
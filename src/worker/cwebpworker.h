@@ -0,0 +1,19 @@
+#ifndef CWEBPWORKER_H
+#define CWEBPWORKER_H
+
+#include "ImageWorker.h"
+#include <imagetask.h>
+
+// Converts JPEG and PNG images to WebP, see ImageOptimizer::getOutputFormat
+class CwebpWorker : public ImageWorker {
+  Q_OBJECT
+public:
+  explicit CwebpWorker(QObject *parent = nullptr);
+
+  void optimize(ImageTask *task) override;
+  QString toolName() const override { return "cwebp"; }
+  QStringList optionArguments() const override;
+  int threadCount() const override;
+};
+
+#endif // CWEBPWORKER_H
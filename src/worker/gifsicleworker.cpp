@@ -76,8 +76,8 @@ GifsicleWorker::GifsicleWorker(QObject *parent)
     : ImageWorker(parent) {}
 
 void GifsicleWorker::optimize(ImageTask *task) {
-    QString src = task->imagePath;
-    QString dst = task->optimizedPath;
+    QString src = task->imagePath();
+    QString dst = task->optimizedPath();
 
     // Ensure destination directory exists
     QFileInfo dstInfo(dst);
@@ -91,6 +91,30 @@ void GifsicleWorker::optimize(ImageTask *task) {
         QFile::remove(dst);
     }
 
+    bool pipes = usePipes();
+    QStringList args = compiledArguments();
+
+    // Output and input file, stdout and stdin when piping
+    if (pipes) {
+        qDebug() << "gifsicle command:" << "gifsicle" << args.join(" ");
+        executePipedProcess("gifsicle", args, task);
+        return;
+    }
+
+    // Output file
+    args << "-o" << dst;
+
+    // Input file
+    args << src;
+
+    // Debug output
+    qDebug() << "gifsicle command:" << "gifsicle" << args.join(" ");
+
+    // Execute the optimization
+    executeProcess("gifsicle", args, task);
+}
+
+QStringList GifsicleWorker::optionArguments() const {
     // Load settings (using getSetting which checks custom settings first, then falls back to global)
     int optimizationLevel = getSetting("gifsicle/optimizationLevel", 2).toInt();
     int compressionType = getSetting("gifsicle/compressionType", 0).toInt();
@@ -155,16 +179,9 @@ void GifsicleWorker::optimize(ImageTask *task) {
         args << "-j" + QString::number(threads);
     }
 
-    // Output file
-    args << "-o" << dst;
-
-    // Input file
-    args << src;
-
-    // Debug output
-    qDebug() << "gifsicle command:" << "gifsicle" << args.join(" ");
-
-    // Execute the optimization
-    executeProcess("gifsicle", args, task);
+    return args;
 }
 
+int GifsicleWorker::threadCount() const {
+    return qMax(1, getSetting("gifsicle/threads", 4).toInt());
+}
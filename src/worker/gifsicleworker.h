@@ -10,6 +10,9 @@ public:
   explicit GifsicleWorker(QObject *parent = nullptr);
 
   void optimize(ImageTask *task) override;
+  QString toolName() const override { return "gifsicle"; }
+  QStringList optionArguments() const override;
+  int threadCount() const override;
 };
 
 #endif // GIFSICLEWORKER_H
@@ -0,0 +1,77 @@
+#include "headeranalyzer.h"
+
+#include <QMetaObject>
+#include <QRunnable>
+#include <QThread>
+
+namespace {
+
+class HeaderAnalysisJob : public QRunnable {
+public:
+  HeaderAnalysisJob(HeaderAnalyzer *analyzer,
+                    std::shared_ptr<QAtomicInteger<quint64>> generation,
+                    ImageTask *task)
+      : m_analyzer(analyzer), m_generation(generation),
+        m_requestGeneration(generation->loadAcquire()), m_task(task),
+        m_imagePath(task->imagePath()), m_imageType(task->imageType) {}
+
+  void run() override {
+    if (isStale()) {
+      return;
+    }
+
+    QString errorString;
+    ImageHeader::Info info =
+        ImageHeader::read(m_imagePath, m_imageType, &errorString);
+
+    if (isStale()) {
+      return;
+    }
+
+    HeaderAnalyzer *analyzer = m_analyzer;
+    ImageTask *task = m_task;
+    QString imagePath = m_imagePath;
+    QMetaObject::invokeMethod(
+        analyzer,
+        [analyzer, task, imagePath, info, errorString]() {
+          emit analyzer->analysisFinished(task, imagePath, info, errorString);
+        },
+        Qt::QueuedConnection);
+  }
+
+private:
+  bool isStale() const {
+    return m_generation->loadAcquire() != m_requestGeneration;
+  }
+
+  HeaderAnalyzer *m_analyzer;
+  std::shared_ptr<QAtomicInteger<quint64>> m_generation;
+  quint64 m_requestGeneration;
+  ImageTask *m_task;
+  QString m_imagePath;
+  ImageType m_imageType;
+};
+
+} // namespace
+
+HeaderAnalyzer::HeaderAnalyzer(QObject *parent)
+    : QObject(parent),
+      m_generation(std::make_shared<QAtomicInteger<quint64>>(0)) {
+  // Mostly waiting on the disk, more jobs than cores keep it busy
+  m_threadPool.setMaxThreadCount(QThread::idealThreadCount() * 2);
+}
+
+HeaderAnalyzer::~HeaderAnalyzer() {
+  cancel();
+  // Jobs hold a raw pointer to us, make sure none outlives the analyzer
+  m_threadPool.waitForDone();
+}
+
+void HeaderAnalyzer::analyze(ImageTask *task) {
+  m_threadPool.start(new HeaderAnalysisJob(this, m_generation, task));
+}
+
+void HeaderAnalyzer::cancel() {
+  m_threadPool.clear();
+  m_generation->fetchAndAddOrdered(1);
+}
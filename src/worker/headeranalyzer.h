@@ -0,0 +1,40 @@
+#ifndef HEADERANALYZER_H
+#define HEADERANALYZER_H
+
+#include "imageheader.h"
+
+#include <QAtomicInteger>
+#include <QObject>
+#include <QThreadPool>
+#include <imagetask.h>
+
+#include <memory>
+
+// Runs ImageHeader for added images on a thread pool.
+//
+// Same contract as QualityAnalyzer: jobs only take copies of the path and
+// type, the task pointer is handed back untouched with the result, so the
+// receiver has to check that the task is still alive. Tasks are pooled and
+// a new one may take the place of a removed one, the path tells them apart.
+// cancel() drops queued jobs and discards running ones.
+class HeaderAnalyzer : public QObject {
+  Q_OBJECT
+
+public:
+  explicit HeaderAnalyzer(QObject *parent = nullptr);
+  ~HeaderAnalyzer();
+
+  void analyze(ImageTask *task);
+  void cancel();
+
+signals:
+  void analysisFinished(ImageTask *task, const QString &imagePath,
+                        const ImageHeader::Info &info,
+                        const QString &errorString);
+
+private:
+  QThreadPool m_threadPool;
+  std::shared_ptr<QAtomicInteger<quint64>> m_generation;
+};
+
+#endif // HEADERANALYZER_H
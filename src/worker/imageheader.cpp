@@ -0,0 +1,373 @@
+#include "imageheader.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QRegularExpression>
+
+#include <climits>
+#include <cstring>
+
+namespace {
+
+// SVG root elements come after the prolog, not megabytes into the file
+const qint64 SVG_ROOT_SEARCH_BYTES = 64 * 1024;
+
+quint16 bigEndian16(const uchar *data) {
+  return quint16((data[0] << 8) | data[1]);
+}
+
+quint32 bigEndian32(const uchar *data) {
+  return (quint32(data[0]) << 24) | (quint32(data[1]) << 16) |
+         (quint32(data[2]) << 8) | quint32(data[3]);
+}
+
+quint16 littleEndian16(const uchar *data) {
+  return quint16(data[0] | (data[1] << 8));
+}
+
+// SOF0 to SOF15, without DHT, JPG and DAC which share the range
+bool isStartOfFrame(uchar marker) {
+  return marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+         marker != 0xC8 && marker != 0xCC;
+}
+
+// GIF data sub-blocks, returns the position after the terminator
+qint64 skipSubBlocks(const uchar *data, qint64 size, qint64 pos) {
+  while (pos < size) {
+    uchar blockSize = data[pos];
+    pos += 1 + blockSize;
+    if (blockSize == 0) {
+      break;
+    }
+  }
+  return pos;
+}
+
+// Leading number of an SVG length, 0 for percentages or no number
+quint32 svgLength(const QString &value) {
+  static const QRegularExpression number("^\\s*([0-9]*\\.?[0-9]+)");
+  if (value.contains('%')) {
+    return 0;
+  }
+  QRegularExpressionMatch match = number.match(value);
+  return match.hasMatch() ? quint32(qRound(match.captured(1).toDouble())) : 0;
+}
+
+} // namespace
+
+ImageHeader::Info ImageHeader::read(const QString &imagePath,
+                                    ImageType imageType,
+                                    QString *errorString) {
+  QFile file(imagePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    if (errorString) {
+      *errorString = file.errorString();
+    }
+    return Info();
+  }
+
+  qint64 size = file.size();
+  QByteArray buffer;
+  const uchar *data = size > 0 ? file.map(0, size) : nullptr;
+  if (!data) {
+    // Not mappable, e.g. on some network file systems
+    buffer = file.readAll();
+    data = reinterpret_cast<const uchar *>(buffer.constData());
+    size = buffer.size();
+  }
+
+  Info info;
+  switch (imageType) {
+  case ImageType::JPG:
+    info = readJpeg(data, size);
+    break;
+  case ImageType::PNG:
+    info = readPng(data, size);
+    break;
+  case ImageType::GIF:
+    info = readGif(data, size);
+    break;
+  case ImageType::SVG:
+    info = readSvg(data, size);
+    break;
+  default:
+    break;
+  }
+
+  if (!info.valid && errorString) {
+    *errorString = QObject::tr("No valid %1 header")
+                       .arg(ImageTypeUtils::imageTypeToString(imageType));
+  }
+  return info;
+}
+
+ImageHeader::Info ImageHeader::readJpeg(const uchar *data, qint64 size) {
+  Info info;
+  if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+    return info;
+  }
+
+  qint64 pos = 2;
+  while (pos + 4 <= size) {
+    if (data[pos] != 0xFF) {
+      break; // lost the marker sequence, keep what was found
+    }
+    uchar marker = data[pos + 1];
+    if (marker == 0xFF) {
+      ++pos; // fill byte
+      continue;
+    }
+    pos += 2;
+
+    // Markers without a segment
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+      continue;
+    }
+    // The entropy coded data follows, nothing of interest beyond it
+    if (marker == 0xD9 || marker == 0xDA) {
+      break;
+    }
+
+    quint16 length = bigEndian16(data + pos);
+    if (length < 2 || pos + length > size) {
+      break;
+    }
+    const uchar *segment = data + pos + 2;
+    int segmentLength = length - 2;
+
+    if ((marker >= 0xE1 && marker <= 0xEF) || marker == 0xFE) {
+      // APP1 to APP15 (EXIF, XMP, ICC, Photoshop...) and COM. APP0 is the
+      // JFIF header, not metadata.
+      info.metadataBytes += 2 + length;
+    } else if (isStartOfFrame(marker) && segmentLength >= 6) {
+      info.bitDepth = segment[0];
+      info.height = bigEndian16(segment + 1);
+      info.width = bigEndian16(segment + 3);
+      switch (segment[5]) {
+      case 1:
+        info.colorType = Grayscale;
+        break;
+      case 3:
+        info.colorType = YCbCr;
+        break;
+      case 4:
+        info.colorType = Cmyk;
+        break;
+      default:
+        info.colorType = UnknownColor;
+      }
+      info.progressive = marker == 0xC2 || marker == 0xC6 ||
+                         marker == 0xCA || marker == 0xCE;
+      info.frameCount = 1;
+      info.valid = true;
+    }
+    pos += length;
+  }
+  return info;
+}
+
+ImageHeader::Info ImageHeader::readPng(const uchar *data, qint64 size) {
+  Info info;
+  if (size < 8 || std::memcmp(data, "\x89PNG\r\n\x1A\n", 8) != 0) {
+    return info;
+  }
+
+  qint64 pos = 8;
+  while (pos + 8 <= size) {
+    quint32 length = bigEndian32(data + pos);
+    const uchar *type = data + pos + 4;
+    const uchar *payload = data + pos + 8;
+    qint64 chunkSize = 12 + qint64(length);
+    bool complete = pos + 8 + qint64(length) <= size;
+
+    if (std::memcmp(type, "IHDR", 4) == 0 && length >= 13 && complete) {
+      info.width = bigEndian32(payload);
+      info.height = bigEndian32(payload + 4);
+      info.bitDepth = payload[8];
+      switch (payload[9]) {
+      case 0:
+        info.colorType = Grayscale;
+        break;
+      case 2:
+        info.colorType = Rgb;
+        break;
+      case 3:
+        info.colorType = Indexed;
+        break;
+      case 4:
+        info.colorType = GrayscaleAlpha;
+        break;
+      case 6:
+        info.colorType = Rgba;
+        break;
+      default:
+        info.colorType = UnknownColor;
+      }
+      info.progressive = payload[12] == 1; // Adam7
+      info.frameCount = 1;
+      info.valid = true;
+    } else if (std::memcmp(type, "acTL", 4) == 0 && length >= 8 && complete) {
+      info.frameCount = bigEndian32(payload); // APNG
+    } else if (std::memcmp(type, "tEXt", 4) == 0 ||
+               std::memcmp(type, "zTXt", 4) == 0 ||
+               std::memcmp(type, "iTXt", 4) == 0 ||
+               std::memcmp(type, "iCCP", 4) == 0 ||
+               std::memcmp(type, "eXIf", 4) == 0 ||
+               std::memcmp(type, "tIME", 4) == 0) {
+      info.metadataBytes += chunkSize;
+    } else if (std::memcmp(type, "IEND", 4) == 0) {
+      break;
+    }
+    pos += chunkSize;
+  }
+  return info;
+}
+
+ImageHeader::Info ImageHeader::readGif(const uchar *data, qint64 size) {
+  Info info;
+  if (size < 13 || (std::memcmp(data, "GIF87a", 6) != 0 &&
+                    std::memcmp(data, "GIF89a", 6) != 0)) {
+    return info;
+  }
+
+  info.width = littleEndian16(data + 6);
+  info.height = littleEndian16(data + 8);
+  uchar screenFlags = data[10];
+  info.bitDepth = (screenFlags & 0x07) + 1;
+  info.colorType = Indexed;
+  info.valid = true;
+
+  qint64 pos = 13;
+  if (screenFlags & 0x80) {
+    pos += 3 * (1 << info.bitDepth); // global color table
+  }
+
+  while (pos < size) {
+    uchar introducer = data[pos];
+    if (introducer == 0x3B) {
+      break; // trailer
+    }
+
+    if (introducer == 0x2C) {
+      // Image descriptor, local color table, LZW code size and image data
+      if (pos + 10 > size) {
+        break;
+      }
+      uchar imageFlags = data[pos + 9];
+      if (info.frameCount == 0) {
+        info.progressive = imageFlags & 0x40;
+      }
+      info.frameCount++;
+      pos += 10;
+      if (imageFlags & 0x80) {
+        pos += 3 * (1 << ((imageFlags & 0x07) + 1));
+      }
+      pos = skipSubBlocks(data, size, pos + 1);
+    } else if (introducer == 0x21) {
+      if (pos + 2 > size) {
+        break;
+      }
+      uchar label = data[pos + 1];
+      qint64 start = pos;
+      pos += 2;
+
+      // Comments and application data (XMP, ICC) other than the looping
+      // extensions needed to play the animation
+      bool metadata = label == 0xFE;
+      if (label == 0xFF && pos + 12 <= size) {
+        const uchar *application = data + pos + 1;
+        metadata = std::memcmp(application, "NETSCAPE2.0", 11) != 0 &&
+                   std::memcmp(application, "ANIMEXTS1.0", 11) != 0;
+      }
+      pos = skipSubBlocks(data, size, pos);
+      if (metadata) {
+        info.metadataBytes += qMin(pos, size) - start;
+      }
+    } else {
+      break; // not a GIF block, keep what was found
+    }
+  }
+  return info;
+}
+
+ImageHeader::Info ImageHeader::readSvg(const uchar *data, qint64 size) {
+  Info info;
+  const QByteArray text = QByteArray::fromRawData(
+      reinterpret_cast<const char *>(data), int(qMin<qint64>(size, INT_MAX)));
+
+  int rootStart = text.indexOf("<svg");
+  if (rootStart < 0 || rootStart > SVG_ROOT_SEARCH_BYTES) {
+    return info;
+  }
+  int rootEnd = text.indexOf('>', rootStart);
+  if (rootEnd < 0) {
+    return info;
+  }
+  const QString root =
+      QString::fromUtf8(text.constData() + rootStart, rootEnd - rootStart);
+
+  auto attribute = [&root](const QString &name) {
+    QRegularExpression expression(
+        QString("\\s%1\\s*=\\s*[\"']([^\"']*)[\"']").arg(name));
+    return expression.match(root).captured(1);
+  };
+  info.width = svgLength(attribute("width"));
+  info.height = svgLength(attribute("height"));
+  if (info.width == 0 || info.height == 0) {
+    // Percentages or no size at all, the view box is the intrinsic size
+    const QStringList viewBox =
+        attribute("viewBox").split(QRegularExpression("[\\s,]+"),
+                                   Qt::SkipEmptyParts);
+    if (viewBox.size() == 4) {
+      info.width = quint32(qRound(viewBox.at(2).toDouble()));
+      info.height = quint32(qRound(viewBox.at(3).toDouble()));
+    }
+  }
+
+  // Metadata elements and comments, as written by the editors
+  const QList<QPair<QByteArray, QByteArray>> sections = {
+      {"<metadata", "</metadata>"}, {"<!--", "-->"}};
+  for (const auto &section : sections) {
+    int start = text.indexOf(section.first);
+    while (start >= 0) {
+      int end = text.indexOf(section.second, start);
+      if (end < 0) {
+        break;
+      }
+      end += section.second.size();
+      info.metadataBytes += end - start;
+      start = text.indexOf(section.first, end);
+    }
+  }
+
+  info.colorType = Vector;
+  info.frameCount = 1;
+  info.valid = true;
+  return info;
+}
+
+QString ImageHeader::colorTypeToString(ColorType colorType) {
+  switch (colorType) {
+  case Grayscale:
+    return QObject::tr("Grayscale");
+  case GrayscaleAlpha:
+    return QObject::tr("Grayscale with alpha");
+  case Rgb:
+    return QObject::tr("RGB");
+  case Rgba:
+    return QObject::tr("RGBA");
+  case Indexed:
+    return QObject::tr("Indexed");
+  case YCbCr:
+    return QObject::tr("YCbCr");
+  case Cmyk:
+    return QObject::tr("CMYK");
+  case Vector:
+    return QObject::tr("Vector");
+  default:
+    return QObject::tr("Unknown");
+  }
+}
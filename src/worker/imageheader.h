@@ -0,0 +1,57 @@
+#ifndef IMAGEHEADER_H
+#define IMAGEHEADER_H
+
+#include <imagetype.h>
+
+#include <QString>
+
+// What an image holds, read from its headers and chunks only.
+//
+// JPEG is read up to the first scan (SOFn and APPn markers), PNG chunk by
+// chunk skipping over the image data (IHDR, acTL and the text, iCCP, eXIf
+// and tIME chunks), GIF block by block for the logical screen and the frame
+// count, SVG up to the root element for its size. Nothing is decoded, the
+// file is memory mapped so the skipped parts are never read from disk.
+//
+// Reentrant, headers are read on worker threads.
+class ImageHeader {
+public:
+  enum ColorType : quint8 {
+    UnknownColor,
+    Grayscale,
+    GrayscaleAlpha,
+    Rgb,
+    Rgba,
+    Indexed,
+    YCbCr,
+    Cmyk,
+    Vector
+  };
+
+  struct Info {
+    bool valid = false;
+    quint8 bitDepth = 0; // per channel, palette index bits for GIF
+    ColorType colorType = UnknownColor;
+    bool progressive = false; // progressive JPEG, interlaced PNG and GIF
+    quint32 width = 0;
+    quint32 height = 0;
+    quint32 frameCount = 0;
+    // EXIF, XMP, ICC, comments and text chunks, with their framing
+    qint64 metadataBytes = 0;
+  };
+
+  static Info read(const QString &imagePath, ImageType imageType,
+                   QString *errorString = nullptr);
+
+  static Info readJpeg(const uchar *data, qint64 size);
+  static Info readPng(const uchar *data, qint64 size);
+  static Info readGif(const uchar *data, qint64 size);
+  static Info readSvg(const uchar *data, qint64 size);
+
+  static QString colorTypeToString(ColorType colorType);
+
+private:
+  ImageHeader() = delete;
+};
+
+#endif // IMAGEHEADER_H
@@ -4,9 +4,10 @@ ImageOptimizer::ImageOptimizer() { valid = false; }
 
 ImageOptimizer::ImageOptimizer(const QString &name,
                                const QStringList &supportedFormats,
-                               const ImageType &imageType)
+                               const ImageType &imageType,
+                               const QString &outputFormat)
     : optimizerName(name), supportedFormats(supportedFormats),
-      imageType(imageType) {
+      imageType(imageType), outputFormat(outputFormat) {
   valid = true;
 }
 
@@ -18,4 +19,16 @@ QStringList ImageOptimizer::getSupportedFormats() const {
 
 ImageType ImageOptimizer::getImageType() const { return imageType; }
 
+QString ImageOptimizer::getOutputFormat() const { return outputFormat; }
+
+bool ImageOptimizer::convertsFormat() const { return !outputFormat.isEmpty(); }
+
+bool ImageOptimizer::stripsMetadataOnly() const {
+  return optimizerName == "Metadata only";
+}
+
+bool ImageOptimizer::keepsOriginalRestorable() const {
+  return optimizerName == "Cjxl";
+}
+
 bool ImageOptimizer::isValid() const { return valid; }
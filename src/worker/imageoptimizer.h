@@ -9,12 +9,21 @@
 class ImageOptimizer {
 public:
   ImageOptimizer();
+  // outputFormat is the suffix of what it writes, empty when it keeps the
+  // format of the image
   ImageOptimizer(const QString &name, const QStringList &supportedFormats,
-                 const ImageType &imageType);
+                 const ImageType &imageType,
+                 const QString &outputFormat = QString());
 
   QString getName() const;
   QStringList getSupportedFormats() const;
   ImageType getImageType() const;
+  QString getOutputFormat() const;
+  bool convertsFormat() const;
+  // Writes the original without its metadata, see MetadataStripWorker
+  bool stripsMetadataOnly() const;
+  // Keeps the original restorable byte for byte, see JpegReconstructor
+  bool keepsOriginalRestorable() const;
   bool isValid() const;
 
 private:
@@ -22,6 +31,7 @@ private:
   QString optimizerName;
   QStringList supportedFormats;
   ImageType imageType;
+  QString outputFormat;
 };
 
 #endif // IMAGEOPTIMIZER_H
@@ -3,9 +3,21 @@
 #include "pngquantworker.h"
 #include "gifsicleworker.h"
 #include "svgoworker.h"
+#include "cwebpworker.h"
+#include "avifencworker.h"
+#include "cjxlworker.h"
+#include "metadatastripworker.h"
 #include <QDebug>
+#include <QFile>
 #include <stdexcept>
 
+namespace {
+
+// Room for the XML declaration, comments and doctype before an SVG root
+const qint64 SNIFF_BYTES = 4096;
+
+} // namespace
+
 ImageWorkerFactory &ImageWorkerFactory::instance() {
   static ImageWorkerFactory factoryInstance;
   return factoryInstance;
@@ -26,6 +38,29 @@ QList<ImageOptimizer> ImageWorkerFactory::createImageOptimizers() {
   optimizers.append(
       ImageOptimizer("SVGO", QStringList{"svg"}, ImageType::SVG));
 
+  // Conversions come after the in-format optimizers, which stay the default
+  // of their type
+  optimizers.append(ImageOptimizer("Cwebp", QStringList{"jpg", "jpeg"},
+                                   ImageType::JPG, "webp"));
+  optimizers.append(
+      ImageOptimizer("Cwebp", QStringList{"png"}, ImageType::PNG, "webp"));
+  optimizers.append(ImageOptimizer("Avifenc", QStringList{"jpg", "jpeg"},
+                                   ImageType::JPG, "avif"));
+  optimizers.append(
+      ImageOptimizer("Avifenc", QStringList{"png"}, ImageType::PNG, "avif"));
+  optimizers.append(ImageOptimizer("Cjxl", QStringList{"jpg", "jpeg"},
+                                   ImageType::JPG, "jxl"));
+
+  // No tool runs, for images that are optimized already
+  optimizers.append(ImageOptimizer("Metadata only", QStringList{"jpg", "jpeg"},
+                                   ImageType::JPG));
+  optimizers.append(
+      ImageOptimizer("Metadata only", QStringList{"png"}, ImageType::PNG));
+  optimizers.append(
+      ImageOptimizer("Metadata only", QStringList{"gif"}, ImageType::GIF));
+  optimizers.append(
+      ImageOptimizer("Metadata only", QStringList{"svg"}, ImageType::SVG));
+
   return optimizers;
 }
 
@@ -41,6 +76,110 @@ ImageWorkerFactory::getImageTypeByExtension(const QString &extension) {
   return ImageType::Unsupported;
 }
 
+ImageType ImageWorkerFactory::getImageType(const QString &filePath) {
+  ImageType byExtension =
+      getImageTypeByExtension(QFileInfo(filePath).suffix());
+
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    // Let the tool report why it can't read the file
+    return byExtension;
+  }
+  QByteArray header = file.read(SNIFF_BYTES);
+  if (header.isEmpty()) {
+    return byExtension;
+  }
+
+  ImageType byContent = getImageTypeByContent(header);
+  if (byContent == ImageType::Unsupported) {
+    // Binary formats have fixed signatures, not finding one means a format
+    // no tool handles. The prolog of an SVG may run past the sniffed bytes.
+    return byExtension == ImageType::SVG && header.size() == SNIFF_BYTES
+               ? byExtension
+               : ImageType::Unsupported;
+  }
+  if (byContent != byExtension && byExtension != ImageType::Unsupported) {
+    qDebug() << filePath << "is"
+             << ImageTypeUtils::imageTypeToString(byContent) << "content";
+  }
+  return byContent;
+}
+
+ImageType ImageWorkerFactory::getImageType(ImageTask *task) {
+  if (!task->imageTypeSniffed) {
+    task->imageType = getImageType(task->imagePath());
+    task->imageTypeSniffed = true;
+  }
+  return task->imageType;
+}
+
+ImageType ImageWorkerFactory::getImageTypeByContent(const QByteArray &header) {
+  if (header.startsWith("\xFF\xD8\xFF")) {
+    return ImageType::JPG;
+  }
+  if (header.startsWith("\x89PNG\r\n\x1A\n")) {
+    return ImageType::PNG;
+  }
+  if (header.startsWith("GIF87a") || header.startsWith("GIF89a")) {
+    return ImageType::GIF;
+  }
+
+  // XML, optionally after a UTF-8 BOM, whose first element is svg. Only
+  // the XML declaration, processing instructions, comments, a doctype and
+  // whitespace may come before it.
+  int pos = header.startsWith("\xEF\xBB\xBF") ? 3 : 0;
+  auto opensWith = [&header, &pos](const char *markup) {
+    return qstrncmp(header.constData() + pos, markup, qstrlen(markup)) == 0;
+  };
+  while (pos < header.size()) {
+    char c = header.at(pos);
+    if (QChar::isSpace(uchar(c))) {
+      ++pos;
+      continue;
+    }
+    if (c != '<') {
+      break;
+    }
+    int end = -1;
+    if (opensWith("<?")) {
+      end = header.indexOf("?>", pos + 2);
+      end = end < 0 ? -1 : end + 2;
+    } else if (opensWith("<!--")) {
+      end = header.indexOf("-->", pos + 4);
+      end = end < 0 ? -1 : end + 3;
+    } else if (opensWith("<!DOCTYPE")) {
+      // An internal subset ends with "]>"
+      int subset = header.indexOf('[', pos);
+      int close = header.indexOf('>', pos);
+      if (subset >= 0 && (close < 0 || subset < close)) {
+        end = header.indexOf("]>", subset);
+        end = end < 0 ? -1 : end + 2;
+      } else {
+        end = close < 0 ? -1 : close + 1;
+      }
+    } else {
+      // The root element, with or without a namespace prefix
+      int nameEnd = pos + 1;
+      while (nameEnd < header.size() &&
+             !QChar::isSpace(uchar(header.at(nameEnd))) &&
+             header.at(nameEnd) != '>' && header.at(nameEnd) != '/') {
+        ++nameEnd;
+      }
+      QByteArray name = header.mid(pos + 1, nameEnd - pos - 1);
+      int colon = name.indexOf(':');
+      if (nameEnd < header.size() && name.mid(colon + 1) == "svg") {
+        return ImageType::SVG;
+      }
+      break;
+    }
+    if (end < 0) {
+      break;
+    }
+    pos = end;
+  }
+  return ImageType::Unsupported;
+}
+
 ImageOptimizer ImageWorkerFactory::getOptimizerByImageType(ImageType imageType) {
   foreach (auto optimizer, registeredImageOptimizers) {
     if (optimizer.getImageType() == imageType) {
@@ -51,6 +190,17 @@ ImageOptimizer ImageWorkerFactory::getOptimizerByImageType(ImageType imageType)
   return ImageOptimizer("", QStringList{}, ImageType::Unsupported);
 }
 
+ImageOptimizer ImageWorkerFactory::getOptimizer(ImageType imageType,
+                                                const QString &name) {
+  foreach (auto optimizer, registeredImageOptimizers) {
+    if (optimizer.getImageType() == imageType &&
+        optimizer.getName() == name) {
+      return optimizer;
+    }
+  }
+  return getOptimizerByImageType(imageType);
+}
+
 QList<ImageOptimizer> ImageWorkerFactory::getRegisteredImageOptimizers() {
   return registeredImageOptimizers;
 }
@@ -74,11 +224,17 @@ ImageWorkerFactory::getOptimizersForFormat(const QString &formatName) {
 }
 
 ImageWorker *ImageWorkerFactory::getWorker(const QString &filePath) {
-  QFileInfo fileInfo(filePath);
-  QString ext = fileInfo.suffix().toLower();
-  ImageType type = getImageTypeByExtension(ext);
+  ImageType type = getImageType(filePath);
+  if (type == ImageType::Unsupported) {
+    QString name = QFileInfo(filePath).fileName();
+    qWarning() << "Unsupported file type: " + name;
+    throw std::runtime_error("Unsupported file type: " + name.toStdString());
+  }
+  return getWorker(type);
+}
 
-  switch (type) {
+ImageWorker *ImageWorkerFactory::getWorker(ImageType imageType) {
+  switch (imageType) {
   case ImageType::JPG: {
     return new JpegoptimWorker();
   }
@@ -93,7 +249,23 @@ ImageWorker *ImageWorkerFactory::getWorker(const QString &filePath) {
   }
   case ImageType::Unsupported:
   default:
-    qWarning() << "Unsupported file type: " + ext;
-    throw std::runtime_error("Unsupported file type: " + ext.toStdString());
+    qWarning() << "No worker for image type" << static_cast<int>(imageType);
+    throw std::runtime_error("Unsupported image type");
+  }
+}
+
+ImageWorker *ImageWorkerFactory::getWorker(const ImageOptimizer &optimizer) {
+  if (optimizer.getName() == "Cwebp") {
+    return new CwebpWorker();
+  }
+  if (optimizer.getName() == "Avifenc") {
+    return new AvifencWorker();
+  }
+  if (optimizer.getName() == "Cjxl") {
+    return new CjxlWorker();
+  }
+  if (optimizer.stripsMetadataOnly()) {
+    return new MetadataStripWorker();
   }
+  return getWorker(optimizer.getImageType());
 }
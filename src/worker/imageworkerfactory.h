@@ -4,6 +4,7 @@
 #include "ImageWorker.h"
 #include "imageoptimizer.h"
 #include "imagetype.h"
+#include <QByteArray>
 #include <QFileInfo>
 #include <QList>
 #include <QMap>
@@ -17,8 +18,20 @@ public:
   ImageWorkerFactory &operator=(const ImageWorkerFactory &) = delete;
 
   ImageWorker *getWorker(const QString &filePath);
+  ImageWorker *getWorker(ImageType imageType);
+  ImageWorker *getWorker(const ImageOptimizer &optimizer);
   ImageType getImageTypeByExtension(const QString &extension);
+  // From the first bytes of the file, the extension is only a fallback for
+  // unreadable files and SVGs with a long prolog
+  ImageType getImageType(const QString &filePath);
+  // Sniffed once and kept on the task
+  ImageType getImageType(ImageTask *task);
+  static ImageType getImageTypeByContent(const QByteArray &header);
+  // The in-format optimizer of the type
   ImageOptimizer getOptimizerByImageType(ImageType imageType);
+  // The optimizer of the type with that name, the in-format one when there
+  // is none, see Settings::getFormatOptimizer
+  ImageOptimizer getOptimizer(ImageType imageType, const QString &name);
   QList<ImageOptimizer> getOptimizersForFormat(const QString &formatName);
   QList<ImageOptimizer> getRegisteredImageOptimizers();
 
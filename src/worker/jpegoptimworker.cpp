@@ -57,7 +57,8 @@
  *     → --workers=N (parallel threads within jpegoptim)
  *
  * Note: jpegoptim operates in-place, so we copy the source to destination
- * first and optimize the copy.
+ * first and optimize the copy. With pipe I/O (task/pipe_io) the source is
+ * streamed through --stdin/--stdout instead and no copy is made.
  *
  * @brief JpegoptimWorker::JpegoptimWorker
  * @param parent
@@ -65,8 +66,8 @@
 JpegoptimWorker::JpegoptimWorker(QObject *parent) : ImageWorker(parent) {}
 
 void JpegoptimWorker::optimize(ImageTask *task) {
-  QString src = task->imagePath;
-  QString dst = task->optimizedPath;
+  QString src = task->imagePath();
+  QString dst = task->optimizedPath();
 
   // Ensure destination directory exists
   QFileInfo dstInfo(dst);
@@ -75,17 +76,41 @@ void JpegoptimWorker::optimize(ImageTask *task) {
     dstDir.mkpath(".");
   }
 
-  // Copy source to destination first
+  // Copy source to destination first, unless it is piped
   // jpegoptim operates in-place, so we work on the destination copy
+  bool pipes = usePipes();
   if (QFile::exists(dst)) {
     QFile::remove(dst);
   }
 
-  if (!QFile::copy(src, dst)) {
+  if (!pipes && !QFile::copy(src, dst)) {
     emit optimizationError(task, "Failed to copy file to destination");
     return;
   }
 
+  QStringList args = compiledArguments();
+
+  // Add the file to optimize (last argument)
+  if (pipes) {
+    args << "--stdin" << "--stdout";
+  } else {
+    args << "--" << dst;
+  }
+
+  // Debug output
+  qDebug() << "jpegoptim command:" << "jpegoptim" << args.join(" ");
+
+  // Execute the optimization
+  if (pipes) {
+    executePipedProcess("jpegoptim", args, task);
+  } else {
+    executeProcess("jpegoptim", args, task);
+  }
+}
+
+QStringList JpegoptimWorker::optionArguments() const {
+  bool pipes = usePipes();
+
   // Load settings (using getSetting which checks custom settings first, then falls back to global)
   // Quality settings
   int maxQuality = getSetting("jpegoptim/maxQuality", 100).toInt();
@@ -175,7 +200,7 @@ void JpegoptimWorker::optimize(ImageTask *task) {
   }
 
   // Preserve file timestamps
-  if (preserveTimes) {
+  if (preserveTimes && !pipes) {
     args << "--preserve";
   }
 
@@ -185,16 +210,9 @@ void JpegoptimWorker::optimize(ImageTask *task) {
   }
 
   // Max workers (parallel threads within jpegoptim)
-  if (maxWorkers > 1) {
+  if (maxWorkers > 1 && !pipes) {
     args << "--workers=" + QString::number(maxWorkers);
   }
 
-  // Add the file to optimize (last argument)
-  args << "--" << dst;
-
-  // Debug output
-  qDebug() << "jpegoptim command:" << "jpegoptim" << args.join(" ");
-
-  // Execute the optimization
-  executeProcess("jpegoptim", args, task);
+  return args;
 }
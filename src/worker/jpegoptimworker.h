@@ -10,6 +10,8 @@ public:
   JpegoptimWorker(QObject *parent = nullptr);
 
   void optimize(ImageTask *task) override;
+  QString toolName() const override { return "jpegoptim"; }
+  QStringList optionArguments() const override;
 };
 
 #endif // JPEGOPTIMWORKER_H
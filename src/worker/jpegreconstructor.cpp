@@ -0,0 +1,164 @@
+#include "jpegreconstructor.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QtEndian>
+
+namespace {
+
+// ISO/IEC 18181-2, the signature box every container starts with
+const QByteArray CONTAINER_SIGNATURE("\x00\x00\x00\x0CJXL \x0D\x0A\x87\x0A",
+                                     12);
+
+void setError(QString *errorString, const QString &error) {
+  if (errorString) {
+    *errorString = error;
+  }
+}
+
+bool runDjxl(const QString &jxlPath, const QString &jpegPath,
+             QString *errorString) {
+  QProcess process;
+  process.setProcessChannelMode(QProcess::MergedChannels);
+  process.start("djxl",
+                JpegReconstructor::restoreArguments(jxlPath, jpegPath));
+  if (!process.waitForStarted()) {
+    setError(errorString, QString("djxl could not be started: %1")
+                              .arg(process.errorString()));
+    return false;
+  }
+  process.waitForFinished(-1);
+  if (process.exitStatus() != QProcess::NormalExit ||
+      process.exitCode() != 0) {
+    QFile::remove(jpegPath);
+    setError(errorString,
+             QString("djxl failed: %1")
+                 .arg(QString::fromLocal8Bit(process.readAll()).trimmed()));
+    return false;
+  }
+  return true;
+}
+
+QByteArray sha256OfFile(const QString &filePath) {
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return QByteArray();
+  }
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+  hash.addData(&file);
+  return hash.result();
+}
+
+} // namespace
+
+bool JpegReconstructor::hasReconstructionData(const QString &jxlPath) {
+  QFile file(jxlPath);
+  if (!file.open(QIODevice::ReadOnly) ||
+      file.read(CONTAINER_SIGNATURE.size()) != CONTAINER_SIGNATURE) {
+    return false;
+  }
+
+  // Box headers only, the payloads are skipped
+  qint64 offset = CONTAINER_SIGNATURE.size();
+  while (offset + 8 <= file.size()) {
+    file.seek(offset);
+    QByteArray header = file.read(16);
+    if (header.size() < 8) {
+      return false;
+    }
+    quint64 boxSize = qFromBigEndian<quint32>(header.constData());
+    QByteArray type = header.mid(4, 4);
+    if (type == "jbrd") {
+      return true;
+    }
+
+    if (boxSize == 1) {
+      // 64 bit size after the type
+      if (header.size() < 16) {
+        return false;
+      }
+      boxSize = qFromBigEndian<quint64>(header.constData() + 8);
+    } else if (boxSize == 0) {
+      // Last box, up to the end of the file
+      return false;
+    }
+    if (boxSize < 8) {
+      return false;
+    }
+    offset += qint64(boxSize);
+  }
+  return false;
+}
+
+QString JpegReconstructor::defaultJpegPath(const QString &jxlPath) {
+  QFileInfo info(jxlPath);
+  return info.absoluteDir().filePath(info.completeBaseName() + ".jpg");
+}
+
+bool JpegReconstructor::restore(const QString &jxlPath,
+                                const QString &jpegPath,
+                                QString *errorString) {
+  if (!hasReconstructionData(jxlPath)) {
+    setError(errorString,
+             QString("%1 has no JPEG reconstruction data").arg(jxlPath));
+    return false;
+  }
+  if (QFileInfo::exists(jpegPath)) {
+    setError(errorString, QString("%1 already exists").arg(jpegPath));
+    return false;
+  }
+
+  QFileInfo jpegInfo(jpegPath);
+  QString partPath = jpegInfo.absoluteDir().filePath(
+      "." + jpegInfo.completeBaseName() + ".restoring.jpg");
+  QFile::remove(partPath);
+  if (!runDjxl(jxlPath, partPath, errorString)) {
+    return false;
+  }
+
+  // Only ever renamed to a .jpg when it is one
+  QFile part(partPath);
+  if (!part.open(QIODevice::ReadOnly) ||
+      !part.read(3).startsWith("\xFF\xD8\xFF")) {
+    QFile::remove(partPath);
+    setError(errorString, "djxl did not write a JPEG");
+    return false;
+  }
+  part.close();
+
+  if (!QFile::rename(partPath, jpegPath)) {
+    QFile::remove(partPath);
+    setError(errorString, QString("Could not write %1").arg(jpegPath));
+    return false;
+  }
+  qDebug() << "Restored" << jpegPath << "from" << jxlPath;
+  return true;
+}
+
+// djxl picks the output format by suffix, .jpg reconstructs
+QStringList JpegReconstructor::restoreArguments(const QString &jxlPath,
+                                                const QString &jpegPath) {
+  QStringList args;
+  args << "--quiet" << QFileInfo(jxlPath).absoluteFilePath() << jpegPath;
+  return args;
+}
+
+bool JpegReconstructor::sameContent(const QString &restoredPath,
+                                    const QString &jpegPath,
+                                    QString *errorString) {
+  // Sizes first, no need to hash files that differ anyway
+  QByteArray restoredHash;
+  if (QFileInfo(restoredPath).size() == QFileInfo(jpegPath).size()) {
+    restoredHash = sha256OfFile(restoredPath);
+  }
+  if (restoredHash.isEmpty() || restoredHash != sha256OfFile(jpegPath)) {
+    setError(errorString,
+             QString("the restored JPEG differs from %1").arg(jpegPath));
+    return false;
+  }
+  return true;
+}
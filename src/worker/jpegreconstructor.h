@@ -0,0 +1,43 @@
+#ifndef JPEGRECONSTRUCTOR_H
+#define JPEGRECONSTRUCTOR_H
+
+#include <QString>
+#include <QStringList>
+
+// Restores the original JPEG from a JPEG XL file it was transcoded to
+// losslessly (see CjxlWorker).
+//
+// cjxl stores the JPEG bitstream reconstruction data in a jbrd box of the
+// JPEG XL container, djxl rebuilds the exact original file from it and the
+// coefficients. A JPEG XL file without it could only be decoded to pixels
+// and encoded to JPEG again, so such files are refused rather than
+// restored lossily.
+class JpegReconstructor {
+public:
+  // Walks the container boxes, false for a bare codestream
+  static bool hasReconstructionData(const QString &jxlPath);
+
+  // Next to the JPEG XL file, photo.jxl gives photo.jpg
+  static QString defaultJpegPath(const QString &jxlPath);
+
+  // Runs djxl through a temporary file, an existing JPEG is never
+  // overwritten
+  static bool restore(const QString &jxlPath, const QString &jpegPath,
+                      QString *errorString = nullptr);
+
+  // djxl arguments writing the JPEG restored from jxlPath to jpegPath
+  static QStringList restoreArguments(const QString &jxlPath,
+                                      const QString &jpegPath);
+
+  // Compares the SHA-256 of a restored file with the original, true only
+  // when the round trip gave back the exact file. Reads both files, keep it
+  // off the GUI thread.
+  static bool sameContent(const QString &restoredPath,
+                          const QString &jpegPath,
+                          QString *errorString = nullptr);
+
+private:
+  JpegReconstructor() = delete;
+};
+
+#endif // JPEGRECONSTRUCTOR_H
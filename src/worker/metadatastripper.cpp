@@ -0,0 +1,510 @@
+#include "metadatastripper.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QLocale>
+#include <QObject>
+#include <QSaveFile>
+#include <QStringList>
+#include <QVector>
+#include <QXmlStreamReader>
+
+#include <climits>
+#include <cstring>
+
+namespace {
+
+// A part of the file to leave out, category < 0 parts are never stripped
+struct Removal {
+  qint64 offset;
+  qint64 length;
+  int category;
+};
+
+const int KEEP = -1;
+
+quint16 bigEndian16(const uchar *data) {
+  return quint16((data[0] << 8) | data[1]);
+}
+
+quint32 bigEndian32(const uchar *data) {
+  return (quint32(data[0]) << 24) | (quint32(data[1]) << 16) |
+         (quint32(data[2]) << 8) | quint32(data[3]);
+}
+
+// Identifier at the start of a segment, including its terminating NUL when
+// the identifier has one
+bool hasIdentifier(const uchar *data, qint64 size, const char *identifier,
+                   qint64 length) {
+  return size >= length && std::memcmp(data, identifier, size_t(length)) == 0;
+}
+
+int jpegCategory(uchar marker, const uchar *segment, qint64 length) {
+  switch (marker) {
+  case 0xE0:
+    // JFIF stays, its JFXX extension only holds a thumbnail
+    return hasIdentifier(segment, length, "JFXX\0", 5)
+               ? MetadataStripper::Thumbnail
+               : KEEP;
+  case 0xE1:
+    if (hasIdentifier(segment, length, "Exif\0", 5)) {
+      return MetadataStripper::Exif;
+    }
+    if (hasIdentifier(segment, length, "http://ns.adobe.com/", 20)) {
+      return MetadataStripper::Xmp; // XMP and extended XMP
+    }
+    return MetadataStripper::Other;
+  case 0xE2:
+    return hasIdentifier(segment, length, "ICC_PROFILE\0", 12)
+               ? MetadataStripper::Icc
+               : MetadataStripper::Other;
+  case 0xED:
+    return hasIdentifier(segment, length, "Photoshop 3.0\0", 14)
+               ? MetadataStripper::Iptc
+               : MetadataStripper::Other;
+  case 0xEE:
+    // Adobe tells RGB from YCbCr and CMYK from YCCK
+    return hasIdentifier(segment, length, "Adobe", 5)
+               ? KEEP
+               : MetadataStripper::Other;
+  case 0xFE:
+    return MetadataStripper::Comment;
+  default:
+    return marker >= 0xE3 && marker <= 0xEF ? MetadataStripper::Other
+                                             : KEEP;
+  }
+}
+
+QVector<Removal> jpegRemovals(const uchar *data, qint64 size) {
+  QVector<Removal> removals;
+  if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+    return removals;
+  }
+
+  qint64 pos = 2;
+  while (pos + 4 <= size) {
+    if (data[pos] != 0xFF) {
+      break;
+    }
+    uchar marker = data[pos + 1];
+    if (marker == 0xFF) {
+      ++pos;
+      continue;
+    }
+    qint64 start = pos;
+    pos += 2;
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+      continue;
+    }
+    // Everything from the first scan on is copied as is
+    if (marker == 0xD9 || marker == 0xDA) {
+      break;
+    }
+
+    quint16 length = bigEndian16(data + pos);
+    if (length < 2 || pos + length > size) {
+      break;
+    }
+    int category = jpegCategory(marker, data + pos + 2, length - 2);
+    if (category != KEEP) {
+      removals.append({start, 2 + qint64(length), category});
+    }
+    pos += length;
+  }
+  return removals;
+}
+
+QVector<Removal> pngRemovals(const uchar *data, qint64 size) {
+  QVector<Removal> removals;
+  if (size < 8 || std::memcmp(data, "\x89PNG\r\n\x1A\n", 8) != 0) {
+    return removals;
+  }
+
+  qint64 pos = 8;
+  while (pos + 12 <= size) {
+    quint32 length = bigEndian32(data + pos);
+    const uchar *type = data + pos + 4;
+    const uchar *payload = data + pos + 8;
+    qint64 chunkSize = 12 + qint64(length);
+    if (pos + chunkSize > size) {
+      break;
+    }
+
+    int category = KEEP;
+    if (std::memcmp(type, "tEXt", 4) == 0 ||
+        std::memcmp(type, "zTXt", 4) == 0) {
+      category = MetadataStripper::Text;
+    } else if (std::memcmp(type, "iTXt", 4) == 0) {
+      category = hasIdentifier(payload, length, "XML:com.adobe.xmp\0", 18)
+                     ? MetadataStripper::Xmp
+                     : MetadataStripper::Text;
+    } else if (std::memcmp(type, "iCCP", 4) == 0) {
+      category = MetadataStripper::Icc;
+    } else if (std::memcmp(type, "eXIf", 4) == 0) {
+      category = MetadataStripper::Exif;
+    } else if (std::memcmp(type, "tIME", 4) == 0) {
+      category = MetadataStripper::Other;
+    } else if (std::memcmp(type, "IEND", 4) == 0) {
+      break;
+    }
+    if (category != KEEP) {
+      removals.append({pos, chunkSize, category});
+    }
+    pos += chunkSize;
+  }
+  return removals;
+}
+
+// GIF data sub-blocks, returns the position after the terminator or -1 when
+// the file ends before it
+qint64 skipSubBlocks(const uchar *data, qint64 size, qint64 pos) {
+  while (pos < size) {
+    uchar blockSize = data[pos];
+    pos += 1 + blockSize;
+    if (blockSize == 0) {
+      return pos <= size ? pos : -1;
+    }
+  }
+  return -1;
+}
+
+QVector<Removal> gifRemovals(const uchar *data, qint64 size) {
+  QVector<Removal> removals;
+  if (size < 13 || (std::memcmp(data, "GIF87a", 6) != 0 &&
+                    std::memcmp(data, "GIF89a", 6) != 0)) {
+    return removals;
+  }
+
+  qint64 pos = 13;
+  if (data[10] & 0x80) {
+    pos += 3 * (1 << ((data[10] & 0x07) + 1));
+  }
+
+  while (pos > 0 && pos < size && data[pos] != 0x3B) {
+    if (data[pos] == 0x2C) {
+      if (pos + 10 > size) {
+        break;
+      }
+      uchar imageFlags = data[pos + 9];
+      pos += 10;
+      if (imageFlags & 0x80) {
+        pos += 3 * (1 << ((imageFlags & 0x07) + 1));
+      }
+      pos = skipSubBlocks(data, size, pos + 1);
+    } else if (data[pos] == 0x21 && pos + 2 <= size) {
+      qint64 start = pos;
+      uchar label = data[pos + 1];
+      int category = KEEP;
+      if (label == 0xFE) {
+        category = MetadataStripper::Comment;
+      } else if (label == 0xFF && pos + 14 <= size) {
+        const uchar *application = data + pos + 3;
+        if (std::memcmp(application, "XMP DataXMP", 11) == 0) {
+          category = MetadataStripper::Xmp;
+        } else if (std::memcmp(application, "ICCRGBG1012", 11) == 0) {
+          category = MetadataStripper::Icc;
+        } else if (std::memcmp(application, "NETSCAPE2.0", 11) != 0 &&
+                   std::memcmp(application, "ANIMEXTS1.0", 11) != 0) {
+          category = MetadataStripper::Other;
+        }
+      }
+      pos = skipSubBlocks(data, size, pos + 2);
+      if (pos > 0 && category != KEEP) {
+        removals.append({start, pos - start, category});
+      }
+    } else {
+      break;
+    }
+  }
+  return removals;
+}
+
+// QXmlStreamReader counts UTF-16 code units, removals are in bytes. Only
+// moves forward, as the reader does.
+class Utf8Offsets {
+public:
+  Utf8Offsets(const QByteArray &text, int start)
+      : m_text(text), m_byte(start), m_characters(0) {}
+
+  int byteOffset(qint64 characterOffset) {
+    while (m_characters < characterOffset && m_byte < m_text.size()) {
+      uchar lead = uchar(m_text.at(m_byte));
+      int length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+      m_characters += length == 4 ? 2 : 1;
+      m_byte += length;
+    }
+    return qMin(m_byte, m_text.size());
+  }
+
+private:
+  const QByteArray &m_text;
+  int m_byte;
+  qint64 m_characters;
+};
+
+// Comments outside style and script elements and metadata elements, as the
+// parser sees them, so markup in CDATA sections or attribute values is
+// never touched. Every span is checked against what the parser read, on a
+// mismatch or an unparsable file nothing is removed.
+QVector<Removal> svgRemovals(const uchar *data, qint64 size) {
+  QVector<Removal> removals;
+  if (size > INT_MAX) {
+    return removals;
+  }
+  const QByteArray text = QByteArray::fromRawData(
+      reinterpret_cast<const char *>(data), int(size));
+  int start = text.startsWith("\xEF\xBB\xBF") ? 3 : 0;
+
+  QXmlStreamReader reader(text.mid(start));
+  Utf8Offsets offsets(text, start);
+  QStringList elements;
+  int metadataStart = -1;
+  int metadataDepth = 0;
+  while (!reader.atEnd()) {
+    QXmlStreamReader::TokenType token = reader.readNext();
+    int end = offsets.byteOffset(reader.characterOffset());
+
+    switch (token) {
+    case QXmlStreamReader::StartDocument: {
+      QString encoding = reader.documentEncoding().toString();
+      if (!encoding.isEmpty() &&
+          encoding.compare("UTF-8", Qt::CaseInsensitive) != 0) {
+        return QVector<Removal>();
+      }
+      break;
+    }
+    case QXmlStreamReader::DTD:
+      // Entities expand into the parsed text, offsets don't add up then
+      if (!reader.entityDeclarations().isEmpty()) {
+        return QVector<Removal>();
+      }
+      break;
+    case QXmlStreamReader::Comment: {
+      QString parent = elements.isEmpty() ? QString() : elements.last();
+      if (metadataStart >= 0 || parent == "style" || parent == "script") {
+        break;
+      }
+      int commentEnd = text.lastIndexOf("-->", end - 3);
+      int commentStart =
+          commentEnd >= 0 ? text.lastIndexOf("<!--", commentEnd) : -1;
+      if (commentStart < 0) {
+        return QVector<Removal>();
+      }
+      // The parser reads line breaks as \n
+      QString raw = QString::fromUtf8(
+          text.mid(commentStart + 4, commentEnd - commentStart - 4));
+      raw.replace("\r\n", "\n").replace('\r', '\n');
+      if (raw != reader.text()) {
+        return QVector<Removal>();
+      }
+      removals.append({commentStart, commentEnd + 3 - commentStart,
+                       MetadataStripper::Comment});
+      break;
+    }
+    case QXmlStreamReader::StartElement: {
+      QString name = reader.name().toString();
+      elements.append(name);
+      if (metadataStart >= 0) {
+        ++metadataDepth;
+      } else if (name == "metadata") {
+        QByteArray tag = "<" + reader.qualifiedName().toUtf8();
+        metadataStart = text.lastIndexOf(tag, end - 1);
+        if (metadataStart < 0) {
+          return QVector<Removal>();
+        }
+      }
+      break;
+    }
+    case QXmlStreamReader::EndElement:
+      elements.removeLast();
+      if (metadataStart >= 0 && metadataDepth-- == 0) {
+        QByteArray tag = "</" + reader.qualifiedName().toUtf8();
+        int closing = text.lastIndexOf(tag, end - 1);
+        int metadataEnd = closing > metadataStart
+                              ? text.indexOf('>', closing) + 1
+                              : text.lastIndexOf("/>", end - 2) + 2;
+        if (metadataEnd <= metadataStart) {
+          return QVector<Removal>();
+        }
+        removals.append({metadataStart, metadataEnd - metadataStart,
+                         MetadataStripper::Xmp});
+        metadataStart = -1;
+        metadataDepth = 0;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  if (reader.hasError()) {
+    return QVector<Removal>();
+  }
+  return removals;
+}
+
+} // namespace
+
+qint64 MetadataStripper::Result::total() const {
+  qint64 sum = 0;
+  for (qint64 bytes : removedBytes) {
+    sum += bytes;
+  }
+  return sum;
+}
+
+QString MetadataStripper::Result::toString() const {
+  QStringList parts;
+  QLocale locale;
+  for (int category = 0; category < CategoryCount; ++category) {
+    if (removedBytes[category] > 0) {
+      parts << QString("%1 %2").arg(
+          categoryToString(Category(category)),
+          locale.formattedDataSize(removedBytes[category]));
+    }
+  }
+  return parts.join(", ");
+}
+
+MetadataStripper::Result &
+MetadataStripper::Result::operator+=(const Result &other) {
+  for (int category = 0; category < CategoryCount; ++category) {
+    removedBytes[category] += other.removedBytes[category];
+  }
+  return *this;
+}
+
+MetadataStripper::Mode MetadataStripper::modeFromInt(int mode) {
+  if (mode < Off || mode > KeepExifAndIcc) {
+    return Off;
+  }
+  return static_cast<Mode>(mode);
+}
+
+bool MetadataStripper::keeps(Mode mode, Category category) {
+  switch (mode) {
+  case Off:
+    return true;
+  case KeepExif:
+    return category == Exif;
+  case KeepIcc:
+    return category == Icc;
+  case KeepExifAndIcc:
+    return category == Exif || category == Icc;
+  default:
+    return false;
+  }
+}
+
+QString MetadataStripper::categoryToString(Category category) {
+  switch (category) {
+  case Exif:
+    return "EXIF";
+  case Xmp:
+    return "XMP";
+  case Icc:
+    return "ICC";
+  case Iptc:
+    return "IPTC";
+  case Thumbnail:
+    return QObject::tr("Thumbnail");
+  case Comment:
+    return QObject::tr("Comments");
+  case Text:
+    return QObject::tr("Text");
+  default:
+    return QObject::tr("Other");
+  }
+}
+
+bool MetadataStripper::strip(const QString &imagePath, ImageType imageType,
+                             Mode mode, Result *result,
+                             QString *errorString) {
+  return strip(imagePath, imagePath, imageType, mode, result, errorString);
+}
+
+bool MetadataStripper::strip(const QString &imagePath,
+                             const QString &outputPath, ImageType imageType,
+                             Mode mode, Result *result,
+                             QString *errorString) {
+  *result = Result();
+  bool inPlace = outputPath == imagePath;
+  if (mode == Off && inPlace) {
+    return true;
+  }
+
+  QFile source(imagePath);
+  if (!source.open(QIODevice::ReadOnly)) {
+    if (errorString) {
+      *errorString = source.errorString();
+    }
+    return false;
+  }
+  qint64 size = source.size();
+  QByteArray buffer;
+  uchar *mapped = size > 0 ? source.map(0, size) : nullptr;
+  const uchar *data = mapped;
+  if (!data) {
+    buffer = source.readAll();
+    data = reinterpret_cast<const uchar *>(buffer.constData());
+    size = buffer.size();
+  }
+
+  QVector<Removal> removals;
+  switch (imageType) {
+  case ImageType::JPG:
+    removals = jpegRemovals(data, size);
+    break;
+  case ImageType::PNG:
+    removals = pngRemovals(data, size);
+    break;
+  case ImageType::GIF:
+    removals = gifRemovals(data, size);
+    break;
+  case ImageType::SVG:
+    removals = svgRemovals(data, size);
+    break;
+  default:
+    break;
+  }
+
+  QVector<Removal> stripped;
+  for (const Removal &removal : qAsConst(removals)) {
+    if (!keeps(mode, Category(removal.category))) {
+      stripped.append(removal);
+    }
+  }
+  if (stripped.isEmpty() && inPlace) {
+    return true;
+  }
+
+  // Spans between the removals, straight from the mapping
+  QSaveFile output(outputPath);
+  if (!output.open(QIODevice::WriteOnly)) {
+    if (errorString) {
+      *errorString = output.errorString();
+    }
+    return false;
+  }
+  qint64 pos = 0;
+  for (const Removal &removal : qAsConst(stripped)) {
+    output.write(reinterpret_cast<const char *>(data) + pos,
+                 removal.offset - pos);
+    pos = removal.offset + removal.length;
+    result->removedBytes[removal.category] += removal.length;
+  }
+  output.write(reinterpret_cast<const char *>(data) + pos, size - pos);
+
+  // Some platforms can't replace a file that is still open
+  if (mapped) {
+    source.unmap(mapped);
+  }
+  source.close();
+  if (!output.commit()) {
+    *result = Result();
+    if (errorString) {
+      *errorString = output.errorString();
+    }
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,63 @@
+#ifndef METADATASTRIPPER_H
+#define METADATASTRIPPER_H
+
+#include <imagetype.h>
+
+#include <QString>
+
+// Removes metadata from an image without decoding or re-encoding it.
+//
+// The file is walked like ImageHeader does and copied without the
+// segments, chunks or blocks to strip: JPEG APPn and COM segments (the
+// JFIF and Adobe APP0/APP14 ones are needed to read the image and always
+// stay), PNG text, iCCP, eXIf and tIME chunks, GIF comment and application
+// extensions (the looping ones stay), SVG metadata elements and comments
+// (the parsed ones outside style and script elements).
+// Image data is copied as is, so the result is identical to look at, apart
+// from the color profile when it is not kept. The bytes removed are
+// counted per category.
+class MetadataStripper {
+public:
+  // Stored as int in Constants::TASK_STRIP_METADATA_KEY
+  enum Mode { Off, StripAll, KeepExif, KeepIcc, KeepExifAndIcc };
+
+  enum Category {
+    Exif,
+    Xmp,
+    Icc,
+    Iptc,
+    Thumbnail,
+    Comment,
+    Text,
+    Other,
+    CategoryCount
+  };
+
+  struct Result {
+    qint64 removedBytes[CategoryCount] = {};
+
+    qint64 total() const;
+    // e.g. "EXIF 12 KB, XMP 3 KB", empty when nothing was removed
+    QString toString() const;
+    Result &operator+=(const Result &other);
+  };
+
+  static Mode modeFromInt(int mode);
+  static bool keeps(Mode mode, Category category);
+  static QString categoryToString(Category category);
+
+  // Rewrites the file in place, through a temporary file so a linked
+  // original is never touched. Left alone when there is nothing to strip.
+  static bool strip(const QString &imagePath, ImageType imageType, Mode mode,
+                    Result *result, QString *errorString = nullptr);
+  // Writes the stripped image to outputPath, a plain copy when there is
+  // nothing to strip
+  static bool strip(const QString &imagePath, const QString &outputPath,
+                    ImageType imageType, Mode mode, Result *result,
+                    QString *errorString = nullptr);
+
+private:
+  MetadataStripper() = delete;
+};
+
+#endif // METADATASTRIPPER_H
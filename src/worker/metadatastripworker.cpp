@@ -0,0 +1,161 @@
+#include "metadatastripworker.h"
+#include "imageworkerfactory.h"
+
+#include <constants.h>
+
+#include <QMetaObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <functional>
+
+// Cleared by the worker when it goes away, the job delivers while holding
+// the mutex so it never posts to a deleted worker
+struct MetadataStripWorker::JobState {
+  QMutex mutex;
+  MetadataStripWorker *receiver;
+};
+
+namespace {
+
+class StripJob : public QRunnable {
+public:
+  typedef std::function<void(bool, const MetadataStripper::Result &,
+                             const QString &)>
+      Deliver;
+
+  StripJob(std::shared_ptr<MetadataStripWorker::JobState> state,
+           const QString &sourcePath, const QString &outputPath,
+           ImageType imageType, MetadataStripper::Mode mode, Deliver deliver)
+      : m_state(state), m_sourcePath(sourcePath), m_outputPath(outputPath),
+        m_imageType(imageType), m_mode(mode), m_deliver(deliver) {}
+
+  void run() override {
+    MetadataStripper::Result result;
+    QString errorString;
+    bool success = MetadataStripper::strip(m_sourcePath, m_outputPath,
+                                           m_imageType, m_mode, &result,
+                                           &errorString);
+
+    QMutexLocker locker(&m_state->mutex);
+    if (!m_state->receiver) {
+      return;
+    }
+    auto deliver = m_deliver;
+    QMetaObject::invokeMethod(
+        m_state->receiver,
+        [deliver, success, result, errorString]() {
+          deliver(success, result, errorString);
+        },
+        Qt::QueuedConnection);
+  }
+
+private:
+  std::shared_ptr<MetadataStripWorker::JobState> m_state;
+  QString m_sourcePath;
+  QString m_outputPath;
+  ImageType m_imageType;
+  MetadataStripper::Mode m_mode;
+  Deliver m_deliver;
+};
+
+} // namespace
+
+MetadataStripWorker::MetadataStripWorker(ImageWorker *worker, QObject *parent)
+    : ImageWorker(parent), m_worker(worker), m_task(nullptr) {
+  if (!m_worker) {
+    return;
+  }
+  m_worker->setParent(this);
+  connect(m_worker, &ImageWorker::optimizationFinished, this,
+          [this](ImageTask *task, bool success) {
+            if (!success || !QFileInfo::exists(task->optimizedPath())) {
+              emit optimizationFinished(task, success);
+              return;
+            }
+            ImageType imageType =
+                ImageWorkerFactory::instance().getImageType(task);
+            if (ImageWorkerFactory::instance()
+                    .getOptimizer(imageType, formatOptimizerName(imageType))
+                    .convertsFormat()) {
+              emit optimizationFinished(task, true);
+              return;
+            }
+            strip(task, task->optimizedPath());
+          });
+  connect(m_worker, &ImageWorker::optimizationError, this,
+          &ImageWorker::optimizationError);
+}
+
+MetadataStripWorker::~MetadataStripWorker() {
+  if (m_state) {
+    QMutexLocker locker(&m_state->mutex);
+    m_state->receiver = nullptr;
+  }
+  if (m_worker) {
+    disconnect(m_worker, nullptr, this, nullptr);
+    delete m_worker;
+  }
+}
+
+void MetadataStripWorker::optimize(ImageTask *task) {
+  m_task = task;
+  task->metadataBytesRemoved = 0;
+  if (!m_worker) {
+    strip(task, task->imagePath());
+    return;
+  }
+  m_worker->setCustomSettings(m_customSettings);
+  m_worker->setSnapshot(m_snapshot);
+  m_worker->setBackground(m_background);
+  m_worker->optimize(task);
+}
+
+void MetadataStripWorker::strip(ImageTask *task, const QString &sourcePath) {
+  m_task = task;
+  MetadataStripper::Mode mode = MetadataStripper::modeFromInt(
+      getSetting(Constants::TASK_STRIP_METADATA_KEY,
+                 Constants::DEFAULT_TASK_STRIP_METADATA)
+          .toInt());
+  // Picked as the optimizer, stripping is all there is to do
+  if (!m_worker && mode == MetadataStripper::Off) {
+    mode = MetadataStripper::StripAll;
+  }
+
+  if (m_state) {
+    QMutexLocker locker(&m_state->mutex);
+    m_state->receiver = nullptr;
+  }
+  m_state = std::make_shared<JobState>();
+  m_state->receiver = this;
+  QThreadPool::globalInstance()->start(new StripJob(
+      m_state, sourcePath, task->optimizedPath(),
+      ImageWorkerFactory::instance().getImageType(task), mode,
+      [this](bool success, const MetadataStripper::Result &result,
+             const QString &errorString) {
+        onStripped(success, result, errorString);
+      }));
+}
+
+void MetadataStripWorker::onStripped(bool success,
+                                     const MetadataStripper::Result &result,
+                                     const QString &errorString) {
+  if (!success) {
+    if (!m_worker) {
+      emit optimizationError(
+          m_task, tr("Unable to strip metadata: %1").arg(errorString));
+      return;
+    }
+    // The output is still what the optimizer wrote
+    qWarning() << "Unable to strip metadata from" << m_task->optimizedPath()
+               << ":" << errorString;
+    emit optimizationFinished(m_task, true);
+    return;
+  }
+
+  m_task->metadataBytesRemoved = result.total();
+  emit metadataStripped(m_task, result);
+  emit optimizationFinished(m_task, true);
+}
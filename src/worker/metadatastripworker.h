@@ -0,0 +1,47 @@
+#ifndef METADATASTRIPWORKER_H
+#define METADATASTRIPWORKER_H
+
+#include "ImageWorker.h"
+#include "metadatastripper.h"
+
+#include <memory>
+
+// Strips metadata with MetadataStripper on a pool thread.
+//
+// Wrapping a worker, it strips what that worker wrote to the output before
+// reporting the task finished, so the commit policy sees the stripped size.
+// Conversions keep what their own settings say. Without a worker it is the
+// "Metadata only" optimizer of a format: the original is copied to the
+// output without its metadata and no tool runs, the cheap way to shrink
+// images that are optimized already. Nothing waits for the job, it delivers
+// nothing once the worker is gone.
+class MetadataStripWorker : public ImageWorker {
+  Q_OBJECT
+
+public:
+  // Takes ownership of worker, nullptr strips the original into the output
+  explicit MetadataStripWorker(ImageWorker *worker = nullptr,
+                               QObject *parent = nullptr);
+  ~MetadataStripWorker();
+
+  void optimize(ImageTask *task) override;
+
+  // Shared with the strip job, which may outlive us
+  struct JobState;
+
+signals:
+  // Also stored as the total in ImageTask::metadataBytesRemoved
+  void metadataStripped(ImageTask *task,
+                        const MetadataStripper::Result &result);
+
+private:
+  void strip(ImageTask *task, const QString &sourcePath);
+  void onStripped(bool success, const MetadataStripper::Result &result,
+                  const QString &errorString);
+
+  ImageWorker *m_worker;
+  ImageTask *m_task;
+  std::shared_ptr<JobState> m_state;
+};
+
+#endif // METADATASTRIPWORKER_H
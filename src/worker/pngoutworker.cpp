@@ -9,8 +9,8 @@ PngoutWorker::PngoutWorker(bool copyChunks, int strategy, QObject *parent)
     : ImageWorker(parent), copyChunks(copyChunks), strategy(strategy) {}
 
 void PngoutWorker::optimize(ImageTask *task) {
-    QString src = task->imagePath;
-    QString dst = task->optimizedPath;
+    QString src = task->imagePath();
+    QString dst = task->optimizedPath();
 
     QStringList args;
     args << "-k" + QString::number(copyChunks ? 1 : 0)
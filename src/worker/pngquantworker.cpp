@@ -47,6 +47,7 @@
  * Additional Options:
  *   - pngquant/stripMetadata (default: true) → --strip
  *   - pngquant/skipIfLarger (default: true) → --skip-if-larger
+ *     (not passed with pipe I/O, the source is kept when not smaller anyway)
  *   - pngquant/force (default: true) → --force
  *
  * @brief PngquantWorker::PngquantWorker
@@ -57,8 +58,8 @@ PngquantWorker::PngquantWorker(QObject *parent)
     : ImageWorker(parent) {}
 
 void PngquantWorker::optimize(ImageTask *task) {
-    QString src = task->imagePath;
-    QString dst = task->optimizedPath;
+    QString src = task->imagePath();
+    QString dst = task->optimizedPath();
 
     // Ensure destination directory exists
     QFileInfo dstInfo(dst);
@@ -74,6 +75,29 @@ void PngquantWorker::optimize(ImageTask *task) {
         QFile::remove(dst);
     }
 
+    bool pipes = usePipes();
+    QStringList args = compiledArguments();
+
+    // Output file, stdout when reading from stdin
+    if (!pipes) {
+        args << "--output=" + dst;
+    }
+
+    // Separator and source file
+    args << "--" << (pipes ? QString("-") : src);
+
+    // Debug output
+    qDebug() << "pngquant command:" << "pngquant" << args.join(" ");
+
+    // Execute the optimization
+    if (pipes) {
+        executePipedProcess("pngquant", args, task);
+    } else {
+        executeProcess("pngquant", args, task);
+    }
+}
+
+QStringList PngquantWorker::optionArguments() const {
     // Load settings (using getSetting which checks custom settings first, then falls back to global)
     int qualityMin = getSetting("pngquant/qualityMin", 65).toInt();
     int qualityMax = getSetting("pngquant/qualityMax", 80).toInt();
@@ -82,6 +106,8 @@ void PngquantWorker::optimize(ImageTask *task) {
     int posterize = getSetting("pngquant/posterize", 0).toInt();
     bool stripMetadata = getSetting("pngquant/stripMetadata", true).toBool();
     bool skipIfLarger = getSetting("pngquant/skipIfLarger", true).toBool();
+    bool force = getSetting("pngquant/force", true).toBool();
+    bool pipes = usePipes();
 
     // Build arguments
     QStringList args;
@@ -92,9 +118,6 @@ void PngquantWorker::optimize(ImageTask *task) {
     // Speed setting (1-11)
     args << "--speed=" + QString::number(speed);
 
-    // Output file
-    args << "--output=" + dst;
-
     // Force overwrite
     if (force) {
         args << "--force";
@@ -106,7 +129,7 @@ void PngquantWorker::optimize(ImageTask *task) {
     }
 
     // Skip if larger
-    if (skipIfLarger) {
+    if (skipIfLarger && !pipes) {
         args << "--skip-if-larger";
     }
 
@@ -120,15 +143,5 @@ void PngquantWorker::optimize(ImageTask *task) {
         args << "--posterize=" + QString::number(posterize);
     }
 
-    // Separator and source file
-    args << "--" << src;
-
-    // Debug output
-    qDebug() << "pngquant command:" << "pngquant" << args.join(" ");
-
-    // Execute the optimization
-    executeProcess("pngquant", args, task);
+    return args;
 }
-
-
-
@@ -10,6 +10,8 @@ public:
   explicit PngquantWorker(QObject *parent = nullptr);
 
   void optimize(ImageTask *task) override;
+  QString toolName() const override { return "pngquant"; }
+  QStringList optionArguments() const override;
 };
 
 #endif // PNGQUANTWORKER_H
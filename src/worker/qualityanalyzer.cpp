@@ -0,0 +1,85 @@
+#include "qualityanalyzer.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QRunnable>
+#include <QThread>
+
+namespace {
+
+class QualityAnalysisJob : public QRunnable {
+public:
+  QualityAnalysisJob(QualityAnalyzer *analyzer,
+                     std::shared_ptr<QAtomicInteger<quint64>> generation,
+                     ImageTask *task)
+      : m_analyzer(analyzer), m_generation(generation),
+        m_requestGeneration(generation->loadAcquire()), m_task(task),
+        m_imagePath(task->imagePath()), m_optimizedPath(task->optimizedPath()) {}
+
+  void run() override {
+    if (isStale()) {
+      return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QString errorString;
+    QualityMetrics::Result result =
+        QualityMetrics::compare(m_imagePath, m_optimizedPath, &errorString);
+
+    qDebug() << "Quality metrics for" << m_imagePath << "took"
+             << timer.elapsed() << "ms using"
+             << QualityMetrics::instructionSet();
+
+    if (isStale()) {
+      return;
+    }
+
+    QualityAnalyzer *analyzer = m_analyzer;
+    ImageTask *task = m_task;
+    QMetaObject::invokeMethod(
+        analyzer,
+        [analyzer, task, result, errorString]() {
+          emit analyzer->analysisFinished(task, result, errorString);
+        },
+        Qt::QueuedConnection);
+  }
+
+private:
+  bool isStale() const {
+    return m_generation->loadAcquire() != m_requestGeneration;
+  }
+
+  QualityAnalyzer *m_analyzer;
+  std::shared_ptr<QAtomicInteger<quint64>> m_generation;
+  quint64 m_requestGeneration;
+  ImageTask *m_task;
+  QString m_imagePath;
+  QString m_optimizedPath;
+};
+
+} // namespace
+
+QualityAnalyzer::QualityAnalyzer(QObject *parent)
+    : QObject(parent),
+      m_generation(std::make_shared<QAtomicInteger<quint64>>(0)) {
+  // Metrics are CPU bound, leave room for the optimizer processes
+  m_threadPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+QualityAnalyzer::~QualityAnalyzer() {
+  cancel();
+  // Jobs hold a raw pointer to us, make sure none outlives the analyzer
+  m_threadPool.waitForDone();
+}
+
+void QualityAnalyzer::analyze(ImageTask *task) {
+  m_threadPool.start(new QualityAnalysisJob(this, m_generation, task));
+}
+
+void QualityAnalyzer::cancel() {
+  m_threadPool.clear();
+  m_generation->fetchAndAddOrdered(1);
+}
@@ -0,0 +1,37 @@
+#ifndef QUALITYANALYZER_H
+#define QUALITYANALYZER_H
+
+#include "qualitymetrics.h"
+
+#include <QAtomicInteger>
+#include <QObject>
+#include <QThreadPool>
+#include <imagetask.h>
+
+#include <memory>
+
+// Runs QualityMetrics for optimized images on a thread pool.
+//
+// Jobs only take copies of the paths, the task pointer is handed back
+// untouched with the result, so the receiver has to check that the task is
+// still alive. cancel() drops queued jobs and discards running ones.
+class QualityAnalyzer : public QObject {
+  Q_OBJECT
+
+public:
+  explicit QualityAnalyzer(QObject *parent = nullptr);
+  ~QualityAnalyzer();
+
+  void analyze(ImageTask *task);
+  void cancel();
+
+signals:
+  void analysisFinished(ImageTask *task, const QualityMetrics::Result &result,
+                        const QString &errorString);
+
+private:
+  QThreadPool m_threadPool;
+  std::shared_ptr<QAtomicInteger<quint64>> m_generation;
+};
+
+#endif // QUALITYANALYZER_H
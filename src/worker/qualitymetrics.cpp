@@ -0,0 +1,675 @@
+#include "qualitymetrics.h"
+
+#include <QImageReader>
+#include <QObject>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define QUALITYMETRICS_X86
+#endif
+
+namespace {
+
+const int WINDOW_SIZE = 11;
+const double WINDOW_SIGMA = 1.5;
+
+// Stabilizing constants for 8 bit data, (K * L)^2 with K1 = 0.01, K2 = 0.03
+const float SSIM_C1 = (0.01f * 255.0f) * (0.01f * 255.0f);
+const float SSIM_C2 = (0.03f * 255.0f) * (0.03f * 255.0f);
+
+const int MS_SSIM_SCALES = 5;
+const double MS_SSIM_WEIGHTS[MS_SSIM_SCALES] = {0.0448, 0.2856, 0.3001,
+                                                0.2363, 0.1333};
+
+// Normalized 1D Gaussian, the 2D window is applied as two separable passes
+const float *gaussianWindow() {
+  static const std::vector<float> window = []() {
+    std::vector<float> weights(WINDOW_SIZE);
+    double sum = 0.0;
+    for (int i = 0; i < WINDOW_SIZE; ++i) {
+      double offset = i - WINDOW_SIZE / 2;
+      weights[i] = float(
+          std::exp(-(offset * offset) / (2.0 * WINDOW_SIGMA * WINDOW_SIGMA)));
+      sum += weights[i];
+    }
+    for (float &weight : weights) {
+      weight = float(weight / sum);
+    }
+    return weights;
+  }();
+  return window.data();
+}
+
+struct Kernels {
+  const char *name;
+  double (*squaredError)(const float *a, const float *b, int count);
+  void (*multiply)(const float *a, const float *b, float *dst, int count);
+  // dst[x] = sum(src[x + k] * weights[k]) over the window
+  void (*horizontalBlur)(const float *src, float *dst, int outWidth,
+                         const float *weights);
+  // dst[x] = sum(rows[k][x] * weights[k]) over the window
+  void (*verticalBlur)(const float *const *rows, float *dst, int width,
+                       const float *weights);
+  // Adds the SSIM and contrast-structure values of one row of local stats
+  void (*ssimRow)(const float *mu1, const float *mu2, const float *sigma11,
+                  const float *sigma22, const float *sigma12, int count,
+                  double *ssimSum, double *csSum);
+};
+
+// Scalar
+
+double squaredErrorScalar(const float *a, const float *b, int count) {
+  double sum = 0.0;
+  for (int i = 0; i < count; ++i) {
+    double difference = double(a[i]) - b[i];
+    sum += difference * difference;
+  }
+  return sum;
+}
+
+void multiplyScalar(const float *a, const float *b, float *dst, int count) {
+  for (int i = 0; i < count; ++i) {
+    dst[i] = a[i] * b[i];
+  }
+}
+
+void horizontalBlurScalar(const float *src, float *dst, int outWidth,
+                          const float *weights) {
+  for (int x = 0; x < outWidth; ++x) {
+    float sum = 0.0f;
+    for (int k = 0; k < WINDOW_SIZE; ++k) {
+      sum += src[x + k] * weights[k];
+    }
+    dst[x] = sum;
+  }
+}
+
+void verticalBlurScalar(const float *const *rows, float *dst, int width,
+                        const float *weights) {
+  for (int x = 0; x < width; ++x) {
+    float sum = 0.0f;
+    for (int k = 0; k < WINDOW_SIZE; ++k) {
+      sum += rows[k][x] * weights[k];
+    }
+    dst[x] = sum;
+  }
+}
+
+inline void ssimPixel(float mu1, float mu2, float sigma11, float sigma22,
+                      float sigma12, float *ssim, float *cs) {
+  float mu11 = mu1 * mu1;
+  float mu22 = mu2 * mu2;
+  float mu12 = mu1 * mu2;
+  float contrastStructure = (2.0f * (sigma12 - mu12) + SSIM_C2) /
+                            ((sigma11 - mu11) + (sigma22 - mu22) + SSIM_C2);
+  float luminance = (2.0f * mu12 + SSIM_C1) / (mu11 + mu22 + SSIM_C1);
+  *ssim = luminance * contrastStructure;
+  *cs = contrastStructure;
+}
+
+void ssimRowScalar(const float *mu1, const float *mu2, const float *sigma11,
+                   const float *sigma22, const float *sigma12, int count,
+                   double *ssimSum, double *csSum) {
+  double ssimRow = 0.0;
+  double csRow = 0.0;
+  for (int x = 0; x < count; ++x) {
+    float ssim, cs;
+    ssimPixel(mu1[x], mu2[x], sigma11[x], sigma22[x], sigma12[x], &ssim, &cs);
+    ssimRow += ssim;
+    csRow += cs;
+  }
+  *ssimSum += ssimRow;
+  *csSum += csRow;
+}
+
+const Kernels SCALAR_KERNELS = {"scalar",         squaredErrorScalar,
+                                multiplyScalar,   horizontalBlurScalar,
+                                verticalBlurScalar, ssimRowScalar};
+
+#if defined(QUALITYMETRICS_X86) && defined(__SSE2__)
+
+// SSE2, baseline on x86-64
+
+inline float horizontalSum(__m128 v) {
+  __m128 high = _mm_movehl_ps(v, v);
+  __m128 sum = _mm_add_ps(v, high);
+  high = _mm_shuffle_ps(sum, sum, 0x1);
+  return _mm_cvtss_f32(_mm_add_ss(sum, high));
+}
+
+double squaredErrorSse2(const float *a, const float *b, int count) {
+  __m128 accumulator = _mm_setzero_ps();
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 difference = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+    accumulator = _mm_add_ps(accumulator, _mm_mul_ps(difference, difference));
+  }
+  return horizontalSum(accumulator) +
+         squaredErrorScalar(a + i, b + i, count - i);
+}
+
+void multiplySse2(const float *a, const float *b, float *dst, int count) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(dst + i,
+                  _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
+  multiplyScalar(a + i, b + i, dst + i, count - i);
+}
+
+void horizontalBlurSse2(const float *src, float *dst, int outWidth,
+                        const float *weights) {
+  int x = 0;
+  for (; x + 4 <= outWidth; x += 4) {
+    __m128 sum = _mm_mul_ps(_mm_loadu_ps(src + x), _mm_set1_ps(weights[0]));
+    for (int k = 1; k < WINDOW_SIZE; ++k) {
+      sum = _mm_add_ps(
+          sum, _mm_mul_ps(_mm_loadu_ps(src + x + k), _mm_set1_ps(weights[k])));
+    }
+    _mm_storeu_ps(dst + x, sum);
+  }
+  horizontalBlurScalar(src + x, dst + x, outWidth - x, weights);
+}
+
+void verticalBlurSse2(const float *const *rows, float *dst, int width,
+                      const float *weights) {
+  int x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128 sum = _mm_mul_ps(_mm_loadu_ps(rows[0] + x), _mm_set1_ps(weights[0]));
+    for (int k = 1; k < WINDOW_SIZE; ++k) {
+      sum = _mm_add_ps(
+          sum, _mm_mul_ps(_mm_loadu_ps(rows[k] + x), _mm_set1_ps(weights[k])));
+    }
+    _mm_storeu_ps(dst + x, sum);
+  }
+  for (; x < width; ++x) {
+    float sum = 0.0f;
+    for (int k = 0; k < WINDOW_SIZE; ++k) {
+      sum += rows[k][x] * weights[k];
+    }
+    dst[x] = sum;
+  }
+}
+
+void ssimRowSse2(const float *mu1, const float *mu2, const float *sigma11,
+                 const float *sigma22, const float *sigma12, int count,
+                 double *ssimSum, double *csSum) {
+  const __m128 c1 = _mm_set1_ps(SSIM_C1);
+  const __m128 c2 = _mm_set1_ps(SSIM_C2);
+  const __m128 two = _mm_set1_ps(2.0f);
+  __m128 ssimAccumulator = _mm_setzero_ps();
+  __m128 csAccumulator = _mm_setzero_ps();
+
+  int x = 0;
+  for (; x + 4 <= count; x += 4) {
+    __m128 m1 = _mm_loadu_ps(mu1 + x);
+    __m128 m2 = _mm_loadu_ps(mu2 + x);
+    __m128 m11 = _mm_mul_ps(m1, m1);
+    __m128 m22 = _mm_mul_ps(m2, m2);
+    __m128 m12 = _mm_mul_ps(m1, m2);
+    __m128 s11 = _mm_sub_ps(_mm_loadu_ps(sigma11 + x), m11);
+    __m128 s22 = _mm_sub_ps(_mm_loadu_ps(sigma22 + x), m22);
+    __m128 s12 = _mm_sub_ps(_mm_loadu_ps(sigma12 + x), m12);
+
+    __m128 cs = _mm_div_ps(_mm_add_ps(_mm_mul_ps(two, s12), c2),
+                           _mm_add_ps(_mm_add_ps(s11, s22), c2));
+    __m128 luminance = _mm_div_ps(_mm_add_ps(_mm_mul_ps(two, m12), c1),
+                                  _mm_add_ps(_mm_add_ps(m11, m22), c1));
+    ssimAccumulator = _mm_add_ps(ssimAccumulator, _mm_mul_ps(luminance, cs));
+    csAccumulator = _mm_add_ps(csAccumulator, cs);
+  }
+
+  *ssimSum += horizontalSum(ssimAccumulator);
+  *csSum += horizontalSum(csAccumulator);
+  ssimRowScalar(mu1 + x, mu2 + x, sigma11 + x, sigma22 + x, sigma12 + x,
+                count - x, ssimSum, csSum);
+}
+
+const Kernels SSE2_KERNELS = {"SSE2",           squaredErrorSse2,
+                              multiplySse2,     horizontalBlurSse2,
+                              verticalBlurSse2, ssimRowSse2};
+
+#endif
+
+#if defined(QUALITYMETRICS_X86) && defined(__GNUC__)
+
+// AVX2, compiled for the target regardless of the build flags and only
+// selected when the CPU reports support for it
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET inline float horizontalSum256(__m256 v) {
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v),
+                          _mm256_extractf128_ps(v, 1));
+  __m128 high = _mm_movehl_ps(sum, sum);
+  sum = _mm_add_ps(sum, high);
+  high = _mm_shuffle_ps(sum, sum, 0x1);
+  return _mm_cvtss_f32(_mm_add_ss(sum, high));
+}
+
+AVX2_TARGET double squaredErrorAvx2(const float *a, const float *b,
+                                    int count) {
+  __m256 accumulator = _mm256_setzero_ps();
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 difference =
+        _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    accumulator =
+        _mm256_add_ps(accumulator, _mm256_mul_ps(difference, difference));
+  }
+  return horizontalSum256(accumulator) +
+         squaredErrorScalar(a + i, b + i, count - i);
+}
+
+AVX2_TARGET void multiplyAvx2(const float *a, const float *b, float *dst,
+                              int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(a + i),
+                                            _mm256_loadu_ps(b + i)));
+  }
+  multiplyScalar(a + i, b + i, dst + i, count - i);
+}
+
+AVX2_TARGET void horizontalBlurAvx2(const float *src, float *dst,
+                                    int outWidth, const float *weights) {
+  int x = 0;
+  for (; x + 8 <= outWidth; x += 8) {
+    __m256 sum =
+        _mm256_mul_ps(_mm256_loadu_ps(src + x), _mm256_set1_ps(weights[0]));
+    for (int k = 1; k < WINDOW_SIZE; ++k) {
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(src + x + k),
+                                             _mm256_set1_ps(weights[k])));
+    }
+    _mm256_storeu_ps(dst + x, sum);
+  }
+  horizontalBlurScalar(src + x, dst + x, outWidth - x, weights);
+}
+
+AVX2_TARGET void verticalBlurAvx2(const float *const *rows, float *dst,
+                                  int width, const float *weights) {
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256 sum =
+        _mm256_mul_ps(_mm256_loadu_ps(rows[0] + x), _mm256_set1_ps(weights[0]));
+    for (int k = 1; k < WINDOW_SIZE; ++k) {
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(rows[k] + x),
+                                             _mm256_set1_ps(weights[k])));
+    }
+    _mm256_storeu_ps(dst + x, sum);
+  }
+  for (; x < width; ++x) {
+    float sum = 0.0f;
+    for (int k = 0; k < WINDOW_SIZE; ++k) {
+      sum += rows[k][x] * weights[k];
+    }
+    dst[x] = sum;
+  }
+}
+
+AVX2_TARGET void ssimRowAvx2(const float *mu1, const float *mu2,
+                             const float *sigma11, const float *sigma22,
+                             const float *sigma12, int count, double *ssimSum,
+                             double *csSum) {
+  const __m256 c1 = _mm256_set1_ps(SSIM_C1);
+  const __m256 c2 = _mm256_set1_ps(SSIM_C2);
+  const __m256 two = _mm256_set1_ps(2.0f);
+  __m256 ssimAccumulator = _mm256_setzero_ps();
+  __m256 csAccumulator = _mm256_setzero_ps();
+
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    __m256 m1 = _mm256_loadu_ps(mu1 + x);
+    __m256 m2 = _mm256_loadu_ps(mu2 + x);
+    __m256 m11 = _mm256_mul_ps(m1, m1);
+    __m256 m22 = _mm256_mul_ps(m2, m2);
+    __m256 m12 = _mm256_mul_ps(m1, m2);
+    __m256 s11 = _mm256_sub_ps(_mm256_loadu_ps(sigma11 + x), m11);
+    __m256 s22 = _mm256_sub_ps(_mm256_loadu_ps(sigma22 + x), m22);
+    __m256 s12 = _mm256_sub_ps(_mm256_loadu_ps(sigma12 + x), m12);
+
+    __m256 cs = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(two, s12), c2),
+                              _mm256_add_ps(_mm256_add_ps(s11, s22), c2));
+    __m256 luminance =
+        _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(two, m12), c1),
+                      _mm256_add_ps(_mm256_add_ps(m11, m22), c1));
+    ssimAccumulator =
+        _mm256_add_ps(ssimAccumulator, _mm256_mul_ps(luminance, cs));
+    csAccumulator = _mm256_add_ps(csAccumulator, cs);
+  }
+
+  *ssimSum += horizontalSum256(ssimAccumulator);
+  *csSum += horizontalSum256(csAccumulator);
+  ssimRowScalar(mu1 + x, mu2 + x, sigma11 + x, sigma22 + x, sigma12 + x,
+                count - x, ssimSum, csSum);
+}
+
+const Kernels AVX2_KERNELS = {"AVX2",           squaredErrorAvx2,
+                              multiplyAvx2,     horizontalBlurAvx2,
+                              verticalBlurAvx2, ssimRowAvx2};
+
+#endif
+
+const Kernels &kernels() {
+  static const Kernels selected = []() {
+#if defined(QUALITYMETRICS_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return AVX2_KERNELS;
+    }
+#endif
+#if defined(QUALITYMETRICS_X86) && defined(__SSE2__)
+    return SSE2_KERNELS;
+#else
+    return SCALAR_KERNELS;
+#endif
+  }();
+  return selected;
+}
+
+struct SsimSums {
+  double ssim = 0.0;
+  double cs = 0.0;
+  double count = 0.0;
+
+  double meanSsim() const { return count > 0 ? ssim / count : 0.0; }
+  double meanCs() const { return count > 0 ? cs / count : 0.0; }
+};
+
+// Images smaller than the window are treated as a single window
+SsimSums globalSsimSums(const float *x, const float *y, int count) {
+  double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumYY = 0.0, sumXY = 0.0;
+  for (int i = 0; i < count; ++i) {
+    sumX += x[i];
+    sumY += y[i];
+    sumXX += double(x[i]) * x[i];
+    sumYY += double(y[i]) * y[i];
+    sumXY += double(x[i]) * y[i];
+  }
+
+  float ssim, cs;
+  ssimPixel(float(sumX / count), float(sumY / count), float(sumXX / count),
+            float(sumYY / count), float(sumXY / count), &ssim, &cs);
+
+  SsimSums sums;
+  sums.ssim = ssim;
+  sums.cs = cs;
+  sums.count = 1;
+  return sums;
+}
+
+// Gaussian weighted local statistics computed with a ring of WINDOW_SIZE
+// horizontally blurred rows, so only the rows under the window are kept
+SsimSums ssimSums(const float *x, const float *y, int width, int height) {
+  if (width < WINDOW_SIZE || height < WINDOW_SIZE) {
+    return globalSsimSums(x, y, width * height);
+  }
+
+  const Kernels &kernel = kernels();
+  const float *weights = gaussianWindow();
+
+  enum { MapX, MapY, MapXX, MapYY, MapXY, MapCount };
+
+  const int outWidth = width - WINDOW_SIZE + 1;
+  std::vector<float> products(3 * size_t(width));
+  std::vector<float> ring(size_t(MapCount) * WINDOW_SIZE * outWidth);
+  std::vector<float> stats(size_t(MapCount) * outWidth);
+
+  auto ringRow = [&](int map, int slot) {
+    return ring.data() + (size_t(map) * WINDOW_SIZE + slot) * outWidth;
+  };
+  auto statsRow = [&](int map) {
+    return stats.data() + size_t(map) * outWidth;
+  };
+
+  float *xx = products.data();
+  float *yy = xx + width;
+  float *xy = yy + width;
+  const float *rows[WINDOW_SIZE];
+
+  SsimSums sums;
+  for (int row = 0; row < height; ++row) {
+    const float *xRow = x + size_t(row) * width;
+    const float *yRow = y + size_t(row) * width;
+    kernel.multiply(xRow, xRow, xx, width);
+    kernel.multiply(yRow, yRow, yy, width);
+    kernel.multiply(xRow, yRow, xy, width);
+
+    int slot = row % WINDOW_SIZE;
+    kernel.horizontalBlur(xRow, ringRow(MapX, slot), outWidth, weights);
+    kernel.horizontalBlur(yRow, ringRow(MapY, slot), outWidth, weights);
+    kernel.horizontalBlur(xx, ringRow(MapXX, slot), outWidth, weights);
+    kernel.horizontalBlur(yy, ringRow(MapYY, slot), outWidth, weights);
+    kernel.horizontalBlur(xy, ringRow(MapXY, slot), outWidth, weights);
+
+    if (row < WINDOW_SIZE - 1) {
+      continue;
+    }
+
+    // Oldest row of the window sits in the slot after the newest one
+    for (int map = 0; map < MapCount; ++map) {
+      for (int k = 0; k < WINDOW_SIZE; ++k) {
+        rows[k] = ringRow(map, (row + 1 + k) % WINDOW_SIZE);
+      }
+      kernel.verticalBlur(rows, statsRow(map), outWidth, weights);
+    }
+
+    kernel.ssimRow(statsRow(MapX), statsRow(MapY), statsRow(MapXX),
+                   statsRow(MapYY), statsRow(MapXY), outWidth, &sums.ssim,
+                   &sums.cs);
+    sums.count += outWidth;
+  }
+  return sums;
+}
+
+QualityMetrics::LumaPlane downsample(const float *pixels, int width,
+                                     int height) {
+  QualityMetrics::LumaPlane plane;
+  plane.width = width / 2;
+  plane.height = height / 2;
+  plane.pixels.resize(size_t(plane.width) * plane.height);
+
+  for (int row = 0; row < plane.height; ++row) {
+    const float *top = pixels + size_t(row) * 2 * width;
+    const float *bottom = top + width;
+    float *out = plane.pixels.data() + size_t(row) * plane.width;
+    for (int column = 0; column < plane.width; ++column) {
+      out[column] = 0.25f * (top[2 * column] + top[2 * column + 1] +
+                             bottom[2 * column] + bottom[2 * column + 1]);
+    }
+  }
+  return plane;
+}
+
+bool sameSize(const QualityMetrics::LumaPlane &a,
+              const QualityMetrics::LumaPlane &b) {
+  return !a.isNull() && a.width == b.width && a.height == b.height;
+}
+
+// SSIM at full resolution and MS-SSIM, which shares the first scale
+void evaluateSsim(const QualityMetrics::LumaPlane &reference,
+                  const QualityMetrics::LumaPlane &distorted, double *ssim,
+                  double *msSsim) {
+  int scales = 1;
+  while (scales < MS_SSIM_SCALES &&
+         qMin(reference.width, reference.height) >> scales >= WINDOW_SIZE) {
+    ++scales;
+  }
+
+  // Small images can not go through all scales, renormalize the weights
+  double weightSum = 0.0;
+  for (int scale = 0; scale < scales; ++scale) {
+    weightSum += MS_SSIM_WEIGHTS[scale];
+  }
+
+  const float *x = reference.pixels.data();
+  const float *y = distorted.pixels.data();
+  int width = reference.width;
+  int height = reference.height;
+  QualityMetrics::LumaPlane scaledX, scaledY;
+
+  double product = 1.0;
+  for (int scale = 0; scale < scales; ++scale) {
+    SsimSums sums = ssimSums(x, y, width, height);
+    double weight = MS_SSIM_WEIGHTS[scale] / weightSum;
+
+    if (scale == 0 && ssim) {
+      *ssim = sums.meanSsim();
+    }
+
+    if (scale == scales - 1) {
+      product *= std::pow(std::max(0.0, sums.meanSsim()), weight);
+      break;
+    }
+    product *= std::pow(std::max(0.0, sums.meanCs()), weight);
+
+    scaledX = downsample(x, width, height);
+    scaledY = downsample(y, width, height);
+    x = scaledX.pixels.data();
+    y = scaledY.pixels.data();
+    width = scaledX.width;
+    height = scaledX.height;
+  }
+
+  if (msSsim) {
+    *msSsim = product;
+  }
+}
+
+} // namespace
+
+QualityMetrics::LumaPlane QualityMetrics::lumaPlane(const QImage &image) {
+  LumaPlane plane;
+  if (image.isNull()) {
+    return plane;
+  }
+
+  QImage argb = image.convertToFormat(QImage::Format_ARGB32);
+  plane.width = argb.width();
+  plane.height = argb.height();
+  plane.pixels.resize(size_t(plane.width) * plane.height);
+
+  for (int row = 0; row < plane.height; ++row) {
+    const QRgb *line = reinterpret_cast<const QRgb *>(argb.constScanLine(row));
+    float *out = plane.pixels.data() + size_t(row) * plane.width;
+    for (int column = 0; column < plane.width; ++column) {
+      QRgb pixel = line[column];
+      float red = qRed(pixel);
+      float green = qGreen(pixel);
+      float blue = qBlue(pixel);
+      int alpha = qAlpha(pixel);
+      if (alpha < 255) {
+        float opacity = alpha / 255.0f;
+        red = red * opacity + 255.0f * (1.0f - opacity);
+        green = green * opacity + 255.0f * (1.0f - opacity);
+        blue = blue * opacity + 255.0f * (1.0f - opacity);
+      }
+      out[column] = 0.299f * red + 0.587f * green + 0.114f * blue;
+    }
+  }
+  return plane;
+}
+
+QualityMetrics::LumaPlane
+QualityMetrics::loadLumaPlane(const QString &imagePath, QString *errorString) {
+  QImageReader reader(imagePath);
+  QImage image = reader.read();
+  if (image.isNull()) {
+    if (errorString) {
+      *errorString = reader.errorString();
+    }
+    return LumaPlane();
+  }
+  return lumaPlane(image);
+}
+
+QualityMetrics::Result QualityMetrics::compare(const LumaPlane &reference,
+                                               const LumaPlane &distorted) {
+  Result result;
+  if (!sameSize(reference, distorted)) {
+    return result;
+  }
+
+  result.psnr = psnr(reference, distorted);
+  evaluateSsim(reference, distorted, &result.ssim, &result.msSsim);
+  result.valid = true;
+  return result;
+}
+
+QualityMetrics::Result QualityMetrics::compare(const QString &referencePath,
+                                               const QString &distortedPath,
+                                               QString *errorString) {
+  LumaPlane reference = loadLumaPlane(referencePath, errorString);
+  if (reference.isNull()) {
+    return Result();
+  }
+  LumaPlane distorted = loadLumaPlane(distortedPath, errorString);
+  if (distorted.isNull()) {
+    return Result();
+  }
+
+  if (!sameSize(reference, distorted)) {
+    if (errorString) {
+      *errorString = QObject::tr("Image dimensions differ (%1x%2 vs %3x%4)")
+                         .arg(reference.width)
+                         .arg(reference.height)
+                         .arg(distorted.width)
+                         .arg(distorted.height);
+    }
+    return Result();
+  }
+
+  return compare(reference, distorted);
+}
+
+double QualityMetrics::psnr(const LumaPlane &reference,
+                            const LumaPlane &distorted) {
+  if (!sameSize(reference, distorted)) {
+    return 0.0;
+  }
+
+  // Row sums keep the float accumulators of the kernels short
+  const Kernels &kernel = kernels();
+  double squaredError = 0.0;
+  for (int row = 0; row < reference.height; ++row) {
+    size_t offset = size_t(row) * reference.width;
+    squaredError +=
+        kernel.squaredError(reference.pixels.data() + offset,
+                            distorted.pixels.data() + offset, reference.width);
+  }
+
+  double meanSquaredError =
+      squaredError / (double(reference.width) * reference.height);
+  if (meanSquaredError <= 0.0) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
+
+double QualityMetrics::ssim(const LumaPlane &reference,
+                            const LumaPlane &distorted) {
+  if (!sameSize(reference, distorted)) {
+    return 0.0;
+  }
+  SsimSums sums = ssimSums(reference.pixels.data(), distorted.pixels.data(),
+                           reference.width, reference.height);
+  return sums.meanSsim();
+}
+
+double QualityMetrics::msSsim(const LumaPlane &reference,
+                              const LumaPlane &distorted) {
+  if (!sameSize(reference, distorted)) {
+    return 0.0;
+  }
+  double value = 0.0;
+  evaluateSsim(reference, distorted, nullptr, &value);
+  return value;
+}
+
+QString QualityMetrics::instructionSet() {
+  return QString::fromLatin1(kernels().name);
+}
@@ -0,0 +1,57 @@
+#ifndef QUALITYMETRICS_H
+#define QUALITYMETRICS_H
+
+#include <QImage>
+#include <QString>
+
+#include <vector>
+
+// Full reference image quality metrics (PSNR, SSIM, MS-SSIM) on luma.
+//
+// SSIM uses the usual 11x11 Gaussian window (sigma 1.5) and MS-SSIM the five
+// scale weights of Wang et al. The inner loops (separable Gaussian blur,
+// squared error and SSIM map) are vectorized with AVX2 or SSE2, selected at
+// runtime, with a scalar fallback for other CPUs. Images are processed in a
+// sliding window of rows so the working set stays small on large images.
+//
+// Everything here is reentrant, metrics are computed on worker threads.
+class QualityMetrics {
+public:
+  struct LumaPlane {
+    int width = 0;
+    int height = 0;
+    std::vector<float> pixels;
+
+    bool isNull() const { return pixels.empty(); }
+  };
+
+  struct Result {
+    double psnr = 0.0; // dB, infinite for identical images
+    double ssim = 0.0;
+    double msSsim = 0.0;
+    bool valid = false;
+  };
+
+  // BT.601 luma, transparent pixels are composited over white
+  static LumaPlane lumaPlane(const QImage &image);
+  static LumaPlane loadLumaPlane(const QString &imagePath,
+                                 QString *errorString = nullptr);
+
+  static Result compare(const LumaPlane &reference,
+                        const LumaPlane &distorted);
+  static Result compare(const QString &referencePath,
+                        const QString &distortedPath,
+                        QString *errorString = nullptr);
+
+  static double psnr(const LumaPlane &reference, const LumaPlane &distorted);
+  static double ssim(const LumaPlane &reference, const LumaPlane &distorted);
+  static double msSsim(const LumaPlane &reference, const LumaPlane &distorted);
+
+  // Instruction set used by the kernels ("AVX2", "SSE2" or "scalar")
+  static QString instructionSet();
+
+private:
+  QualityMetrics() = delete;
+};
+
+#endif // QUALITYMETRICS_H
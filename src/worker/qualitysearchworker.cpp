@@ -0,0 +1,425 @@
+#include "qualitysearchworker.h"
+#include "imageworkerfactory.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+#include <functional>
+
+/**
+ * Quality parameter of each format, mapped to 0-100 (higher = better):
+ *
+ *   JPG: jpegoptim/maxQuality 40-100 (targetSize and threshold disabled)
+ *   PNG: pngquant/qualityMax 10-100 with qualityMin 0, so pngquant never
+ *        refuses to write a candidate, and skip-if-larger disabled
+ *   GIF: gifsicle lossy level 200-2 (quality 0-99), lossless at 100
+ *
+ * Search: each round evaluates CANDIDATES_PER_ROUND evenly spaced qualities
+ * of the open interval (the first round includes the maximum). The interval
+ * then shrinks to the qualities between the largest failing candidate below
+ * the lowest passing one and that passing candidate, until it is empty.
+ * A 60 step range takes about four rounds.
+ */
+
+namespace {
+
+struct QualityRange {
+  int minimum;
+  int maximum;
+};
+
+QualityRange qualityRange(ImageType imageType) {
+  switch (imageType) {
+  case ImageType::JPG:
+    return {40, 100};
+  case ImageType::PNG:
+    return {10, 100};
+  case ImageType::GIF:
+    return {0, 100};
+  default:
+    return {100, 100};
+  }
+}
+
+} // namespace
+
+// Decoded once on the first measurement, read-only afterwards
+struct QualitySearchWorker::ReferenceLuma {
+  QMutex mutex;
+  bool loaded = false;
+  QString imagePath;
+  QualityMetrics::LumaPlane plane;
+  QString errorString;
+
+  const QualityMetrics::LumaPlane &get() {
+    QMutexLocker locker(&mutex);
+    if (!loaded) {
+      plane = QualityMetrics::loadLumaPlane(imagePath, &errorString);
+      loaded = true;
+    }
+    return plane;
+  }
+};
+
+namespace {
+
+class CandidateMeasureJob : public QRunnable {
+public:
+  CandidateMeasureJob(
+      QObject *receiver,
+      std::function<const QualityMetrics::LumaPlane &()> reference,
+      const QString &candidatePath,
+      std::function<void(const QualityMetrics::Result &)> deliver)
+      : m_receiver(receiver), m_reference(reference),
+        m_candidatePath(candidatePath), m_deliver(deliver) {}
+
+  void run() override {
+    QualityMetrics::Result result;
+    const QualityMetrics::LumaPlane &reference = m_reference();
+    if (!reference.isNull()) {
+      QualityMetrics::LumaPlane candidate =
+          QualityMetrics::loadLumaPlane(m_candidatePath);
+      result = QualityMetrics::compare(reference, candidate);
+    }
+
+    auto deliver = m_deliver;
+    QMetaObject::invokeMethod(
+        m_receiver, [deliver, result]() { deliver(result); },
+        Qt::QueuedConnection);
+  }
+
+private:
+  QObject *m_receiver;
+  std::function<const QualityMetrics::LumaPlane &()> m_reference;
+  QString m_candidatePath;
+  std::function<void(const QualityMetrics::Result &)> m_deliver;
+};
+
+} // namespace
+
+QualitySearchWorker::QualitySearchWorker(double targetSsim, QObject *parent)
+    : ImageWorker(parent), m_targetSsim(targetSsim), m_task(nullptr),
+      m_imageType(ImageType::Unsupported), m_low(0), m_high(0), m_round(0),
+      m_pendingCandidates(0) {
+  // Candidates of a round are encoded in parallel, measure them in parallel
+  m_metricsPool.setMaxThreadCount(
+      qMin(CANDIDATES_PER_ROUND, qMax(1, QThread::idealThreadCount() / 2)));
+}
+
+QualitySearchWorker::~QualitySearchWorker() {
+  // Measurement jobs hold a raw pointer to us
+  m_metricsPool.clear();
+  m_metricsPool.waitForDone();
+
+  // Kill candidate processes while their tasks are still alive, without
+  // getting called back for them
+  const QList<ImageWorker *> workers =
+      findChildren<ImageWorker *>(QString(), Qt::FindDirectChildrenOnly);
+  for (ImageWorker *worker : workers) {
+    disconnect(worker, nullptr, this, nullptr);
+    delete worker;
+  }
+}
+
+bool QualitySearchWorker::canSearch(ImageType imageType) {
+  return imageType == ImageType::JPG || imageType == ImageType::PNG ||
+         imageType == ImageType::GIF;
+}
+
+void QualitySearchWorker::optimize(ImageTask *task) {
+  m_task = task;
+  m_imageType = ImageWorkerFactory::instance().getImageType(task);
+
+  if (!canSearch(m_imageType)) {
+    fail(tr("Quality search is not supported for this format"));
+    return;
+  }
+
+  // Same directory as the output, so the winner is renamed and not copied
+  QFileInfo outputInfo(task->optimizedPath());
+  QDir().mkpath(outputInfo.absolutePath());
+  m_candidateDir.reset(new QTemporaryDir(outputInfo.absolutePath() +
+                                         "/.pixelbatch-search-XXXXXX"));
+  if (!m_candidateDir->isValid()) {
+    fail(tr("Unable to create a directory for quality search candidates"));
+    return;
+  }
+
+  m_reference = std::make_shared<ReferenceLuma>();
+  m_reference->imagePath = task->imagePath();
+
+  QualityRange range = qualityRange(m_imageType);
+  m_low = range.minimum;
+  m_high = range.maximum;
+  m_round = 0;
+  m_candidates.clear();
+
+  qDebug() << "Quality search for" << task->imagePath() << "target SSIM"
+           << m_targetSsim << "range" << m_low << "-" << m_high;
+
+  startRound();
+}
+
+QVariantMap QualitySearchWorker::candidateSettings(int quality) const {
+  QVariantMap settings = m_customSettings;
+
+  switch (m_imageType) {
+  case ImageType::JPG:
+    settings["jpegoptim/maxQuality"] = quality;
+    settings["jpegoptim/targetSize"] = 0;
+    settings["jpegoptim/compressionThreshold"] = 0;
+    break;
+  case ImageType::PNG:
+    settings["pngquant/qualityMin"] = 0;
+    settings["pngquant/qualityMax"] = quality;
+    settings["pngquant/skipIfLarger"] = false;
+    settings["pngquant/force"] = true;
+    break;
+  case ImageType::GIF:
+    if (quality >= 100) {
+      settings["gifsicle/compressionType"] = 0;
+    } else {
+      settings["gifsicle/compressionType"] = 1;
+      settings["gifsicle/lossyLevel"] = (100 - quality) * 2;
+    }
+    break;
+  default:
+    break;
+  }
+
+  return settings;
+}
+
+void QualitySearchWorker::startRound() {
+  QList<int> qualities;
+  int span = m_high - m_low;
+
+  if (span + 1 <= CANDIDATES_PER_ROUND) {
+    for (int quality = m_low; quality <= m_high; ++quality) {
+      qualities << quality;
+    }
+  } else {
+    for (int i = 1; i <= CANDIDATES_PER_ROUND; ++i) {
+      qualities << m_low + span * i / CANDIDATES_PER_ROUND;
+    }
+  }
+
+  // Candidates are evaluated at most once
+  QList<int> pending;
+  for (int quality : qualities) {
+    if (m_candidates.count(quality) == 0 && !pending.contains(quality)) {
+      pending << quality;
+    }
+  }
+
+  if (pending.isEmpty()) {
+    finishSearch();
+    return;
+  }
+
+  ++m_round;
+  m_pendingCandidates = pending.size();
+  qDebug() << "Quality search round" << m_round << "for" << m_task->imagePath()
+           << "candidates" << pending;
+
+  for (int quality : pending) {
+    startCandidate(quality);
+  }
+}
+
+void QualitySearchWorker::startCandidate(int quality) {
+  // Named after the content, the source may be misnamed or extensionless
+  QString suffix = ImageWorkerFactory::instance()
+                       .getOptimizerByImageType(m_imageType)
+                       .getSupportedFormats()
+                       .value(0);
+  QString candidatePath =
+      m_candidateDir->filePath(QString("q%1.%2").arg(quality).arg(suffix));
+
+  Candidate &candidate = m_candidates[quality];
+  candidate.task.reset(new ImageTask(m_task->imagePath(), candidatePath));
+  candidate.task->imageType = m_imageType;
+  candidate.task->imageTypeSniffed = true;
+  candidate.task->customOptimizerSettings = candidateSettings(quality);
+
+  ImageWorker *worker = nullptr;
+  try {
+    worker = ImageWorkerFactory::instance().getWorker(m_imageType);
+  } catch (const std::exception &e) {
+    qWarning() << "Quality search candidate failed:" << e.what();
+    onCandidateEncoded(quality, false);
+    return;
+  }
+
+  // Owned by us, so cancelling the search also kills the candidate processes
+  worker->setParent(this);
+  worker->setCustomSettings(candidate.task->customOptimizerSettings);
+  if (m_snapshot) {
+    worker->setSnapshot(SettingsSnapshot::compile(
+        candidate.task->customOptimizerSettings, m_snapshot.data()));
+  }
+  worker->setBackground(m_background);
+
+  connect(worker, &ImageWorker::optimizationFinished, this,
+          [this, worker, quality](ImageTask *, bool success) {
+            worker->deleteLater();
+            onCandidateEncoded(quality, success);
+          });
+  connect(worker, &ImageWorker::optimizationError, this,
+          [this, worker, quality](ImageTask *, const QString &errorString) {
+            qDebug() << "Quality search candidate" << quality
+                     << "failed:" << errorString;
+            worker->deleteLater();
+            onCandidateEncoded(quality, false);
+          });
+
+  worker->optimize(candidate.task.get());
+}
+
+void QualitySearchWorker::onCandidateEncoded(int quality, bool success) {
+  Candidate &candidate = m_candidates[quality];
+  QString candidatePath = candidate.task->optimizedPath();
+
+  if (!success || !QFileInfo::exists(candidatePath)) {
+    candidate.succeeded = false;
+    onCandidateMeasured(quality, QualityMetrics::Result());
+    return;
+  }
+
+  candidate.succeeded = true;
+  candidate.size = QFileInfo(candidatePath).size();
+
+  std::shared_ptr<ReferenceLuma> reference = m_reference;
+  m_metricsPool.start(new CandidateMeasureJob(
+      this,
+      [reference]() -> const QualityMetrics::LumaPlane & {
+        return reference->get();
+      },
+      candidatePath,
+      [this, quality](const QualityMetrics::Result &result) {
+        onCandidateMeasured(quality, result);
+      }));
+}
+
+void QualitySearchWorker::onCandidateMeasured(
+    int quality, const QualityMetrics::Result &result) {
+  Candidate &candidate = m_candidates[quality];
+  candidate.metrics = result;
+
+  qDebug() << "Quality search candidate" << quality << "size" << candidate.size
+           << "SSIM" << result.ssim;
+
+  if (--m_pendingCandidates == 0) {
+    finishRound();
+  }
+}
+
+void QualitySearchWorker::finishRound() {
+  // Lowest quality that reaches the target
+  int passing = -1;
+  for (const auto &entry : m_candidates) {
+    if (entry.second.meets(m_targetSsim)) {
+      passing = entry.first;
+      break;
+    }
+  }
+
+  // Not even the highest quality reaches the target
+  if (passing < 0) {
+    finishSearch();
+    return;
+  }
+
+  // Largest failing quality below it bounds the interval from below
+  int failing = m_low - 1;
+  for (const auto &entry : m_candidates) {
+    if (entry.first >= passing) {
+      break;
+    }
+    if (!entry.second.meets(m_targetSsim)) {
+      failing = entry.first;
+    }
+  }
+
+  m_low = qMax(m_low, failing + 1);
+  m_high = passing - 1;
+
+  if (m_low > m_high) {
+    finishSearch();
+  } else {
+    startRound();
+  }
+}
+
+void QualitySearchWorker::finishSearch() {
+  // Smallest file among the candidates that reach the target
+  int best = -1;
+  for (const auto &entry : m_candidates) {
+    const Candidate &candidate = entry.second;
+    if (candidate.meets(m_targetSsim) &&
+        (best < 0 || candidate.size < m_candidates[best].size)) {
+      best = entry.first;
+    }
+  }
+
+  // Target unreachable, fall back to the closest candidate
+  if (best < 0) {
+    for (const auto &entry : m_candidates) {
+      const Candidate &candidate = entry.second;
+      if (candidate.succeeded && candidate.metrics.valid &&
+          (best < 0 ||
+           candidate.metrics.ssim > m_candidates[best].metrics.ssim)) {
+        best = entry.first;
+      }
+    }
+    if (best >= 0) {
+      qWarning() << "Quality search could not reach SSIM" << m_targetSsim
+                 << "for" << m_task->imagePath() << ", best was"
+                 << m_candidates[best].metrics.ssim;
+    }
+  }
+
+  if (best < 0) {
+    QString errorString = m_reference->loaded && m_reference->plane.isNull()
+                              ? m_reference->errorString
+                              : tr("No candidate could be encoded");
+    fail(tr("Quality search failed: %1").arg(errorString));
+    return;
+  }
+
+  const Candidate &winner = m_candidates[best];
+  QString dst = m_task->optimizedPath();
+  if (QFile::exists(dst)) {
+    QFile::remove(dst);
+  }
+  if (!QFile::rename(winner.task->optimizedPath(), dst) &&
+      !QFile::copy(winner.task->optimizedPath(), dst)) {
+    fail(tr("Failed to move the selected candidate to the destination"));
+    return;
+  }
+
+  m_task->hasQualityMetrics = true;
+  m_task->psnr = winner.metrics.psnr;
+  m_task->ssim = winner.metrics.ssim;
+  m_task->msSsim = winner.metrics.msSsim;
+  m_task->searchedQuality = best;
+
+  qDebug() << "Quality search for" << m_task->imagePath() << "picked quality"
+           << best << "SSIM" << winner.metrics.ssim << "after" << m_round
+           << "rounds and" << m_candidates.size() << "candidates";
+
+  m_candidates.clear();
+  m_candidateDir.reset();
+  emit optimizationFinished(m_task, true);
+}
+
+void QualitySearchWorker::fail(const QString &errorString) {
+  m_candidates.clear();
+  m_candidateDir.reset();
+  emit optimizationError(m_task, errorString);
+}
@@ -0,0 +1,75 @@
+#ifndef QUALITYSEARCHWORKER_H
+#define QUALITYSEARCHWORKER_H
+
+#include "ImageWorker.h"
+#include "imagetype.h"
+#include "qualitymetrics.h"
+
+#include <QTemporaryDir>
+#include <QThreadPool>
+
+#include <map>
+#include <memory>
+
+// Searches the lossy quality parameter of an image for the smallest output
+// that still reaches a target SSIM.
+//
+// Every round encodes a few candidates in parallel with the regular worker of
+// the format (jpegoptim --max, pngquant --quality, gifsicle --lossy) into a
+// temporary directory next to the output, measures them against the original
+// and narrows the quality interval around the lowest passing candidate. The
+// original is decoded once and shared by all measurements. The winner is
+// moved to the output path and its metrics are stored on the task.
+class QualitySearchWorker : public ImageWorker {
+  Q_OBJECT
+
+public:
+  // Candidates encoded at once
+  static constexpr int CANDIDATES_PER_ROUND = 3;
+
+  explicit QualitySearchWorker(double targetSsim, QObject *parent = nullptr);
+  ~QualitySearchWorker();
+
+  static bool canSearch(ImageType imageType);
+
+  void optimize(ImageTask *task) override;
+
+private:
+  struct ReferenceLuma;
+
+  struct Candidate {
+    std::unique_ptr<ImageTask> task;
+    bool succeeded = false;
+    qint64 size = 0;
+    QualityMetrics::Result metrics;
+
+    bool meets(double targetSsim) const {
+      return succeeded && metrics.valid && metrics.ssim >= targetSsim;
+    }
+  };
+
+  void startRound();
+  void startCandidate(int quality);
+  void onCandidateEncoded(int quality, bool success);
+  void onCandidateMeasured(int quality, const QualityMetrics::Result &result);
+  void finishRound();
+  void finishSearch();
+  void fail(const QString &errorString);
+
+  QVariantMap candidateSettings(int quality) const;
+
+  double m_targetSsim;
+  ImageTask *m_task;
+  ImageType m_imageType;
+  int m_low;
+  int m_high;
+  int m_round;
+  int m_pendingCandidates;
+
+  std::map<int, Candidate> m_candidates; // ordered by quality
+  std::unique_ptr<QTemporaryDir> m_candidateDir;
+  std::shared_ptr<ReferenceLuma> m_reference;
+  QThreadPool m_metricsPool;
+};
+
+#endif // QUALITYSEARCHWORKER_H
@@ -0,0 +1,86 @@
+#include "remoteworker.h"
+#include "imageworkerfactory.h"
+#include "qualitysearchworker.h"
+
+#include <workcoordinator.h>
+
+RemoteWorker::RemoteWorker(WorkCoordinator *coordinator, double targetSsim,
+                           QObject *parent)
+    : ImageWorker(parent), m_coordinator(coordinator),
+      m_targetSsim(targetSsim), m_task(nullptr) {
+  // Taken now, the scheduler must not hand the same slot to more tasks
+  // while wrapping stages run locally
+  if (m_coordinator) {
+    m_coordinator->reserveSlot(this);
+  }
+}
+
+RemoteWorker::~RemoteWorker() {
+  // Tell the agent to stop, a local fallback worker is our child
+  if (m_coordinator) {
+    m_coordinator->cancel(this);
+  }
+}
+
+void RemoteWorker::optimize(ImageTask *task) {
+  m_task = task;
+  if (!m_coordinator ||
+      !m_coordinator->submit(this, task, effectiveSettings(), m_targetSsim)) {
+    runLocally();
+  }
+}
+
+void RemoteWorker::remoteFinished(bool success, const QString &errorString) {
+  if (success) {
+    emit optimizationFinished(m_task, true);
+  } else {
+    QFile::remove(m_task->optimizedPath());
+    emit optimizationError(m_task, errorString.isEmpty()
+                                       ? tr("Optimization failed")
+                                       : errorString);
+  }
+}
+
+void RemoteWorker::agentLost(const QString &reason) {
+  qWarning() << "Agent lost while optimizing" << m_task->imagePath() << ":"
+             << reason << "- continuing locally";
+  runLocally();
+}
+
+QVariantMap RemoteWorker::effectiveSettings() {
+  // The agent must not fill gaps from its own preferences, it gets the
+  // whole snapshot, the optimizer picked for the type included
+  if (!m_snapshot) {
+    m_snapshot = SettingsSnapshot::compile(m_customSettings);
+  }
+  return m_snapshot->toTransferMap();
+}
+
+void RemoteWorker::runLocally() {
+  ImageType imageType = ImageWorkerFactory::instance().getImageType(m_task);
+  ImageOptimizer optimizer = ImageWorkerFactory::instance().getOptimizer(
+      imageType, formatOptimizerName(imageType));
+
+  ImageWorker *worker = nullptr;
+  try {
+    worker = m_targetSsim > 0.0 && !optimizer.convertsFormat() &&
+                     !optimizer.stripsMetadataOnly() &&
+                     QualitySearchWorker::canSearch(imageType)
+                 ? new QualitySearchWorker(m_targetSsim)
+                 : ImageWorkerFactory::instance().getWorker(optimizer);
+  } catch (const std::exception &e) {
+    emit optimizationError(m_task, e.what());
+    return;
+  }
+
+  worker->setParent(this);
+  worker->setCustomSettings(m_customSettings);
+  worker->setSnapshot(m_snapshot);
+  worker->setBackground(m_background);
+  connect(worker, &ImageWorker::optimizationFinished, this,
+          &ImageWorker::optimizationFinished);
+  connect(worker, &ImageWorker::optimizationError, this,
+          &ImageWorker::optimizationError);
+  emit runningLocally(m_task);
+  worker->optimize(m_task);
+}
@@ -0,0 +1,44 @@
+#ifndef REMOTEWORKER_H
+#define REMOTEWORKER_H
+
+#include "ImageWorker.h"
+
+#include <QPointer>
+
+class WorkCoordinator;
+
+// Optimizes a task on an agent of the WorkCoordinator.
+//
+// The agent gets the whole settings snapshot of the task, option arguments
+// built here included (see SettingsSnapshot::toTransferMap), so it produces
+// what a local worker would. When no agent slot is free anymore or
+// the agent goes away mid task, the task runs locally instead, announced by
+// runningLocally so the scheduler can account for it. The agent slot is
+// reserved from construction, see WorkCoordinator::reserveSlot.
+class RemoteWorker : public ImageWorker {
+  Q_OBJECT
+
+public:
+  RemoteWorker(WorkCoordinator *coordinator, double targetSsim,
+               QObject *parent = nullptr);
+  ~RemoteWorker();
+
+  void optimize(ImageTask *task) override;
+
+  // Called by WorkCoordinator
+  void remoteFinished(bool success, const QString &errorString);
+  void agentLost(const QString &reason);
+
+signals:
+  void runningLocally(ImageTask *task);
+
+private:
+  QVariantMap effectiveSettings();
+  void runLocally();
+
+  QPointer<WorkCoordinator> m_coordinator;
+  double m_targetSsim;
+  ImageTask *m_task;
+};
+
+#endif // REMOTEWORKER_H
@@ -0,0 +1,478 @@
+#include "resampler.h"
+
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+#include <cmath>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RESAMPLER_X86
+#endif
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+// Output rows per band. Every band filters the source rows under it
+// horizontally, plus the overlap with its neighbours, so bands are large
+// unless the image is too small to keep all threads busy.
+const int MAX_BAND_ROWS = 64;
+const int MIN_BAND_ROWS = 8;
+
+// Steps of the linear to sRGB table, enough to keep the darkest 8 bit
+// values apart
+const int LINEAR_STEPS = 4096;
+
+double sinc(double x) {
+  if (x == 0.0) {
+    return 1.0;
+  }
+  x *= PI;
+  return std::sin(x) / x;
+}
+
+double lanczos3(double x) {
+  x = std::fabs(x);
+  return x < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+}
+
+// Mitchell-Netravali with B = C = 1/3, softer than Lanczos without ringing
+double mitchell(double x) {
+  const double B = 1.0 / 3.0;
+  const double C = 1.0 / 3.0;
+  x = std::fabs(x);
+  if (x < 1.0) {
+    return ((12 - 9 * B - 6 * C) * x * x * x +
+            (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) /
+           6.0;
+  }
+  if (x < 2.0) {
+    return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x +
+            (-12 * B - 48 * C) * x + (8 * B + 24 * C)) /
+           6.0;
+  }
+  return 0.0;
+}
+
+const float *srgbToLinearTable() {
+  static const std::vector<float> table = []() {
+    std::vector<float> values(256);
+    for (int i = 0; i < 256; ++i) {
+      double value = i / 255.0;
+      values[i] = float(value <= 0.04045
+                            ? value / 12.92
+                            : std::pow((value + 0.055) / 1.055, 2.4));
+    }
+    return values;
+  }();
+  return table.data();
+}
+
+const uchar *linearToSrgbTable() {
+  static const std::vector<uchar> table = []() {
+    std::vector<uchar> values(LINEAR_STEPS + 1);
+    for (int i = 0; i <= LINEAR_STEPS; ++i) {
+      double value = double(i) / LINEAR_STEPS;
+      value = value <= 0.0031308 ? value * 12.92
+                                 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+      values[i] = uchar(qBound(0, int(std::lround(value * 255.0)), 255));
+    }
+    return values;
+  }();
+  return table.data();
+}
+
+// 8 bit pixels with alpha last to premultiplied linear float
+void toLinear(const uchar *src, float *dst, int width) {
+  const float *table = srgbToLinearTable();
+  for (int x = 0; x < width; ++x, src += 4, dst += 4) {
+    float alpha = src[3] * (1.0f / 255.0f);
+    dst[0] = table[src[0]] * alpha;
+    dst[1] = table[src[1]] * alpha;
+    dst[2] = table[src[2]] * alpha;
+    dst[3] = alpha;
+  }
+}
+
+// Premultiplied linear float to 8 bit pixels, clamping the ringing of the
+// filter
+void fromLinear(const float *src, uchar *dst, int width) {
+  const uchar *table = linearToSrgbTable();
+  for (int x = 0; x < width; ++x, src += 4, dst += 4) {
+    float alpha = qMin(src[3], 1.0f);
+    int alpha8 = int(alpha * 255.0f + 0.5f);
+    if (alpha8 <= 0) {
+      dst[0] = dst[1] = dst[2] = dst[3] = 0;
+      continue;
+    }
+    float inverse = 1.0f / alpha;
+    for (int c = 0; c < 3; ++c) {
+      float value = qBound(0.0f, src[c] * inverse, 1.0f);
+      dst[c] = table[int(value * LINEAR_STEPS + 0.5f)];
+    }
+    dst[3] = uchar(alpha8);
+  }
+}
+
+// Source pixels and weights of every output pixel along one axis. All
+// output pixels have the same number of taps, windows at the edges are
+// shifted inside the image and their extra taps weigh 0.
+struct Contributions {
+  int taps = 0;
+  std::vector<int> first;
+  std::vector<float> weights; // taps per output pixel
+};
+
+Contributions contributions(int srcSize, int dstSize,
+                            Resampler::Filter filter) {
+  double (*function)(double) =
+      filter == Resampler::Mitchell ? mitchell : lanczos3;
+  double radius = filter == Resampler::Mitchell ? 2.0 : 3.0;
+
+  // Downscaling stretches the filter over the source pixels that make up
+  // one output pixel
+  double scale = double(srcSize) / dstSize;
+  double filterScale = qMax(1.0, scale);
+  double support = radius * filterScale;
+
+  Contributions result;
+  result.taps = qMin(srcSize, int(std::ceil(support)) * 2 + 1);
+  result.first.resize(dstSize);
+  result.weights.assign(size_t(dstSize) * result.taps, 0.0f);
+
+  for (int i = 0; i < dstSize; ++i) {
+    double center = (i + 0.5) * scale;
+    int first = int(std::ceil(center - support - 0.5));
+    first = qBound(0, first, srcSize - result.taps);
+    result.first[i] = first;
+
+    float *weights = result.weights.data() + size_t(i) * result.taps;
+    double sum = 0.0;
+    for (int k = 0; k < result.taps; ++k) {
+      double weight = function((first + k + 0.5 - center) / filterScale);
+      weights[k] = float(weight);
+      sum += weight;
+    }
+    if (sum != 0.0) {
+      for (int k = 0; k < result.taps; ++k) {
+        weights[k] = float(weights[k] / sum);
+      }
+    }
+  }
+  return result;
+}
+
+struct Kernels {
+  const char *name;
+  // One row of 4 channel pixels,
+  // dst[x] = sum(src[first[x] + k] * weights[x * taps + k]) over the taps
+  void (*horizontal)(const float *src, float *dst, int dstWidth,
+                     const int *first, const float *weights, int taps);
+  // dst[i] = sum(rows[k][i] * weights[k]) over the taps
+  void (*vertical)(const float *const *rows, float *dst, int count,
+                   const float *weights, int taps);
+};
+
+// Scalar
+
+void horizontalScalar(const float *src, float *dst, int dstWidth,
+                      const int *first, const float *weights, int taps) {
+  for (int x = 0; x < dstWidth; ++x, weights += taps, dst += 4) {
+    const float *pixel = src + first[x] * 4;
+    float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+    for (int k = 0; k < taps; ++k, pixel += 4) {
+      r += pixel[0] * weights[k];
+      g += pixel[1] * weights[k];
+      b += pixel[2] * weights[k];
+      a += pixel[3] * weights[k];
+    }
+    dst[0] = r;
+    dst[1] = g;
+    dst[2] = b;
+    dst[3] = a;
+  }
+}
+
+void verticalRange(const float *const *rows, float *dst, int begin,
+                   int end, const float *weights, int taps) {
+  for (int i = begin; i < end; ++i) {
+    float sum = 0.0f;
+    for (int k = 0; k < taps; ++k) {
+      sum += rows[k][i] * weights[k];
+    }
+    dst[i] = sum;
+  }
+}
+
+void verticalScalar(const float *const *rows, float *dst, int count,
+                    const float *weights, int taps) {
+  verticalRange(rows, dst, 0, count, weights, taps);
+}
+
+const Kernels SCALAR_KERNELS = {"Scalar", horizontalScalar, verticalScalar};
+
+#if defined(RESAMPLER_X86) && defined(__SSE2__)
+
+// SSE2, baseline on x86-64. A pixel fills a register.
+
+void horizontalSse2(const float *src, float *dst, int dstWidth,
+                    const int *first, const float *weights, int taps) {
+  for (int x = 0; x < dstWidth; ++x, weights += taps) {
+    const float *pixel = src + first[x] * 4;
+    __m128 sum = _mm_setzero_ps();
+    for (int k = 0; k < taps; ++k, pixel += 4) {
+      sum = _mm_add_ps(
+          sum, _mm_mul_ps(_mm_loadu_ps(pixel), _mm_set1_ps(weights[k])));
+    }
+    _mm_storeu_ps(dst + x * 4, sum);
+  }
+}
+
+void verticalSse2(const float *const *rows, float *dst, int count,
+                  const float *weights, int taps) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 sum = _mm_setzero_ps();
+    for (int k = 0; k < taps; ++k) {
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[k] + i),
+                                       _mm_set1_ps(weights[k])));
+    }
+    _mm_storeu_ps(dst + i, sum);
+  }
+  verticalRange(rows, dst, i, count, weights, taps);
+}
+
+const Kernels SSE2_KERNELS = {"SSE2", horizontalSse2, verticalSse2};
+
+#endif
+
+#if defined(RESAMPLER_X86) && defined(__GNUC__)
+
+// AVX2, compiled for the target regardless of the build flags and only
+// selected when the CPU reports support for it. Two output pixels share a
+// register horizontally.
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET inline __m256 combine(__m128 low, __m128 high) {
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+}
+
+AVX2_TARGET void horizontalAvx2(const float *src, float *dst, int dstWidth,
+                                const int *first, const float *weights,
+                                int taps) {
+  int x = 0;
+  for (; x + 2 <= dstWidth; x += 2) {
+    const float *pixel0 = src + first[x] * 4;
+    const float *pixel1 = src + first[x + 1] * 4;
+    const float *weights0 = weights + size_t(x) * taps;
+    const float *weights1 = weights0 + taps;
+    __m256 sum = _mm256_setzero_ps();
+    for (int k = 0; k < taps; ++k) {
+      __m256 pixels = combine(_mm_loadu_ps(pixel0 + k * 4),
+                              _mm_loadu_ps(pixel1 + k * 4));
+      __m256 weight =
+          combine(_mm_set1_ps(weights0[k]), _mm_set1_ps(weights1[k]));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(pixels, weight));
+    }
+    _mm256_storeu_ps(dst + x * 4, sum);
+  }
+  horizontalScalar(src, dst + x * 4, dstWidth - x, first + x,
+                   weights + size_t(x) * taps, taps);
+}
+
+AVX2_TARGET void verticalAvx2(const float *const *rows, float *dst,
+                              int count, const float *weights, int taps) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 sum = _mm256_setzero_ps();
+    for (int k = 0; k < taps; ++k) {
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(rows[k] + i),
+                                             _mm256_set1_ps(weights[k])));
+    }
+    _mm256_storeu_ps(dst + i, sum);
+  }
+  verticalRange(rows, dst, i, count, weights, taps);
+}
+
+const Kernels AVX2_KERNELS = {"AVX2", horizontalAvx2, verticalAvx2};
+
+#endif
+
+const Kernels &kernels() {
+  static const Kernels selected = []() {
+#if defined(RESAMPLER_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return AVX2_KERNELS;
+    }
+#endif
+#if defined(RESAMPLER_X86) && defined(__SSE2__)
+    return SSE2_KERNELS;
+#else
+    return SCALAR_KERNELS;
+#endif
+  }();
+  return selected;
+}
+
+// Band jobs never wait on anything, so a pool of their own can't deadlock
+// with callers that run on a pool themselves
+QThreadPool &bandPool() {
+  static QThreadPool pool;
+  return pool;
+}
+
+struct ResizeJob {
+  const uchar *source;
+  int sourceStride;
+  int sourceWidth;
+  uchar *target;
+  int targetStride;
+  int targetWidth;
+  int targetHeight;
+  Contributions horizontal;
+  Contributions vertical;
+  int bandRows;
+  int bandCount;
+  QAtomicInt nextBand;
+};
+
+void filterBand(const ResizeJob &job, int band) {
+  const Kernels &selected = kernels();
+  const Contributions &vertical = job.vertical;
+  int top = band * job.bandRows;
+  int bottom = qMin(top + job.bandRows, job.targetHeight);
+
+  // Source rows under the band, filtered horizontally
+  int firstRow = vertical.first[top];
+  int rowCount = vertical.first[bottom - 1] + vertical.taps - firstRow;
+  int rowLength = job.targetWidth * 4;
+  std::vector<float> linear(size_t(job.sourceWidth) * 4);
+  std::vector<float> rows(size_t(rowCount) * rowLength);
+  for (int row = 0; row < rowCount; ++row) {
+    toLinear(job.source + size_t(firstRow + row) * job.sourceStride,
+             linear.data(), job.sourceWidth);
+    selected.horizontal(linear.data(), rows.data() + size_t(row) * rowLength,
+                        job.targetWidth, job.horizontal.first.data(),
+                        job.horizontal.weights.data(), job.horizontal.taps);
+  }
+
+  std::vector<const float *> taps(vertical.taps);
+  std::vector<float> output(rowLength);
+  for (int y = top; y < bottom; ++y) {
+    for (int k = 0; k < vertical.taps; ++k) {
+      taps[k] = rows.data() +
+                size_t(vertical.first[y] + k - firstRow) * rowLength;
+    }
+    selected.vertical(taps.data(), output.data(), rowLength,
+                      vertical.weights.data() + size_t(y) * vertical.taps,
+                      vertical.taps);
+    fromLinear(output.data(), job.target + size_t(y) * job.targetStride,
+               job.targetWidth);
+  }
+}
+
+void filterBands(ResizeJob &job) {
+  int band;
+  while ((band = job.nextBand.fetchAndAddRelaxed(1)) < job.bandCount) {
+    filterBand(job, band);
+  }
+}
+
+class BandJob : public QRunnable {
+public:
+  BandJob(ResizeJob *job, QSemaphore *done) : m_job(job), m_done(done) {}
+
+  void run() override {
+    filterBands(*m_job);
+    m_done->release();
+  }
+
+private:
+  ResizeJob *m_job;
+  QSemaphore *m_done;
+};
+
+} // namespace
+
+Resampler::Filter Resampler::filterFromInt(int filter) {
+  return filter == Mitchell ? Mitchell : Lanczos3;
+}
+
+QSize Resampler::fitWithin(const QSize &size, int maxWidth, int maxHeight) {
+  QSize bounds(maxWidth > 0 ? maxWidth : size.width(),
+               maxHeight > 0 ? maxHeight : size.height());
+  if (size.width() <= bounds.width() && size.height() <= bounds.height()) {
+    return size;
+  }
+  return size.scaled(bounds, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+}
+
+QImage Resampler::resize(const QImage &image, const QSize &size,
+                         Filter filter) {
+  if (image.isNull() || size.isEmpty()) {
+    return QImage();
+  }
+
+  // Channels are filtered alike, only alpha has to come last in memory
+  bool alpha = image.hasAlphaChannel();
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+  QImage::Format format = alpha ? QImage::Format_ARGB32 : QImage::Format_RGB32;
+#else
+  QImage::Format format =
+      alpha ? QImage::Format_RGBA8888 : QImage::Format_RGBX8888;
+#endif
+  const QImage source =
+      image.format() == format ? image : image.convertToFormat(format);
+  QImage target(size, format);
+  if (source.isNull() || target.isNull()) {
+    return QImage();
+  }
+
+  ResizeJob job;
+  job.source = source.constBits();
+  job.sourceStride = source.bytesPerLine();
+  job.sourceWidth = source.width();
+  // Detached here, scanLine would detach on every band thread
+  job.target = target.bits();
+  job.targetStride = target.bytesPerLine();
+  job.targetWidth = size.width();
+  job.targetHeight = size.height();
+  job.horizontal = contributions(source.width(), size.width(), filter);
+  job.vertical = contributions(source.height(), size.height(), filter);
+
+  int threads = qMax(1, QThread::idealThreadCount());
+  job.bandRows = qBound(MIN_BAND_ROWS,
+                        (size.height() + threads - 1) / threads,
+                        MAX_BAND_ROWS);
+  job.bandCount = (size.height() + job.bandRows - 1) / job.bandRows;
+  job.nextBand.storeRelaxed(0);
+
+  // The calling thread takes bands too
+  int helpers = qMin(job.bandCount, threads) - 1;
+  QSemaphore done;
+  for (int i = 0; i < helpers; ++i) {
+    bandPool().start(new BandJob(&job, &done));
+  }
+  filterBands(job);
+  done.acquire(helpers);
+
+  target.setColorSpace(image.colorSpace());
+  target.setDotsPerMeterX(image.dotsPerMeterX());
+  target.setDotsPerMeterY(image.dotsPerMeterY());
+  if (image.format() == QImage::Format_Grayscale8 ||
+      image.format() == QImage::Format_Grayscale16) {
+    target = target.convertToFormat(QImage::Format_Grayscale8);
+  }
+  return target;
+}
+
+QString Resampler::instructionSet() {
+  return QString::fromLatin1(kernels().name);
+}
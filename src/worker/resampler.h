@@ -0,0 +1,41 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+// Downscales images with a separable windowed filter in linear light.
+//
+// 8 bit sRGB is converted to premultiplied linear float through lookup
+// tables, filtered horizontally and then vertically with weights computed
+// once per axis, and converted back. Averaging linear light keeps fine
+// detail from getting darker, premultiplying keeps transparent pixels from
+// bleeding their color into the edges. The output rows are cut into bands
+// filtered on a thread pool, each band filters the source rows it needs on
+// its own, so memory stays a few rows per thread whatever the image size.
+// The kernels use AVX2 or SSE2 when the CPU has them, like QualityMetrics.
+//
+// Reentrant, images are resized on worker threads.
+class Resampler {
+public:
+  // Stored as int in Constants::RESIZE_FILTER_KEY
+  enum Filter { Lanczos3, Mitchell };
+
+  static Filter filterFromInt(int filter);
+
+  // Largest size within the limits with the aspect ratio of size, size
+  // itself when it fits. A limit of 0 is no limit.
+  static QSize fitWithin(const QSize &size, int maxWidth, int maxHeight);
+
+  // Null when image is null, size is empty or memory ran out
+  static QImage resize(const QImage &image, const QSize &size, Filter filter);
+
+  // Kernels in use, e.g. "AVX2"
+  static QString instructionSet();
+
+private:
+  Resampler() = delete;
+};
+
+#endif // RESAMPLER_H
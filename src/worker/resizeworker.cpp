@@ -0,0 +1,275 @@
+#include "resizeworker.h"
+#include "imageworkerfactory.h"
+#include "resampler.h"
+
+#include <constants.h>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMetaObject>
+#include <QRunnable>
+
+#include <functional>
+
+namespace {
+
+// JPEG quality of a downscaled image that is optimized losslessly
+// afterwards
+const int INTERMEDIATE_JPEG_QUALITY = 92;
+
+class ResizeJob : public QRunnable {
+public:
+  typedef std::function<void(const QString &, const QSize &,
+                             const QString &)>
+      Deliver;
+
+  ResizeJob(QObject *receiver, const QString &imagePath,
+            const QString &resizedPath, ImageType imageType, int maxWidth,
+            int maxHeight, Resampler::Filter filter, int jpegQuality,
+            Deliver deliver)
+      : m_receiver(receiver), m_imagePath(imagePath),
+        m_resizedPath(resizedPath), m_imageType(imageType),
+        m_maxWidth(maxWidth), m_maxHeight(maxHeight), m_filter(filter),
+        m_jpegQuality(jpegQuality), m_deliver(deliver) {}
+
+  void run() override {
+    QString resizedPath;
+    QSize size;
+    QString errorString;
+    resize(&resizedPath, &size, &errorString);
+
+    auto deliver = m_deliver;
+    QMetaObject::invokeMethod(
+        m_receiver,
+        [deliver, resizedPath, size, errorString]() {
+          deliver(resizedPath, size, errorString);
+        },
+        Qt::QueuedConnection);
+  }
+
+private:
+  // Leaves resizedPath empty when the image already fits
+  void resize(QString *resizedPath, QSize *size,
+              QString *errorString) const {
+    QImageReader reader(m_imagePath);
+    reader.setDecideFormatFromContent(true);
+    reader.setAutoTransform(true);
+    QImage image = reader.read();
+    if (image.isNull()) {
+      *errorString = reader.errorString();
+      return;
+    }
+
+    *size = Resampler::fitWithin(image.size(), m_maxWidth, m_maxHeight);
+    if (*size == image.size()) {
+      return;
+    }
+    QImage resized = Resampler::resize(image, *size, m_filter);
+    image = QImage();
+    if (resized.isNull()) {
+      *errorString = QObject::tr("Not enough memory to resize the image");
+      return;
+    }
+
+    if (ResizeWorker::writeIntermediate(resized, m_resizedPath, m_imageType,
+                                        m_jpegQuality, errorString)) {
+      *resizedPath = m_resizedPath;
+    }
+  }
+
+  QObject *m_receiver;
+  QString m_imagePath;
+  QString m_resizedPath;
+  ImageType m_imageType;
+  int m_maxWidth;
+  int m_maxHeight;
+  Resampler::Filter m_filter;
+  int m_jpegQuality;
+  Deliver m_deliver;
+};
+
+} // namespace
+
+ResizeWorker::ResizeWorker(ImageWorker *worker, QObject *parent)
+    : ImageWorker(parent), m_worker(worker), m_task(nullptr) {
+  // Resampler spreads a single image over all cores already
+  m_pool.setMaxThreadCount(1);
+
+  m_worker->setParent(this);
+  connect(m_worker, &ImageWorker::optimizationFinished, this,
+          [this](ImageTask *task, bool success) {
+            takeResults(task);
+            emit optimizationFinished(m_task, success);
+          });
+  connect(m_worker, &ImageWorker::optimizationError, this,
+          [this](ImageTask *task, const QString &errorString) {
+            takeResults(task);
+            emit optimizationError(m_task, errorString);
+          });
+}
+
+ResizeWorker::~ResizeWorker() {
+  // The resize job holds a raw pointer to us
+  m_pool.clear();
+  m_pool.waitForDone();
+
+  // Kill the optimizer while the resized task is still alive, without
+  // getting called back for it
+  disconnect(m_worker, nullptr, this, nullptr);
+  delete m_worker;
+}
+
+bool ResizeWorker::canResize(ImageType imageType) {
+  return imageType == ImageType::JPG || imageType == ImageType::PNG;
+}
+
+int ResizeWorker::intermediateJpegQuality(int maxQuality, double targetSsim,
+                                          bool converts) {
+  return maxQuality < 100 || targetSsim > 0.0 || converts
+             ? 100
+             : INTERMEDIATE_JPEG_QUALITY;
+}
+
+bool ResizeWorker::writeIntermediate(const QImage &image, const QString &path,
+                                     ImageType imageType, int jpegQuality,
+                                     QString *errorString) {
+  bool jpeg = imageType == ImageType::JPG;
+  QImageWriter writer(path, jpeg ? "jpg" : "png");
+  if (jpeg) {
+    writer.setQuality(jpegQuality);
+  }
+  if (!writer.write(image)) {
+    *errorString = writer.errorString();
+    return false;
+  }
+  return true;
+}
+
+void ResizeWorker::optimize(ImageTask *task) {
+  m_task = task;
+  task->resizedTo = QSize();
+
+  int maxWidth = getSetting(Constants::RESIZE_MAX_WIDTH_KEY,
+                            Constants::DEFAULT_RESIZE_MAX_WIDTH)
+                     .toInt();
+  int maxHeight = getSetting(Constants::RESIZE_MAX_HEIGHT_KEY,
+                             Constants::DEFAULT_RESIZE_MAX_HEIGHT)
+                      .toInt();
+  ImageType imageType = ImageWorkerFactory::instance().getImageType(task);
+
+  // The orientation is only known after decoding, so the header has to
+  // fit either way up
+  const ImageHeader::Info &header = task->header;
+  QSize headerSize(int(header.width), int(header.height));
+  bool fits = header.valid &&
+              Resampler::fitWithin(headerSize, maxWidth, maxHeight) ==
+                  headerSize &&
+              Resampler::fitWithin(headerSize.transposed(), maxWidth,
+                                   maxHeight) == headerSize.transposed();
+
+  if (!canResize(imageType) || (maxWidth <= 0 && maxHeight <= 0) || fits) {
+    optimizeWrapped(task);
+    return;
+  }
+
+  // Same directory as the output, so agents with shared paths see it too
+  QFileInfo outputInfo(task->optimizedPath());
+  QDir().mkpath(outputInfo.absolutePath());
+  m_resizeDir.reset(new QTemporaryDir(outputInfo.absolutePath() +
+                                      "/.pixelbatch-resize-XXXXXX"));
+  if (!m_resizeDir->isValid()) {
+    m_resizeDir.reset();
+    emit optimizationError(
+        task, tr("Unable to create a directory for the resized image"));
+    return;
+  }
+
+  // Named after the content, the source may be misnamed or extensionless
+  QString suffix = ImageWorkerFactory::instance()
+                       .getOptimizerByImageType(imageType)
+                       .getSupportedFormats()
+                       .value(0);
+  QString resizedPath = m_resizeDir->filePath(
+      QFileInfo(task->fileName()).completeBaseName() + "." + suffix);
+
+  int jpegQuality = intermediateJpegQuality(
+      getSetting("jpegoptim/maxQuality", 100).toInt(),
+      getSetting(Constants::QUALITY_TARGET_SSIM_KEY,
+                 Constants::DEFAULT_QUALITY_TARGET_SSIM)
+          .toDouble(),
+      ImageWorkerFactory::instance()
+          .getOptimizer(imageType, formatOptimizerName(imageType))
+          .convertsFormat());
+
+  Resampler::Filter filter = Resampler::filterFromInt(
+      getSetting(Constants::RESIZE_FILTER_KEY,
+                 Constants::DEFAULT_RESIZE_FILTER)
+          .toInt());
+
+  qDebug() << "Resizing" << task->imagePath() << "to fit" << maxWidth << "x"
+           << maxHeight << "with" << Resampler::instructionSet()
+           << "kernels";
+
+  m_pool.start(new ResizeJob(
+      this, task->imagePath(), resizedPath, imageType, maxWidth, maxHeight,
+      filter, jpegQuality,
+      [this](const QString &resizedPath, const QSize &size,
+             const QString &errorString) {
+        onResized(resizedPath, size, errorString);
+      }));
+}
+
+void ResizeWorker::onResized(const QString &resizedPath, const QSize &size,
+                             const QString &errorString) {
+  if (!errorString.isEmpty()) {
+    m_resizeDir.reset();
+    emit optimizationError(m_task,
+                           tr("Resize failed: %1").arg(errorString));
+    return;
+  }
+
+  if (resizedPath.isEmpty()) {
+    // Fits once upright
+    m_resizeDir.reset();
+    optimizeWrapped(m_task);
+    return;
+  }
+
+  qDebug() << "Resized" << m_task->imagePath() << "to" << size;
+  m_task->resizedTo = size;
+
+  // Optimized into the output of the task, as if it was the original
+  m_resizedTask.reset(new ImageTask(resizedPath, m_task->optimizedPath()));
+  m_resizedTask->imageType = m_task->imageType;
+  m_resizedTask->imageTypeSniffed = m_task->imageTypeSniffed;
+  m_resizedTask->customOptimizerSettings = m_task->customOptimizerSettings;
+  m_resizedTask->settingsSnapshot = m_task->settingsSnapshot;
+  m_resizedTask->taskStatus = ImageTask::Processing;
+  optimizeWrapped(m_resizedTask.get());
+}
+
+void ResizeWorker::optimizeWrapped(ImageTask *task) {
+  m_worker->setCustomSettings(m_customSettings);
+  m_worker->setSnapshot(m_snapshot);
+  m_worker->setBackground(m_background);
+  m_worker->optimize(task);
+}
+
+void ResizeWorker::takeResults(ImageTask *task) {
+  // The resized file goes with its temporary directory, the resized task
+  // stays until we are deleted, the optimizer may still read its paths
+  m_resizeDir.reset();
+  if (task == m_task) {
+    return;
+  }
+
+  m_task->hasQualityMetrics = task->hasQualityMetrics;
+  m_task->psnr = task->psnr;
+  m_task->ssim = task->ssim;
+  m_task->msSsim = task->msSsim;
+  m_task->searchedQuality = task->searchedQuality;
+  m_task->processedOn = task->processedOn;
+  m_task->timedOut = task->timedOut;
+}
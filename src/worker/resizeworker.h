@@ -0,0 +1,60 @@
+#ifndef RESIZEWORKER_H
+#define RESIZEWORKER_H
+
+#include "ImageWorker.h"
+#include "imagetype.h"
+
+#include <QImage>
+#include <QSize>
+#include <QTemporaryDir>
+#include <QThreadPool>
+
+#include <memory>
+
+// Shrinks an image to the maximum size of the settings before the
+// optimizer of its format runs.
+//
+// The original is decoded, upright, and downscaled by Resampler on a pool
+// thread, then written to a temporary directory next to the output: PNG
+// losslessly, JPEG at high quality, or at full quality when a lossy
+// optimizer encodes it again anyway. The wrapped worker optimizes that file
+// into the output of the task as if it was the original. Images that fit
+// go to the wrapped worker untouched, without being decoded when their
+// header tells. GIF and SVG are not resized, animations and vectors have
+// no single raster to shrink.
+class ResizeWorker : public ImageWorker {
+  Q_OBJECT
+
+public:
+  // Takes ownership of worker
+  explicit ResizeWorker(ImageWorker *worker, QObject *parent = nullptr);
+  ~ResizeWorker();
+
+  static bool canResize(ImageType imageType);
+
+  // Quality a downscaled JPEG is written at before its optimizer runs. A
+  // lossy optimizer, the quality search or a conversion encodes it again,
+  // so it doesn't lose quality twice then.
+  static int intermediateJpegQuality(int maxQuality, double targetSsim,
+                                     bool converts);
+  // PNG losslessly, JPEG at jpegQuality
+  static bool writeIntermediate(const QImage &image, const QString &path,
+                                ImageType imageType, int jpegQuality,
+                                QString *errorString);
+
+  void optimize(ImageTask *task) override;
+
+private:
+  void onResized(const QString &resizedPath, const QSize &size,
+                 const QString &errorString);
+  void optimizeWrapped(ImageTask *task);
+  void takeResults(ImageTask *task);
+
+  ImageWorker *m_worker;
+  ImageTask *m_task;
+  std::unique_ptr<ImageTask> m_resizedTask;
+  std::unique_ptr<QTemporaryDir> m_resizeDir;
+  QThreadPool m_pool;
+};
+
+#endif // RESIZEWORKER_H
@@ -0,0 +1,253 @@
+#include "resourcegovernor.h"
+
+#include <settings.h>
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#if defined(Q_OS_LINUX)
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+// Interpreter, libraries and buffers of a tool before it touches the image
+const qint64 PROCESS_BASELINE_BYTES = 32 * 1024 * 1024;
+// Decoded bytes per file byte assumed without a header, about what a
+// photo saved at high JPEG quality decodes to
+const int UNKNOWN_DECODE_RATIO = 16;
+
+#if defined(Q_OS_LINUX)
+// From linux/ioprio.h, not exported by glibc
+const int IOPRIO_WHO_PROCESS = 1;
+const int IOPRIO_CLASS_IDLE = 3;
+const int IOPRIO_CLASS_SHIFT = 13;
+
+// Unbuffered, cgroup files report errors on the write itself
+bool writeCgroupFile(const QString &path, const QByteArray &data) {
+  QFile file(path);
+  return file.open(QIODevice::WriteOnly | QIODevice::Unbuffered) &&
+         file.write(data) == data.size();
+}
+
+// The cgroup we found ourselves in, set while our leaves exist
+QString createdInCgroup;
+bool enabledMemoryController = false;
+#endif
+
+} // namespace
+
+ResourceGovernor::Limits ResourceGovernor::limits(bool background) {
+  Settings &settings = Settings::instance();
+
+  Limits limits;
+  limits.memoryBytes = qint64(settings.getToolMemoryLimitMb()) * 1024 * 1024;
+  limits.cpuSeconds = settings.getToolCpuTimeLimit();
+  if (background) {
+    limits.niceness = settings.getBatchNiceness();
+    limits.idleIo = settings.getBatchIdleIo();
+  }
+
+  limits.cgroupProcsPath = toolCgroupProcsPath();
+  if (!limits.cgroupProcsPath.isEmpty()) {
+    // Follows the preference, written before every start as it may change
+    static QMutex mutex;
+    static qint64 writtenBudget = -1;
+    QMutexLocker locker(&mutex);
+    qint64 budget = memoryBudget();
+    if (budget != writtenBudget) {
+      QFile memoryMax(QFileInfo(QFile::decodeName(limits.cgroupProcsPath))
+                          .absolutePath() +
+                      "/memory.max");
+      if (memoryMax.open(QIODevice::WriteOnly)) {
+        memoryMax.write(budget > 0 ? QByteArray::number(budget) : "max");
+        writtenBudget = budget;
+      }
+    }
+  }
+  return limits;
+}
+
+qint64 ResourceGovernor::memoryBudget() {
+  return qint64(Settings::instance().getMemoryBudgetMb()) * 1024 * 1024;
+}
+
+int ResourceGovernor::threadBudget() {
+  int threads = Settings::instance().getThreadBudget();
+  return threads > 0 ? threads : qMax(1, QThread::idealThreadCount());
+}
+
+qint64 ResourceGovernor::estimateTaskMemory(const QString &imagePath,
+                                            const ImageHeader::Info &header) {
+  qint64 fileSize = QFileInfo(imagePath).size();
+
+  // Source, output and work copies of the decoded pixels. SVG tools work on
+  // the markup, their memory follows the file size.
+  qint64 pixelBytes = fileSize * UNKNOWN_DECODE_RATIO;
+  if (header.valid) {
+    pixelBytes = header.colorType != ImageHeader::Vector
+                     ? qint64(header.width) * header.height * 4
+                     : 0;
+  }
+
+  return PROCESS_BASELINE_BYTES + qMax(fileSize * 4, pixelBytes * 3);
+}
+
+void ResourceGovernor::applyToCurrentProcess(const Limits &limits) {
+#if defined(Q_OS_UNIX)
+  if (!limits.cgroupProcsPath.isEmpty()) {
+    // "0" moves the writing process
+    int fd = ::open(limits.cgroupProcsPath.constData(), O_WRONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      ssize_t written = ::write(fd, "0\n", 2);
+      Q_UNUSED(written)
+      ::close(fd);
+    }
+  }
+
+  if (limits.memoryBytes > 0) {
+    // RLIMIT_DATA and not RLIMIT_AS: node (svgo) reserves gigabytes of
+    // address space it never touches
+    struct rlimit memory;
+    memory.rlim_cur = rlim_t(limits.memoryBytes);
+    memory.rlim_max = rlim_t(limits.memoryBytes);
+    ::setrlimit(RLIMIT_DATA, &memory);
+  }
+
+  if (limits.cpuSeconds > 0) {
+    // SIGXCPU at the soft limit, SIGKILL for tools ignoring it
+    struct rlimit cpu;
+    cpu.rlim_cur = rlim_t(limits.cpuSeconds);
+    cpu.rlim_max = rlim_t(limits.cpuSeconds + 5);
+    ::setrlimit(RLIMIT_CPU, &cpu);
+  }
+
+  if (limits.niceness > 0) {
+    ::setpriority(PRIO_PROCESS, 0, limits.niceness);
+  }
+
+#if defined(Q_OS_LINUX)
+  if (limits.idleIo) {
+    ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+              IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+  }
+#endif
+#else
+  Q_UNUSED(limits)
+#endif
+}
+
+QByteArray ResourceGovernor::toolCgroupProcsPath() {
+  static const QByteArray path = []() -> QByteArray {
+#if defined(Q_OS_LINUX)
+    // cgroup v2 only, a single "0::<path>" line
+    QFile self("/proc/self/cgroup");
+    if (!self.open(QIODevice::ReadOnly)) {
+      return QByteArray();
+    }
+    QString relativePath;
+    const QList<QByteArray> lines = self.readAll().split('\n');
+    for (const QByteArray &line : lines) {
+      if (line.startsWith("0::")) {
+        relativePath = QString::fromUtf8(line.mid(3)).trimmed();
+      }
+    }
+    // The root cgroup is never delegated
+    if (relativePath.isEmpty() || relativePath == "/") {
+      return QByteArray();
+    }
+    QString ownCgroup = "/sys/fs/cgroup" + relativePath;
+    QFile controllers(ownCgroup + "/cgroup.controllers");
+    if (!controllers.open(QIODevice::ReadOnly) ||
+        !controllers.readAll().trimmed().split(' ').contains("memory")) {
+      return QByteArray();
+    }
+
+    // A cgroup with controllers enabled for its children may not have
+    // processes itself, so we move into an "app" leaf next to the tools one
+    QString appCgroup = ownCgroup + "/pixelbatch-app";
+    QString toolCgroup = ownCgroup + "/pixelbatch-tools";
+    QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    if (!QDir().mkpath(appCgroup) || !QDir().mkpath(toolCgroup) ||
+        !writeCgroupFile(appCgroup + "/cgroup.procs", pid)) {
+      // Not delegated to us, rlimits only
+      QDir().rmdir(appCgroup);
+      QDir().rmdir(toolCgroup);
+      return QByteArray();
+    }
+    QFile subtreeControl(ownCgroup + "/cgroup.subtree_control");
+    bool memoryEnabled =
+        subtreeControl.open(QIODevice::ReadOnly) &&
+        subtreeControl.readAll().trimmed().split(' ').contains("memory");
+    subtreeControl.close();
+    if ((!memoryEnabled &&
+         !writeCgroupFile(ownCgroup + "/cgroup.subtree_control",
+                          "+memory")) ||
+        !QFileInfo::exists(toolCgroup + "/memory.max")) {
+      // Other processes share our cgroup, back to where we were
+      writeCgroupFile(ownCgroup + "/cgroup.procs", pid);
+      QDir().rmdir(appCgroup);
+      QDir().rmdir(toolCgroup);
+      return QByteArray();
+    }
+    createdInCgroup = ownCgroup;
+    enabledMemoryController = !memoryEnabled;
+    qAddPostRoutine(releaseCgroups);
+    qDebug() << "Optimizer processes run in cgroup" << toolCgroup;
+    return QFile::encodeName(toolCgroup + "/cgroup.procs");
+#else
+    return QByteArray();
+#endif
+  }();
+  return path;
+}
+
+void ResourceGovernor::releaseCgroups() {
+#if defined(Q_OS_LINUX)
+  if (createdInCgroup.isEmpty()) {
+    return;
+  }
+  QString ownCgroup = createdInCgroup;
+  createdInCgroup.clear();
+
+  // The workers are gone and have stopped their tools by now, a cgroup
+  // with controllers enabled for its children can't take us back
+  if (enabledMemoryController) {
+    writeCgroupFile(ownCgroup + "/cgroup.subtree_control", "-memory");
+  }
+  QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+  if (!writeCgroupFile(ownCgroup + "/cgroup.procs", pid)) {
+    qWarning() << "Could not move back to cgroup" << ownCgroup;
+  }
+  QDir().rmdir(ownCgroup + "/pixelbatch-app");
+  QDir().rmdir(ownCgroup + "/pixelbatch-tools");
+#endif
+}
+
+GovernedProcess::GovernedProcess(const ResourceGovernor::Limits &limits,
+                                 QObject *parent)
+    : QProcess(parent), m_limits(limits) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0) && defined(Q_OS_UNIX)
+  setChildProcessModifier([limits = m_limits]() {
+    ResourceGovernor::applyToCurrentProcess(limits);
+  });
+#endif
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+void GovernedProcess::setupChildProcess() {
+  ResourceGovernor::applyToCurrentProcess(m_limits);
+}
+#endif
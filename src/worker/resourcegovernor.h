@@ -0,0 +1,78 @@
+#ifndef RESOURCEGOVERNOR_H
+#define RESOURCEGOVERNOR_H
+
+#include "imageheader.h"
+
+#include <QByteArray>
+#include <QProcess>
+#include <QString>
+
+// Keeps optimizer processes from taking the machine down.
+//
+// Every tool runs with a data segment (RLIMIT_DATA) and CPU time
+// (RLIMIT_CPU) limit, and batch tools with a lower CPU and I/O priority.
+// When the cgroup PixelBatch runs in is delegated to it alone (cgroup v2
+// with the memory controller available, e.g. under systemd-run --user
+// --scope -p Delegate=yes), PixelBatch moves itself into a
+// "pixelbatch-app" child cgroup, enables the memory controller for the
+// children and runs tools in a "pixelbatch-tools" one whose memory.max is
+// the memory budget, so a runaway tool is OOM killed there and not the
+// session. Both leaves are removed again when the application quits. The
+// same budget caps the estimated memory of the tasks TaskWidget runs at
+// once, as the thread budget caps the threads of their tools.
+class ResourceGovernor {
+public:
+  struct Limits {
+    qint64 memoryBytes = 0; // per process, 0 = unlimited
+    int cpuSeconds = 0;     // per process, 0 = unlimited
+    int niceness = 0;
+    bool idleIo = false;
+    QByteArray cgroupProcsPath; // empty = stay in our cgroup
+  };
+
+  // Batch tasks are background work, on-demand ones are not
+  static Limits limits(bool background);
+
+  // Bytes, 0 = unlimited
+  static qint64 memoryBudget();
+
+  // Threads the tools of all local tasks may run on together, see
+  // ImageWorker::threadCount. One per core unless set.
+  static int threadBudget();
+
+  // Rough peak memory of optimizing the image, from the pre-flight header
+  // (see HeaderAnalyzer). Never decodes anything, without a valid header
+  // it assumes a poorly compressed image of the file size.
+  static qint64 estimateTaskMemory(
+      const QString &imagePath,
+      const ImageHeader::Info &header = ImageHeader::Info());
+
+  // Runs in the forked child, async-signal-safe calls only
+  static void applyToCurrentProcess(const Limits &limits);
+
+private:
+  ResourceGovernor() = delete;
+
+  static QByteArray toolCgroupProcsPath();
+  // Undoes what toolCgroupProcsPath set up, run when the application quits
+  static void releaseCgroups();
+};
+
+// QProcess applying ResourceGovernor limits to the child before exec
+class GovernedProcess : public QProcess {
+  Q_OBJECT
+
+public:
+  explicit GovernedProcess(const ResourceGovernor::Limits &limits,
+                           QObject *parent = nullptr);
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+protected:
+  void setupChildProcess() override;
+#endif
+
+private:
+  ResourceGovernor::Limits m_limits;
+};
+
+#endif // RESOURCEGOVERNOR_H
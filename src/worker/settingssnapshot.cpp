@@ -0,0 +1,198 @@
+#include "settingssnapshot.h"
+#include "imageworkerfactory.h"
+#include "qualitysearchworker.h"
+#include "resizeworker.h"
+#include "variantworker.h"
+
+#include <settings.h>
+
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+// "320, 640 1280" to ascending widths, anything else is ignored
+QList<int> parseWidths(const QString &text) {
+  static const QRegularExpression separators("[,;\\s]+");
+  QList<int> widths;
+  const QStringList parts = text.split(separators, Qt::SkipEmptyParts);
+  for (const QString &part : parts) {
+    int width = part.toInt();
+    if (width > 0 && !widths.contains(width)) {
+      widths << width;
+    }
+  }
+  std::sort(widths.begin(), widths.end());
+  return widths;
+}
+
+} // namespace
+
+SettingsSnapshot::Ptr SettingsSnapshot::compile(const QVariantMap &overrides,
+                                                const SettingsSnapshot *base) {
+  QVariantMap values = base ? base->m_values : globalValues();
+  for (auto it = overrides.cbegin(); it != overrides.cend(); ++it) {
+    values.insert(it.key(), it.value());
+  }
+  QSharedPointer<SettingsSnapshot> snapshot(new SettingsSnapshot(values));
+
+  // Workers read their options from the snapshot being compiled, nothing
+  // else holds it yet
+  ImageWorkerFactory &factory = ImageWorkerFactory::instance();
+  const QList<ImageOptimizer> optimizers =
+      factory.getRegisteredImageOptimizers();
+  for (const ImageOptimizer &optimizer : optimizers) {
+    std::unique_ptr<ImageWorker> worker(factory.getWorker(optimizer));
+    worker->setSnapshot(snapshot);
+    snapshot->m_threads.insert(optimizer.getName(), worker->threadCount());
+    // Conversions are registered once per input type
+    if (!worker->toolName().isEmpty() &&
+        !snapshot->hasArguments(worker->toolName())) {
+      snapshot->m_arguments.insert(worker->toolName(),
+                                   worker->optionArguments());
+    }
+  }
+  return snapshot;
+}
+
+QVariantMap SettingsSnapshot::toTransferMap() const {
+  QVariantMap arguments;
+  for (auto it = m_arguments.cbegin(); it != m_arguments.cend(); ++it) {
+    arguments.insert(it.key(), it.value());
+  }
+  QVariantMap map;
+  map.insert("values", m_values);
+  map.insert("arguments", arguments);
+  return map;
+}
+
+SettingsSnapshot::Ptr
+SettingsSnapshot::fromTransferMap(const QVariantMap &map) {
+  QSharedPointer<SettingsSnapshot> snapshot(
+      new SettingsSnapshot(map.value("values").toMap()));
+  const QVariantMap arguments = map.value("arguments").toMap();
+  for (auto it = arguments.cbegin(); it != arguments.cend(); ++it) {
+    snapshot->m_arguments.insert(it.key(), it.value().toStringList());
+  }
+
+  ImageWorkerFactory &factory = ImageWorkerFactory::instance();
+  const QList<ImageOptimizer> optimizers =
+      factory.getRegisteredImageOptimizers();
+  for (const ImageOptimizer &optimizer : optimizers) {
+    std::unique_ptr<ImageWorker> worker(factory.getWorker(optimizer));
+    worker->setSnapshot(snapshot);
+    snapshot->m_threads.insert(optimizer.getName(), worker->threadCount());
+  }
+  return snapshot;
+}
+
+QVariant SettingsSnapshot::value(const QString &key,
+                                 const QVariant &defaultValue) const {
+  return m_values.value(key, defaultValue);
+}
+
+ImageOptimizer SettingsSnapshot::optimizer(ImageType imageType) const {
+  QString format = ImageTypeUtils::imageTypeToString(imageType).toLower();
+  return ImageWorkerFactory::instance().getOptimizer(
+      imageType,
+      value(Constants::FORMAT_OPTIMIZER_KEY_PREFIX + format).toString());
+}
+
+QStringList SettingsSnapshot::arguments(const QString &tool) const {
+  return m_arguments.value(tool);
+}
+
+bool SettingsSnapshot::hasArguments(const QString &tool) const {
+  return m_arguments.contains(tool);
+}
+
+int SettingsSnapshot::threads(ImageType imageType) const {
+  return m_threads.value(optimizer(imageType).getName(), 1);
+}
+
+int SettingsSnapshot::concurrentEncodes(ImageType imageType) const {
+  // Picked like TaskWidget::processNextBatch wraps the workers
+  int encodes = 1;
+  ImageOptimizer picked = optimizer(imageType);
+  if (m_targetSsim > 0.0 && !picked.convertsFormat() &&
+      !picked.stripsMetadataOnly() &&
+      QualitySearchWorker::canSearch(imageType)) {
+    encodes = QualitySearchWorker::CANDIDATES_PER_ROUND;
+  }
+  if (!m_variantWidths.isEmpty() && ResizeWorker::canResize(imageType)) {
+    encodes += qMin(int(m_variantWidths.count()),
+                    VariantWorker::MAX_CONCURRENT_VARIANTS);
+  }
+  return encodes;
+}
+
+SettingsSnapshot::SettingsSnapshot(const QVariantMap &values)
+    : m_values(values),
+      m_pipeIo(value(Constants::TASK_PIPE_IO_KEY,
+                     Constants::DEFAULT_TASK_PIPE_IO)
+                   .toBool()),
+      m_computeQualityMetrics(
+          value(Constants::QUALITY_COMPUTE_METRICS_KEY,
+                Constants::DEFAULT_QUALITY_COMPUTE_METRICS)
+              .toBool()),
+      m_minimumSsim(value(Constants::QUALITY_MINIMUM_SSIM_KEY,
+                          Constants::DEFAULT_QUALITY_MINIMUM_SSIM)
+                        .toDouble()),
+      m_targetSsim(value(Constants::QUALITY_TARGET_SSIM_KEY,
+                         Constants::DEFAULT_QUALITY_TARGET_SSIM)
+                       .toDouble()),
+      m_linkMode(OutputLinker::modeFromInt(
+          value(Constants::TASK_LINK_UNCHANGED_KEY,
+                Constants::DEFAULT_TASK_LINK_UNCHANGED)
+              .toInt())),
+      m_commitPolicy(
+          CommitPolicy::actionFromInt(
+              value(Constants::TASK_NOT_SMALLER_ACTION_KEY,
+                    Constants::DEFAULT_TASK_NOT_SMALLER_ACTION)
+                  .toInt()),
+          value(Constants::TASK_MINIMUM_GAIN_KEY,
+                Constants::DEFAULT_TASK_MINIMUM_GAIN)
+              .toDouble(),
+          m_linkMode),
+      m_stripMetadataMode(MetadataStripper::modeFromInt(
+          value(Constants::TASK_STRIP_METADATA_KEY,
+                Constants::DEFAULT_TASK_STRIP_METADATA)
+              .toInt())),
+      m_maxWidth(value(Constants::RESIZE_MAX_WIDTH_KEY,
+                       Constants::DEFAULT_RESIZE_MAX_WIDTH)
+                     .toInt()),
+      m_maxHeight(value(Constants::RESIZE_MAX_HEIGHT_KEY,
+                        Constants::DEFAULT_RESIZE_MAX_HEIGHT)
+                      .toInt()),
+      m_variantWidths(parseWidths(
+          value(Constants::RESIZE_VARIANT_WIDTHS_KEY,
+                Constants::DEFAULT_RESIZE_VARIANT_WIDTHS)
+              .toString())),
+      m_backgroundLimits(ResourceGovernor::limits(true)),
+      m_interactiveLimits(ResourceGovernor::limits(false)) {}
+
+QVariantMap SettingsSnapshot::globalValues() {
+  // Optimizer groups and what the task pipeline reads, not window state
+  QStringList prefixes = {"task/", "quality/", "resize/", "resources/",
+                          "format/"};
+  const QList<ImageOptimizer> optimizers =
+      ImageWorkerFactory::instance().getRegisteredImageOptimizers();
+  for (const ImageOptimizer &optimizer : optimizers) {
+    prefixes << optimizer.getName().toLower() + "/";
+  }
+
+  QVariantMap values;
+  const QSettings &settings = Settings::instance().getSettings();
+  const QStringList keys = settings.allKeys();
+  for (const QString &key : keys) {
+    for (const QString &prefix : qAsConst(prefixes)) {
+      if (key.startsWith(prefix)) {
+        values.insert(key, settings.value(key));
+        break;
+      }
+    }
+  }
+  return values;
+}
@@ -0,0 +1,99 @@
+#ifndef SETTINGSSNAPSHOT_H
+#define SETTINGSSNAPSHOT_H
+
+#include "imageoptimizer.h"
+#include "metadatastripper.h"
+#include "resourcegovernor.h"
+
+#include <commitpolicy.h>
+#include <outputlinker.h>
+
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+// Everything an optimization reads from the preferences, captured once.
+//
+// TaskWidget compiles a snapshot when a task is queued, from the global
+// settings overlaid with the custom settings of the task, and shares it
+// between the tasks of a batch with the same custom settings. Preference
+// changes apply from the next batch on, never to half a batch. A snapshot
+// does not change once compiled and never touches QSettings, so it can be
+// read from any thread. It also holds the option arguments of every
+// optimizer, built once per snapshot and not per image.
+class SettingsSnapshot {
+public:
+  typedef QSharedPointer<const SettingsSnapshot> Ptr;
+
+  // Overrides applied on top of base, or of the global settings
+  static Ptr compile(const QVariantMap &overrides,
+                     const SettingsSnapshot *base = nullptr);
+
+  // What an agent needs to optimize exactly as this snapshot does: the
+  // values and the option arguments built here, defaults of this side
+  // applied. Keys left out are read with the same code defaults on both
+  // sides. Resource limits stay those of the machine running the tool.
+  QVariantMap toTransferMap() const;
+  // Never reads the settings of this side
+  static Ptr fromTransferMap(const QVariantMap &map);
+
+  QVariant value(const QString &key,
+                 const QVariant &defaultValue = QVariant()) const;
+
+  // Options of the tool, without input and output, empty if unknown
+  QStringList arguments(const QString &tool) const;
+  bool hasArguments(const QString &tool) const;
+  // Threads the optimizer picked for the type runs on
+  int threads(ImageType imageType) const;
+  // Optimizers a task of the type runs at once, quality search candidates
+  // and responsive variants included
+  int concurrentEncodes(ImageType imageType) const;
+
+  // The optimizer picked for the type, see Settings::getFormatOptimizer
+  ImageOptimizer optimizer(ImageType imageType) const;
+
+  bool pipeIo() const { return m_pipeIo; }
+  bool computeQualityMetrics() const { return m_computeQualityMetrics; }
+  double minimumSsim() const { return m_minimumSsim; }
+  double targetSsim() const { return m_targetSsim; }
+  OutputLinker::Mode linkMode() const { return m_linkMode; }
+  const CommitPolicy &commitPolicy() const { return m_commitPolicy; }
+  MetadataStripper::Mode stripMetadataMode() const {
+    return m_stripMetadataMode;
+  }
+  // Largest output size, 0 = no limit
+  int maxWidth() const { return m_maxWidth; }
+  int maxHeight() const { return m_maxHeight; }
+  bool resizes() const { return m_maxWidth > 0 || m_maxHeight > 0; }
+  // Widths of the responsive variants, ascending, empty = none
+  const QList<int> &variantWidths() const { return m_variantWidths; }
+  const ResourceGovernor::Limits &limits(bool background) const {
+    return background ? m_backgroundLimits : m_interactiveLimits;
+  }
+
+private:
+  SettingsSnapshot(const QVariantMap &values);
+
+  static QVariantMap globalValues();
+
+  QVariantMap m_values;
+  QHash<QString, QStringList> m_arguments;
+  QHash<QString, int> m_threads; // by optimizer name
+
+  bool m_pipeIo;
+  bool m_computeQualityMetrics;
+  double m_minimumSsim;
+  double m_targetSsim;
+  OutputLinker::Mode m_linkMode;
+  CommitPolicy m_commitPolicy;
+  MetadataStripper::Mode m_stripMetadataMode;
+  int m_maxWidth;
+  int m_maxHeight;
+  QList<int> m_variantWidths;
+  ResourceGovernor::Limits m_backgroundLimits;
+  ResourceGovernor::Limits m_interactiveLimits;
+};
+
+#endif // SETTINGSSNAPSHOT_H
@@ -66,8 +66,8 @@
 SvgoWorker::SvgoWorker(QObject *parent) : ImageWorker(parent) {}
 
 void SvgoWorker::optimize(ImageTask *task) {
-  QString src = task->imagePath;
-  QString dst = task->optimizedPath;
+  QString src = task->imagePath();
+  QString dst = task->optimizedPath();
 
   // Ensure destination directory exists
   QFileInfo dstInfo(dst);
@@ -81,6 +81,45 @@ void SvgoWorker::optimize(ImageTask *task) {
     QFile::remove(dst);
   }
 
+  QStringList args = compiledArguments();
+
+  // Input/Output, "-" is stdin/stdout
+  bool pipes = usePipes();
+  args << "-i" << (pipes ? QString("-") : src);
+  args << "-o" << (pipes ? QString("-") : dst);
+
+  // SVGO 4.0+ uses a config-based approach for plugins
+  // We'll use default plugins and override specific ones via command line isn't
+  // directly possible Instead, we rely on SVGO's built-in defaults which align
+  // with most of our settings For fine-grained control, we'd need to create a
+  // config file, but for simplicity, we'll use the defaults which are already
+  // quite good
+
+  // Note: SVGO 4.0's defaults already include:
+  // - removeComments: enabled
+  // - removeMetadata: enabled
+  // - removeEditorsNSData: enabled
+  // - removeHiddenElems: enabled
+  // - removeEmptyContainers: enabled
+  // - mergePaths: enabled
+  // - convertShapeToPath: enabled
+  // - cleanupIds: enabled
+
+  // The settings we've exposed give users awareness of what's happening,
+  // and in a future version we could generate a custom config file
+
+  // Debug output
+  qDebug() << "svgo command:" << "svgo" << args.join(" ");
+
+  // Execute the optimization
+  if (pipes) {
+    executePipedProcess("svgo", args, task);
+  } else {
+    executeProcess("svgo", args, task);
+  }
+}
+
+QStringList SvgoWorker::optionArguments() const {
   // Load settings (using getSetting which checks custom settings first, then falls back to global)
   int precision = getSetting("svgo/precision", 3).toInt();
   bool multipass = getSetting("svgo/multipass", true).toBool();
@@ -110,10 +149,6 @@ void SvgoWorker::optimize(ImageTask *task) {
   // Build arguments
   QStringList args;
 
-  // Input/Output
-  args << "-i" << src;
-  args << "-o" << dst;
-
   // Precision
   args << "--precision=" + QString::number(precision);
 
@@ -131,29 +166,5 @@ void SvgoWorker::optimize(ImageTask *task) {
   // Quiet mode
   args << "-q";
 
-  // SVGO 4.0+ uses a config-based approach for plugins
-  // We'll use default plugins and override specific ones via command line isn't
-  // directly possible Instead, we rely on SVGO's built-in defaults which align
-  // with most of our settings For fine-grained control, we'd need to create a
-  // config file, but for simplicity, we'll use the defaults which are already
-  // quite good
-
-  // Note: SVGO 4.0's defaults already include:
-  // - removeComments: enabled
-  // - removeMetadata: enabled
-  // - removeEditorsNSData: enabled
-  // - removeHiddenElems: enabled
-  // - removeEmptyContainers: enabled
-  // - mergePaths: enabled
-  // - convertShapeToPath: enabled
-  // - cleanupIds: enabled
-
-  // The settings we've exposed give users awareness of what's happening,
-  // and in a future version we could generate a custom config file
-
-  // Debug output
-  qDebug() << "svgo command:" << "svgo" << args.join(" ");
-
-  // Execute the optimization
-  executeProcess("svgo", args, task);
+  return args;
 }
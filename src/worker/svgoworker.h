@@ -10,6 +10,8 @@ public:
   explicit SvgoWorker(QObject *parent = nullptr);
 
   void optimize(ImageTask *task) override;
+  QString toolName() const override { return "svgo"; }
+  QStringList optionArguments() const override;
 };
 
 #endif // SVGOWORKER_H
@@ -0,0 +1,408 @@
+#include "variantworker.h"
+#include "imageworkerfactory.h"
+#include "resampler.h"
+#include "resizeworker.h"
+
+#include <constants.h>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QUrl>
+
+#include <algorithm>
+
+// Cleared by the worker when it goes away, the job delivers while holding
+// the mutex so it never posts to a deleted worker
+struct VariantWorker::PyramidState {
+  QMutex mutex;
+  VariantWorker *receiver;
+
+  bool cancelled() {
+    QMutexLocker locker(&mutex);
+    return !receiver;
+  }
+};
+
+namespace {
+
+class PyramidJob : public QRunnable {
+public:
+  typedef std::function<void(const QList<VariantWorker::Level> &,
+                             const QString &)>
+      Deliver;
+
+  PyramidJob(std::shared_ptr<VariantWorker::PyramidState> state,
+             const QString &imagePath, const QList<int> &widths,
+             const QSize &maxSize, std::shared_ptr<QTemporaryDir> levelDir,
+             ImageType imageType, Resampler::Filter filter, int jpegQuality,
+             Deliver deliver)
+      : m_state(state), m_imagePath(imagePath), m_widths(widths),
+        m_maxSize(maxSize), m_levelDir(levelDir), m_imageType(imageType),
+        m_filter(filter), m_jpegQuality(jpegQuality), m_deliver(deliver) {}
+
+  void run() override {
+    QList<VariantWorker::Level> levels;
+    QString errorString;
+    build(&levels, &errorString);
+
+    QMutexLocker locker(&m_state->mutex);
+    if (!m_state->receiver) {
+      return;
+    }
+    auto deliver = m_deliver;
+    QMetaObject::invokeMethod(
+        m_state->receiver,
+        [deliver, levels, errorString]() { deliver(levels, errorString); },
+        Qt::QueuedConnection);
+  }
+
+private:
+  void build(QList<VariantWorker::Level> *levels,
+             QString *errorString) const {
+    QImageReader reader(m_imagePath);
+    reader.setDecideFormatFromContent(true);
+    reader.setAutoTransform(true);
+    QImage image = reader.read();
+    if (image.isNull()) {
+      *errorString = reader.errorString();
+      return;
+    }
+
+    // Widest first, no wider than the image at its maximum size
+    int largest = Resampler::fitWithin(image.size(), m_maxSize.width(),
+                                       m_maxSize.height())
+                      .width();
+    QList<int> widths;
+    for (int width : m_widths) {
+      width = qMin(width, largest);
+      if (!widths.contains(width)) {
+        widths << width;
+      }
+    }
+    std::sort(widths.begin(), widths.end(), std::greater<int>());
+
+    QString suffix = ImageWorkerFactory::instance()
+                         .getOptimizerByImageType(m_imageType)
+                         .getSupportedFormats()
+                         .value(0);
+    QImage previous = image;
+    for (int width : widths) {
+      // The task was cancelled or preempted meanwhile
+      if (m_state->cancelled()) {
+        return;
+      }
+      // Heights from the original, rounding doesn't add up across levels
+      QSize size(width, qMax(1, int(qRound64(double(image.height()) * width /
+                                             image.width()))));
+      QImage level = size == previous.size()
+                         ? previous
+                         : Resampler::resize(previous, size, m_filter);
+      if (level.isNull()) {
+        *errorString = QObject::tr("Not enough memory to resize the image");
+        return;
+      }
+
+      QString levelName = QString("%1.%2").arg(width).arg(suffix);
+      QString levelPath = QDir(m_levelDir->path()).filePath(levelName);
+      if (!ResizeWorker::writeIntermediate(level, levelPath, m_imageType,
+                                           m_jpegQuality, errorString)) {
+        return;
+      }
+      levels->append(VariantWorker::Level{size, levelPath});
+      previous = level;
+    }
+  }
+
+  std::shared_ptr<VariantWorker::PyramidState> m_state;
+  QString m_imagePath;
+  QList<int> m_widths;
+  QSize m_maxSize;
+  std::shared_ptr<QTemporaryDir> m_levelDir;
+  ImageType m_imageType;
+  Resampler::Filter m_filter;
+  int m_jpegQuality;
+  Deliver m_deliver;
+};
+
+} // namespace
+
+VariantWorker::VariantWorker(ImageWorker *worker, const QList<int> &widths,
+                             const PathForWidth &variantPath,
+                             const QString &manifestPath, QObject *parent)
+    : ImageWorker(parent), m_worker(worker), m_widths(widths),
+      m_variantPath(variantPath), m_manifestPath(manifestPath),
+      m_task(nullptr), m_mainDone(false), m_mainSucceeded(false),
+      m_variantsDone(false), m_pendingVariants(0), m_nextVariant(0) {
+  m_worker->setParent(this);
+  connect(m_worker, &ImageWorker::optimizationFinished, this,
+          [this](ImageTask *, bool success) {
+            m_mainDone = true;
+            m_mainSucceeded = success;
+            finishIfDone();
+          });
+  connect(m_worker, &ImageWorker::optimizationError, this,
+          [this](ImageTask *, const QString &errorString) {
+            m_mainDone = true;
+            m_mainSucceeded = false;
+            m_mainError = errorString;
+            finishIfDone();
+          });
+}
+
+VariantWorker::~VariantWorker() {
+  // A running pyramid job finishes on its own and delivers nothing, the
+  // level directory goes with it
+  if (m_pyramidState) {
+    QMutexLocker locker(&m_pyramidState->mutex);
+    m_pyramidState->receiver = nullptr;
+  }
+
+  // Kill the optimizers while the variant tasks are still alive, without
+  // getting called back for them
+  const QList<ImageWorker *> workers =
+      findChildren<ImageWorker *>(QString(), Qt::FindDirectChildrenOnly);
+  for (ImageWorker *worker : workers) {
+    disconnect(worker, nullptr, this, nullptr);
+    delete worker;
+  }
+}
+
+void VariantWorker::optimize(ImageTask *task) {
+  m_task = task;
+  m_mainDone = false;
+  m_mainSucceeded = false;
+  m_mainError.clear();
+  m_variantsDone = false;
+  m_variantsError.clear();
+  m_variants.clear();
+  m_nextVariant = 0;
+
+  // Next to the output, like the candidates of the quality search
+  QFileInfo outputInfo(task->optimizedPath());
+  QDir().mkpath(outputInfo.absolutePath());
+  m_levelDir.reset(new QTemporaryDir(outputInfo.absolutePath() +
+                                     "/.pixelbatch-variants-XXXXXX"));
+  if (!m_levelDir->isValid()) {
+    m_levelDir.reset();
+    m_variantsDone = true;
+    m_variantsError = tr("Unable to create a directory for the variants");
+  } else {
+    ImageType imageType = ImageWorkerFactory::instance().getImageType(task);
+    m_variantOptimizer = ImageWorkerFactory::instance().getOptimizer(
+        imageType, formatOptimizerName(imageType));
+    QSize maxSize(getSetting(Constants::RESIZE_MAX_WIDTH_KEY,
+                             Constants::DEFAULT_RESIZE_MAX_WIDTH)
+                      .toInt(),
+                  getSetting(Constants::RESIZE_MAX_HEIGHT_KEY,
+                             Constants::DEFAULT_RESIZE_MAX_HEIGHT)
+                      .toInt());
+    int jpegQuality = ResizeWorker::intermediateJpegQuality(
+        getSetting("jpegoptim/maxQuality", 100).toInt(),
+        getSetting(Constants::QUALITY_TARGET_SSIM_KEY,
+                   Constants::DEFAULT_QUALITY_TARGET_SSIM)
+            .toDouble(),
+        m_variantOptimizer.convertsFormat());
+    Resampler::Filter filter = Resampler::filterFromInt(
+        getSetting(Constants::RESIZE_FILTER_KEY,
+                   Constants::DEFAULT_RESIZE_FILTER)
+            .toInt());
+
+    qDebug() << "Building variants" << m_widths << "of" << task->imagePath();
+
+    // A job of an earlier run still going delivers nothing
+    if (m_pyramidState) {
+      QMutexLocker locker(&m_pyramidState->mutex);
+      m_pyramidState->receiver = nullptr;
+    }
+    m_pyramidState = std::make_shared<PyramidState>();
+    m_pyramidState->receiver = this;
+    QThreadPool::globalInstance()->start(new PyramidJob(
+        m_pyramidState, task->imagePath(), m_widths, maxSize, m_levelDir,
+        imageType, filter, jpegQuality,
+        [this](const QList<Level> &levels, const QString &errorString) {
+          onLevelsWritten(levels, errorString);
+        }));
+  }
+
+  m_worker->setCustomSettings(m_customSettings);
+  m_worker->setSnapshot(m_snapshot);
+  m_worker->setBackground(m_background);
+  m_worker->optimize(task);
+}
+
+void VariantWorker::onLevelsWritten(const QList<Level> &levels,
+                                    const QString &errorString) {
+  if (!errorString.isEmpty() || levels.isEmpty()) {
+    m_levelDir.reset();
+    m_variantsDone = true;
+    m_variantsError =
+        tr("Variants failed: %1")
+            .arg(errorString.isEmpty() ? tr("no width to write") : errorString);
+    finishIfDone();
+    return;
+  }
+
+  // All tasks exist before the first optimizer runs, a worker that fails
+  // to start calls back right away
+  m_variants.resize(levels.size());
+  for (int i = 0; i < levels.size(); ++i) {
+    const Level &level = levels.at(i);
+    QString outputPath = m_variantPath(level.size.width());
+    QDir().mkpath(QFileInfo(outputPath).absolutePath());
+
+    Variant &variant = m_variants[i];
+    variant.size = level.size;
+    variant.task.reset(new ImageTask(level.path, outputPath));
+    variant.task->imageType = m_task->imageType;
+    variant.task->imageTypeSniffed = m_task->imageTypeSniffed;
+    variant.task->customOptimizerSettings = m_task->customOptimizerSettings;
+    variant.task->settingsSnapshot = m_task->settingsSnapshot;
+    variant.task->taskStatus = ImageTask::Processing;
+  }
+  m_pendingVariants = levels.size();
+
+  for (int i = 0; i < MAX_CONCURRENT_VARIANTS; ++i) {
+    startNextVariant();
+  }
+}
+
+void VariantWorker::startNextVariant() {
+  if (m_nextVariant >= int(m_variants.size())) {
+    return;
+  }
+  int i = m_nextVariant++;
+  ImageTask *variantTask = m_variants[i].task.get();
+
+  // Encoded like the main output, converted when it is
+  ImageWorker *worker = nullptr;
+  try {
+    worker = ImageWorkerFactory::instance().getWorker(m_variantOptimizer);
+  } catch (const std::exception &e) {
+    onVariantFinished(i, false, e.what());
+    return;
+  }
+
+  // Owned by us, so cancelling the task also kills the variant processes
+  worker->setParent(this);
+  worker->setCustomSettings(m_customSettings);
+  worker->setSnapshot(m_snapshot);
+  worker->setBackground(m_background);
+
+  connect(worker, &ImageWorker::optimizationFinished, this,
+          [this, worker, i](ImageTask *, bool success) {
+            worker->deleteLater();
+            onVariantFinished(i, success, QString());
+          });
+  connect(worker, &ImageWorker::optimizationError, this,
+          [this, worker, i](ImageTask *, const QString &errorString) {
+            worker->deleteLater();
+            onVariantFinished(i, false, errorString);
+          });
+
+  worker->optimize(variantTask);
+}
+
+void VariantWorker::onVariantFinished(int index, bool success,
+                                      const QString &errorString) {
+  Variant &variant = m_variants[index];
+  QString outputPath = variant.task->optimizedPath();
+  if (success && !QFileInfo::exists(outputPath)) {
+    // Skipped by the optimizer, e.g. not smaller, the level is as good
+    success = QFile::copy(variant.task->imagePath(), outputPath);
+  }
+  variant.succeeded = success;
+  if (!success) {
+    variant.errorString =
+        errorString.isEmpty() ? tr("Optimizer failed") : errorString;
+  }
+
+  if (--m_pendingVariants > 0) {
+    startNextVariant();
+    return;
+  }
+  m_levelDir.reset();
+
+  QStringList failures;
+  for (const Variant &other : m_variants) {
+    if (!other.succeeded) {
+      failures << QString("%1w: %2")
+                      .arg(other.size.width())
+                      .arg(other.errorString);
+    }
+  }
+  QString manifestError;
+  if (!failures.isEmpty()) {
+    m_variantsError = tr("Variants failed: %1").arg(failures.join("; "));
+  } else if (!writeManifest(&manifestError)) {
+    m_variantsError =
+        tr("Unable to write the srcset manifest: %1").arg(manifestError);
+  }
+  m_variantsDone = true;
+  finishIfDone();
+}
+
+bool VariantWorker::writeManifest(QString *errorString) const {
+  QDir manifestDir = QFileInfo(m_manifestPath).absoluteDir();
+  QStringList srcset;
+  QJsonArray variants;
+
+  // Narrowest first, as srcset lists are usually written
+  for (auto it = m_variants.rbegin(); it != m_variants.rend(); ++it) {
+    QString path = it->task->optimizedPath();
+    QString file = manifestDir.relativeFilePath(path);
+    // Spaces and commas separate srcset candidates
+    srcset << QString("%1 %2w")
+                  .arg(QString::fromUtf8(QUrl::toPercentEncoding(file, "/")))
+                  .arg(it->size.width());
+
+    QJsonObject variant;
+    variant["file"] = file;
+    variant["width"] = it->size.width();
+    variant["height"] = it->size.height();
+    variant["bytes"] = double(QFileInfo(path).size());
+    variants.append(variant);
+  }
+
+  QJsonObject manifest;
+  manifest["source"] = m_task->fileName();
+  manifest["srcset"] = srcset.join(", ");
+  manifest["variants"] = variants;
+
+  QSaveFile file(m_manifestPath);
+  if (!file.open(QIODevice::WriteOnly) ||
+      file.write(QJsonDocument(manifest).toJson()) < 0 || !file.commit()) {
+    *errorString = file.errorString();
+    return false;
+  }
+  return true;
+}
+
+void VariantWorker::finishIfDone() {
+  if (!m_mainDone || !m_variantsDone) {
+    return;
+  }
+
+  if (!m_mainSucceeded) {
+    if (m_mainError.isEmpty()) {
+      emit optimizationFinished(m_task, false);
+    } else {
+      emit optimizationError(m_task, m_mainError);
+    }
+  } else if (!m_variantsError.isEmpty()) {
+    emit optimizationError(m_task, m_variantsError);
+  } else {
+    qDebug() << "Variants of" << m_task->imagePath() << "written to"
+             << m_manifestPath;
+    emit optimizationFinished(m_task, true);
+  }
+}
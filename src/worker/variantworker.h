@@ -0,0 +1,92 @@
+#ifndef VARIANTWORKER_H
+#define VARIANTWORKER_H
+
+#include "ImageWorker.h"
+#include "imagetype.h"
+
+#include <QList>
+#include <QSize>
+#include <QTemporaryDir>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Writes an image at several widths for responsive web pages, next to the
+// regular output.
+//
+// The wrapped worker optimizes the task as usual. Meanwhile the original is
+// decoded once on a pool thread and downscaled into a pyramid by Resampler,
+// widest first, every level from the one above it, so each level costs a
+// fraction of the original's pixels. Levels are written like ResizeWorker
+// does and optimized by the optimizer picked for the format, at most
+// MAX_CONCURRENT_VARIANTS at once (TaskWidget reserves threads and memory for
+// them, see SettingsSnapshot::concurrentEncodes), into the paths given by
+// TaskWidget::generateOutputPath. Widths above the image, or above the
+// maximum size of the settings, become one variant at that size, there is
+// no upscaling. Once all are done a srcset
+// manifest is written next to the output. The pyramid job is detached when
+// the worker goes away early, it never blocks the caller.
+class VariantWorker : public ImageWorker {
+  Q_OBJECT
+
+public:
+  // Variant optimizers running next to the main one
+  static constexpr int MAX_CONCURRENT_VARIANTS = 2;
+
+  // Output path of the variant with the given width
+  typedef std::function<QString(int)> PathForWidth;
+
+  struct Level {
+    QSize size;
+    QString path; // intermediate file
+  };
+
+  // Shared with the pyramid job, which may outlive us
+  struct PyramidState;
+
+  // Takes ownership of worker
+  VariantWorker(ImageWorker *worker, const QList<int> &widths,
+                const PathForWidth &variantPath, const QString &manifestPath,
+                QObject *parent = nullptr);
+  ~VariantWorker();
+
+  void optimize(ImageTask *task) override;
+
+private:
+  struct Variant {
+    QSize size;
+    std::unique_ptr<ImageTask> task;
+    bool succeeded = false;
+    QString errorString;
+  };
+
+  void onLevelsWritten(const QList<Level> &levels,
+                       const QString &errorString);
+  void startNextVariant();
+  void onVariantFinished(int index, bool success,
+                         const QString &errorString);
+  bool writeManifest(QString *errorString) const;
+  void finishIfDone();
+
+  ImageWorker *m_worker;
+  QList<int> m_widths;
+  PathForWidth m_variantPath;
+  QString m_manifestPath;
+
+  ImageTask *m_task;
+  bool m_mainDone;
+  bool m_mainSucceeded;
+  QString m_mainError;
+  bool m_variantsDone;
+  int m_pendingVariants;
+  int m_nextVariant;
+  ImageOptimizer m_variantOptimizer;
+  QString m_variantsError;
+
+  std::vector<Variant> m_variants; // widest first
+  std::shared_ptr<QTemporaryDir> m_levelDir;
+  std::shared_ptr<PyramidState> m_pyramidState;
+};
+
+#endif // VARIANTWORKER_H
@@ -0,0 +1,144 @@
+#include "workprotocol.h"
+
+#include <QIODevice>
+#include <QJsonDocument>
+#include <QMessageAuthenticationCode>
+#include <QRandomGenerator>
+#include <QtEndian>
+
+namespace {
+
+// Headers are small, anything bigger is a corrupt or foreign stream
+const quint32 MAX_HEADER_SIZE = 1024 * 1024;
+
+} // namespace
+
+const char *const WorkProtocol::SECRET_ENVIRONMENT_VARIABLE =
+    "PIXELBATCH_AGENT_SECRET";
+
+QByteArray WorkProtocol::secret() {
+  return qgetenv(SECRET_ENVIRONMENT_VARIABLE);
+}
+
+QString WorkProtocol::newNonce() {
+  QByteArray nonce(16, Qt::Uninitialized);
+  QRandomGenerator::system()->fillRange(
+      reinterpret_cast<quint32 *>(nonce.data()), nonce.size() / 4);
+  return QString::fromLatin1(nonce.toHex());
+}
+
+QString WorkProtocol::authCode(const QString &role, const QString &nonce) {
+  return QString::fromLatin1(
+      QMessageAuthenticationCode::hash((role + ":" + nonce).toUtf8(),
+                                       secret(), QCryptographicHash::Sha256)
+          .toHex());
+}
+
+bool WorkProtocol::verifyAuthCode(const QString &role, const QString &nonce,
+                                  const QString &code) {
+  // Constant time, the comparison must not tell how much matched
+  const QByteArray expected = authCode(role, nonce).toLatin1();
+  const QByteArray actual = code.toLatin1();
+  if (nonce.isEmpty() || expected.size() != actual.size()) {
+    return false;
+  }
+  char difference = 0;
+  for (int i = 0; i < expected.size(); ++i) {
+    difference |= expected.at(i) ^ actual.at(i);
+  }
+  return difference == 0;
+}
+
+QByteArray WorkProtocol::encode(const QJsonObject &header,
+                                const QByteArray &payload) {
+  QJsonObject framedHeader = header;
+  framedHeader["payload"] = double(payload.size());
+  QByteArray json = QJsonDocument(framedHeader).toJson(QJsonDocument::Compact);
+
+  QByteArray frame;
+  frame.reserve(4 + json.size() + payload.size());
+  quint32 headerSize = qToBigEndian<quint32>(json.size());
+  frame.append(reinterpret_cast<const char *>(&headerSize), 4);
+  frame.append(json);
+  frame.append(payload);
+  return frame;
+}
+
+bool WorkProtocol::parseAddress(const QString &address, QString *host,
+                                quint16 *port, QString *socketPath) {
+  QString trimmed = address.trimmed();
+  if (trimmed.startsWith("unix:")) {
+    *socketPath = trimmed.mid(5);
+    return !socketPath->isEmpty();
+  }
+  if (trimmed.startsWith('/')) {
+    *socketPath = trimmed;
+    return true;
+  }
+
+  int colon = trimmed.lastIndexOf(':');
+  *host = colon >= 0 ? trimmed.left(colon) : trimmed;
+  *port = DEFAULT_PORT;
+  if (colon >= 0) {
+    bool ok = false;
+    *port = trimmed.mid(colon + 1).toUShort(&ok);
+    if (!ok || *port == 0) {
+      return false;
+    }
+  }
+  return !host->isEmpty();
+}
+
+void WorkProtocol::FrameReader::read(QIODevice *device) {
+  m_buffer.append(device->readAll());
+}
+
+bool WorkProtocol::FrameReader::takeMessage(Message *message,
+                                            QString *errorString) {
+  if (m_buffer.size() < 4) {
+    return false;
+  }
+
+  quint32 headerSize = qFromBigEndian<quint32>(
+      reinterpret_cast<const uchar *>(m_buffer.constData()));
+  if (headerSize == 0 || headerSize > MAX_HEADER_SIZE) {
+    *errorString = QString("Invalid header size %1").arg(headerSize);
+    m_buffer.clear();
+    return false;
+  }
+  if (quint32(m_buffer.size()) < 4 + headerSize) {
+    return false;
+  }
+
+  QJsonParseError parseError;
+  QJsonDocument header = QJsonDocument::fromJson(
+      QByteArray::fromRawData(m_buffer.constData() + 4, headerSize),
+      &parseError);
+  if (parseError.error != QJsonParseError::NoError || !header.isObject()) {
+    *errorString = "Malformed header: " + parseError.errorString();
+    m_buffer.clear();
+    return false;
+  }
+
+  qint64 payloadSize =
+      header.object().value("payload").toVariant().toLongLong();
+  if (payloadSize < 0 || payloadSize > MAX_PAYLOAD_SIZE) {
+    *errorString = QString("Invalid payload size %1").arg(payloadSize);
+    m_buffer.clear();
+    return false;
+  }
+  if (payloadSize > 0 && !m_payloadAllowed) {
+    *errorString = "Payload before authentication";
+    m_buffer.clear();
+    return false;
+  }
+  qint64 frameSize = 4 + qint64(headerSize) + payloadSize;
+  if (m_buffer.size() < frameSize) {
+    return false;
+  }
+
+  message->header = header.object();
+  message->payload = m_buffer.mid(4 + headerSize, int(payloadSize));
+  m_buffer.remove(0, int(frameSize));
+  return true;
+}
@@ -0,0 +1,84 @@
+#ifndef WORKPROTOCOL_H
+#define WORKPROTOCOL_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+class QIODevice;
+
+// Framing of the coordinator <-> agent protocol.
+//
+// Every message is a 32 bit big endian header length, a compact JSON header
+// and an optional binary payload whose size is given by the "payload" field
+// of the header (file bytes when coordinator and agent don't share paths).
+//
+//   coordinator -> agent  challenge {nonce}
+//   agent -> coordinator  hello   {version, slots, host, sharedPaths, auth,
+//                                  nonce}
+//   coordinator -> agent  welcome {auth}
+//   coordinator -> agent  task    {id, fileName, imagePath, outputPath,
+//                                  settings, targetSsim} + source bytes
+//   coordinator -> agent  cancel  {id}
+//   agent -> coordinator  result  {id, ok, error, quality} + output bytes
+//
+// Both sides prove they know the shared secret before anything else is
+// exchanged: auth is an HMAC-SHA256 of the nonce the other side sent. The
+// secret never goes over the wire, but the traffic is not encrypted. Until
+// then no payload is accepted, after that none above MAX_PAYLOAD_SIZE, so a
+// peer can't make the other side buffer more than that.
+class WorkProtocol {
+public:
+  static const int VERSION = 2;
+  static const quint16 DEFAULT_PORT = 7433;
+  // Bigger images are optimized where they are
+  static const qint64 MAX_PAYLOAD_SIZE = 512 * 1024 * 1024;
+  static const char *const SECRET_ENVIRONMENT_VARIABLE;
+
+  struct Message {
+    QJsonObject header;
+    QByteArray payload;
+
+    QString type() const { return header.value("type").toString(); }
+  };
+
+  static QByteArray encode(const QJsonObject &header,
+                           const QByteArray &payload = QByteArray());
+
+  // From the environment, empty when not set
+  static QByteArray secret();
+  static QString newNonce();
+  // role is "agent" or "coordinator", so one side's answer can't be
+  // replayed as the other's
+  static QString authCode(const QString &role, const QString &nonce);
+  static bool verifyAuthCode(const QString &role, const QString &nonce,
+                             const QString &code);
+
+  // "host:port", "unix:/path" or an absolute socket path
+  static bool parseAddress(const QString &address, QString *host,
+                           quint16 *port, QString *socketPath);
+
+  // Reassembles messages from the bytes of a stream socket
+  class FrameReader {
+  public:
+    // Appends what the device has buffered
+    void read(QIODevice *device);
+
+    // False when no complete message is buffered yet or on a protocol
+    // error, which is reported through errorString
+    bool takeMessage(Message *message, QString *errorString);
+
+    // Once the peer is authenticated, messages with a payload are a
+    // protocol error before
+    void setPayloadAllowed(bool allowed) { m_payloadAllowed = allowed; }
+
+  private:
+    QByteArray m_buffer;
+    bool m_payloadAllowed = false;
+  };
+
+private:
+  WorkProtocol() = delete;
+};
+
+#endif // WORKPROTOCOL_H